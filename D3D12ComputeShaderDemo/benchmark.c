@@ -0,0 +1,683 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "compute_backend.h"
+#include "compute_utils.h"
+#include "compute_timeline.h"
+#include "upload_ring.h"
+#include "descriptor_allocator.h"
+#include "shader_cache.h"
+#include "kernel_variants.h"
+#include "host_copy.h"
+#include "thread_pool.h"
+
+// Times the stages of a compute job separately, over sweeps of the job parameters:
+// - staging:  filling the upload ring with UpdateSubresourcesFromRing, CPU time only
+// - upload:   staging and copying the buffer to the GPU in chunks, until the last copy has completed
+// - dispatch: submitting the kernel and waiting for it, with several submissions in flight at a time
+// - readback: copying the result to a readback buffer with CopyResource and waiting for it
+// - sync:     signaling the idle queue and waiting for the fence, the cost of a CPU-GPU round trip
+// Every configuration is timed over a number of iterations, and reported with its percentiles as JSON or CSV.
+
+// The maximum number of values of a swept parameter
+#define BENCH_MAX_VALUES    16
+
+// The root parameter of the dispatch constants
+#define DISPATCH_CONSTANTS_ROOT_PARAMETER   2
+
+typedef enum BenchFormat
+{
+    BENCH_FORMAT_JSON,
+    BENCH_FORMAT_CSV
+} BenchFormat;
+
+typedef struct BenchOptions
+{
+    ComputeBackendType backendType;
+    uint64_t counts[BENCH_MAX_VALUES];
+    uint32_t numCounts;
+    uint64_t groupSizes[BENCH_MAX_VALUES];
+    uint32_t numGroupSizes;
+    uint64_t chunkSizes[BENCH_MAX_VALUES];
+    uint32_t numChunkSizes;
+    uint64_t depths[BENCH_MAX_VALUES];
+    uint32_t numDepths;
+    uint32_t iterations;
+    uint32_t warmup;
+    BenchFormat format;
+    const char *outputPath;
+} BenchOptions;
+
+// The statistics of one configuration, in microseconds
+typedef struct BenchResult
+{
+    const char *name;
+    uint32_t elements;
+    uint32_t groupSize;
+    uint64_t chunkSize;
+    uint32_t depth;
+    // The bytes moved per sample, 0 when the throughput is meaningless
+    uint64_t bytes;
+    uint32_t samples;
+    double mean;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} BenchResult;
+
+typedef struct BenchContext
+{
+    const BenchOptions *options;
+    ComputeDevice *device;
+    ComputeCommandQueue *queue;
+    ComputeTimeline timeline;
+    ComputeFrameRing frames;
+    ComputeRootSignature *rootSignature;
+    ComputeShaderCache shaderCache;
+    ComputeKernelRegistry registry;
+    ComputeDescriptorAllocator descriptors;
+    ComputeDescriptorAllocation views;
+    ComputeUploadRing uploadRing;
+    ThreadPool *hostThreads;
+    // The buffers of the current element count: the SRV buffer rests in the shader resource state,
+    // the UAV buffer in the unordered access state
+    uint32_t elements;
+    ComputeResource *srcBuffer;
+    ComputeResource *dstBuffer;
+    ComputeResource *readbackBuffer;
+    int *hostData;
+    // The timings of the configuration being measured
+    double *samples;
+    BenchResult *results;
+    uint32_t numResults;
+    uint32_t resultCapacity;
+} BenchContext;
+
+// Parse a comma separated list of positive integers
+static bool ParseList(const char *text, uint64_t *values, uint32_t *pCount)
+{
+    uint32_t count = 0;
+    while (*text != '\0')
+    {
+        char *end;
+        const unsigned long long value = strtoull(text, &end, 10);
+        if (end == text || value == 0 || count == BENCH_MAX_VALUES || (*end != ',' && *end != '\0'))
+            return false;
+        values[count++] = value;
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    *pCount = count;
+    return count > 0;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double Percentile(const double *samples, uint32_t count, double percent)
+{
+    uint32_t rank = (uint32_t)ceil(percent / 100.0 * count);
+    if (rank < 1)
+        rank = 1;
+    return samples[rank - 1];
+}
+
+static bool AddResult(BenchContext *bench, const char *name, uint32_t groupSize, uint64_t chunkSize, uint32_t depth,
+    uint64_t bytes)
+{
+    if (bench->numResults == bench->resultCapacity)
+    {
+        const uint32_t capacity = bench->resultCapacity > 0 ? bench->resultCapacity * 2 : 64;
+        BenchResult *results = realloc(bench->results, capacity * sizeof(*results));
+        if (results == NULL)
+            return false;
+        bench->results = results;
+        bench->resultCapacity = capacity;
+    }
+
+    const uint32_t count = bench->options->iterations;
+    qsort(bench->samples, count, sizeof(double), CompareDoubles);
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < count; i++)
+        sum += bench->samples[i];
+
+    BenchResult *result = &bench->results[bench->numResults++];
+    result->name = name;
+    result->elements = bench->elements;
+    result->groupSize = groupSize;
+    result->chunkSize = chunkSize;
+    result->depth = depth;
+    result->bytes = bytes;
+    result->samples = count;
+    result->mean = sum / count;
+    result->min = bench->samples[0];
+    result->p50 = Percentile(bench->samples, count, 50.0);
+    result->p90 = Percentile(bench->samples, count, 90.0);
+    result->p99 = Percentile(bench->samples, count, 99.0);
+    result->max = bench->samples[count - 1];
+
+    fprintf(stderr, "%-8s elements=%-10u group=%-5u chunk=%-9llu depth=%u  p50 %10.1f us  p99 %10.1f us\n",
+        name, result->elements, groupSize, (unsigned long long)chunkSize, depth, result->p50, result->p99);
+    return true;
+}
+
+static double ElapsedMicroseconds(uint64_t startTime)
+{
+    return (double)(ComputeGetTimeNanoseconds() - startTime) / 1000.0;
+}
+
+static void RecordTransition(ComputeCommandList *commandList, ComputeResource *resource,
+    ComputeResourceStates before, ComputeResourceStates after)
+{
+    const ComputeResourceBarrier barrier = { COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE,
+        resource, before, after, NULL };
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &barrier);
+}
+
+static void ReleaseBenchBuffers(BenchContext *bench)
+{
+    ComputeTimelineFlush(&bench->timeline);
+
+    if (bench->srcBuffer != NULL)
+        bench->srcBuffer->lpVtbl->Release(bench->srcBuffer);
+    if (bench->dstBuffer != NULL)
+        bench->dstBuffer->lpVtbl->Release(bench->dstBuffer);
+    if (bench->readbackBuffer != NULL)
+        bench->readbackBuffer->lpVtbl->Release(bench->readbackBuffer);
+    ComputeUploadRingDestroy(&bench->uploadRing);
+    free(bench->hostData);
+
+    bench->srcBuffer = NULL;
+    bench->dstBuffer = NULL;
+    bench->readbackBuffer = NULL;
+    bench->hostData = NULL;
+    bench->elements = 0;
+}
+
+// Create the buffers and the views of the element count
+static bool CreateBenchBuffers(BenchContext *bench, uint32_t elements)
+{
+    ReleaseBenchBuffers(bench);
+
+    ComputeDevice *device = bench->device;
+    const uint64_t size = (uint64_t)elements * sizeof(int);
+    const ComputeResourceDesc srcDesc = { size, COMPUTE_RESOURCE_FLAG_NONE };
+    const ComputeResourceDesc dstDesc = { size, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+
+    bench->elements = elements;
+    bench->hostData = malloc((size_t)size);
+    bench->srcBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &srcDesc,
+        COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    bench->dstBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &dstDesc,
+        COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    // Exactly the size of the UAV buffer, as CopyResource requires
+    bench->readbackBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_READBACK, &srcDesc,
+        COMPUTE_RESOURCE_STATE_COPY_DEST);
+    if (bench->hostData == NULL || bench->srcBuffer == NULL || bench->dstBuffer == NULL || bench->readbackBuffer == NULL)
+        return false;
+
+    for (uint32_t i = 0; i < elements; i++)
+        bench->hostData[i] = (int)i;
+
+    // The whole buffer is staged at once by the staging benchmark, and the largest chunk twice by the upload one.
+    uint64_t ringSize = size;
+    for (uint32_t i = 0; i < bench->options->numChunkSizes; i++)
+    {
+        if (ringSize < 2 * bench->options->chunkSizes[i])
+            ringSize = 2 * bench->options->chunkSizes[i];
+    }
+    if (!ComputeUploadRingInit(&bench->uploadRing, device, &bench->timeline, ringSize + 2 * COMPUTE_UPLOAD_ALIGNMENT))
+        return false;
+
+    const ComputeBufferViewDesc viewDesc = { 0, elements, sizeof(int), COMPUTE_FORMAT_UNKNOWN, COMPUTE_BUFFER_VIEW_FLAG_NONE };
+    device->lpVtbl->CreateShaderResourceView(device, bench->srcBuffer, &viewDesc,
+        ComputeDescriptorCPUHandle(&bench->descriptors, &bench->views, 0));
+    device->lpVtbl->CreateUnorderedAccessView(device, bench->dstBuffer, &viewDesc,
+        ComputeDescriptorCPUHandle(&bench->descriptors, &bench->views, 1));
+
+    return true;
+}
+
+// staging: the CPU side of UpdateSubresourcesFromRing, for the whole buffer
+static bool RunStagingBenchmark(BenchContext *bench)
+{
+    const size_t size = (size_t)bench->elements * sizeof(int);
+    const ComputeSubresourceData data = { bench->hostData, (intptr_t)size, (intptr_t)size };
+
+    for (uint32_t i = 0; i < bench->options->warmup + bench->options->iterations; i++)
+    {
+        ComputeCommandList *commandList = ComputeFrameRingBegin(&bench->frames, NULL, COMPUTE_WAIT_INFINITE);
+        if (commandList == NULL)
+            return false;
+        RecordTransition(commandList, bench->srcBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            COMPUTE_RESOURCE_STATE_COPY_DEST);
+
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        const size_t staged = UpdateSubresourcesFromRing(commandList, bench->srcBuffer, &bench->uploadRing, 0, 1, &data);
+        const double elapsed = ElapsedMicroseconds(startTime);
+
+        RecordTransition(commandList, bench->srcBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST,
+            COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        const uint64_t fenceValue = ComputeFrameRingSubmit(&bench->frames);
+        if (staged == 0 || fenceValue == 0 || !ComputeTimelineWait(&bench->timeline, fenceValue, COMPUTE_WAIT_INFINITE))
+            return false;
+
+        if (i >= bench->options->warmup)
+            bench->samples[i - bench->options->warmup] = elapsed;
+    }
+
+    return AddResult(bench, "staging", 0, 0, 1, size);
+}
+
+// upload: the buffer staged and copied chunk by chunk, each chunk in a submission of its own
+static bool RunUploadBenchmark(BenchContext *bench, uint64_t chunkSize)
+{
+    const uint64_t size = (uint64_t)bench->elements * sizeof(int);
+
+    for (uint32_t i = 0; i < bench->options->warmup + bench->options->iterations; i++)
+    {
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        uint64_t fenceValue = 0;
+
+        for (uint64_t offset = 0; offset < size; offset += chunkSize)
+        {
+            const uint64_t chunk = size - offset < chunkSize ? size - offset : chunkSize;
+
+            ComputeCommandList *commandList = ComputeFrameRingBegin(&bench->frames, NULL, COMPUTE_WAIT_INFINITE);
+            if (commandList == NULL)
+                return false;
+
+            ComputeUploadAllocation allocation;
+            if (!ComputeUploadRingAllocate(&bench->uploadRing, chunk, COMPUTE_UPLOAD_ALIGNMENT, COMPUTE_WAIT_INFINITE, &allocation))
+            {
+                ComputeFrameRingSubmit(&bench->frames);
+                return false;
+            }
+            ComputeHostCopy(allocation.pData, (const uint8_t*)bench->hostData + offset, (size_t)chunk);
+
+            if (offset == 0)
+                RecordTransition(commandList, bench->srcBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+                    COMPUTE_RESOURCE_STATE_COPY_DEST);
+            commandList->lpVtbl->CopyBufferRegion(commandList, bench->srcBuffer, offset, allocation.resource,
+                allocation.offset, chunk);
+            if (offset + chunk == size)
+                RecordTransition(commandList, bench->srcBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST,
+                    COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+            fenceValue = ComputeFrameRingSubmit(&bench->frames);
+            if (fenceValue == 0)
+                return false;
+        }
+
+        if (!ComputeTimelineWait(&bench->timeline, fenceValue, COMPUTE_WAIT_INFINITE))
+            return false;
+
+        if (i >= bench->options->warmup)
+            bench->samples[i - bench->options->warmup] = ElapsedMicroseconds(startTime);
+    }
+
+    return AddResult(bench, "upload", 0, chunkSize, 1, size);
+}
+
+// dispatch: depth submissions of the kernel in flight, the sample is the time per dispatch
+static bool RunDispatchBenchmark(BenchContext *bench, const ComputeKernelVariant *variant, uint32_t depth)
+{
+    ComputeDescriptorHeap *ppHeaps[] = { bench->descriptors.heap };
+    const ComputeGPUDescriptorHandle srvHandle = ComputeDescriptorGPUHandle(&bench->descriptors, &bench->views, 0);
+    const ComputeGPUDescriptorHandle uavHandle = ComputeDescriptorGPUHandle(&bench->descriptors, &bench->views, 1);
+
+    for (uint32_t i = 0; i < bench->options->warmup + bench->options->iterations; i++)
+    {
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        uint64_t fenceValue = 0;
+
+        for (uint32_t j = 0; j < depth; j++)
+        {
+            ComputeCommandList *commandList = ComputeFrameRingBegin(&bench->frames, variant->pipelineState, COMPUTE_WAIT_INFINITE);
+            if (commandList == NULL)
+                return false;
+
+            commandList->lpVtbl->SetComputeRootSignature(commandList, bench->rootSignature);
+            commandList->lpVtbl->SetDescriptorHeaps(commandList, 1, ppHeaps);
+            commandList->lpVtbl->SetComputeRootDescriptorTable(commandList, 0, srvHandle);
+            commandList->lpVtbl->SetComputeRootDescriptorTable(commandList, 1, uavHandle);
+            ComputeDispatchElements(commandList, DISPATCH_CONSTANTS_ROOT_PARAMETER, bench->elements, variant->elementsPerGroup);
+
+            // The submissions write the same buffer one after the other.
+            const ComputeResourceBarrier barrier = {
+                .Type = COMPUTE_RESOURCE_BARRIER_TYPE_UAV, .Flags = COMPUTE_RESOURCE_BARRIER_FLAG_NONE, .pResource = bench->dstBuffer
+            };
+            commandList->lpVtbl->ResourceBarrier(commandList, 1, &barrier);
+
+            fenceValue = ComputeFrameRingSubmit(&bench->frames);
+            if (fenceValue == 0)
+                return false;
+        }
+
+        if (!ComputeTimelineWait(&bench->timeline, fenceValue, COMPUTE_WAIT_INFINITE))
+            return false;
+
+        if (i >= bench->options->warmup)
+            bench->samples[i - bench->options->warmup] = ElapsedMicroseconds(startTime) / depth;
+    }
+
+    return AddResult(bench, "dispatch", variant->threadGroupSize[0], 0, depth, 2ull * bench->elements * sizeof(int));
+}
+
+// readback: CopyResource of the UAV buffer to the readback buffer, until the copy has completed
+static bool RunReadbackBenchmark(BenchContext *bench)
+{
+    for (uint32_t i = 0; i < bench->options->warmup + bench->options->iterations; i++)
+    {
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+
+        ComputeCommandList *commandList = ComputeFrameRingBegin(&bench->frames, NULL, COMPUTE_WAIT_INFINITE);
+        if (commandList == NULL)
+            return false;
+
+        RecordTransition(commandList, bench->dstBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS,
+            COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        commandList->lpVtbl->CopyResource(commandList, bench->readbackBuffer, bench->dstBuffer);
+        RecordTransition(commandList, bench->dstBuffer, COMPUTE_RESOURCE_STATE_COPY_SOURCE,
+            COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        const uint64_t fenceValue = ComputeFrameRingSubmit(&bench->frames);
+        if (fenceValue == 0 || !ComputeTimelineWait(&bench->timeline, fenceValue, COMPUTE_WAIT_INFINITE))
+            return false;
+
+        if (i >= bench->options->warmup)
+            bench->samples[i - bench->options->warmup] = ElapsedMicroseconds(startTime);
+    }
+
+    return AddResult(bench, "readback", 0, 0, 1, (uint64_t)bench->elements * sizeof(int));
+}
+
+// sync: a signal on the idle queue and the wait for it
+static bool RunSyncBenchmark(BenchContext *bench)
+{
+    for (uint32_t i = 0; i < bench->options->warmup + bench->options->iterations; i++)
+    {
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        if (!ComputeTimelineFlush(&bench->timeline))
+            return false;
+
+        if (i >= bench->options->warmup)
+            bench->samples[i - bench->options->warmup] = ElapsedMicroseconds(startTime);
+    }
+
+    return AddResult(bench, "sync", 0, 0, 1, 0);
+}
+
+static bool InitBench(BenchContext *bench)
+{
+#ifdef _WIN32
+    if (bench->options->backendType == COMPUTE_BACKEND_D3D12)
+        bench->device = CreateD3D12ComputeDevice();
+    else
+#endif
+        bench->device = CreateCPUComputeDevice(NULL);
+    if (bench->device == NULL)
+        return false;
+
+    ComputeDevice *device = bench->device;
+
+    const ComputeDescriptorRange ranges[2] = {
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0 },
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0 }
+    };
+    const ComputeRootParameter rootParameters[3] = {
+        { COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[0] } },
+        { COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[1] } },
+        { COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, .Constants = { 0, COMPUTE_DISPATCH_CONSTANTS_COUNT } }
+    };
+    const ComputeRootSignatureDesc rootSignatureDesc = { 3, rootParameters };
+    bench->rootSignature = device->lpVtbl->CreateRootSignature(device, &rootSignatureDesc);
+    if (bench->rootSignature == NULL)
+        return false;
+
+    if (!ComputeShaderCacheInit(&bench->shaderCache, device, "shader_cache", NULL, NULL) ||
+        !ComputeKernelRegistryInit(&bench->registry, &bench->shaderCache, bench->rootSignature, "compute.hlsl", "CSMain", "cs_5_0",
+            COMPUTE_COMPILE_OPTIMIZATION_LEVEL3))
+        return false;
+
+    bench->queue = device->lpVtbl->CreateCommandQueue(device, COMPUTE_COMMAND_LIST_TYPE_COMPUTE);
+    if (bench->queue == NULL || !ComputeTimelineInit(&bench->timeline, device, bench->queue))
+        return false;
+
+    if (!ComputeFrameRingInit(&bench->frames, device, &bench->timeline, COMPUTE_MAX_FRAMES_IN_FLIGHT, COMPUTE_COMMAND_LIST_TYPE_COMPUTE))
+        return false;
+
+    const ComputeDescriptorAllocatorDesc descriptorDesc = { 8, 8, 8 };
+    if (!ComputeDescriptorAllocatorInit(&bench->descriptors, device, &bench->timeline, &descriptorDesc) ||
+        !ComputeDescriptorAllocatorAllocatePersistent(&bench->descriptors, 2, &bench->views))
+        return false;
+
+    bench->hostThreads = CreateThreadPool(0);
+    if (bench->hostThreads == NULL)
+        return false;
+    ComputeHostCopySetThreadPool(bench->hostThreads);
+
+    bench->samples = malloc(bench->options->iterations * sizeof(double));
+    return bench->samples != NULL;
+}
+
+static void DestroyBench(BenchContext *bench)
+{
+    ReleaseBenchBuffers(bench);
+    ComputeFrameRingDestroy(&bench->frames);
+    if (bench->views.count > 0)
+        ComputeDescriptorAllocatorFreePersistent(&bench->descriptors, &bench->views);
+    ComputeDescriptorAllocatorDestroy(&bench->descriptors);
+    ComputeTimelineDestroy(&bench->timeline);
+    if (bench->queue != NULL)
+        bench->queue->lpVtbl->Release(bench->queue);
+    ComputeKernelRegistryDestroy(&bench->registry);
+    if (bench->rootSignature != NULL)
+        bench->rootSignature->lpVtbl->Release(bench->rootSignature);
+    if (bench->device != NULL)
+        bench->device->lpVtbl->Release(bench->device);
+
+    ComputeHostCopySetThreadPool(NULL);
+    if (bench->hostThreads != NULL)
+        ReleaseThreadPool(bench->hostThreads);
+    free(bench->samples);
+    free(bench->results);
+}
+
+static bool RunBenchmarks(BenchContext *bench)
+{
+    const BenchOptions *options = bench->options;
+
+    if (!RunSyncBenchmark(bench))
+        return false;
+
+    for (uint32_t c = 0; c < options->numCounts; c++)
+    {
+        if (!CreateBenchBuffers(bench, (uint32_t)options->counts[c]) || !RunStagingBenchmark(bench))
+            return false;
+
+        for (uint32_t i = 0; i < options->numChunkSizes; i++)
+        {
+            if (!RunUploadBenchmark(bench, options->chunkSizes[i]))
+                return false;
+        }
+
+        for (uint32_t g = 0; g < options->numGroupSizes; g++)
+        {
+            const ComputeKernelVariantKey key = { 10, (uint32_t)options->groupSizes[g], COMPUTE_ELEMENT_TYPE_INT, 1 };
+            const ComputeKernelVariant *variant = ComputeKernelRegistryGet(&bench->registry, &key);
+            if (variant == NULL)
+                return false;
+
+            for (uint32_t d = 0; d < options->numDepths; d++)
+            {
+                if (!RunDispatchBenchmark(bench, variant, (uint32_t)options->depths[d]))
+                    return false;
+            }
+        }
+
+        if (!RunReadbackBenchmark(bench))
+            return false;
+    }
+
+    return true;
+}
+
+static void WriteResults(const BenchContext *bench, FILE *file)
+{
+    const char *backendName = bench->options->backendType == COMPUTE_BACKEND_D3D12 ? "d3d12" : "cpu";
+
+    if (bench->options->format == BENCH_FORMAT_CSV)
+    {
+        fputs("backend,name,elements,group_size,chunk_size,depth,samples,mean_us,min_us,p50_us,p90_us,p99_us,max_us,gb_per_s\n", file);
+        for (uint32_t i = 0; i < bench->numResults; i++)
+        {
+            const BenchResult *r = &bench->results[i];
+            fprintf(file, "%s,%s,%u,%u,%llu,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                backendName, r->name, r->elements, r->groupSize, (unsigned long long)r->chunkSize, r->depth, r->samples,
+                r->mean, r->min, r->p50, r->p90, r->p99, r->max, r->bytes > 0 ? (double)r->bytes / (r->p50 * 1000.0) : 0.0);
+        }
+        return;
+    }
+
+    fprintf(file, "{\n  \"backend\": \"%s\",\n  \"copy_kernel\": \"%s\",\n  \"results\": [\n", backendName,
+        ComputeHostCopyGetKernelName(ComputeHostCopyGetBestKernel()));
+    for (uint32_t i = 0; i < bench->numResults; i++)
+    {
+        const BenchResult *r = &bench->results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"elements\": %u, \"group_size\": %u, \"chunk_size\": %llu, \"depth\": %u, "
+            "\"samples\": %u, \"mean_us\": %.3f, \"min_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, "
+            "\"max_us\": %.3f, \"gb_per_s\": %.3f }%s\n",
+            r->name, r->elements, r->groupSize, (unsigned long long)r->chunkSize, r->depth, r->samples,
+            r->mean, r->min, r->p50, r->p90, r->p99, r->max, r->bytes > 0 ? (double)r->bytes / (r->p50 * 1000.0) : 0.0,
+            i + 1 < bench->numResults ? "," : "");
+    }
+    fputs("  ]\n}\n", file);
+}
+
+static void PrintUsage(void)
+{
+    puts("Usage: D3D12ComputeBenchmark [options]\n"
+        "  --cpu                 Run on the CPU backend (the only one outside Windows)\n"
+        "  --counts <n,...>      Element counts (default 4096,262144,4194304)\n"
+        "  --group-sizes <n,...> Thread group sizes (default 64,256,1024)\n"
+        "  --chunk-sizes <n,...> Upload chunk sizes in bytes (default 65536,1048576,4194304)\n"
+        "  --depths <n,...>      Dispatch submissions in flight, up to 8 (default 1,2,4)\n"
+        "  --iterations <n>      Timed iterations per configuration (default 50)\n"
+        "  --warmup <n>          Untimed iterations per configuration (default 5)\n"
+        "  --format json|csv     Output format (default json)\n"
+        "  --output <path>       Output file (default stdout)");
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    memset(&options, 0, sizeof(options));
+#ifdef _WIN32
+    options.backendType = COMPUTE_BACKEND_D3D12;
+#else
+    options.backendType = COMPUTE_BACKEND_CPU;
+#endif
+    ParseList("4096,262144,4194304", options.counts, &options.numCounts);
+    ParseList("64,256,1024", options.groupSizes, &options.numGroupSizes);
+    ParseList("65536,1048576,4194304", options.chunkSizes, &options.numChunkSizes);
+    ParseList("1,2,4", options.depths, &options.numDepths);
+    options.iterations = 50;
+    options.warmup = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool valid = true;
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--cpu") == 0)
+        {
+            options.backendType = COMPUTE_BACKEND_CPU;
+            continue;
+        }
+        if (value == NULL)
+            valid = false;
+        else if (strcmp(argv[i], "--counts") == 0)
+            valid = ParseList(value, options.counts, &options.numCounts);
+        else if (strcmp(argv[i], "--group-sizes") == 0)
+            valid = ParseList(value, options.groupSizes, &options.numGroupSizes);
+        else if (strcmp(argv[i], "--chunk-sizes") == 0)
+            valid = ParseList(value, options.chunkSizes, &options.numChunkSizes);
+        else if (strcmp(argv[i], "--depths") == 0)
+            valid = ParseList(value, options.depths, &options.numDepths);
+        else if (strcmp(argv[i], "--iterations") == 0)
+            valid = (options.iterations = (uint32_t)strtoul(value, NULL, 10)) > 0;
+        else if (strcmp(argv[i], "--warmup") == 0)
+            options.warmup = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "--format") == 0)
+        {
+            valid = strcmp(value, "json") == 0 || strcmp(value, "csv") == 0;
+            options.format = strcmp(value, "csv") == 0 ? BENCH_FORMAT_CSV : BENCH_FORMAT_JSON;
+        }
+        else if (strcmp(argv[i], "--output") == 0)
+            options.outputPath = value;
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            PrintUsage();
+            return 1;
+        }
+        i++;
+    }
+
+    for (uint32_t i = 0; i < options.numCounts; i++)
+    {
+        if (options.counts[i] > UINT32_MAX / sizeof(int))
+        {
+            puts("Invalid element count!");
+            return 1;
+        }
+    }
+    for (uint32_t i = 0; i < options.numDepths; i++)
+    {
+        if (options.depths[i] > COMPUTE_MAX_FRAMES_IN_FLIGHT)
+        {
+            printf("The depth must be in [1, %d]!\n", COMPUTE_MAX_FRAMES_IN_FLIGHT);
+            return 1;
+        }
+    }
+
+    BenchContext bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.options = &options;
+
+    bool result = InitBench(&bench) && RunBenchmarks(&bench);
+    if (result)
+    {
+        FILE *file = options.outputPath != NULL ? fopen(options.outputPath, "w") : stdout;
+        if (file != NULL)
+        {
+            WriteResults(&bench, file);
+            if (file != stdout)
+                fclose(file);
+        }
+        else
+        {
+            printf("Failed to open %s!\n", options.outputPath);
+            result = false;
+        }
+    }
+    else
+        puts("Benchmark failed!");
+
+    DestroyBench(&bench);
+    return result ? 0 : 1;
+}
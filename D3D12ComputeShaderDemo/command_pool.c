@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command_pool.h"
+#include "compute_trace.h"
+
+static void ReleaseRecordingContext(ComputeRecordingContext *context)
+{
+    if (context->commandList != NULL)
+        context->commandList->lpVtbl->Release(context->commandList);
+
+    if (context->prologueList != NULL)
+        context->prologueList->lpVtbl->Release(context->prologueList);
+
+    ComputeStateTrackerDestroy(&context->tracker);
+
+    if (context->allocator != NULL)
+        context->allocator->lpVtbl->Release(context->allocator);
+
+    free(context);
+}
+
+static ComputeRecordingContext* CreateRecordingContext(ComputeCommandPool *pool)
+{
+    ComputeRecordingContext *context = calloc(1, sizeof(*context));
+    if (context == NULL)
+        return NULL;
+
+    ComputeDevice *device = pool->device;
+
+    do
+    {
+        context->allocator = device->lpVtbl->CreateCommandAllocator(device, pool->type);
+        if (context->allocator == NULL)
+            break;
+
+        // Command lists are created in the recording state.
+        context->commandList = device->lpVtbl->CreateCommandList(device, pool->type, context->allocator, NULL);
+        if (context->commandList == NULL || !context->commandList->lpVtbl->Close(context->commandList))
+            break;
+
+        if (pool->stateTable != NULL)
+        {
+            if (!ComputeStateTrackerInit(&context->tracker))
+                break;
+
+            // The prologue shares the allocator of the context, it is recorded at submit once the main command list is closed.
+            context->prologueList = device->lpVtbl->CreateCommandList(device, pool->type, context->allocator, NULL);
+            if (context->prologueList == NULL || !context->prologueList->lpVtbl->Close(context->prologueList))
+                break;
+        }
+
+        return context;
+
+    } while (false);
+
+    puts("Failed to create a recording context!");
+    ReleaseRecordingContext(context);
+    return NULL;
+}
+
+// Called with the mutex held
+static bool AddRecordingContext(ComputeCommandPool *pool, ComputeRecordingContext *context)
+{
+    if (pool->numContexts == pool->contextCapacity)
+    {
+        const uint32_t capacity = pool->contextCapacity * 2;
+        ComputeRecordingContext **contexts = realloc(pool->contexts, capacity * sizeof(*contexts));
+        if (contexts != NULL)
+            pool->contexts = contexts;
+        ComputeRecordingContext **freeContexts = realloc(pool->freeContexts, capacity * sizeof(*freeContexts));
+        if (freeContexts != NULL)
+            pool->freeContexts = freeContexts;
+        ComputeRecordingContext **finishedContexts = realloc(pool->finishedContexts, capacity * sizeof(*finishedContexts));
+        if (finishedContexts != NULL)
+            pool->finishedContexts = finishedContexts;
+        ComputeCommandList **submitLists = realloc(pool->submitLists, 2 * capacity * sizeof(*submitLists));
+        if (submitLists != NULL)
+            pool->submitLists = submitLists;
+
+        if (contexts == NULL || freeContexts == NULL || finishedContexts == NULL || submitLists == NULL)
+            return false;
+        pool->contextCapacity = capacity;
+    }
+
+    pool->contexts[pool->numContexts++] = context;
+    return true;
+}
+
+bool ComputeCommandPoolInit(ComputeCommandPool *pool, ComputeDevice *device, ComputeTimeline *timeline,
+    ComputeCommandListType type, ComputeResourceStateTable *stateTable)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->device = device;
+    pool->timeline = timeline;
+    pool->type = type;
+    pool->stateTable = stateTable;
+
+    pool->contextCapacity = 16;
+    pool->contexts = malloc(pool->contextCapacity * sizeof(*pool->contexts));
+    pool->freeContexts = malloc(pool->contextCapacity * sizeof(*pool->freeContexts));
+    pool->finishedContexts = malloc(pool->contextCapacity * sizeof(*pool->finishedContexts));
+    pool->submitLists = malloc(2 * pool->contextCapacity * sizeof(*pool->submitLists));
+    if (pool->contexts == NULL || pool->freeContexts == NULL || pool->finishedContexts == NULL || pool->submitLists == NULL)
+    {
+        free(pool->contexts);
+        free(pool->freeContexts);
+        free(pool->finishedContexts);
+        free(pool->submitLists);
+        memset(pool, 0, sizeof(*pool));
+        return false;
+    }
+
+    ComputeMutexInit(&pool->mutex);
+    return true;
+}
+
+void ComputeCommandPoolDestroy(ComputeCommandPool *pool)
+{
+    if (pool->contexts == NULL)
+        return;
+
+    for (uint32_t i = 0; i < pool->numContexts; i++)
+    {
+        ComputeRecordingContext *context = pool->contexts[i];
+        if (context->fenceValue != 0)
+            ComputeTimelineWait(pool->timeline, context->fenceValue, COMPUTE_WAIT_INFINITE);
+        ReleaseRecordingContext(context);
+    }
+
+    ComputeMutexDestroy(&pool->mutex);
+    free(pool->contexts);
+    free(pool->freeContexts);
+    free(pool->finishedContexts);
+    free(pool->submitLists);
+    memset(pool, 0, sizeof(*pool));
+}
+
+ComputeRecordingContext* ComputeCommandPoolAcquire(ComputeCommandPool *pool, uint64_t sortKey,
+    ComputePipelineState *pInitialState)
+{
+    ComputeRecordingContext *context = NULL;
+
+    // The free contexts are ordered by submission, so once one is still in flight, so are the ones after it.
+    ComputeMutexLock(&pool->mutex);
+    if (pool->numFreeContexts > 0 && ComputeTimelineIsComplete(pool->timeline, pool->freeContexts[0]->fenceValue))
+    {
+        context = pool->freeContexts[0];
+        pool->numFreeContexts--;
+        memmove(pool->freeContexts, pool->freeContexts + 1, pool->numFreeContexts * sizeof(*pool->freeContexts));
+    }
+    ComputeMutexUnlock(&pool->mutex);
+
+    if (context == NULL)
+    {
+        context = CreateRecordingContext(pool);
+        if (context == NULL)
+            return NULL;
+
+        ComputeMutexLock(&pool->mutex);
+        const bool added = AddRecordingContext(pool, context);
+        ComputeMutexUnlock(&pool->mutex);
+
+        if (!added)
+        {
+            puts("Failed to add a recording context!");
+            ReleaseRecordingContext(context);
+            return NULL;
+        }
+    }
+
+    context->sortKey = sortKey;
+
+    // The allocator is only used by its context, so it is reset without the lock.
+    if (!context->allocator->lpVtbl->Reset(context->allocator) ||
+        !context->commandList->lpVtbl->Reset(context->commandList, context->allocator, pInitialState))
+    {
+        ComputeMutexLock(&pool->mutex);
+        pool->freeContexts[pool->numFreeContexts++] = context;
+        ComputeMutexUnlock(&pool->mutex);
+        return NULL;
+    }
+
+    if (pool->stateTable != NULL)
+        ComputeStateTrackerReset(&context->tracker);
+
+    return context;
+}
+
+bool ComputeCommandPoolFinish(ComputeCommandPool *pool, ComputeRecordingContext *context)
+{
+    if (pool->stateTable != NULL)
+        ComputeStateTrackerFinish(&context->tracker, context->commandList);
+
+    const bool closed = context->commandList->lpVtbl->Close(context->commandList);
+
+    // A context that failed to record goes back to the free contexts. It has not been executed,
+    // so its last submission is still the one it waits for.
+    ComputeMutexLock(&pool->mutex);
+    if (closed)
+        pool->finishedContexts[pool->numFinishedContexts++] = context;
+    else
+        pool->freeContexts[pool->numFreeContexts++] = context;
+    ComputeMutexUnlock(&pool->mutex);
+
+    return closed;
+}
+
+uint64_t ComputeCommandPoolSubmit(ComputeCommandPool *pool)
+{
+    ComputeMutexLock(&pool->mutex);
+
+    const uint32_t numContexts = pool->numFinishedContexts;
+    ComputeRecordingContext **contexts = pool->finishedContexts;
+
+    // Insertion sort on the sort keys, the lists are finished roughly in order already.
+    for (uint32_t i = 1; i < numContexts; i++)
+    {
+        ComputeRecordingContext *context = contexts[i];
+        uint32_t j = i;
+        for (; j > 0 && contexts[j - 1]->sortKey > context->sortKey; j--)
+            contexts[j] = contexts[j - 1];
+        contexts[j] = context;
+    }
+
+    uint32_t numCommandLists = 0;
+    bool result = numContexts > 0;
+
+    for (uint32_t i = 0; i < numContexts && result; i++)
+    {
+        ComputeRecordingContext *context = contexts[i];
+
+        // The lists are resolved in execution order, so each one starts from the states the previous ones end with.
+        if (pool->stateTable != NULL)
+        {
+            const ComputeResourceBarrier *barriers;
+            const uint32_t numBarriers = ComputeStateTrackerResolve(&context->tracker, pool->stateTable, &barriers);
+            if (numBarriers > 0)
+            {
+                ComputeCommandList *prologueList = context->prologueList;
+                if (!prologueList->lpVtbl->Reset(prologueList, context->allocator, NULL))
+                {
+                    result = false;
+                    break;
+                }
+                prologueList->lpVtbl->ResourceBarrier(prologueList, numBarriers, barriers);
+                if (!prologueList->lpVtbl->Close(prologueList))
+                {
+                    result = false;
+                    break;
+                }
+                pool->submitLists[numCommandLists++] = prologueList;
+            }
+        }
+        pool->submitLists[numCommandLists++] = context->commandList;
+    }
+
+    uint64_t value = 0;
+    if (result)
+    {
+        COMPUTE_TRACE_CPU_BEGIN(traceScope, "Submit");
+        ComputeCommandQueue *queue = pool->timeline->queue;
+        queue->lpVtbl->ExecuteCommandLists(queue, numCommandLists, pool->submitLists);
+
+        value = ComputeTimelineSignal(pool->timeline);
+        COMPUTE_TRACE_CPU_END(traceScope);
+    }
+
+    // On failure the lists have not been executed, and their contexts keep waiting for their previous submission.
+    for (uint32_t i = 0; i < numContexts; i++)
+    {
+        if (value != 0)
+            contexts[i]->fenceValue = value;
+        pool->freeContexts[pool->numFreeContexts++] = contexts[i];
+    }
+    pool->numFinishedContexts = 0;
+
+    ComputeMutexUnlock(&pool->mutex);
+
+    return value;
+}
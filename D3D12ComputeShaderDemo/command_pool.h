@@ -0,0 +1,76 @@
+#ifndef COMMAND_POOL_H
+#define COMMAND_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "compute_timeline.h"
+#include "resource_states.h"
+
+// The command allocator and the command list recorded by one thread
+typedef struct ComputeRecordingContext
+{
+    ComputeCommandAllocator *allocator;
+    ComputeCommandList *commandList;
+    // With state tracking, the states needed by the command list,
+    // and the list executed before it with the barriers from the states left by the lists before it
+    ComputeStateTracker tracker;
+    ComputeCommandList *prologueList;
+    // The timeline value signaled after the context's last submission, 0 if it has never been submitted
+    uint64_t fenceValue;
+    // The position of the command list in its submission
+    uint64_t sortKey;
+} ComputeRecordingContext;
+
+// Hands every recording thread an allocator and a command list of its own, so command lists are recorded in parallel.
+// The contexts are recycled once the timeline has passed their last submission.
+// A new context is created when none is free, so the pool grows to the number of threads recording at the same time
+// times the number of submissions in flight, and never blocks a recording thread.
+// Acquire and Finish may be called from any thread. Submit gathers all the finished command lists
+// into a single ExecuteCommandLists call, from the thread that owns the queue.
+typedef struct ComputeCommandPool
+{
+    ComputeDevice *device;
+    ComputeTimeline *timeline;
+    ComputeCommandListType type;
+    // The states shared by the submissions, NULL without state tracking
+    ComputeResourceStateTable *stateTable;
+    ComputeMutex mutex;
+    // All the contexts created, the ones waiting to be reused, oldest submission first,
+    // and the finished ones waiting for Submit
+    ComputeRecordingContext **contexts;
+    ComputeRecordingContext **freeContexts;
+    ComputeRecordingContext **finishedContexts;
+    uint32_t numContexts;
+    uint32_t numFreeContexts;
+    uint32_t numFinishedContexts;
+    uint32_t contextCapacity;
+    // The command lists of the submission being built, twice the capacity with the prologues
+    ComputeCommandList **submitLists;
+} ComputeCommandPool;
+
+// stateTable may be NULL, otherwise the resource states are tracked in the command lists like in the frame ring,
+// and resolved against the table at submit.
+extern bool ComputeCommandPoolInit(ComputeCommandPool *pool, ComputeDevice *device, ComputeTimeline *timeline,
+    ComputeCommandListType type, ComputeResourceStateTable *stateTable);
+// Waits for all the submitted contexts before releasing them
+extern void ComputeCommandPoolDestroy(ComputeCommandPool *pool);
+
+// Take a free context and reset its command list for recording.
+// Command lists are executed in the increasing order of their sort keys, whatever the order they were finished in.
+// Returns NULL on failure.
+extern ComputeRecordingContext* ComputeCommandPoolAcquire(ComputeCommandPool *pool, uint64_t sortKey,
+    ComputePipelineState *pInitialState);
+
+// Close the command list of the context and queue it for the next submission
+extern bool ComputeCommandPoolFinish(ComputeCommandPool *pool, ComputeRecordingContext *context);
+
+// Execute the finished command lists with one ExecuteCommandLists call, then signal the timeline.
+// All the acquired contexts must have been finished.
+// Returns the fence value that marks the completion of the command lists, or 0 on failure or if there are none.
+extern uint64_t ComputeCommandPoolSubmit(ComputeCommandPool *pool);
+
+#endif // COMMAND_POOL_H
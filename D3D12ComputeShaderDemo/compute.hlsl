@@ -1,12 +1,63 @@
-
-StructuredBuffer<int> srcBuffer: register(t0);      // SRV
-RWStructuredBuffer<int> dstBuffer: register(u0);    // UAV
-
-[numthreads(1024, 1, 1)]
-void CSMain(uint3 groupID : SV_GroupID, uint3 tid : SV_DispatchThreadID, uint3 localTID : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)
-{
-    const int index = tid.x;
-
-    dstBuffer[index] = srcBuffer[index] + 10;
-}
-
+// Specialization macros, set through D3D_SHADER_MACRO when the variant is compiled
+#ifndef OPERAND
+#define OPERAND     10
+#endif
+#ifndef GROUP_SIZE
+#define GROUP_SIZE  1024
+#endif
+#ifndef ELEM_TYPE
+#define ELEM_TYPE   int
+#endif
+// Number of elements processed per thread
+#ifndef UNROLL
+#define UNROLL      1
+#endif
+
+StructuredBuffer<ELEM_TYPE> srcBuffer: register(t0);      // SRV
+RWStructuredBuffer<ELEM_TYPE> dstBuffer: register(u0);    // UAV
+
+// Root constants set by ComputeDispatchElements for each Dispatch
+cbuffer DispatchConstants : register(b0)
+{
+    // The number of valid elements, the tail of the last group is masked off
+    uint NumElements;
+    // The linear index of the first group of this Dispatch, when a large job is split into several
+    uint BaseGroup;
+    // The width of the grid, when a large job is folded into 2D
+    uint GroupsPerRow;
+};
+
+// The operand of CSMainDynamic, set as a root constant for each Dispatch instead of being compiled in,
+// so that one pipeline serves every operand
+cbuffer OperandConstants : register(b1)
+{
+    ELEM_TYPE Operand;
+};
+
+// Each group covers GROUP_SIZE * UNROLL consecutive elements, and the threads of the group
+// access consecutive elements in each iteration.
+void AddOperand(uint3 groupID, uint3 localTID, ELEM_TYPE operand)
+{
+    const uint group = BaseGroup + groupID.y * GroupsPerRow + groupID.x;
+    const uint index = group * (GROUP_SIZE * UNROLL) + localTID.x;
+
+    [unroll]
+    for (uint i = 0; i < UNROLL; i++)
+    {
+        if (index + i * GROUP_SIZE < NumElements)
+            dstBuffer[index + i * GROUP_SIZE] = srcBuffer[index + i * GROUP_SIZE] + operand;
+    }
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain(uint3 groupID : SV_GroupID, uint3 tid : SV_DispatchThreadID, uint3 localTID : SV_GroupThreadID, uint groupIndex : SV_GroupIndex)
+{
+    AddOperand(groupID, localTID, (ELEM_TYPE)OPERAND);
+}
+
+// CSMain with the operand of the OperandConstants cbuffer, OPERAND is ignored
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMainDynamic(uint3 groupID : SV_GroupID, uint3 localTID : SV_GroupThreadID)
+{
+    AddOperand(groupID, localTID, Operand);
+}
@@ -0,0 +1,609 @@
+#ifndef COMPUTE_BACKEND_H
+#define COMPUTE_BACKEND_H
+
+// The device abstraction used by the sample.
+// It mirrors the subset of the Direct3D 12 API that the compute pipeline needs, in the same C COM style:
+// every object starts with a lpVtbl pointer and is used as object->lpVtbl->Method(object, ...).
+// There are two implementations, one that forwards to Direct3D 12 (Windows only)
+// and one that executes the compute pipeline on the host CPU (portable).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_thread.h"
+
+typedef struct ComputeDevice ComputeDevice;
+typedef struct ComputeBlob ComputeBlob;
+typedef struct ComputeResource ComputeResource;
+typedef struct ComputeHeap ComputeHeap;
+typedef struct ComputeDescriptorHeap ComputeDescriptorHeap;
+typedef struct ComputeRootSignature ComputeRootSignature;
+typedef struct ComputePipelineState ComputePipelineState;
+typedef struct ComputeCommandAllocator ComputeCommandAllocator;
+typedef struct ComputeCommandList ComputeCommandList;
+typedef struct ComputeCommandQueue ComputeCommandQueue;
+typedef struct ComputeFence ComputeFence;
+typedef struct ComputeQueryHeap ComputeQueryHeap;
+
+typedef enum ComputeBackendType
+{
+    COMPUTE_BACKEND_D3D12,
+    COMPUTE_BACKEND_CPU
+} ComputeBackendType;
+
+// The enumeration values below are identical to their D3D12 counterparts,
+// so the D3D12 backend passes them through unchanged.
+
+typedef enum ComputeHeapType
+{
+    COMPUTE_HEAP_TYPE_DEFAULT = 1,
+    COMPUTE_HEAP_TYPE_UPLOAD = 2,
+    COMPUTE_HEAP_TYPE_READBACK = 3
+} ComputeHeapType;
+
+typedef enum ComputeResourceFlags
+{
+    COMPUTE_RESOURCE_FLAG_NONE = 0,
+    COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4
+} ComputeResourceFlags;
+
+typedef enum ComputeResourceStates
+{
+    COMPUTE_RESOURCE_STATE_COMMON = 0,
+    COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+    COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    COMPUTE_RESOURCE_STATE_COPY_DEST = 0x400,
+    COMPUTE_RESOURCE_STATE_COPY_SOURCE = 0x800,
+    COMPUTE_RESOURCE_STATE_GENERIC_READ = 0xac3
+} ComputeResourceStates;
+
+typedef enum ComputeCommandListType
+{
+    COMPUTE_COMMAND_LIST_TYPE_DIRECT = 0,
+    COMPUTE_COMMAND_LIST_TYPE_COMPUTE = 2,
+    COMPUTE_COMMAND_LIST_TYPE_COPY = 3
+} ComputeCommandListType;
+
+typedef enum ComputeResourceBarrierType
+{
+    COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+    COMPUTE_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+    COMPUTE_RESOURCE_BARRIER_TYPE_UAV = 2
+} ComputeResourceBarrierType;
+
+typedef enum ComputeResourceBarrierFlags
+{
+    COMPUTE_RESOURCE_BARRIER_FLAG_NONE = 0,
+    COMPUTE_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+    COMPUTE_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2
+} ComputeResourceBarrierFlags;
+
+typedef enum ComputeRootParameterType
+{
+    COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+    COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS = 1,
+    // Root descriptors: a buffer bound by its GPU virtual address, without any view in a descriptor heap.
+    // Only structured and raw buffers can be bound this way, and their accesses are not bounds checked.
+    COMPUTE_ROOT_PARAMETER_TYPE_SRV = 3,
+    COMPUTE_ROOT_PARAMETER_TYPE_UAV = 4
+} ComputeRootParameterType;
+
+typedef enum ComputeDescriptorRangeType
+{
+    COMPUTE_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+    COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV = 1
+} ComputeDescriptorRangeType;
+
+typedef enum ComputeQueryHeapType
+{
+    COMPUTE_QUERY_HEAP_TYPE_TIMESTAMP = 1,
+    // The timestamps of copy queues live in a heap type of their own
+    COMPUTE_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP = 5
+} ComputeQueryHeapType;
+
+typedef enum ComputeQueryType
+{
+    COMPUTE_QUERY_TYPE_TIMESTAMP = 2
+} ComputeQueryType;
+
+// The formats of the typed buffer views, and R32_TYPELESS for the raw ones
+typedef enum ComputeFormat
+{
+    COMPUTE_FORMAT_UNKNOWN = 0,
+    COMPUTE_FORMAT_R32G32B32A32_FLOAT = 2,
+    COMPUTE_FORMAT_R32G32B32A32_UINT = 3,
+    COMPUTE_FORMAT_R32G32_FLOAT = 16,
+    COMPUTE_FORMAT_R32G32_UINT = 17,
+    COMPUTE_FORMAT_R32_TYPELESS = 39,
+    COMPUTE_FORMAT_R32_FLOAT = 41,
+    COMPUTE_FORMAT_R32_UINT = 42,
+    COMPUTE_FORMAT_R32_SINT = 43,
+    COMPUTE_FORMAT_R16_FLOAT = 54,
+    COMPUTE_FORMAT_R16_UINT = 57,
+    COMPUTE_FORMAT_R16_SINT = 59
+} ComputeFormat;
+
+// The flags of the SRVs and UAVs of buffers
+typedef enum ComputeBufferViewFlags
+{
+    COMPUTE_BUFFER_VIEW_FLAG_NONE = 0,
+    COMPUTE_BUFFER_VIEW_FLAG_RAW = 0x1
+} ComputeBufferViewFlags;
+
+// Shader compile flags
+typedef enum ComputeCompileFlags
+{
+    COMPUTE_COMPILE_DEBUG = 0x1,
+    COMPUTE_COMPILE_SKIP_OPTIMIZATION = 0x4,
+    COMPUTE_COMPILE_OPTIMIZATION_LEVEL3 = 0x8000
+} ComputeCompileFlags;
+
+// The maximum number of t# and u# registers a kernel may use
+#define COMPUTE_MAX_SHADER_REGISTERS    8
+
+// The maximum number of resources a kernel may bind, the cbuffers included
+#define COMPUTE_MAX_SHADER_BINDINGS     (3 * COMPUTE_MAX_SHADER_REGISTERS)
+
+// The maximum number of root parameters of a root signature
+#define COMPUTE_MAX_ROOT_PARAMETERS     16
+
+// The maximum number of 32-bit root constants of a root signature
+#define COMPUTE_MAX_ROOT_CONSTANTS      64
+
+// The size of a root signature in 32-bit values: a root constant costs 1, a table 1 and a root descriptor 2
+#define COMPUTE_MAX_ROOT_SIGNATURE_SIZE 64
+
+// The maximum number of thread groups per dimension of a Dispatch
+#define COMPUTE_MAX_DISPATCH_GROUPS     65535
+
+// The alignment of the heap offsets of placed resources
+#define COMPUTE_PLACEMENT_ALIGNMENT     65536
+
+// Layout compatible with D3D12_RANGE
+typedef struct ComputeRange
+{
+    size_t Begin;
+    size_t End;
+} ComputeRange;
+
+typedef struct ComputeCPUDescriptorHandle
+{
+    size_t ptr;
+} ComputeCPUDescriptorHandle;
+
+typedef struct ComputeGPUDescriptorHandle
+{
+    uint64_t ptr;
+} ComputeGPUDescriptorHandle;
+
+// The address of a buffer as seen by the kernels, for the root descriptors
+typedef uint64_t ComputeGPUVirtualAddress;
+
+// Layout compatible with D3D_SHADER_MACRO. Arrays of macros are terminated with a {NULL, NULL} entry.
+typedef struct ComputeShaderMacro
+{
+    const char *Name;
+    const char *Definition;
+} ComputeShaderMacro;
+
+// Only buffer resources are supported
+typedef struct ComputeResourceDesc
+{
+    uint64_t Width;
+    ComputeResourceFlags Flags;
+} ComputeResourceDesc;
+
+// Only buffers may be placed in heaps
+typedef struct ComputeHeapDesc
+{
+    uint64_t SizeInBytes;
+    ComputeHeapType Type;
+} ComputeHeapDesc;
+
+typedef struct ComputeQueryHeapDesc
+{
+    ComputeQueryHeapType Type;
+    uint32_t Count;
+} ComputeQueryHeapDesc;
+
+typedef struct ComputeDescriptorHeapDesc
+{
+    uint32_t NumDescriptors;
+    bool ShaderVisible;
+} ComputeDescriptorHeapDesc;
+
+// Describes a buffer view (SRV or UAV), which is either:
+// - structured: a StructureByteStride, with the format UNKNOWN,
+// - typed: the Format of the elements, with no stride,
+// - raw: the format R32_TYPELESS with the RAW flag, the elements being 32-bit words.
+// The zero-initialized members of a structured view may be left out.
+typedef struct ComputeBufferViewDesc
+{
+    uint64_t FirstElement;
+    uint32_t NumElements;
+    uint32_t StructureByteStride;
+    ComputeFormat Format;
+    ComputeBufferViewFlags Flags;
+} ComputeBufferViewDesc;
+
+typedef struct ComputeDescriptorRange
+{
+    ComputeDescriptorRangeType RangeType;
+    uint32_t NumDescriptors;
+    uint32_t BaseShaderRegister;
+} ComputeDescriptorRange;
+
+typedef struct ComputeRootDescriptorTable
+{
+    uint32_t NumDescriptorRanges;
+    const ComputeDescriptorRange *pDescriptorRanges;
+} ComputeRootDescriptorTable;
+
+// 32-bit constants bound to the b# register of a cbuffer
+typedef struct ComputeRootConstants
+{
+    uint32_t ShaderRegister;
+    uint32_t Num32BitValues;
+} ComputeRootConstants;
+
+// A root SRV or UAV bound to a t# or u# register
+typedef struct ComputeRootDescriptor
+{
+    uint32_t ShaderRegister;
+} ComputeRootDescriptor;
+
+typedef struct ComputeRootParameter
+{
+    ComputeRootParameterType ParameterType;
+    union
+    {
+        ComputeRootDescriptorTable DescriptorTable;
+        ComputeRootConstants Constants;
+        ComputeRootDescriptor Descriptor;
+    };
+} ComputeRootParameter;
+
+typedef struct ComputeRootSignatureDesc
+{
+    uint32_t NumParameters;
+    const ComputeRootParameter *pParameters;
+} ComputeRootSignatureDesc;
+
+typedef struct ComputeShaderBytecode
+{
+    const void *pShaderBytecode;
+    size_t BytecodeLength;
+} ComputeShaderBytecode;
+
+// The kinds of resources a shader binds to its registers
+typedef enum ComputeShaderInputType
+{
+    // A cbuffer on a b# register
+    COMPUTE_SHADER_INPUT_CBUFFER,
+    // Buffer<T> on a t# register, which only a typed view in a descriptor table can bind
+    COMPUTE_SHADER_INPUT_TYPED_SRV,
+    // StructuredBuffer<T> and ByteAddressBuffer on a t# register
+    COMPUTE_SHADER_INPUT_STRUCTURED_SRV,
+    COMPUTE_SHADER_INPUT_RAW_SRV,
+    // RWBuffer<T>, RWStructuredBuffer<T> and RWByteAddressBuffer on a u# register
+    COMPUTE_SHADER_INPUT_TYPED_UAV,
+    COMPUTE_SHADER_INPUT_STRUCTURED_UAV,
+    COMPUTE_SHADER_INPUT_RAW_UAV,
+    // Textures, samplers, append and consume buffers, and the buffers with counters
+    COMPUTE_SHADER_INPUT_UNSUPPORTED
+} ComputeShaderInputType;
+
+// A register used by the shader, the arrays of resources taking one binding per register
+typedef struct ComputeShaderInputBinding
+{
+    ComputeShaderInputType Type;
+    uint32_t BindPoint;
+    uint32_t Space;
+    // For a cbuffer, the size in bytes up to the end of its last variable
+    uint32_t Size;
+} ComputeShaderInputBinding;
+
+// What ComputeDevice::ReflectShader extracts from the bytecode
+typedef struct ComputeShaderReflection
+{
+    // The [numthreads] attribute
+    uint32_t ThreadGroupSize[3];
+    // The resources used by the entry point. Those declared but not used are left out by the compiler.
+    uint32_t NumBoundResources;
+    ComputeShaderInputBinding BoundResources[COMPUTE_MAX_SHADER_BINDINGS];
+} ComputeShaderReflection;
+
+// A blob returned by ComputePipelineState::GetCachedBlob
+typedef struct ComputeCachedPipelineState
+{
+    const void *pCachedBlob;
+    size_t CachedBlobSizeInBytes;
+} ComputeCachedPipelineState;
+
+typedef struct ComputePipelineStateDesc
+{
+    ComputeRootSignature *pRootSignature;
+    ComputeShaderBytecode CS;
+    // Optional. Creation fails if the blob does not match the device or the description.
+    ComputeCachedPipelineState CachedPSO;
+} ComputePipelineStateDesc;
+
+typedef struct ComputeResourceBarrier
+{
+    ComputeResourceBarrierType Type;
+    ComputeResourceBarrierFlags Flags;
+    // For UAV barriers, NULL means any UAV access.
+    // For aliasing barriers, the resource taking over the memory; NULL means any placed resource.
+    ComputeResource *pResource;
+    ComputeResourceStates StateBefore;
+    ComputeResourceStates StateAfter;
+    // For aliasing barriers, the resource that gives up the memory; NULL means any placed resource
+    ComputeResource *pResourceBefore;
+} ComputeResourceBarrier;
+
+// ---- Blob ----
+
+typedef struct ComputeBlobVtbl
+{
+    void (*Release)(ComputeBlob *This);
+    void* (*GetBufferPointer)(ComputeBlob *This);
+    size_t (*GetBufferSize)(ComputeBlob *This);
+} ComputeBlobVtbl;
+
+struct ComputeBlob
+{
+    const ComputeBlobVtbl *lpVtbl;
+};
+
+// ---- Resource ----
+
+typedef struct ComputeResourceVtbl
+{
+    void (*Release)(ComputeResource *This);
+    void (*GetDesc)(ComputeResource *This, ComputeResourceDesc *pDesc);
+    bool (*Map)(ComputeResource *This, const ComputeRange *pReadRange, void **ppData);
+    void (*Unmap)(ComputeResource *This, const ComputeRange *pWrittenRange);
+    // The address of the start of the buffer, for the root descriptors
+    ComputeGPUVirtualAddress (*GetGPUVirtualAddress)(ComputeResource *This);
+} ComputeResourceVtbl;
+
+struct ComputeResource
+{
+    const ComputeResourceVtbl *lpVtbl;
+};
+
+// ---- Heap ----
+
+typedef struct ComputeHeapVtbl
+{
+    void (*Release)(ComputeHeap *This);
+    void (*GetDesc)(ComputeHeap *This, ComputeHeapDesc *pDesc);
+} ComputeHeapVtbl;
+
+// The resources placed in a heap hold a reference to it, so it may be released before them.
+struct ComputeHeap
+{
+    const ComputeHeapVtbl *lpVtbl;
+};
+
+// ---- Descriptor heap ----
+
+typedef struct ComputeDescriptorHeapVtbl
+{
+    void (*Release)(ComputeDescriptorHeap *This);
+    ComputeCPUDescriptorHandle (*GetCPUDescriptorHandleForHeapStart)(ComputeDescriptorHeap *This);
+    ComputeGPUDescriptorHandle (*GetGPUDescriptorHandleForHeapStart)(ComputeDescriptorHeap *This);
+} ComputeDescriptorHeapVtbl;
+
+struct ComputeDescriptorHeap
+{
+    const ComputeDescriptorHeapVtbl *lpVtbl;
+};
+
+// ---- Query heap ----
+
+typedef struct ComputeQueryHeapVtbl
+{
+    void (*Release)(ComputeQueryHeap *This);
+} ComputeQueryHeapVtbl;
+
+struct ComputeQueryHeap
+{
+    const ComputeQueryHeapVtbl *lpVtbl;
+};
+
+// ---- Root signature and pipeline state ----
+
+typedef struct ComputeRootSignatureVtbl
+{
+    void (*Release)(ComputeRootSignature *This);
+    // A hash of the layout of the root signature, part of the key of the pipeline state blobs created with it
+    uint64_t (*GetHash)(ComputeRootSignature *This);
+} ComputeRootSignatureVtbl;
+
+struct ComputeRootSignature
+{
+    const ComputeRootSignatureVtbl *lpVtbl;
+};
+
+typedef struct ComputePipelineStateVtbl
+{
+    void (*Release)(ComputePipelineState *This);
+    // Serialize the pipeline state so that it can be recreated faster with ComputePipelineStateDesc::CachedPSO
+    bool (*GetCachedBlob)(ComputePipelineState *This, ComputeBlob **ppBlob);
+} ComputePipelineStateVtbl;
+
+struct ComputePipelineState
+{
+    const ComputePipelineStateVtbl *lpVtbl;
+};
+
+// ---- Command allocator and command list ----
+
+typedef struct ComputeCommandAllocatorVtbl
+{
+    void (*Release)(ComputeCommandAllocator *This);
+    // Reuse the memory of the recorded commands. Only valid after the commands finished execution.
+    bool (*Reset)(ComputeCommandAllocator *This);
+} ComputeCommandAllocatorVtbl;
+
+struct ComputeCommandAllocator
+{
+    const ComputeCommandAllocatorVtbl *lpVtbl;
+};
+
+typedef struct ComputeCommandListVtbl
+{
+    void (*Release)(ComputeCommandList *This);
+    bool (*Close)(ComputeCommandList *This);
+    bool (*Reset)(ComputeCommandList *This, ComputeCommandAllocator *pAllocator, ComputePipelineState *pInitialState);
+    void (*SetPipelineState)(ComputeCommandList *This, ComputePipelineState *pPipelineState);
+    void (*SetComputeRootSignature)(ComputeCommandList *This, ComputeRootSignature *pRootSignature);
+    void (*SetDescriptorHeaps)(ComputeCommandList *This, uint32_t NumDescriptorHeaps, ComputeDescriptorHeap *const *ppDescriptorHeaps);
+    void (*SetComputeRootDescriptorTable)(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUDescriptorHandle BaseDescriptor);
+    void (*SetComputeRoot32BitConstants)(ComputeCommandList *This, uint32_t RootParameterIndex, uint32_t Num32BitValuesToSet,
+        const void *pSrcData, uint32_t DestOffsetIn32BitValues);
+    // Bind the buffer at BufferLocation to a root descriptor: a multiple of 4 bytes, past which the kernel may access the whole buffer.
+    void (*SetComputeRootShaderResourceView)(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation);
+    void (*SetComputeRootUnorderedAccessView)(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation);
+    void (*Dispatch)(ComputeCommandList *This, uint32_t ThreadGroupCountX, uint32_t ThreadGroupCountY, uint32_t ThreadGroupCountZ);
+    void (*ResourceBarrier)(ComputeCommandList *This, uint32_t NumBarriers, const ComputeResourceBarrier *pBarriers);
+    void (*CopyBufferRegion)(ComputeCommandList *This, ComputeResource *pDstBuffer, uint64_t DstOffset,
+        ComputeResource *pSrcBuffer, uint64_t SrcOffset, uint64_t NumBytes);
+    void (*CopyResource)(ComputeCommandList *This, ComputeResource *pDstResource, ComputeResource *pSrcResource);
+    // Write the timestamp of the queue to the query once the commands before it have completed
+    void (*EndQuery)(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t Index);
+    // Copy the queries as uint64_t values to the buffer, which must be in the copy destination state.
+    // The offset is a multiple of 8.
+    void (*ResolveQueryData)(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t StartIndex,
+        uint32_t NumQueries, ComputeResource *pDestinationBuffer, uint64_t AlignedDestinationBufferOffset);
+} ComputeCommandListVtbl;
+
+struct ComputeCommandList
+{
+    const ComputeCommandListVtbl *lpVtbl;
+};
+
+// ---- Command queue and fence ----
+
+typedef struct ComputeCommandQueueVtbl
+{
+    void (*Release)(ComputeCommandQueue *This);
+    void (*ExecuteCommandLists)(ComputeCommandQueue *This, uint32_t NumCommandLists, ComputeCommandList *const *ppCommandLists);
+    // Update the fence to Value when the queue reaches this point
+    bool (*Signal)(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value);
+    // Make the queue wait until the fence reaches Value
+    bool (*Wait)(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value);
+    // The frequency of the timestamps written by the queue, in ticks per second
+    bool (*GetTimestampFrequency)(ComputeCommandQueue *This, uint64_t *pFrequency);
+    // Sample the timestamp counter of the queue and the CPU time at the same moment.
+    // The CPU time is on the clock of ComputeGetTimeNanoseconds.
+    bool (*GetClockCalibration)(ComputeCommandQueue *This, uint64_t *pGpuTimestamp, uint64_t *pCpuTimestamp);
+} ComputeCommandQueueVtbl;
+
+struct ComputeCommandQueue
+{
+    const ComputeCommandQueueVtbl *lpVtbl;
+};
+
+typedef struct ComputeFenceVtbl
+{
+    void (*Release)(ComputeFence *This);
+    uint64_t (*GetCompletedValue)(ComputeFence *This);
+    // The event is set once the fence reaches Value
+    bool (*SetEventOnCompletion)(ComputeFence *This, uint64_t Value, ComputeEvent hEvent);
+    // Set the fence value from the host side
+    bool (*Signal)(ComputeFence *This, uint64_t Value);
+} ComputeFenceVtbl;
+
+struct ComputeFence
+{
+    const ComputeFenceVtbl *lpVtbl;
+};
+
+// ---- Device ----
+
+typedef struct ComputeDeviceVtbl
+{
+    void (*Release)(ComputeDevice *This);
+    ComputeBackendType (*GetBackendType)(ComputeDevice *This);
+    // Compile a compute shader from a HLSL file.
+    // The CPU backend resolves the entry point to its native implementation instead.
+    bool (*CompileShaderFromFile)(ComputeDevice *This, const char *pFileName, const ComputeShaderMacro *pDefines,
+        const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode);
+    // Reflect the bytecode returned by CompileShaderFromFile
+    bool (*ReflectShader)(ComputeDevice *This, const ComputeShaderBytecode *pBytecode, ComputeShaderReflection *pReflection);
+    ComputeResource* (*CreateCommittedResource)(ComputeDevice *This, ComputeHeapType HeapType, const ComputeResourceDesc *pDesc,
+        ComputeResourceStates InitialResourceState);
+    ComputeHeap* (*CreateHeap)(ComputeDevice *This, const ComputeHeapDesc *pDesc);
+    // Create a buffer in the memory of the heap at HeapOffset, a multiple of COMPUTE_PLACEMENT_ALIGNMENT.
+    // Unlike committed resources, the initial content is undefined. Placed resources may overlap each other,
+    // and an aliasing barrier is needed before a resource accesses the memory last used by another one.
+    ComputeResource* (*CreatePlacedResource)(ComputeDevice *This, ComputeHeap *pHeap, uint64_t HeapOffset,
+        const ComputeResourceDesc *pDesc, ComputeResourceStates InitialState);
+    ComputeDescriptorHeap* (*CreateDescriptorHeap)(ComputeDevice *This, const ComputeDescriptorHeapDesc *pDesc);
+    uint32_t (*GetDescriptorHandleIncrementSize)(ComputeDevice *This);
+    void (*CreateShaderResourceView)(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+        ComputeCPUDescriptorHandle DestDescriptor);
+    void (*CreateUnorderedAccessView)(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+        ComputeCPUDescriptorHandle DestDescriptor);
+    // Copy descriptors between heaps on the CPU timeline. A NULL array of range sizes means ranges of one descriptor.
+    // The sources must not be in a shader visible heap.
+    void (*CopyDescriptors)(ComputeDevice *This, uint32_t NumDestDescriptorRanges, const ComputeCPUDescriptorHandle *pDestDescriptorRangeStarts,
+        const uint32_t *pDestDescriptorRangeSizes, uint32_t NumSrcDescriptorRanges, const ComputeCPUDescriptorHandle *pSrcDescriptorRangeStarts,
+        const uint32_t *pSrcDescriptorRangeSizes);
+    ComputeRootSignature* (*CreateRootSignature)(ComputeDevice *This, const ComputeRootSignatureDesc *pDesc);
+    ComputePipelineState* (*CreateComputePipelineState)(ComputeDevice *This, const ComputePipelineStateDesc *pDesc);
+    ComputeCommandQueue* (*CreateCommandQueue)(ComputeDevice *This, ComputeCommandListType Type);
+    ComputeCommandAllocator* (*CreateCommandAllocator)(ComputeDevice *This, ComputeCommandListType Type);
+    ComputeCommandList* (*CreateCommandList)(ComputeDevice *This, ComputeCommandListType Type,
+        ComputeCommandAllocator *pCommandAllocator, ComputePipelineState *pInitialState);
+    ComputeFence* (*CreateFence)(ComputeDevice *This, uint64_t InitialValue);
+    // Fails when the device does not support the type, which may be the case of the copy queue timestamps
+    ComputeQueryHeap* (*CreateQueryHeap)(ComputeDevice *This, const ComputeQueryHeapDesc *pDesc);
+} ComputeDeviceVtbl;
+
+struct ComputeDevice
+{
+    const ComputeDeviceVtbl *lpVtbl;
+};
+
+// ---- Device creation ----
+
+typedef struct ComputeCPUDeviceDesc
+{
+    // The number of threads that execute the thread groups of a dispatch. 0 means one per logical processor.
+    uint32_t NumThreads;
+    // The simulated speed in percent of the host: each command list takes 100 / SpeedPercent times as long to execute,
+    // so several devices of different speeds can be tried on one machine. 0 means 100.
+    uint32_t SpeedPercent;
+} ComputeCPUDeviceDesc;
+
+// Create the CPU executing device. pDesc may be NULL.
+extern ComputeDevice* CreateCPUComputeDevice(const ComputeCPUDeviceDesc *pDesc);
+
+#ifdef _WIN32
+// The maximum length of an adapter description, in UTF-8
+#define COMPUTE_ADAPTER_DESCRIPTION_SIZE    256
+
+typedef struct ComputeAdapterDesc
+{
+    char Description[COMPUTE_ADAPTER_DESCRIPTION_SIZE];
+    uint64_t DedicatedVideoMemory;
+    // A software adapter, such as WARP
+    bool Software;
+} ComputeAdapterDesc;
+
+// Create the D3D12 device on the WARP adapter
+extern ComputeDevice* CreateD3D12ComputeDevice(void);
+
+// Enumerate the adapters that support Direct3D 12, in the DXGI order. Fills up to maxAdapters descriptions.
+// Returns the number of adapters, which may be larger than maxAdapters.
+extern uint32_t EnumD3D12ComputeAdapters(ComputeAdapterDesc *pDescs, uint32_t maxAdapters);
+
+// Create the D3D12 device on the adapter of the index in EnumD3D12ComputeAdapters
+extern ComputeDevice* CreateD3D12ComputeDeviceOnAdapter(uint32_t adapterIndex);
+#endif
+
+#endif // COMPUTE_BACKEND_H
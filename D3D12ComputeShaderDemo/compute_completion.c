@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_completion.h"
+#include "compute_trace.h"
+
+struct ComputeFuture
+{
+    uint64_t fenceValue;
+    ComputeCompletionCallback callback;
+    void *context;
+    ComputeCompletionWatcher *watcher;
+    // One reference for the caller, one for the watcher until the future is ready
+    volatile int64_t refCount;
+    // Written under the mutex of the watcher
+    bool ready;
+    // The next pending future of the timeline, then the next one to complete
+    ComputeFuture *next;
+};
+
+static void ReleaseFuture(ComputeFuture *future)
+{
+    if (ComputeAtomicAdd64(&future->refCount, -1) == 1)
+        free(future);
+}
+
+// Move the futures of the values reached to the list, in fence value order
+static ComputeFuture** CollectCompleted(ComputeCompletionTimeline *entry, ComputeFuture **link)
+{
+    if (entry->head == NULL)
+        return link;
+
+    const uint64_t completedValue = ComputeTimelineGetCompletedValue(entry->timeline);
+    if (entry->armedValue != 0 && entry->armedValue <= completedValue)
+        entry->armedValue = 0;
+
+    while (entry->head != NULL && entry->head->fenceValue <= completedValue)
+    {
+        ComputeFuture *future = entry->head;
+        entry->head = future->next;
+        future->next = NULL;
+        *link = future;
+        link = &future->next;
+    }
+    if (entry->head == NULL)
+        entry->tail = NULL;
+
+    return link;
+}
+
+// Make the fence set the event when it reaches the lowest pending value.
+// A value armed earlier is kept, unless a lower one has been watched since.
+static bool ArmTimeline(ComputeCompletionWatcher *watcher, ComputeCompletionTimeline *entry)
+{
+    if (entry->head == NULL)
+        return true;
+    if (entry->armedValue != 0 && entry->armedValue <= entry->head->fenceValue)
+        return true;
+
+    ComputeFence *fence = entry->timeline->fence;
+    if (!fence->lpVtbl->SetEventOnCompletion(fence, entry->head->fenceValue, watcher->event))
+    {
+        puts("Set event failed!");
+        return false;
+    }
+    entry->armedValue = entry->head->fenceValue;
+    return true;
+}
+
+static void CompletionThreadProc(void *context)
+{
+    ComputeCompletionWatcher *watcher = context;
+
+    ComputeMutexLock(&watcher->mutex);
+    for (;;)
+    {
+        ComputeFuture *completed = NULL;
+        ComputeFuture **link = &completed;
+        for (uint32_t i = 0; i < watcher->numTimelines; i++)
+            link = CollectCompleted(&watcher->timelines[i], link);
+
+        if (completed != NULL)
+        {
+            // The callbacks run outside the lock, so they may watch new values.
+            ComputeMutexUnlock(&watcher->mutex);
+            COMPUTE_TRACE_CPU_BEGIN(traceScope, "Completion");
+            for (ComputeFuture *future = completed; future != NULL; future = future->next)
+            {
+                if (future->callback != NULL)
+                    future->callback(future->context, future->fenceValue);
+            }
+            COMPUTE_TRACE_CPU_END(traceScope);
+            ComputeMutexLock(&watcher->mutex);
+
+            while (completed != NULL)
+            {
+                ComputeFuture *next = completed->next;
+                completed->ready = true;
+                watcher->numPending--;
+                ReleaseFuture(completed);
+                completed = next;
+            }
+            ComputeConditionBroadcast(&watcher->readyCond);
+
+            // More values may have been reached while the callbacks ran.
+            continue;
+        }
+
+        if (watcher->stopping && watcher->numPending == 0)
+            break;
+
+        // Without an armed event, fall back to polling the fences.
+        uint32_t timeoutMs = COMPUTE_WAIT_INFINITE;
+        for (uint32_t i = 0; i < watcher->numTimelines; i++)
+        {
+            if (!ArmTimeline(watcher, &watcher->timelines[i]))
+                timeoutMs = 1;
+        }
+
+        ComputeMutexUnlock(&watcher->mutex);
+        ComputeEventWait(watcher->event, timeoutMs);
+        ComputeMutexLock(&watcher->mutex);
+    }
+    ComputeMutexUnlock(&watcher->mutex);
+}
+
+bool ComputeCompletionWatcherInit(ComputeCompletionWatcher *watcher)
+{
+    memset(watcher, 0, sizeof(*watcher));
+
+    watcher->event = ComputeEventCreate();
+    if (watcher->event == NULL)
+    {
+        puts("Failed to create event handle!");
+        return false;
+    }
+
+    ComputeMutexInit(&watcher->mutex);
+    ComputeConditionInit(&watcher->readyCond);
+
+    if (!ComputeThreadCreate(&watcher->thread, CompletionThreadProc, watcher))
+    {
+        puts("Failed to create the completion thread!");
+        ComputeConditionDestroy(&watcher->readyCond);
+        ComputeMutexDestroy(&watcher->mutex);
+        ComputeEventDestroy(watcher->event);
+        memset(watcher, 0, sizeof(*watcher));
+        return false;
+    }
+    watcher->running = true;
+
+    return true;
+}
+
+void ComputeCompletionWatcherDestroy(ComputeCompletionWatcher *watcher)
+{
+    if (!watcher->running)
+        return;
+
+    ComputeMutexLock(&watcher->mutex);
+    watcher->stopping = true;
+    ComputeMutexUnlock(&watcher->mutex);
+    ComputeEventSet(watcher->event);
+    ComputeThreadJoin(watcher->thread);
+
+    // Every armed value has been reached, so the fences no longer reference the event.
+    ComputeConditionDestroy(&watcher->readyCond);
+    ComputeMutexDestroy(&watcher->mutex);
+    ComputeEventDestroy(watcher->event);
+    memset(watcher, 0, sizeof(*watcher));
+}
+
+static ComputeFuture* WatchValue(ComputeCompletionWatcher *watcher, ComputeTimeline *timeline, uint64_t fenceValue,
+    ComputeCompletionCallback callback, void *context, bool keepReference)
+{
+    ComputeFuture *future = calloc(1, sizeof(*future));
+    if (future == NULL)
+        return NULL;
+
+    future->fenceValue = fenceValue;
+    future->callback = callback;
+    future->context = context;
+    future->watcher = watcher;
+    future->refCount = keepReference ? 2 : 1;
+
+    ComputeMutexLock(&watcher->mutex);
+    if (watcher->stopping)
+    {
+        ComputeMutexUnlock(&watcher->mutex);
+        puts("The completion watcher is stopping!");
+        free(future);
+        return NULL;
+    }
+
+    ComputeCompletionTimeline *entry = NULL;
+    for (uint32_t i = 0; i < watcher->numTimelines && entry == NULL; i++)
+    {
+        if (watcher->timelines[i].timeline == timeline)
+            entry = &watcher->timelines[i];
+    }
+    if (entry == NULL)
+    {
+        if (watcher->numTimelines == COMPUTE_COMPLETION_MAX_TIMELINES)
+        {
+            ComputeMutexUnlock(&watcher->mutex);
+            puts("Too many timelines watched!");
+            free(future);
+            return NULL;
+        }
+        entry = &watcher->timelines[watcher->numTimelines++];
+        entry->timeline = timeline;
+    }
+
+    // The values are mostly watched in submission order, so the position is searched from the tail.
+    if (entry->tail == NULL || entry->tail->fenceValue <= fenceValue)
+    {
+        if (entry->tail != NULL)
+            entry->tail->next = future;
+        else
+            entry->head = future;
+        entry->tail = future;
+    }
+    else
+    {
+        ComputeFuture **link = &entry->head;
+        while ((*link)->fenceValue <= fenceValue)
+            link = &(*link)->next;
+        future->next = *link;
+        *link = future;
+    }
+    watcher->numPending++;
+    ComputeMutexUnlock(&watcher->mutex);
+
+    // The thread arms the fence with the new value if it is the lowest one.
+    ComputeEventSet(watcher->event);
+
+    return future;
+}
+
+ComputeFuture* ComputeCompletionWatch(ComputeCompletionWatcher *watcher, ComputeTimeline *timeline, uint64_t fenceValue,
+    ComputeCompletionCallback callback, void *context)
+{
+    return WatchValue(watcher, timeline, fenceValue, callback, context, true);
+}
+
+bool ComputeCompletionNotify(ComputeCompletionWatcher *watcher, ComputeTimeline *timeline, uint64_t fenceValue,
+    ComputeCompletionCallback callback, void *context)
+{
+    return WatchValue(watcher, timeline, fenceValue, callback, context, false) != NULL;
+}
+
+ComputeFuture* ComputeCompletionSubmitFrame(ComputeCompletionWatcher *watcher, ComputeFrameRing *ring,
+    ComputeCompletionCallback callback, void *context)
+{
+    const uint64_t fenceValue = ComputeFrameRingSubmit(ring);
+    if (fenceValue == 0)
+        return NULL;
+
+    return ComputeCompletionWatch(watcher, ring->timeline, fenceValue, callback, context);
+}
+
+uint64_t ComputeFutureGetFenceValue(const ComputeFuture *future)
+{
+    return future->fenceValue;
+}
+
+bool ComputeFutureIsReady(ComputeFuture *future)
+{
+    ComputeCompletionWatcher *watcher = future->watcher;
+    ComputeMutexLock(&watcher->mutex);
+    const bool ready = future->ready;
+    ComputeMutexUnlock(&watcher->mutex);
+    return ready;
+}
+
+bool ComputeFutureWait(ComputeFuture *future, uint32_t timeoutMs)
+{
+    ComputeCompletionWatcher *watcher = future->watcher;
+    const uint64_t deadline = ComputeGetTimeNanoseconds() + (uint64_t)timeoutMs * 1000000ULL;
+
+    ComputeMutexLock(&watcher->mutex);
+    if (!future->ready && timeoutMs != 0)
+    {
+        COMPUTE_TRACE_CPU_BEGIN(traceScope, "Wait");
+        while (!future->ready)
+        {
+            uint32_t remainingMs = COMPUTE_WAIT_INFINITE;
+            if (timeoutMs != COMPUTE_WAIT_INFINITE)
+            {
+                const uint64_t now = ComputeGetTimeNanoseconds();
+                if (now >= deadline)
+                    break;
+                remainingMs = (uint32_t)((deadline - now + 999999ULL) / 1000000ULL);
+            }
+            ComputeConditionTimedWait(&watcher->readyCond, &watcher->mutex, remainingMs);
+        }
+        COMPUTE_TRACE_CPU_END(traceScope);
+    }
+    const bool ready = future->ready;
+    ComputeMutexUnlock(&watcher->mutex);
+
+    return ready;
+}
+
+void ComputeFutureRelease(ComputeFuture *future)
+{
+    if (future != NULL)
+        ReleaseFuture(future);
+}
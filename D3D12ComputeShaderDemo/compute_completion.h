@@ -0,0 +1,82 @@
+#ifndef COMPUTE_COMPLETION_H
+#define COMPUTE_COMPLETION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "compute_timeline.h"
+
+// The maximum number of timelines a watcher can follow
+#define COMPUTE_COMPLETION_MAX_TIMELINES    8
+
+// Called on the watcher thread once the timeline has reached the fence value.
+// The callbacks of one timeline run in the order of their fence values.
+typedef void (*ComputeCompletionCallback)(void *context, uint64_t fenceValue);
+
+// The completion of a fence value, with a reference held by the caller that watched it
+typedef struct ComputeFuture ComputeFuture;
+
+// The pending futures of one timeline
+typedef struct ComputeCompletionTimeline
+{
+    ComputeTimeline *timeline;
+    // In ascending fence value order
+    ComputeFuture *head;
+    ComputeFuture *tail;
+    // The value the fence sets the event on, 0 when none is pending
+    uint64_t armedValue;
+} ComputeCompletionTimeline;
+
+// A thread that watches the fences of several timelines, runs the callbacks of the values reached and wakes the waiters,
+// so the threads that submit work can hand off its completion and go on instead of blocking on each fence value.
+// All the fences set the same event, so the watcher waits on any number of outstanding values with a single wait:
+// each fence only has its lowest pending value armed, and every wake polls the completed values of all the timelines.
+// Watch may be called from any thread.
+typedef struct ComputeCompletionWatcher
+{
+    ComputeMutex mutex;
+    // Broadcast when futures become ready
+    ComputeCondition readyCond;
+    // Set by the fences, and by Watch and Destroy to wake the thread
+    ComputeEvent event;
+    ComputeThread thread;
+    bool running;
+    bool stopping;
+    uint32_t numPending;
+    uint32_t numTimelines;
+    ComputeCompletionTimeline timelines[COMPUTE_COMPLETION_MAX_TIMELINES];
+} ComputeCompletionWatcher;
+
+extern bool ComputeCompletionWatcherInit(ComputeCompletionWatcher *watcher);
+// Waits for all the watched values and runs their callbacks before stopping the thread.
+// The futures must still be released, but not waited on afterwards.
+extern void ComputeCompletionWatcherDestroy(ComputeCompletionWatcher *watcher);
+
+// Watch the fence value of the timeline. The callback may be NULL.
+// The timeline must outlive the completion of the value. Returns NULL on failure.
+extern ComputeFuture* ComputeCompletionWatch(ComputeCompletionWatcher *watcher, ComputeTimeline *timeline, uint64_t fenceValue,
+    ComputeCompletionCallback callback, void *context);
+
+// Like Watch, without a future: only the callback reports the completion
+extern bool ComputeCompletionNotify(ComputeCompletionWatcher *watcher, ComputeTimeline *timeline, uint64_t fenceValue,
+    ComputeCompletionCallback callback, void *context);
+
+// Submit the current frame of the ring, and watch its fence value
+extern ComputeFuture* ComputeCompletionSubmitFrame(ComputeCompletionWatcher *watcher, ComputeFrameRing *ring,
+    ComputeCompletionCallback callback, void *context);
+
+extern uint64_t ComputeFutureGetFenceValue(const ComputeFuture *future);
+
+// Whether the value has been reached and the callback has returned. Non-blocking.
+extern bool ComputeFutureIsReady(ComputeFuture *future);
+
+// Wait until the future is ready, for at most timeoutMs. Returns false when the timeout elapsed.
+extern bool ComputeFutureWait(ComputeFuture *future, uint32_t timeoutMs);
+
+// Release the reference of the caller. A pending future still completes and runs its callback.
+extern void ComputeFutureRelease(ComputeFuture *future);
+
+#endif // COMPUTE_COMPLETION_H
@@ -0,0 +1,353 @@
+#ifdef _WIN32
+// Winsock has to come before windows.h
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#define _GNU_SOURCE
+#endif
+
+#include "compute_ipc.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+// Fill the address of the socket path. Returns false if the path is too long.
+static bool MakeSocketAddress(struct sockaddr_un *address, const char *path)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path))
+    {
+        puts("The socket path is too long!");
+        return false;
+    }
+    strcpy(address->sun_path, path);
+    return true;
+}
+
+static bool SetSharedMemoryName(ComputeSharedMemory *memory, const char *name)
+{
+    if (strlen(name) >= sizeof(memory->name))
+    {
+        puts("The shared memory name is too long!");
+        return false;
+    }
+    strcpy(memory->name, name);
+    return true;
+}
+
+#ifdef _WIN32
+
+bool ComputeIpcStartup(void)
+{
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+void ComputeIpcCleanup(void)
+{
+    WSACleanup();
+}
+
+static bool MapSharedMemory(ComputeSharedMemory *memory, uint64_t size)
+{
+    memory->pData = MapViewOfFile(memory->mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+    if (memory->pData == NULL)
+    {
+        CloseHandle(memory->mapping);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+    memory->size = size;
+    return true;
+}
+
+bool ComputeSharedMemoryCreate(ComputeSharedMemory *memory, const char *name, uint64_t size)
+{
+    memset(memory, 0, sizeof(*memory));
+    if (!SetSharedMemoryName(memory, name))
+        return false;
+
+    // Backed by the paging file. The region lives as long as a process keeps a handle to it.
+    memory->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, name);
+    if (memory->mapping == NULL || GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        if (memory->mapping != NULL)
+            CloseHandle(memory->mapping);
+        printf("Failed to create the shared memory %s!\n", name);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+    memory->owner = true;
+
+    return MapSharedMemory(memory, size);
+}
+
+bool ComputeSharedMemoryOpen(ComputeSharedMemory *memory, const char *name, uint64_t size)
+{
+    memset(memory, 0, sizeof(*memory));
+    if (!SetSharedMemoryName(memory, name))
+        return false;
+
+    memory->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (memory->mapping == NULL)
+    {
+        printf("Failed to open the shared memory %s!\n", name);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+
+    // Mapping more than the size of the region fails.
+    return MapSharedMemory(memory, size);
+}
+
+void ComputeSharedMemoryUnlink(ComputeSharedMemory *memory)
+{
+    memory->owner = false;
+}
+
+void ComputeSharedMemoryClose(ComputeSharedMemory *memory)
+{
+    if (memory->pData != NULL)
+        UnmapViewOfFile(memory->pData);
+    if (memory->mapping != NULL)
+        CloseHandle(memory->mapping);
+    memset(memory, 0, sizeof(*memory));
+}
+
+void ComputeIpcClose(ComputeIpcSocket socket)
+{
+    if (socket != COMPUTE_IPC_INVALID_SOCKET)
+        closesocket((SOCKET)socket);
+}
+
+static int SendSome(ComputeIpcSocket socket, const uint8_t *pData, size_t size)
+{
+    return send((SOCKET)socket, (const char*)pData, size > INT_MAX ? INT_MAX : (int)size, 0);
+}
+
+static int ReceiveSome(ComputeIpcSocket socket, uint8_t *pData, size_t size)
+{
+    return recv((SOCKET)socket, (char*)pData, size > INT_MAX ? INT_MAX : (int)size, 0);
+}
+
+#else
+
+bool ComputeIpcStartup(void)
+{
+    return true;
+}
+
+void ComputeIpcCleanup(void)
+{
+}
+
+static bool MapSharedMemory(ComputeSharedMemory *memory, uint64_t size)
+{
+    void *pData = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, memory->fd, 0);
+    if (pData == MAP_FAILED)
+    {
+        close(memory->fd);
+        if (memory->owner)
+            shm_unlink(memory->name);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+    memory->pData = pData;
+    memory->size = size;
+    return true;
+}
+
+bool ComputeSharedMemoryCreate(ComputeSharedMemory *memory, const char *name, uint64_t size)
+{
+    memset(memory, 0, sizeof(*memory));
+    if (!SetSharedMemoryName(memory, name))
+        return false;
+
+    memory->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (memory->fd < 0)
+    {
+        printf("Failed to create the shared memory %s!\n", name);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+    memory->owner = true;
+
+    if (ftruncate(memory->fd, (off_t)size) != 0)
+    {
+        printf("Failed to size the shared memory %s!\n", name);
+        close(memory->fd);
+        shm_unlink(name);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+
+    return MapSharedMemory(memory, size);
+}
+
+bool ComputeSharedMemoryOpen(ComputeSharedMemory *memory, const char *name, uint64_t size)
+{
+    memset(memory, 0, sizeof(*memory));
+    if (!SetSharedMemoryName(memory, name))
+        return false;
+
+    memory->fd = shm_open(name, O_RDWR, 0);
+    struct stat info;
+    if (memory->fd < 0 || fstat(memory->fd, &info) != 0 || (uint64_t)info.st_size < size)
+    {
+        printf("Failed to open the shared memory %s!\n", name);
+        if (memory->fd >= 0)
+            close(memory->fd);
+        memset(memory, 0, sizeof(*memory));
+        return false;
+    }
+
+    return MapSharedMemory(memory, size);
+}
+
+void ComputeSharedMemoryUnlink(ComputeSharedMemory *memory)
+{
+    if (memory->owner)
+        shm_unlink(memory->name);
+    memory->owner = false;
+}
+
+void ComputeSharedMemoryClose(ComputeSharedMemory *memory)
+{
+    if (memory->pData != NULL)
+    {
+        munmap(memory->pData, (size_t)memory->size);
+        close(memory->fd);
+    }
+    if (memory->owner)
+        shm_unlink(memory->name);
+    memset(memory, 0, sizeof(*memory));
+}
+
+void ComputeIpcClose(ComputeIpcSocket socket)
+{
+    if (socket != COMPUTE_IPC_INVALID_SOCKET)
+        close(socket);
+}
+
+static int SendSome(ComputeIpcSocket socket, const uint8_t *pData, size_t size)
+{
+    // A peer that went away fails the call instead of raising SIGPIPE.
+#ifdef MSG_NOSIGNAL
+    const ssize_t sent = send(socket, pData, size, MSG_NOSIGNAL);
+#else
+    const ssize_t sent = send(socket, pData, size, 0);
+#endif
+    return sent < 0 && errno == EINTR ? 0 : (int)sent;
+}
+
+static int ReceiveSome(ComputeIpcSocket socket, uint8_t *pData, size_t size)
+{
+    const ssize_t received = recv(socket, pData, size, 0);
+    // 0 is a closed connection, so an interrupted call retries through a negative count that is not an error.
+    return received < 0 && errno == EINTR ? INT32_MIN : (int)received;
+}
+
+#endif
+
+ComputeIpcSocket ComputeIpcListen(const char *path)
+{
+    struct sockaddr_un address;
+    if (!MakeSocketAddress(&address, path))
+        return COMPUTE_IPC_INVALID_SOCKET;
+
+    const ComputeIpcSocket listener = (ComputeIpcSocket)socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == COMPUTE_IPC_INVALID_SOCKET)
+    {
+        puts("Failed to create the socket!");
+        return COMPUTE_IPC_INVALID_SOCKET;
+    }
+
+    // A socket file is not removed when its process ends.
+    remove(path);
+    if (bind(listener, (const struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 8) != 0)
+    {
+        printf("Failed to listen on %s!\n", path);
+        ComputeIpcClose(listener);
+        return COMPUTE_IPC_INVALID_SOCKET;
+    }
+
+    return listener;
+}
+
+ComputeIpcSocket ComputeIpcAccept(ComputeIpcSocket listener)
+{
+    for (;;)
+    {
+        const ComputeIpcSocket connection = (ComputeIpcSocket)accept(listener, NULL, NULL);
+#ifndef _WIN32
+        if (connection == COMPUTE_IPC_INVALID_SOCKET && errno == EINTR)
+            continue;
+#endif
+        return connection;
+    }
+}
+
+ComputeIpcSocket ComputeIpcConnect(const char *path)
+{
+    struct sockaddr_un address;
+    if (!MakeSocketAddress(&address, path))
+        return COMPUTE_IPC_INVALID_SOCKET;
+
+    const ComputeIpcSocket connection = (ComputeIpcSocket)socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection == COMPUTE_IPC_INVALID_SOCKET)
+    {
+        puts("Failed to create the socket!");
+        return COMPUTE_IPC_INVALID_SOCKET;
+    }
+
+    if (connect(connection, (const struct sockaddr*)&address, sizeof(address)) != 0)
+    {
+        printf("Failed to connect to %s!\n", path);
+        ComputeIpcClose(connection);
+        return COMPUTE_IPC_INVALID_SOCKET;
+    }
+
+    return connection;
+}
+
+bool ComputeIpcSend(ComputeIpcSocket socket, const void *pData, size_t size)
+{
+    const uint8_t *pBytes = pData;
+    while (size > 0)
+    {
+        const int sent = SendSome(socket, pBytes, size);
+        if (sent < 0)
+            return false;
+        pBytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+bool ComputeIpcReceive(ComputeIpcSocket socket, void *pData, size_t size)
+{
+    uint8_t *pBytes = pData;
+    while (size > 0)
+    {
+        const int received = ReceiveSome(socket, pBytes, size);
+        if (received == INT32_MIN)
+            continue;
+        if (received <= 0)
+            return false;
+        pBytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef COMPUTE_IPC_H
+#define COMPUTE_IPC_H
+
+// Minimal inter-process layer of the compute service: named shared memory and local stream sockets.
+// The sockets are Unix domain sockets, which Windows also supports since Windows 10 version 1803.
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// The maximum length of a shared memory name
+#define COMPUTE_SHARED_MEMORY_MAX_NAME  64
+
+#ifdef _WIN32
+// A Winsock SOCKET
+typedef uintptr_t ComputeIpcSocket;
+#define COMPUTE_IPC_INVALID_SOCKET  (~(ComputeIpcSocket)0)
+#else
+typedef int ComputeIpcSocket;
+#define COMPUTE_IPC_INVALID_SOCKET  (-1)
+#endif
+
+// A named region of memory mapped by several processes
+typedef struct ComputeSharedMemory
+{
+    uint8_t *pData;
+    uint64_t size;
+    char name[COMPUTE_SHARED_MEMORY_MAX_NAME];
+    // The creator removes the name when it closes the region.
+    bool owner;
+#ifdef _WIN32
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} ComputeSharedMemory;
+
+// Called once per process before any socket is used, and once after the last one is closed
+extern bool ComputeIpcStartup(void);
+extern void ComputeIpcCleanup(void);
+
+// Create a new region of the name, which must not exist yet. On POSIX the name starts with a '/'.
+extern bool ComputeSharedMemoryCreate(ComputeSharedMemory *memory, const char *name, uint64_t size);
+
+// Map the existing region of the name, which must hold at least size bytes
+extern bool ComputeSharedMemoryOpen(ComputeSharedMemory *memory, const char *name, uint64_t size);
+
+// Remove the name of a region created by this process once every other process has opened it.
+// The mappings stay valid, and the region is freed with the last one even if its processes are killed.
+// Windows frees the name along with the last handle anyway.
+extern void ComputeSharedMemoryUnlink(ComputeSharedMemory *memory);
+
+extern void ComputeSharedMemoryClose(ComputeSharedMemory *memory);
+
+// Listen on the socket path, replacing a socket file left by an earlier process
+extern ComputeIpcSocket ComputeIpcListen(const char *path);
+
+// Wait for the next connection. Returns COMPUTE_IPC_INVALID_SOCKET on failure.
+extern ComputeIpcSocket ComputeIpcAccept(ComputeIpcSocket listener);
+
+extern ComputeIpcSocket ComputeIpcConnect(const char *path);
+
+// Send or receive exactly size bytes. Returns false on failure or when the peer closed the connection.
+extern bool ComputeIpcSend(ComputeIpcSocket socket, const void *pData, size_t size);
+extern bool ComputeIpcReceive(ComputeIpcSocket socket, void *pData, size_t size);
+
+extern void ComputeIpcClose(ComputeIpcSocket socket);
+
+#endif // COMPUTE_IPC_H
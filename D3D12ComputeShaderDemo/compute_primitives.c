@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compute_primitives.h"
+#include "compute_utils.h"
+
+// The root parameters of the kernels
+#define PRIMITIVE_SRV_ROOT_PARAMETER        0
+#define PRIMITIVE_UAV_ROOT_PARAMETER        1
+#define PRIMITIVE_CONSTANTS_ROOT_PARAMETER  2
+
+#define PRIMITIVE_NUM_SRVS  2
+#define PRIMITIVE_NUM_UAVS  3
+
+// The digits of a radix sort pass
+#define PRIMITIVE_RADIX_SIZE    (1 << COMPUTE_PRIMITIVE_RADIX_BITS)
+
+// The groupshared memory of cs_5_0, and the bytes primitives.hlsl declares for a group:
+// gs_items holds the block, gs_digitOffsets the digits and gs_scan one uint4 per thread.
+#define PRIMITIVE_MAX_GROUPSHARED_SIZE  32768
+#define PRIMITIVE_GROUPSHARED_SIZE(groupSize, itemsPerThread) \
+    (((uint64_t)(groupSize) * (itemsPerThread) + PRIMITIVE_RADIX_SIZE + 4 * (uint64_t)(groupSize)) * sizeof(uint32_t))
+
+static const char* const s_kernelEntryPoints[COMPUTE_PRIMITIVE_KERNEL_COUNT] = {
+    "Reduce", "ScanBlocks", "AddBlockOffsets", "CompactScatter", "RadixHistogram", "RadixScatter"
+};
+
+static bool CreatePrimitiveKernel(ComputePrimitives *primitives, ComputeShaderCache *shaderCache, const char *fileName,
+    const ComputeShaderMacro *defines, uint32_t compileFlags, uint32_t itemsPerThread, ComputePrimitiveKernel kernel)
+{
+    ComputeBlob *shader;
+    if (!ComputeShaderCacheCompile(shaderCache, fileName, defines, s_kernelEntryPoints[kernel], "cs_5_0", compileFlags, &shader))
+        return false;
+
+    ComputePipelineStateDesc psoDesc = { 0 };
+    psoDesc.pRootSignature = primitives->rootSignature;
+    psoDesc.CS = (ComputeShaderBytecode){ shader->lpVtbl->GetBufferPointer(shader), shader->lpVtbl->GetBufferSize(shader) };
+
+    // The passes are sized from the group size of the bytecode, which all the kernels share.
+    ComputeShaderReflection reflection;
+    if (!primitives->device->lpVtbl->ReflectShader(primitives->device, &psoDesc.CS, &reflection) ||
+        (primitives->elementsPerGroup != 0 && primitives->elementsPerGroup != reflection.ThreadGroupSize[0] * itemsPerThread))
+    {
+        shader->lpVtbl->Release(shader);
+        return false;
+    }
+    primitives->elementsPerGroup = reflection.ThreadGroupSize[0] * itemsPerThread;
+
+    primitives->pipelineStates[kernel] = ComputeShaderCacheCreatePipelineState(shaderCache, &psoDesc);
+    shader->lpVtbl->Release(shader);
+    return primitives->pipelineStates[kernel] != NULL;
+}
+
+bool ComputePrimitivesInit(ComputePrimitives *primitives, ComputeShaderCache *shaderCache, ComputeDescriptorAllocator *descriptors,
+    const char *fileName, uint32_t groupSize, uint32_t itemsPerThread, uint32_t compileFlags)
+{
+    memset(primitives, 0, sizeof(*primitives));
+
+    // One thread per digit of the radix sort, and the digit counts of a block packed in 16 bits
+    if (groupSize < PRIMITIVE_RADIX_SIZE || groupSize > 1024 || (groupSize & (groupSize - 1)) != 0 ||
+        itemsPerThread == 0 || (uint64_t)groupSize * itemsPerThread >= 65536)
+    {
+        puts("Invalid group size for the primitives!");
+        return false;
+    }
+
+    // The compiler would only reject the kernels later on.
+    if (PRIMITIVE_GROUPSHARED_SIZE(groupSize, itemsPerThread) > PRIMITIVE_MAX_GROUPSHARED_SIZE)
+    {
+        printf("The blocks of %u x %u elements of the primitives exceed the %u bytes of groupshared memory!\n",
+            groupSize, itemsPerThread, PRIMITIVE_MAX_GROUPSHARED_SIZE);
+        return false;
+    }
+
+    primitives->device = shaderCache->device;
+    primitives->descriptors = descriptors;
+
+    const ComputeDescriptorRange ranges[2] = {
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_SRV, PRIMITIVE_NUM_SRVS, 0 },
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV, PRIMITIVE_NUM_UAVS, 0 }
+    };
+    const ComputeRootParameter rootParameters[3] = {
+        { COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[0] } },
+        { COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[1] } },
+        { COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+            .Constants = { 0, COMPUTE_DISPATCH_CONSTANTS_COUNT + COMPUTE_PRIMITIVE_CONSTANTS_COUNT } }
+    };
+    const ComputeRootSignatureDesc rootSignatureDesc = { 3, rootParameters };
+
+    primitives->rootSignature = primitives->device->lpVtbl->CreateRootSignature(primitives->device, &rootSignatureDesc);
+    if (primitives->rootSignature == NULL)
+    {
+        puts("Failed to create the root signature of the primitives!");
+        ComputePrimitivesDestroy(primitives);
+        return false;
+    }
+
+    char groupSizeText[16], itemsPerThreadText[16];
+    snprintf(groupSizeText, sizeof(groupSizeText), "%u", groupSize);
+    snprintf(itemsPerThreadText, sizeof(itemsPerThreadText), "%u", itemsPerThread);
+    const ComputeShaderMacro defines[] = {
+        { "GROUP_SIZE", groupSizeText },
+        { "ITEMS_PER_THREAD", itemsPerThreadText },
+        { NULL, NULL }
+    };
+
+    for (uint32_t kernel = 0; kernel < COMPUTE_PRIMITIVE_KERNEL_COUNT; kernel++)
+    {
+        if (!CreatePrimitiveKernel(primitives, shaderCache, fileName, defines, compileFlags, itemsPerThread, kernel))
+        {
+            printf("Failed to create the kernel %s of the primitives!\n", s_kernelEntryPoints[kernel]);
+            ComputePrimitivesDestroy(primitives);
+            return false;
+        }
+    }
+
+    if (!ComputeDescriptorAllocatorAllocateStaging(descriptors, PRIMITIVE_NUM_SRVS + PRIMITIVE_NUM_UAVS, &primitives->views))
+    {
+        ComputePrimitivesDestroy(primitives);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputePrimitivesDestroy(ComputePrimitives *primitives)
+{
+    if (primitives->device == NULL)
+        return;
+
+    if (primitives->views.count > 0)
+        ComputeDescriptorAllocatorFreeStaging(primitives->descriptors, &primitives->views);
+
+    for (uint32_t kernel = 0; kernel < COMPUTE_PRIMITIVE_KERNEL_COUNT; kernel++)
+    {
+        if (primitives->pipelineStates[kernel] != NULL)
+            primitives->pipelineStates[kernel]->lpVtbl->Release(primitives->pipelineStates[kernel]);
+    }
+
+    if (primitives->rootSignature != NULL)
+        primitives->rootSignature->lpVtbl->Release(primitives->rootSignature);
+
+    memset(primitives, 0, sizeof(*primitives));
+}
+
+// The blocks of a pass over numElements elements. A pass has at least one group, which writes the result of an empty input.
+static uint32_t GetNumBlocks(const ComputePrimitives *primitives, uint32_t numElements)
+{
+    const uint32_t numBlocks = (uint32_t)(((uint64_t)numElements + primitives->elementsPerGroup - 1) / primitives->elementsPerGroup);
+    return numBlocks > 0 ? numBlocks : 1;
+}
+
+// The scratch elements of the block sums of a scan: the sums of each level, down to the total of the last one
+static uint64_t GetScanSumsSize(const ComputePrimitives *primitives, uint32_t numElements)
+{
+    uint64_t size = 0;
+    for (;;)
+    {
+        const uint32_t numBlocks = GetNumBlocks(primitives, numElements);
+        size += numBlocks;
+        if (numBlocks == 1)
+            return size;
+        numElements = numBlocks;
+    }
+}
+
+// The scratch elements of the sort: the histograms, their scan sums, and the keys and values between two passes
+static uint64_t GetSortScratchSize(const ComputePrimitives *primitives, uint32_t numElements, bool hasValues, uint64_t *pKeysOffset)
+{
+    const uint64_t histogramSize = (uint64_t)PRIMITIVE_RADIX_SIZE * GetNumBlocks(primitives, numElements);
+    *pKeysOffset = histogramSize + GetScanSumsSize(primitives, (uint32_t)histogramSize);
+    return *pKeysOffset + (uint64_t)numElements * (hasValues ? 2 : 1);
+}
+
+uint64_t ComputePrimitivesGetScratchSize(const ComputePrimitives *primitives, ComputePrimitiveType type,
+    uint32_t numElements, bool hasValues)
+{
+    uint64_t numScratchElements;
+    switch (type)
+    {
+    case COMPUTE_PRIMITIVE_REDUCE:
+    case COMPUTE_PRIMITIVE_SCAN:
+        numScratchElements = GetScanSumsSize(primitives, numElements);
+        break;
+    case COMPUTE_PRIMITIVE_COMPACT:
+        // The scanned flags, then their block sums
+        numScratchElements = numElements + GetScanSumsSize(primitives, numElements);
+        break;
+    case COMPUTE_PRIMITIVE_SORT:
+    {
+        uint64_t keysOffset;
+        numScratchElements = GetSortScratchSize(primitives, numElements, hasValues, &keysOffset);
+        break;
+    }
+    default:
+        return 0;
+    }
+
+    return numScratchElements * sizeof(uint32_t);
+}
+
+// The offsets of the passes are 32-bit, so is the size of a view.
+static bool CheckScratch(ComputeResource *scratch, uint64_t size)
+{
+    ComputeResourceDesc desc;
+    scratch->lpVtbl->GetDesc(scratch, &desc);
+    if (size / sizeof(uint32_t) > UINT32_MAX || desc.Width < size)
+    {
+        puts("The scratch buffer of the primitive is too small!");
+        return false;
+    }
+    return true;
+}
+
+// Create the views of the buffers of a primitive, copy them to a transient table and bind it
+static bool BindPrimitiveViews(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *const srvs[PRIMITIVE_NUM_SRVS], ComputeResource *const uavs[PRIMITIVE_NUM_UAVS])
+{
+    ComputeDevice *device = primitives->device;
+    ComputeDescriptorAllocator *descriptors = primitives->descriptors;
+
+    ComputeCPUDescriptorHandle handles[PRIMITIVE_NUM_SRVS + PRIMITIVE_NUM_UAVS];
+    for (uint32_t i = 0; i < PRIMITIVE_NUM_SRVS + PRIMITIVE_NUM_UAVS; i++)
+    {
+        ComputeResource *resource = i < PRIMITIVE_NUM_SRVS ? srvs[i] : uavs[i - PRIMITIVE_NUM_SRVS];
+
+        ComputeResourceDesc desc;
+        resource->lpVtbl->GetDesc(resource, &desc);
+        const uint64_t numElements = desc.Width / sizeof(uint32_t);
+        const ComputeBufferViewDesc viewDesc = {
+            0, numElements < UINT32_MAX ? (uint32_t)numElements : UINT32_MAX, sizeof(uint32_t), COMPUTE_FORMAT_UNKNOWN,
+            COMPUTE_BUFFER_VIEW_FLAG_NONE
+        };
+
+        handles[i] = ComputeDescriptorCPUHandle(descriptors, &primitives->views, i);
+        if (i < PRIMITIVE_NUM_SRVS)
+            device->lpVtbl->CreateShaderResourceView(device, resource, &viewDesc, handles[i]);
+        else
+            device->lpVtbl->CreateUnorderedAccessView(device, resource, &viewDesc, handles[i]);
+    }
+
+    // The staging views are copied at once, so they can be created again for the next primitive.
+    ComputeDescriptorAllocation table;
+    if (!ComputeDescriptorAllocatorCopyTable(descriptors, PRIMITIVE_NUM_SRVS + PRIMITIVE_NUM_UAVS, handles, COMPUTE_WAIT_INFINITE, &table))
+        return false;
+
+    commandList->lpVtbl->SetComputeRootSignature(commandList, primitives->rootSignature);
+
+    ComputeDescriptorHeap* ppHeaps[] = { descriptors->heap };
+    commandList->lpVtbl->SetDescriptorHeaps(commandList, 1, ppHeaps);
+
+    commandList->lpVtbl->SetComputeRootDescriptorTable(commandList, PRIMITIVE_SRV_ROOT_PARAMETER,
+        ComputeDescriptorGPUHandle(descriptors, &table, 0));
+    commandList->lpVtbl->SetComputeRootDescriptorTable(commandList, PRIMITIVE_UAV_ROOT_PARAMETER,
+        ComputeDescriptorGPUHandle(descriptors, &table, PRIMITIVE_NUM_SRVS));
+    return true;
+}
+
+// Dispatch one group per block, and make its writes visible to the next pass
+static void RecordPrimitivePass(ComputePrimitives *primitives, ComputeCommandList *commandList, ComputePrimitiveKernel kernel,
+    uint32_t numElements, const ComputePrimitiveConstants *constants)
+{
+    commandList->lpVtbl->SetPipelineState(commandList, primitives->pipelineStates[kernel]);
+    commandList->lpVtbl->SetComputeRoot32BitConstants(commandList, PRIMITIVE_CONSTANTS_ROOT_PARAMETER,
+        COMPUTE_PRIMITIVE_CONSTANTS_COUNT, constants, COMPUTE_DISPATCH_CONSTANTS_COUNT);
+    ComputeDispatchGroupRange(commandList, PRIMITIVE_CONSTANTS_ROOT_PARAMETER, numElements, 0, GetNumBlocks(primitives, numElements));
+
+    const ComputeResourceBarrier barrier = {
+        .Type = COMPUTE_RESOURCE_BARRIER_TYPE_UAV, .Flags = COMPUTE_RESOURCE_BARRIER_FLAG_NONE, .pResource = NULL
+    };
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &barrier);
+}
+
+// Scan the blocks, scan their sums in place with the same passes, then add the scanned sums to the blocks.
+// The sums of each level are stored at sumsOffset, followed by the sums of the next level.
+// Returns the scratch offset of the total.
+static uint32_t RecordScanPasses(ComputePrimitives *primitives, ComputeCommandList *commandList, uint32_t numElements,
+    uint32_t flags, uint32_t inputOffset, uint32_t outputOffset, uint32_t sumsOffset)
+{
+    const ComputePrimitiveConstants scanConstants = { inputOffset, outputOffset, sumsOffset, flags, 0, 0 };
+    RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_SCAN_BLOCKS, numElements, &scanConstants);
+
+    const uint32_t numBlocks = GetNumBlocks(primitives, numElements);
+    if (numBlocks == 1)
+        return sumsOffset;
+
+    const uint32_t totalOffset = RecordScanPasses(primitives, commandList, numBlocks,
+        COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH | COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH, sumsOffset, sumsOffset, sumsOffset + numBlocks);
+
+    const ComputePrimitiveConstants addConstants = { 0, outputOffset, sumsOffset, flags & COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH, 0, 0 };
+    RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_ADD_BLOCK_OFFSETS, numElements, &addConstants);
+    return totalOffset;
+}
+
+bool ComputePrimitivesReduce(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *dst, ComputeResource *scratch, uint32_t numElements)
+{
+    if (!CheckScratch(scratch, ComputePrimitivesGetScratchSize(primitives, COMPUTE_PRIMITIVE_REDUCE, numElements, false)))
+        return false;
+
+    ComputeResource *const srvs[PRIMITIVE_NUM_SRVS] = { src, src };
+    ComputeResource *const uavs[PRIMITIVE_NUM_UAVS] = { dst, scratch, scratch };
+    if (!BindPrimitiveViews(primitives, commandList, srvs, uavs))
+        return false;
+
+    // Each pass sums the blocks of the previous one, until a single block is left, which writes dst.
+    // The sums of each pass follow its input in the scratch buffer.
+    uint32_t flags = 0;
+    uint32_t inputOffset = 0;
+    for (;;)
+    {
+        const uint32_t numBlocks = GetNumBlocks(primitives, numElements);
+        const uint32_t outputOffset = (flags & COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH) ? inputOffset + numElements : 0;
+        const ComputePrimitiveConstants constants = {
+            inputOffset, outputOffset, 0, flags | (numBlocks > 1 ? COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH : 0), 0, 0
+        };
+        RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_REDUCE, numElements, &constants);
+
+        if (numBlocks == 1)
+            return true;
+
+        flags = COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH;
+        inputOffset = outputOffset;
+        numElements = numBlocks;
+    }
+}
+
+bool ComputePrimitivesScan(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *dst, ComputeResource *scratch, uint32_t numElements)
+{
+    if (!CheckScratch(scratch, ComputePrimitivesGetScratchSize(primitives, COMPUTE_PRIMITIVE_SCAN, numElements, false)))
+        return false;
+    if (numElements == 0)
+        return true;
+
+    ComputeResource *const srvs[PRIMITIVE_NUM_SRVS] = { src, src };
+    ComputeResource *const uavs[PRIMITIVE_NUM_UAVS] = { dst, scratch, scratch };
+    if (!BindPrimitiveViews(primitives, commandList, srvs, uavs))
+        return false;
+
+    RecordScanPasses(primitives, commandList, numElements, 0, 0, 0, 0);
+    return true;
+}
+
+bool ComputePrimitivesCompact(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *flags, ComputeResource *dst, ComputeResource *count, ComputeResource *scratch,
+    uint32_t numElements)
+{
+    if (!CheckScratch(scratch, ComputePrimitivesGetScratchSize(primitives, COMPUTE_PRIMITIVE_COMPACT, numElements, false)))
+        return false;
+
+    ComputeResource *const srvs[PRIMITIVE_NUM_SRVS] = { src, flags };
+    ComputeResource *const uavs[PRIMITIVE_NUM_UAVS] = { dst, scratch, count };
+    if (!BindPrimitiveViews(primitives, commandList, srvs, uavs))
+        return false;
+
+    // The output positions are the exclusive scan of the flags, stored at the start of the scratch buffer.
+    const uint32_t totalOffset = RecordScanPasses(primitives, commandList, numElements,
+        COMPUTE_PRIMITIVE_FLAG_PREDICATE | COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH, 0, 0, numElements);
+
+    const ComputePrimitiveConstants constants = { 0, 0, totalOffset, 0, 0, 0 };
+    RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_COMPACT_SCATTER, numElements, &constants);
+    return true;
+}
+
+bool ComputePrimitivesSort(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *keys, ComputeResource *values, ComputeResource *dstKeys, ComputeResource *dstValues,
+    ComputeResource *scratch, uint32_t numElements, uint32_t numBits)
+{
+    const bool hasValues = values != NULL;
+    if (numBits == 0 || numBits > 32 || hasValues != (dstValues != NULL))
+    {
+        puts("Invalid sort parameters!");
+        return false;
+    }
+    if (!CheckScratch(scratch, ComputePrimitivesGetScratchSize(primitives, COMPUTE_PRIMITIVE_SORT, numElements, hasValues)))
+        return false;
+    if (numElements == 0)
+        return true;
+
+    ComputeResource *const srvs[PRIMITIVE_NUM_SRVS] = { keys, hasValues ? values : keys };
+    ComputeResource *const uavs[PRIMITIVE_NUM_UAVS] = { dstKeys, scratch, hasValues ? dstValues : scratch };
+    if (!BindPrimitiveViews(primitives, commandList, srvs, uavs))
+        return false;
+
+    // The histograms are at the start of the scratch buffer, followed by their scan sums and the keys and values
+    // between two passes. The passes alternate between the scratch buffer and the output, the last one writing the output.
+    uint64_t keysOffset;
+    GetSortScratchSize(primitives, numElements, hasValues, &keysOffset);
+    const uint32_t histogramSize = PRIMITIVE_RADIX_SIZE * GetNumBlocks(primitives, numElements);
+    const uint32_t valuesOffset = (uint32_t)keysOffset + numElements;
+    const uint32_t numPasses = (numBits + COMPUTE_PRIMITIVE_RADIX_BITS - 1) / COMPUTE_PRIMITIVE_RADIX_BITS;
+
+    uint32_t readFlags = 0;
+    for (uint32_t pass = 0; pass < numPasses; pass++)
+    {
+        const uint32_t shift = pass * COMPUTE_PRIMITIVE_RADIX_BITS;
+        const bool toOutput = (numPasses - 1 - pass) % 2 == 0;
+
+        const ComputePrimitiveConstants histogramConstants = { (uint32_t)keysOffset, 0, 0, readFlags, shift, valuesOffset };
+        RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_RADIX_HISTOGRAM, numElements, &histogramConstants);
+
+        RecordScanPasses(primitives, commandList, histogramSize,
+            COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH | COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH, 0, 0, histogramSize);
+
+        const uint32_t scatterFlags = readFlags | (toOutput ? 0 : COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH) |
+            (hasValues ? COMPUTE_PRIMITIVE_FLAG_VALUES : 0);
+        const ComputePrimitiveConstants scatterConstants = { (uint32_t)keysOffset, (uint32_t)keysOffset, 0, scatterFlags, shift, valuesOffset };
+        RecordPrimitivePass(primitives, commandList, COMPUTE_PRIMITIVE_KERNEL_RADIX_SCATTER, numElements, &scatterConstants);
+
+        readFlags = toOutput ? COMPUTE_PRIMITIVE_FLAG_READ_OUTPUT : COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH;
+    }
+
+    return true;
+}
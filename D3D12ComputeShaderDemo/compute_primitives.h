@@ -0,0 +1,111 @@
+#ifndef COMPUTE_PRIMITIVES_H
+#define COMPUTE_PRIMITIVES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "descriptor_allocator.h"
+#include "shader_cache.h"
+
+// The kernels of primitives.hlsl
+typedef enum ComputePrimitiveKernel
+{
+    COMPUTE_PRIMITIVE_KERNEL_REDUCE,
+    COMPUTE_PRIMITIVE_KERNEL_SCAN_BLOCKS,
+    COMPUTE_PRIMITIVE_KERNEL_ADD_BLOCK_OFFSETS,
+    COMPUTE_PRIMITIVE_KERNEL_COMPACT_SCATTER,
+    COMPUTE_PRIMITIVE_KERNEL_RADIX_HISTOGRAM,
+    COMPUTE_PRIMITIVE_KERNEL_RADIX_SCATTER,
+    COMPUTE_PRIMITIVE_KERNEL_COUNT
+} ComputePrimitiveKernel;
+
+typedef enum ComputePrimitiveType
+{
+    COMPUTE_PRIMITIVE_REDUCE,
+    COMPUTE_PRIMITIVE_SCAN,
+    COMPUTE_PRIMITIVE_COMPACT,
+    COMPUTE_PRIMITIVE_SORT
+} ComputePrimitiveType;
+
+// The Flags of a pass, FLAG_* in primitives.hlsl
+#define COMPUTE_PRIMITIVE_FLAG_READ_SCRATCH     1
+#define COMPUTE_PRIMITIVE_FLAG_WRITE_SCRATCH    2
+#define COMPUTE_PRIMITIVE_FLAG_READ_OUTPUT      4
+#define COMPUTE_PRIMITIVE_FLAG_PREDICATE        8
+#define COMPUTE_PRIMITIVE_FLAG_VALUES           16
+
+// The number of key bits sorted per radix sort pass
+#define COMPUTE_PRIMITIVE_RADIX_BITS    4
+
+// The root constants of a pass, following the ComputeDispatchConstants. The offsets are in elements of the scratch buffer.
+typedef struct ComputePrimitiveConstants
+{
+    uint32_t InputOffset;
+    uint32_t OutputOffset;
+    uint32_t SumsOffset;
+    uint32_t Flags;
+    uint32_t Shift;
+    uint32_t ValuesOffset;
+} ComputePrimitiveConstants;
+
+#define COMPUTE_PRIMITIVE_CONSTANTS_COUNT   (sizeof(ComputePrimitiveConstants) / sizeof(uint32_t))
+
+// Reduction, exclusive prefix scan, stream compaction and radix sort of 32-bit unsigned integers on the device.
+// Each primitive is recorded as a chain of passes over blocks of elementsPerGroup elements, the per-block results
+// of a pass going to a scratch buffer that the next pass reads, so the inputs may have any size.
+// The kernels use the layout of the root signature of the elementwise kernels with wider tables:
+// the SRVs t0-t1 in root parameter 0, the UAVs u0-u2 in root parameter 1, and the root constants in parameter 2.
+// Recording a primitive sets the root signature, the descriptor heap and the pipeline state of the command list,
+// so the caller sets its own again afterwards.
+// Like the descriptor allocator, it is meant to be used by the single thread that records the command lists.
+typedef struct ComputePrimitives
+{
+    ComputeDevice *device;
+    ComputeDescriptorAllocator *descriptors;
+    ComputeRootSignature *rootSignature;
+    ComputePipelineState *pipelineStates[COMPUTE_PRIMITIVE_KERNEL_COUNT];
+    // GROUP_SIZE * ITEMS_PER_THREAD, from the group size reflected from the kernels
+    uint32_t elementsPerGroup;
+    // The staging descriptors of the views of a primitive: t0, t1, u0, u1 and u2
+    ComputeDescriptorAllocation views;
+} ComputePrimitives;
+
+// Compile the kernels of the file with the group size and the number of elements per thread.
+// The group size must be a power of two in [16, 1024], and a block must hold less than 65536 elements
+// and fit with the scan of the group in the 32 KB of groupshared memory.
+extern bool ComputePrimitivesInit(ComputePrimitives *primitives, ComputeShaderCache *shaderCache, ComputeDescriptorAllocator *descriptors,
+    const char *fileName, uint32_t groupSize, uint32_t itemsPerThread, uint32_t compileFlags);
+// No command list recorded with the primitives may be in flight.
+extern void ComputePrimitivesDestroy(ComputePrimitives *primitives);
+
+// The size in bytes of the scratch buffer of the primitive on numElements elements, with values for the sort
+extern uint64_t ComputePrimitivesGetScratchSize(const ComputePrimitives *primitives, ComputePrimitiveType type,
+    uint32_t numElements, bool hasValues);
+
+// The functions below record the passes of a primitive into the command list.
+// The input buffers must be in the NON_PIXEL_SHADER_RESOURCE state, and the output and scratch buffers in the
+// UNORDERED_ACCESS state. They are left in the same states, with the writes of the last pass made visible by a UAV barrier.
+// The scratch buffer needs ComputePrimitivesGetScratchSize bytes, and may be shared by the primitives of a command list.
+
+// dst[0] = src[0] + ... + src[numElements - 1]
+extern bool ComputePrimitivesReduce(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *dst, ComputeResource *scratch, uint32_t numElements);
+
+// dst[i] = src[0] + ... + src[i - 1], dst[0] = 0
+extern bool ComputePrimitivesScan(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *dst, ComputeResource *scratch, uint32_t numElements);
+
+// Move the elements src[i] with flags[i] != 0 to the start of dst, in order, and write their number to count[0]
+extern bool ComputePrimitivesCompact(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *src, ComputeResource *flags, ComputeResource *dst, ComputeResource *count, ComputeResource *scratch,
+    uint32_t numElements);
+
+// Stable sort of the keys by their numBits low bits, the bits above them being zero, into dstKeys, with one pass per COMPUTE_PRIMITIVE_RADIX_BITS bits.
+// The values are moved along with the keys into dstValues; both are NULL to sort the keys only.
+extern bool ComputePrimitivesSort(ComputePrimitives *primitives, ComputeCommandList *commandList,
+    ComputeResource *keys, ComputeResource *values, ComputeResource *dstKeys, ComputeResource *dstValues,
+    ComputeResource *scratch, uint32_t numElements, uint32_t numBits);
+
+#endif // COMPUTE_PRIMITIVES_H
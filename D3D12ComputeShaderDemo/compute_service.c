@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compute_service.h"
+#include "compute_thread.h"
+#include "compute_trace.h"
+
+// Whether size bytes at offset lie in the shared memory, at a multiple of 4 bytes
+static bool IsRangeValid(const ComputeSharedMemory *memory, uint64_t offset, uint64_t size)
+{
+    return (offset & 3) == 0 && offset <= memory->size && size <= memory->size - offset;
+}
+
+static ComputeServiceStatus RunRequest(ComputeSharedMemory *memory, const ComputeServiceRequest *request,
+    ComputeServiceJobFunc func, void *context)
+{
+    if (memory->pData == NULL)
+        return COMPUTE_SERVICE_STATUS_NOT_ATTACHED;
+
+    const uint64_t size = (uint64_t)request->NumElements * sizeof(uint32_t);
+    if (request->NumElements == 0 || !IsRangeValid(memory, request->InputOffset, size) ||
+        !IsRangeValid(memory, request->OutputOffset, size))
+        return COMPUTE_SERVICE_STATUS_BAD_REQUEST;
+
+    COMPUTE_TRACE_CPU_BEGIN(scope, "ServiceRequest");
+    const ComputeServiceJob job = {
+        .pInput = memory->pData + request->InputOffset,
+        .pOutput = memory->pData + request->OutputOffset,
+        .NumElements = request->NumElements,
+        .Operand = request->Operand
+    };
+    const bool succeeded = func(&job, context);
+    COMPUTE_TRACE_CPU_END(scope);
+
+    return succeeded ? COMPUTE_SERVICE_STATUS_OK : COMPUTE_SERVICE_STATUS_FAILED;
+}
+
+// Serve one connection until the client leaves. Returns true when the client asked for a shutdown.
+static bool ServeConnection(ComputeIpcSocket connection, ComputeServiceJobFunc func, void *context)
+{
+    ComputeSharedMemory memory = { 0 };
+    bool shutdown = false;
+    uint32_t numJobs = 0;
+
+    ComputeServiceRequest request;
+    while (!shutdown && ComputeIpcReceive(connection, &request, sizeof(request)))
+    {
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        ComputeServiceResponse response = { .Magic = COMPUTE_SERVICE_MAGIC, .Status = COMPUTE_SERVICE_STATUS_OK };
+
+        if (request.Magic != COMPUTE_SERVICE_MAGIC)
+        {
+            // Not a client of ours, or the stream lost its framing
+            puts("The service received a malformed request!");
+            break;
+        }
+
+        switch (request.Op)
+        {
+        case COMPUTE_SERVICE_OP_ATTACH:
+            ComputeSharedMemoryClose(&memory);
+            request.SharedMemoryName[COMPUTE_SHARED_MEMORY_MAX_NAME - 1] = '\0';
+            if (request.SharedMemorySize == 0 || request.SharedMemorySize > SIZE_MAX ||
+                !ComputeSharedMemoryOpen(&memory, request.SharedMemoryName, request.SharedMemorySize))
+                response.Status = COMPUTE_SERVICE_STATUS_BAD_REQUEST;
+            break;
+
+        case COMPUTE_SERVICE_OP_RUN:
+            response.Status = RunRequest(&memory, &request, func, context);
+            if (response.Status == COMPUTE_SERVICE_STATUS_OK)
+                numJobs++;
+            break;
+
+        case COMPUTE_SERVICE_OP_SHUTDOWN:
+            shutdown = true;
+            break;
+
+        default:
+            response.Status = COMPUTE_SERVICE_STATUS_BAD_REQUEST;
+            break;
+        }
+
+        response.ServiceTimeNs = ComputeGetTimeNanoseconds() - startTime;
+        if (!ComputeIpcSend(connection, &response, sizeof(response)))
+            break;
+    }
+
+    ComputeSharedMemoryClose(&memory);
+    printf("A client left after %u jobs.\n", numJobs);
+    return shutdown;
+}
+
+bool ComputeServiceRun(const char *socketPath, ComputeServiceJobFunc func, void *context)
+{
+    if (!ComputeIpcStartup())
+    {
+        puts("Failed to initialize the sockets!");
+        return false;
+    }
+
+    const ComputeIpcSocket listener = ComputeIpcListen(socketPath);
+    if (listener == COMPUTE_IPC_INVALID_SOCKET)
+    {
+        ComputeIpcCleanup();
+        return false;
+    }
+
+    printf("The compute service is listening on %s.\n", socketPath);
+
+    bool shutdown = false;
+    while (!shutdown)
+    {
+        const ComputeIpcSocket connection = ComputeIpcAccept(listener);
+        if (connection == COMPUTE_IPC_INVALID_SOCKET)
+        {
+            puts("Failed to accept a connection!");
+            break;
+        }
+
+        shutdown = ServeConnection(connection, func, context);
+        ComputeIpcClose(connection);
+    }
+
+    ComputeIpcClose(listener);
+    remove(socketPath);
+    ComputeIpcCleanup();
+
+    puts("The compute service stopped.");
+    return true;
+}
+
+// Send the request and wait for its response. Returns the status of the response, or COMPUTE_SERVICE_STATUS_FAILED
+// if the connection failed.
+static ComputeServiceStatus Transact(ComputeServiceClient *client, ComputeServiceRequest *request, uint64_t *pServiceTimeNs)
+{
+    request->Magic = COMPUTE_SERVICE_MAGIC;
+
+    ComputeServiceResponse response;
+    if (!ComputeIpcSend(client->socket, request, sizeof(*request)) ||
+        !ComputeIpcReceive(client->socket, &response, sizeof(response)) || response.Magic != COMPUTE_SERVICE_MAGIC)
+    {
+        puts("The connection to the compute service failed!");
+        return COMPUTE_SERVICE_STATUS_FAILED;
+    }
+
+    if (pServiceTimeNs != NULL)
+        *pServiceTimeNs = response.ServiceTimeNs;
+    return (ComputeServiceStatus)response.Status;
+}
+
+bool ComputeServiceClientConnect(ComputeServiceClient *client, const char *socketPath, const char *sharedMemoryName,
+    uint64_t sharedMemorySize)
+{
+    memset(client, 0, sizeof(*client));
+    client->socket = COMPUTE_IPC_INVALID_SOCKET;
+
+    if (!ComputeIpcStartup())
+    {
+        puts("Failed to initialize the sockets!");
+        return false;
+    }
+
+    client->socket = ComputeIpcConnect(socketPath);
+    if (client->socket == COMPUTE_IPC_INVALID_SOCKET)
+    {
+        ComputeIpcCleanup();
+        return false;
+    }
+
+    // A client that only stops the service needs no memory.
+    if (sharedMemoryName == NULL)
+        return true;
+
+    if (!ComputeSharedMemoryCreate(&client->memory, sharedMemoryName, sharedMemorySize))
+    {
+        ComputeServiceClientClose(client);
+        return false;
+    }
+
+    ComputeServiceRequest request = { .Op = COMPUTE_SERVICE_OP_ATTACH, .SharedMemorySize = sharedMemorySize };
+    strcpy(request.SharedMemoryName, client->memory.name);
+    if (Transact(client, &request, NULL) != COMPUTE_SERVICE_STATUS_OK)
+    {
+        puts("The compute service could not attach the shared memory!");
+        ComputeServiceClientClose(client);
+        return false;
+    }
+
+    // The service has mapped the region, so nothing is left behind if either process dies.
+    ComputeSharedMemoryUnlink(&client->memory);
+
+    return true;
+}
+
+bool ComputeServiceClientRun(ComputeServiceClient *client, uint64_t inputOffset, uint64_t outputOffset,
+    uint32_t numElements, int32_t operand, uint64_t *pServiceTimeNs)
+{
+    ComputeServiceRequest request = {
+        .Op = COMPUTE_SERVICE_OP_RUN,
+        .InputOffset = inputOffset,
+        .OutputOffset = outputOffset,
+        .NumElements = numElements,
+        .Operand = operand
+    };
+
+    const ComputeServiceStatus status = Transact(client, &request, pServiceTimeNs);
+    if (status != COMPUTE_SERVICE_STATUS_OK)
+    {
+        printf("The compute service failed the job with the status %d!\n", (int)status);
+        return false;
+    }
+    return true;
+}
+
+bool ComputeServiceClientShutdown(ComputeServiceClient *client)
+{
+    ComputeServiceRequest request = { .Op = COMPUTE_SERVICE_OP_SHUTDOWN };
+    return Transact(client, &request, NULL) == COMPUTE_SERVICE_STATUS_OK;
+}
+
+void ComputeServiceClientClose(ComputeServiceClient *client)
+{
+    if (client->socket != COMPUTE_IPC_INVALID_SOCKET)
+    {
+        ComputeIpcClose(client->socket);
+        ComputeIpcCleanup();
+    }
+    ComputeSharedMemoryClose(&client->memory);
+    client->socket = COMPUTE_IPC_INVALID_SOCKET;
+}
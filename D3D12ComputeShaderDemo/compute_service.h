@@ -0,0 +1,94 @@
+#ifndef COMPUTE_SERVICE_H
+#define COMPUTE_SERVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_ipc.h"
+
+// A resident process that keeps the device, the compiled pipelines and the pools warm and runs the jobs of
+// other processes. The socket only carries small fixed-size control messages: the data of the jobs stays in
+// a shared memory region created by the client, which the service maps once when the client attaches.
+// The service serves one client at a time, and one job at a time, in the order of the requests.
+
+// "CSVC"
+#define COMPUTE_SERVICE_MAGIC       0x43535643U
+
+typedef enum ComputeServiceOp
+{
+    // Map the shared memory region named by the request
+    COMPUTE_SERVICE_OP_ATTACH,
+    // Run a job on the elements at InputOffset, writing them to OutputOffset
+    COMPUTE_SERVICE_OP_RUN,
+    // Stop the service after the response
+    COMPUTE_SERVICE_OP_SHUTDOWN
+} ComputeServiceOp;
+
+typedef enum ComputeServiceStatus
+{
+    COMPUTE_SERVICE_STATUS_OK,
+    COMPUTE_SERVICE_STATUS_BAD_REQUEST,
+    COMPUTE_SERVICE_STATUS_NOT_ATTACHED,
+    COMPUTE_SERVICE_STATUS_FAILED
+} ComputeServiceStatus;
+
+typedef struct ComputeServiceRequest
+{
+    uint32_t Magic;
+    uint32_t Op;
+    // ATTACH
+    char SharedMemoryName[COMPUTE_SHARED_MEMORY_MAX_NAME];
+    uint64_t SharedMemorySize;
+    // RUN: byte offsets into the shared memory, and the number of 32-bit elements
+    uint64_t InputOffset;
+    uint64_t OutputOffset;
+    uint32_t NumElements;
+    int32_t Operand;
+} ComputeServiceRequest;
+
+typedef struct ComputeServiceResponse
+{
+    uint32_t Magic;
+    uint32_t Status;
+    // The time the service spent on the request, from its receipt to the response
+    uint64_t ServiceTimeNs;
+} ComputeServiceResponse;
+
+// A job as seen by the service, with the pointers into the shared memory
+typedef struct ComputeServiceJob
+{
+    const void *pInput;
+    void *pOutput;
+    uint32_t NumElements;
+    int32_t Operand;
+} ComputeServiceJob;
+
+// Runs a job on the warm device. Returns false on failure.
+typedef bool (*ComputeServiceJobFunc)(const ComputeServiceJob *job, void *context);
+
+// Serve the clients on the socket path until one of them asks for a shutdown.
+// Returns false if the socket could not be opened.
+extern bool ComputeServiceRun(const char *socketPath, ComputeServiceJobFunc func, void *context);
+
+// The client side. The client creates the shared memory, attaches it, then places its jobs in it.
+typedef struct ComputeServiceClient
+{
+    ComputeIpcSocket socket;
+    ComputeSharedMemory memory;
+} ComputeServiceClient;
+
+// Connect to the service and attach a new shared memory region of the name and size, or no region if the name is NULL
+extern bool ComputeServiceClientConnect(ComputeServiceClient *client, const char *socketPath, const char *sharedMemoryName,
+    uint64_t sharedMemorySize);
+
+// Run a job on the shared memory and wait for it. pServiceTimeNs receives the time spent by the service, if not NULL.
+extern bool ComputeServiceClientRun(ComputeServiceClient *client, uint64_t inputOffset, uint64_t outputOffset,
+    uint32_t numElements, int32_t operand, uint64_t *pServiceTimeNs);
+
+// Ask the service to stop. The client is still to be closed.
+extern bool ComputeServiceClientShutdown(ComputeServiceClient *client);
+
+extern void ComputeServiceClientClose(ComputeServiceClient *client);
+
+#endif // COMPUTE_SERVICE_H
@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compute_shard.h"
+#include "compute_utils.h"
+#include "host_copy.h"
+#include "compute_trace.h"
+
+// The frames of each device: the shard of one run is in flight at a time
+#define COMPUTE_SHARD_FRAME_COUNT   2
+
+static void ReleaseShardBuffers(ComputeShardDevice *shard)
+{
+    ComputeResource *const buffers[4] = { shard->uploadBuffer, shard->inputBuffer, shard->outputBuffer, shard->readbackBuffer };
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        if (buffers[i] != NULL)
+            buffers[i]->lpVtbl->Release(buffers[i]);
+    }
+    shard->uploadBuffer = NULL;
+    shard->inputBuffer = NULL;
+    shard->outputBuffer = NULL;
+    shard->readbackBuffer = NULL;
+    shard->pUploadData = NULL;
+    shard->pReadbackData = NULL;
+    shard->capacity = 0;
+}
+
+// Grow the buffers of the device to hold size bytes. Nothing of the device may be in flight.
+static bool ReserveShardBuffers(ComputeShardDevice *shard, uint64_t size)
+{
+    if (size <= shard->capacity)
+        return true;
+    ReleaseShardBuffers(shard);
+
+    ComputeDevice *device = shard->device;
+    const ComputeResourceDesc desc = { size, COMPUTE_RESOURCE_FLAG_NONE };
+    const ComputeResourceDesc uavDesc = { size, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+
+    // Between the runs, the input rests in the copy destination state and the output in the unordered access state.
+    shard->uploadBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_UPLOAD, &desc,
+        COMPUTE_RESOURCE_STATE_GENERIC_READ);
+    shard->inputBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &desc,
+        COMPUTE_RESOURCE_STATE_COPY_DEST);
+    shard->outputBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &uavDesc,
+        COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    shard->readbackBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_READBACK, &desc,
+        COMPUTE_RESOURCE_STATE_COPY_DEST);
+    if (shard->uploadBuffer == NULL || shard->inputBuffer == NULL || shard->outputBuffer == NULL || shard->readbackBuffer == NULL)
+    {
+        puts("Failed to create the shard buffers!");
+        ReleaseShardBuffers(shard);
+        return false;
+    }
+
+    // Both stay mapped, the data is only accessed while no copy of the device is in flight.
+    const ComputeRange noRead = { 0, 0 };
+    const ComputeRange fullRead = { 0, (size_t)size };
+    if (!shard->uploadBuffer->lpVtbl->Map(shard->uploadBuffer, &noRead, &shard->pUploadData) ||
+        !shard->readbackBuffer->lpVtbl->Map(shard->readbackBuffer, &fullRead, &shard->pReadbackData))
+    {
+        puts("Failed to map the shard buffers!");
+        ReleaseShardBuffers(shard);
+        return false;
+    }
+    shard->capacity = size;
+
+    return true;
+}
+
+static bool InitShardDevice(ComputeShardDevice *shard, const ComputeShardKernelDesc *desc)
+{
+    ComputeDevice *device = shard->device;
+
+    shard->queue = device->lpVtbl->CreateCommandQueue(device, COMPUTE_COMMAND_LIST_TYPE_COMPUTE);
+    if (shard->queue == NULL)
+    {
+        puts("Failed to create the shard command queue!");
+        return false;
+    }
+    if (!ComputeTimelineInit(&shard->timeline, device, shard->queue) ||
+        !ComputeFrameRingInit(&shard->frames, device, &shard->timeline, COMPUTE_SHARD_FRAME_COUNT, COMPUTE_COMMAND_LIST_TYPE_COMPUTE))
+        return false;
+
+    // Each device compiles the kernel for itself, with the same root layout as the single device path.
+    if (!ComputeShaderCacheInit(&shard->shaderCache, device, desc->CacheDirectory, NULL, NULL) ||
+        !ComputeRootLayoutCreateFromShader(&shard->layout, &shard->shaderCache, desc->FileName, NULL, desc->EntryPoint,
+            desc->Target, desc->CompileFlags, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS) ||
+        !ComputeKernelRegistryInit(&shard->registry, &shard->shaderCache, shard->layout.rootSignature, desc->FileName,
+            desc->EntryPoint, desc->Target, desc->CompileFlags))
+        return false;
+
+    shard->variant = ComputeKernelRegistryGet(&shard->registry, &desc->Key);
+    return shard->variant != NULL;
+}
+
+static void DestroyShardDevice(ComputeShardDevice *shard)
+{
+    // The frame ring and the timeline wait for the last shard before anything is released.
+    if (shard->frames.timeline != NULL)
+        ComputeFrameRingDestroy(&shard->frames);
+    if (shard->timeline.fence != NULL)
+        ComputeTimelineDestroy(&shard->timeline);
+
+    if (shard->registry.shaderCache != NULL)
+        ComputeKernelRegistryDestroy(&shard->registry);
+    if (shard->layout.rootSignature != NULL)
+        ComputeRootLayoutDestroy(&shard->layout);
+    ReleaseShardBuffers(shard);
+
+    if (shard->queue != NULL)
+        shard->queue->lpVtbl->Release(shard->queue);
+    if (shard->device != NULL)
+        shard->device->lpVtbl->Release(shard->device);
+    memset(shard, 0, sizeof(*shard));
+}
+
+bool ComputeShardSchedulerInit(ComputeShardScheduler *scheduler, ComputeDevice *const *devices, uint32_t numDevices,
+    const ComputeShardKernelDesc *desc)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    if (numDevices == 0 || numDevices > COMPUTE_SHARD_MAX_DEVICES)
+    {
+        puts("Invalid shard device count!");
+        for (uint32_t i = 0; i < numDevices; i++)
+            devices[i]->lpVtbl->Release(devices[i]);
+        return false;
+    }
+
+    scheduler->numDevices = numDevices;
+    for (uint32_t i = 0; i < numDevices; i++)
+        scheduler->devices[i].device = devices[i];
+
+    bool initialized = ComputeCompletionWatcherInit(&scheduler->watcher);
+    for (uint32_t i = 0; i < numDevices && initialized; i++)
+        initialized = InitShardDevice(&scheduler->devices[i], desc);
+
+    if (!initialized)
+    {
+        ComputeShardSchedulerDestroy(scheduler);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeShardSchedulerDestroy(ComputeShardScheduler *scheduler)
+{
+    ComputeCompletionWatcherDestroy(&scheduler->watcher);
+    for (uint32_t i = 0; i < scheduler->numDevices; i++)
+        DestroyShardDevice(&scheduler->devices[i]);
+    memset(scheduler, 0, sizeof(*scheduler));
+}
+
+void ComputeShardSchedulerPartition(const ComputeShardScheduler *scheduler, uint32_t count, uint32_t *pCounts)
+{
+    const uint32_t numDevices = scheduler->numDevices;
+
+    double measuredSum = 0.0;
+    uint32_t numMeasured = 0;
+    for (uint32_t i = 0; i < numDevices; i++)
+    {
+        if (scheduler->devices[i].throughput > 0.0)
+        {
+            measuredSum += scheduler->devices[i].throughput;
+            numMeasured++;
+        }
+    }
+    const double defaultWeight = numMeasured > 0 ? measuredSum / numMeasured : 1.0;
+
+    double weights[COMPUTE_SHARD_MAX_DEVICES];
+    double weightSum = 0.0;
+    uint32_t heaviest = 0;
+    for (uint32_t i = 0; i < numDevices; i++)
+    {
+        weights[i] = scheduler->devices[i].throughput > 0.0 ? scheduler->devices[i].throughput : defaultWeight;
+        weightSum += weights[i];
+        if (weights[i] > weights[heaviest])
+            heaviest = i;
+    }
+
+    // The shards are rounded down to the alignment, and the fastest device takes the rest.
+    uint32_t assigned = 0;
+    for (uint32_t i = 0; i < numDevices; i++)
+    {
+        const uint32_t shard = (uint32_t)((double)count * weights[i] / weightSum);
+        pCounts[i] = shard / COMPUTE_SHARD_ALIGNMENT * COMPUTE_SHARD_ALIGNMENT;
+        assigned += pCounts[i];
+    }
+    pCounts[heaviest] += count - assigned;
+}
+
+// Record the upload, the kernel and the readback of the shard
+static bool RecordShard(ComputeShardDevice *shard)
+{
+    const uint64_t size = shard->numElements * sizeof(uint32_t);
+
+    ComputeCommandList *commandList = ComputeFrameRingBegin(&shard->frames, shard->variant->pipelineState, COMPUTE_WAIT_INFINITE);
+    if (commandList == NULL)
+        return false;
+
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, &shard->timeline, commandList, "Shard");
+    commandList->lpVtbl->CopyBufferRegion(commandList, shard->inputBuffer, 0, shard->uploadBuffer, 0, size);
+    const ComputeResourceBarrier inputBarrier = {
+        COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, shard->inputBuffer,
+        COMPUTE_RESOURCE_STATE_COPY_DEST, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, NULL
+    };
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &inputBarrier);
+
+    commandList->lpVtbl->SetComputeRootSignature(commandList, shard->layout.rootSignature);
+    ComputeRootLayoutSetSRV(&shard->layout, commandList, 0, shard->inputBuffer, 0);
+    ComputeRootLayoutSetUAV(&shard->layout, commandList, 0, shard->outputBuffer, 0);
+    ComputeDispatchElements(commandList, shard->layout.constantsParameters[0], (uint32_t)shard->numElements,
+        shard->variant->elementsPerGroup);
+
+    // Both buffers return to their resting states in the same list.
+    const ComputeResourceBarrier copyBarriers[2] = {
+        { COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, shard->outputBuffer,
+            COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, COMPUTE_RESOURCE_STATE_COPY_SOURCE, NULL },
+        { COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, shard->inputBuffer,
+            COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, COMPUTE_RESOURCE_STATE_COPY_DEST, NULL }
+    };
+    commandList->lpVtbl->ResourceBarrier(commandList, 2, copyBarriers);
+    commandList->lpVtbl->CopyBufferRegion(commandList, shard->readbackBuffer, 0, shard->outputBuffer, 0, size);
+    const ComputeResourceBarrier outputBarrier = {
+        COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, shard->outputBuffer,
+        COMPUTE_RESOURCE_STATE_COPY_SOURCE, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, NULL
+    };
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &outputBarrier);
+    COMPUTE_TRACE_GPU_END(traceSpan, &shard->timeline, commandList);
+
+    return true;
+}
+
+// The output of a run, filled by the completion callbacks of its shards
+typedef struct ShardGather
+{
+    ComputeShardDevice *shard;
+    uint8_t *pOutput;
+} ShardGather;
+
+// Runs on the completion thread: the shard is gathered as soon as it is done, while the other devices still run theirs.
+static void OnShardComplete(void *context, uint64_t fenceValue)
+{
+    const ShardGather *gather = context;
+    ComputeShardDevice *shard = gather->shard;
+    (void)fenceValue;
+
+    shard->completeTime = ComputeGetTimeNanoseconds();
+    memcpy(gather->pOutput + shard->firstElement * sizeof(uint32_t), shard->pReadbackData, (size_t)shard->numElements * sizeof(uint32_t));
+}
+
+bool ComputeShardSchedulerRun(ComputeShardScheduler *scheduler, const void *input, void *output, uint32_t count)
+{
+    uint32_t counts[COMPUTE_SHARD_MAX_DEVICES];
+    ComputeShardSchedulerPartition(scheduler, count, counts);
+
+    ShardGather gathers[COMPUTE_SHARD_MAX_DEVICES];
+    ComputeFuture *futures[COMPUTE_SHARD_MAX_DEVICES] = { NULL };
+    bool recorded[COMPUTE_SHARD_MAX_DEVICES] = { false };
+    bool succeeded = true;
+    uint64_t firstElement = 0;
+
+    // All the shards are staged and recorded before any is submitted,
+    // so that the measured time of a device does not include the staging of the others.
+    for (uint32_t i = 0; i < scheduler->numDevices && succeeded; i++)
+    {
+        ComputeShardDevice *shard = &scheduler->devices[i];
+        shard->firstElement = firstElement;
+        shard->numElements = counts[i];
+        firstElement += counts[i];
+        if (counts[i] == 0)
+            continue;
+
+        const uint64_t size = (uint64_t)counts[i] * sizeof(uint32_t);
+        if (!ReserveShardBuffers(shard, size))
+        {
+            succeeded = false;
+            break;
+        }
+
+        COMPUTE_TRACE_CPU_BEGIN(traceScope, "Stage shard");
+        ComputeHostCopy(shard->pUploadData, (const uint8_t*)input + shard->firstElement * sizeof(uint32_t), (size_t)size);
+        COMPUTE_TRACE_CPU_END(traceScope);
+
+        recorded[i] = RecordShard(shard);
+        succeeded = recorded[i];
+    }
+
+    // The recorded shards are submitted even after a failure, so that their frames are closed.
+    for (uint32_t i = 0; i < scheduler->numDevices; i++)
+    {
+        if (!recorded[i])
+            continue;
+
+        ComputeShardDevice *shard = &scheduler->devices[i];
+        gathers[i].shard = shard;
+        gathers[i].pOutput = output;
+        shard->submitTime = ComputeGetTimeNanoseconds();
+        futures[i] = ComputeCompletionSubmitFrame(&scheduler->watcher, &shard->frames, OnShardComplete, &gathers[i]);
+        if (futures[i] == NULL)
+            succeeded = false;
+    }
+
+    // The shards already submitted are waited on even after a failure, since they write the output.
+    for (uint32_t i = 0; i < scheduler->numDevices; i++)
+    {
+        if (futures[i] == NULL)
+            continue;
+
+        ComputeShardDevice *shard = &scheduler->devices[i];
+        if (ComputeFutureWait(futures[i], COMPUTE_WAIT_INFINITE))
+        {
+            const uint64_t elapsed = shard->completeTime - shard->submitTime;
+            const double measured = (double)shard->numElements * 1e9 / (double)(elapsed > 0 ? elapsed : 1);
+            shard->throughput = shard->throughput > 0.0 ? 0.5 * (shard->throughput + measured) : measured;
+        }
+        else
+            succeeded = false;
+        ComputeFutureRelease(futures[i]);
+    }
+
+    return succeeded;
+}
@@ -0,0 +1,86 @@
+#ifndef COMPUTE_SHARD_H
+#define COMPUTE_SHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_completion.h"
+#include "compute_timeline.h"
+#include "kernel_variants.h"
+#include "root_layout.h"
+#include "shader_cache.h"
+
+// The maximum number of devices of a scheduler
+#define COMPUTE_SHARD_MAX_DEVICES   8
+// The shards start at multiples of this number of elements
+#define COMPUTE_SHARD_ALIGNMENT     1024
+
+// The kernel run on every shard: a variant of an elementwise kernel like compute.hlsl,
+// reading t0, writing u0 and taking the DispatchConstants in b0
+typedef struct ComputeShardKernelDesc
+{
+    // The shader cache directory shared by the devices. Its entries are keyed on the backend.
+    const char *CacheDirectory;
+    const char *FileName;
+    const char *EntryPoint;
+    const char *Target;
+    uint32_t CompileFlags;
+    ComputeKernelVariantKey Key;
+} ComputeShardKernelDesc;
+
+// One device of the scheduler, with everything it needs to run its shard on its own
+typedef struct ComputeShardDevice
+{
+    ComputeDevice *device;
+    ComputeCommandQueue *queue;
+    ComputeTimeline timeline;
+    ComputeFrameRing frames;
+    ComputeShaderCache shaderCache;
+    ComputeRootLayout layout;
+    ComputeKernelRegistry registry;
+    const ComputeKernelVariant *variant;
+    // The buffers hold capacity bytes, grown to the largest shard of the device
+    uint64_t capacity;
+    ComputeResource *uploadBuffer;
+    ComputeResource *inputBuffer;
+    ComputeResource *outputBuffer;
+    ComputeResource *readbackBuffer;
+    void *pUploadData;
+    void *pReadbackData;
+    // The elements processed per second, smoothed over the runs. 0 until the device has run a shard.
+    double throughput;
+    // The shard of the last run, and the times of its submission and completion
+    uint64_t firstElement;
+    uint64_t numElements;
+    uint64_t submitTime;
+    uint64_t completeTime;
+} ComputeShardDevice;
+
+// Splits the elements of a large buffer across several devices, each running the same kernel on its shard,
+// and gathers the results into one output. The shards are weighted by the throughput measured on each device
+// by the previous runs: the time from the submission of a shard to its completion, reported by the completion watcher.
+// The first run splits the elements evenly.
+typedef struct ComputeShardScheduler
+{
+    uint32_t numDevices;
+    ComputeCompletionWatcher watcher;
+    ComputeShardDevice devices[COMPUTE_SHARD_MAX_DEVICES];
+} ComputeShardScheduler;
+
+// The scheduler takes over the devices, and releases them when destroyed, also on failure.
+// The strings of the desc must stay valid until the scheduler is destroyed.
+extern bool ComputeShardSchedulerInit(ComputeShardScheduler *scheduler, ComputeDevice *const *devices, uint32_t numDevices,
+    const ComputeShardKernelDesc *desc);
+extern void ComputeShardSchedulerDestroy(ComputeShardScheduler *scheduler);
+
+// The number of elements of each device for count elements, from the measured throughputs.
+// A device without a measure yet weighs the mean of the measured ones.
+extern void ComputeShardSchedulerPartition(const ComputeShardScheduler *scheduler, uint32_t count, uint32_t *pCounts);
+
+// Run the kernel on count 32-bit elements of input, writing them to output.
+// All the devices run their shard at the same time. Returns false if any shard failed.
+extern bool ComputeShardSchedulerRun(ComputeShardScheduler *scheduler, const void *input, void *output, uint32_t count);
+
+#endif // COMPUTE_SHARD_H
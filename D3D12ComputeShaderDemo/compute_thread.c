@@ -0,0 +1,382 @@
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
+#include "compute_thread.h"
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef _WIN32
+
+void ComputeMutexInit(ComputeMutex *mutex)
+{
+    InitializeSRWLock(mutex);
+}
+
+void ComputeMutexDestroy(ComputeMutex *mutex)
+{
+    (void)mutex;
+}
+
+void ComputeMutexLock(ComputeMutex *mutex)
+{
+    AcquireSRWLockExclusive(mutex);
+}
+
+void ComputeMutexUnlock(ComputeMutex *mutex)
+{
+    ReleaseSRWLockExclusive(mutex);
+}
+
+void ComputeConditionInit(ComputeCondition *cond)
+{
+    InitializeConditionVariable(cond);
+}
+
+void ComputeConditionDestroy(ComputeCondition *cond)
+{
+    (void)cond;
+}
+
+void ComputeConditionWait(ComputeCondition *cond, ComputeMutex *mutex)
+{
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+bool ComputeConditionTimedWait(ComputeCondition *cond, ComputeMutex *mutex, uint32_t timeoutMs)
+{
+    return SleepConditionVariableSRW(cond, mutex, timeoutMs == COMPUTE_WAIT_INFINITE ? INFINITE : timeoutMs, 0) != FALSE;
+}
+
+void ComputeConditionSignal(ComputeCondition *cond)
+{
+    WakeConditionVariable(cond);
+}
+
+void ComputeConditionBroadcast(ComputeCondition *cond)
+{
+    WakeAllConditionVariable(cond);
+}
+
+typedef struct ThreadStartInfo
+{
+    ComputeThreadProc proc;
+    void *context;
+} ThreadStartInfo;
+
+static DWORD WINAPI ThreadStartRoutine(LPVOID param)
+{
+    ThreadStartInfo info = *(ThreadStartInfo*)param;
+    free(param);
+    info.proc(info.context);
+    return 0;
+}
+
+bool ComputeThreadCreate(ComputeThread *thread, ComputeThreadProc proc, void *context)
+{
+    ThreadStartInfo *info = malloc(sizeof(*info));
+    if (info == NULL)
+        return false;
+
+    info->proc = proc;
+    info->context = context;
+    *thread = CreateThread(NULL, 0, ThreadStartRoutine, info, 0, NULL);
+    if (*thread == NULL)
+    {
+        free(info);
+        return false;
+    }
+    return true;
+}
+
+void ComputeThreadJoin(ComputeThread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+ComputeEvent ComputeEventCreate(void)
+{
+    return CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+void ComputeEventDestroy(ComputeEvent event)
+{
+    if (event != NULL)
+        CloseHandle(event);
+}
+
+void ComputeEventSet(ComputeEvent event)
+{
+    SetEvent(event);
+}
+
+bool ComputeEventWait(ComputeEvent event, uint32_t timeoutMs)
+{
+    return WaitForSingleObject(event, timeoutMs == COMPUTE_WAIT_INFINITE ? INFINITE : timeoutMs) == WAIT_OBJECT_0;
+}
+
+uint32_t ComputeGetProcessorCount(void)
+{
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    return sysInfo.dwNumberOfProcessors > 0 ? (uint32_t)sysInfo.dwNumberOfProcessors : 1;
+}
+
+uint32_t ComputeGetCurrentThreadId(void)
+{
+    return (uint32_t)GetCurrentThreadId();
+}
+
+uint64_t ComputeGetTimeNanoseconds(void)
+{
+    static LARGE_INTEGER s_frequency;
+    if (s_frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&s_frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / s_frequency.QuadPart) * 1000000000ULL +
+        (uint64_t)(counter.QuadPart % s_frequency.QuadPart) * 1000000000ULL / (uint64_t)s_frequency.QuadPart;
+}
+
+void ComputeSleepMicroseconds(uint64_t microseconds)
+{
+    Sleep((DWORD)((microseconds + 999) / 1000));
+}
+
+void* ComputeAlignedAlloc(size_t size, size_t alignment)
+{
+    return _aligned_malloc(size, alignment);
+}
+
+void ComputeAlignedFree(void *ptr)
+{
+    _aligned_free(ptr);
+}
+
+#else
+
+void ComputeMutexInit(ComputeMutex *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+void ComputeMutexDestroy(ComputeMutex *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+void ComputeMutexLock(ComputeMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void ComputeMutexUnlock(ComputeMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+void ComputeConditionInit(ComputeCondition *cond)
+{
+    // Use the monotonic clock so that timed waits are not affected by wall clock changes
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void ComputeConditionDestroy(ComputeCondition *cond)
+{
+    pthread_cond_destroy(cond);
+}
+
+void ComputeConditionWait(ComputeCondition *cond, ComputeMutex *mutex)
+{
+    pthread_cond_wait(cond, mutex);
+}
+
+bool ComputeConditionTimedWait(ComputeCondition *cond, ComputeMutex *mutex, uint32_t timeoutMs)
+{
+    if (timeoutMs == COMPUTE_WAIT_INFINITE)
+    {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cond, mutex, &deadline) != ETIMEDOUT;
+}
+
+void ComputeConditionSignal(ComputeCondition *cond)
+{
+    pthread_cond_signal(cond);
+}
+
+void ComputeConditionBroadcast(ComputeCondition *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+typedef struct ThreadStartInfo
+{
+    ComputeThreadProc proc;
+    void *context;
+} ThreadStartInfo;
+
+static void* ThreadStartRoutine(void *param)
+{
+    ThreadStartInfo info = *(ThreadStartInfo*)param;
+    free(param);
+    info.proc(info.context);
+    return NULL;
+}
+
+bool ComputeThreadCreate(ComputeThread *thread, ComputeThreadProc proc, void *context)
+{
+    ThreadStartInfo *info = malloc(sizeof(*info));
+    if (info == NULL)
+        return false;
+
+    info->proc = proc;
+    info->context = context;
+    if (pthread_create(thread, NULL, ThreadStartRoutine, info) != 0)
+    {
+        free(info);
+        return false;
+    }
+    return true;
+}
+
+void ComputeThreadJoin(ComputeThread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+// The POSIX emulation of a Win32 auto-reset event
+typedef struct PosixEvent
+{
+    ComputeMutex mutex;
+    ComputeCondition cond;
+    bool signaled;
+} PosixEvent;
+
+ComputeEvent ComputeEventCreate(void)
+{
+    PosixEvent *event = calloc(1, sizeof(*event));
+    if (event == NULL)
+        return NULL;
+
+    ComputeMutexInit(&event->mutex);
+    ComputeConditionInit(&event->cond);
+    return event;
+}
+
+void ComputeEventDestroy(ComputeEvent event)
+{
+    PosixEvent *posixEvent = event;
+    if (posixEvent == NULL)
+        return;
+
+    ComputeConditionDestroy(&posixEvent->cond);
+    ComputeMutexDestroy(&posixEvent->mutex);
+    free(posixEvent);
+}
+
+void ComputeEventSet(ComputeEvent event)
+{
+    PosixEvent *posixEvent = event;
+    ComputeMutexLock(&posixEvent->mutex);
+    posixEvent->signaled = true;
+    ComputeConditionSignal(&posixEvent->cond);
+    ComputeMutexUnlock(&posixEvent->mutex);
+}
+
+bool ComputeEventWait(ComputeEvent event, uint32_t timeoutMs)
+{
+    PosixEvent *posixEvent = event;
+    const uint64_t deadline = ComputeGetTimeNanoseconds() + (uint64_t)timeoutMs * 1000000ULL;
+
+    ComputeMutexLock(&posixEvent->mutex);
+    while (!posixEvent->signaled)
+    {
+        uint32_t remainingMs = COMPUTE_WAIT_INFINITE;
+        if (timeoutMs != COMPUTE_WAIT_INFINITE)
+        {
+            const uint64_t now = ComputeGetTimeNanoseconds();
+            if (now >= deadline)
+                break;
+            remainingMs = (uint32_t)((deadline - now + 999999ULL) / 1000000ULL);
+        }
+        ComputeConditionTimedWait(&posixEvent->cond, &posixEvent->mutex, remainingMs);
+    }
+
+    // Auto-reset
+    const bool signaled = posixEvent->signaled;
+    posixEvent->signaled = false;
+    ComputeMutexUnlock(&posixEvent->mutex);
+
+    return signaled;
+}
+
+uint32_t ComputeGetProcessorCount(void)
+{
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+uint32_t ComputeGetCurrentThreadId(void)
+{
+#ifdef __linux__
+    return (uint32_t)syscall(SYS_gettid);
+#else
+    return (uint32_t)(uintptr_t)pthread_self();
+#endif
+}
+
+uint64_t ComputeGetTimeNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void ComputeSleepMicroseconds(uint64_t microseconds)
+{
+    struct timespec ts = { (time_t)(microseconds / 1000000), (long)(microseconds % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+void* ComputeAlignedAlloc(size_t size, size_t alignment)
+{
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size > 0 ? size : alignment) != 0)
+        return NULL;
+    return ptr;
+}
+
+void ComputeAlignedFree(void *ptr)
+{
+    free(ptr);
+}
+
+#endif
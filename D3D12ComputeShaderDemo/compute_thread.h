@@ -0,0 +1,148 @@
+#ifndef COMPUTE_THREAD_H
+#define COMPUTE_THREAD_H
+
+// Minimal platform layer used by the portable parts of the sample.
+// Windows uses the Win32 primitives, every other platform uses pthreads.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Infinite timeout for the wait functions
+#define COMPUTE_WAIT_INFINITE   0xffffffffU
+
+#ifdef _WIN32
+typedef SRWLOCK ComputeMutex;
+typedef CONDITION_VARIABLE ComputeCondition;
+typedef HANDLE ComputeThread;
+#else
+typedef pthread_mutex_t ComputeMutex;
+typedef pthread_cond_t ComputeCondition;
+typedef pthread_t ComputeThread;
+#endif
+
+// An auto-reset event object.
+// On Windows this is a Win32 event HANDLE so that it can be passed to ID3D12Fence::SetEventOnCompletion directly.
+typedef void* ComputeEvent;
+
+// Thread entry point
+typedef void (*ComputeThreadProc)(void *context);
+
+extern void ComputeMutexInit(ComputeMutex *mutex);
+extern void ComputeMutexDestroy(ComputeMutex *mutex);
+extern void ComputeMutexLock(ComputeMutex *mutex);
+extern void ComputeMutexUnlock(ComputeMutex *mutex);
+
+extern void ComputeConditionInit(ComputeCondition *cond);
+extern void ComputeConditionDestroy(ComputeCondition *cond);
+extern void ComputeConditionWait(ComputeCondition *cond, ComputeMutex *mutex);
+// Returns false when the timeout elapsed
+extern bool ComputeConditionTimedWait(ComputeCondition *cond, ComputeMutex *mutex, uint32_t timeoutMs);
+extern void ComputeConditionSignal(ComputeCondition *cond);
+extern void ComputeConditionBroadcast(ComputeCondition *cond);
+
+extern bool ComputeThreadCreate(ComputeThread *thread, ComputeThreadProc proc, void *context);
+extern void ComputeThreadJoin(ComputeThread thread);
+
+extern ComputeEvent ComputeEventCreate(void);
+extern void ComputeEventDestroy(ComputeEvent event);
+extern void ComputeEventSet(ComputeEvent event);
+// Returns false when the timeout elapsed
+extern bool ComputeEventWait(ComputeEvent event, uint32_t timeoutMs);
+
+// Number of logical processors of the host
+extern uint32_t ComputeGetProcessorCount(void);
+
+// The system identifier of the calling thread
+extern uint32_t ComputeGetCurrentThreadId(void);
+
+// Monotonic time in nanoseconds
+extern uint64_t ComputeGetTimeNanoseconds(void);
+
+// Suspend the calling thread. Windows rounds the time up to whole milliseconds.
+extern void ComputeSleepMicroseconds(uint64_t microseconds);
+
+extern void* ComputeAlignedAlloc(size_t size, size_t alignment);
+extern void ComputeAlignedFree(void *ptr);
+
+// ---- Atomic operations on 64-bit and 32-bit integers (sequentially consistent) ----
+
+#ifdef _MSC_VER
+
+static inline int64_t ComputeAtomicLoad64(volatile int64_t *ptr)
+{
+    return InterlockedCompareExchange64((volatile LONG64*)ptr, 0, 0);
+}
+
+static inline void ComputeAtomicStore64(volatile int64_t *ptr, int64_t value)
+{
+    InterlockedExchange64((volatile LONG64*)ptr, value);
+}
+
+// Returns the value before the addition
+static inline int64_t ComputeAtomicAdd64(volatile int64_t *ptr, int64_t value)
+{
+    return InterlockedExchangeAdd64((volatile LONG64*)ptr, value);
+}
+
+// Returns true if *ptr was equal to expected and has been replaced with desired
+static inline bool ComputeAtomicCompareExchange64(volatile int64_t *ptr, int64_t expected, int64_t desired)
+{
+    return InterlockedCompareExchange64((volatile LONG64*)ptr, desired, expected) == expected;
+}
+
+// The 32-bit versions, on the words of the buffers
+static inline uint32_t ComputeAtomicAdd32(volatile uint32_t *ptr, uint32_t value)
+{
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG*)ptr, (LONG)value);
+}
+
+static inline bool ComputeAtomicCompareExchange32(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+    return (uint32_t)InterlockedCompareExchange((volatile LONG*)ptr, (LONG)desired, (LONG)expected) == expected;
+}
+
+#else
+
+static inline int64_t ComputeAtomicLoad64(volatile int64_t *ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline void ComputeAtomicStore64(volatile int64_t *ptr, int64_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// Returns the value before the addition
+static inline int64_t ComputeAtomicAdd64(volatile int64_t *ptr, int64_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// Returns true if *ptr was equal to expected and has been replaced with desired
+static inline bool ComputeAtomicCompareExchange64(volatile int64_t *ptr, int64_t expected, int64_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// The 32-bit versions, on the words of the buffers
+static inline uint32_t ComputeAtomicAdd32(volatile uint32_t *ptr, uint32_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool ComputeAtomicCompareExchange32(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+#endif // COMPUTE_THREAD_H
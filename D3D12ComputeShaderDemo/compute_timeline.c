@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compute_timeline.h"
+#include "compute_trace.h"
+
+bool ComputeTimelineInit(ComputeTimeline *timeline, ComputeDevice *device, ComputeCommandQueue *queue)
+{
+    memset(timeline, 0, sizeof(*timeline));
+    timeline->queue = queue;
+
+    timeline->fence = device->lpVtbl->CreateFence(device, 0);
+    if (timeline->fence == NULL)
+    {
+        puts("Failed to create the timeline fence!");
+        return false;
+    }
+
+    timeline->event = ComputeEventCreate();
+    if (timeline->event == NULL)
+    {
+        puts("Failed to create event handle!");
+        timeline->fence->lpVtbl->Release(timeline->fence);
+        timeline->fence = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeTimelineDestroy(ComputeTimeline *timeline)
+{
+    if (timeline->fence != NULL && timeline->event != NULL)
+        ComputeTimelineWait(timeline, timeline->lastSignaledValue, COMPUTE_WAIT_INFINITE);
+
+    if (timeline->event != NULL)
+        ComputeEventDestroy(timeline->event);
+
+    if (timeline->fence != NULL)
+        timeline->fence->lpVtbl->Release(timeline->fence);
+
+    memset(timeline, 0, sizeof(*timeline));
+}
+
+uint64_t ComputeTimelineSignal(ComputeTimeline *timeline)
+{
+    const uint64_t value = timeline->lastSignaledValue + 1;
+
+    // Add an instruction to the command queue to set a new fence point.  Because we
+    // are on the GPU timeline, the new fence point won't be set until the GPU finishes
+    // processing all the commands prior to this Signal().
+    if (!timeline->queue->lpVtbl->Signal(timeline->queue, timeline->fence, value))
+    {
+        puts("Signal failed!");
+        return 0;
+    }
+
+    timeline->lastSignaledValue = value;
+    return value;
+}
+
+uint64_t ComputeTimelineGetCompletedValue(const ComputeTimeline *timeline)
+{
+    return timeline->fence->lpVtbl->GetCompletedValue(timeline->fence);
+}
+
+bool ComputeTimelineIsComplete(const ComputeTimeline *timeline, uint64_t value)
+{
+    return ComputeTimelineGetCompletedValue(timeline) >= value;
+}
+
+bool ComputeTimelineWait(ComputeTimeline *timeline, uint64_t value, uint32_t timeoutMs)
+{
+    if (ComputeTimelineIsComplete(timeline, value))
+        return true;
+    if (timeoutMs == 0)
+        return false;
+
+    COMPUTE_TRACE_CPU_BEGIN(traceScope, "Wait");
+    const uint64_t startTime = ComputeGetTimeNanoseconds();
+    bool result = false;
+
+    for (;;)
+    {
+        // Fire event when GPU hits the fence value.
+        if (!timeline->fence->lpVtbl->SetEventOnCompletion(timeline->fence, value, timeline->event))
+        {
+            puts("Set event failed!");
+            break;
+        }
+
+        uint32_t remainingMs = COMPUTE_WAIT_INFINITE;
+        if (timeoutMs != COMPUTE_WAIT_INFINITE)
+        {
+            const uint64_t elapsedMs = (ComputeGetTimeNanoseconds() - startTime) / 1000000;
+            remainingMs = elapsedMs >= timeoutMs ? 0 : timeoutMs - (uint32_t)elapsedMs;
+        }
+
+        // The event may have been set by an earlier wait that timed out, so always recheck the fence.
+        const bool signaled = ComputeEventWait(timeline->event, remainingMs);
+        if (ComputeTimelineIsComplete(timeline, value))
+        {
+            result = true;
+            break;
+        }
+        if (!signaled || remainingMs == 0)
+            break;
+    }
+
+    COMPUTE_TRACE_CPU_END(traceScope);
+    return result;
+}
+
+bool ComputeTimelineWaitOnQueue(ComputeTimeline *timeline, const ComputeTimeline *other, uint64_t value)
+{
+    // A queue executes its own submissions in order.
+    if (timeline == other || value == 0)
+        return true;
+
+    if (!timeline->queue->lpVtbl->Wait(timeline->queue, other->fence, value))
+    {
+        puts("Queue wait failed!");
+        return false;
+    }
+
+    return true;
+}
+
+bool ComputeTimelineFlush(ComputeTimeline *timeline)
+{
+    const uint64_t value = ComputeTimelineSignal(timeline);
+    if (value == 0)
+        return false;
+
+    return ComputeTimelineWait(timeline, value, COMPUTE_WAIT_INFINITE);
+}
+
+bool ComputeFrameRingInit(ComputeFrameRing *ring, ComputeDevice *device, ComputeTimeline *timeline,
+    uint32_t numFrames, ComputeCommandListType type)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (numFrames == 0 || numFrames > COMPUTE_MAX_FRAMES_IN_FLIGHT)
+    {
+        printf("The number of frames in flight must be in [1, %d]!\n", COMPUTE_MAX_FRAMES_IN_FLIGHT);
+        return false;
+    }
+
+    ring->timeline = timeline;
+    ring->type = type;
+    ring->numFrames = numFrames;
+
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        ComputeFrameContext *frame = &ring->frames[i];
+
+        frame->allocator = device->lpVtbl->CreateCommandAllocator(device, type);
+        if (frame->allocator == NULL)
+            break;
+
+        frame->commandList = device->lpVtbl->CreateCommandList(device, type, frame->allocator, NULL);
+        if (frame->commandList == NULL)
+            break;
+
+        // Command lists are created in the recording state.
+        if (!frame->commandList->lpVtbl->Close(frame->commandList))
+            break;
+
+        if (i + 1 == numFrames)
+            return true;
+    }
+
+    puts("Failed to create the frame contexts!");
+    ComputeFrameRingDestroy(ring);
+    return false;
+}
+
+void ComputeFrameRingDestroy(ComputeFrameRing *ring)
+{
+    for (uint32_t i = 0; i < ring->numFrames; i++)
+    {
+        ComputeFrameContext *frame = &ring->frames[i];
+
+        if (frame->fenceValue != 0)
+            ComputeTimelineWait(ring->timeline, frame->fenceValue, COMPUTE_WAIT_INFINITE);
+
+        if (frame->commandList != NULL)
+            frame->commandList->lpVtbl->Release(frame->commandList);
+
+        if (frame->prologueList != NULL)
+            frame->prologueList->lpVtbl->Release(frame->prologueList);
+
+        ComputeStateTrackerDestroy(&frame->tracker);
+
+        if (frame->allocator != NULL)
+            frame->allocator->lpVtbl->Release(frame->allocator);
+    }
+
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool ComputeFrameRingEnableStateTracking(ComputeFrameRing *ring, ComputeDevice *device, ComputeResourceStateTable *stateTable)
+{
+    for (uint32_t i = 0; i < ring->numFrames; i++)
+    {
+        ComputeFrameContext *frame = &ring->frames[i];
+
+        if (!ComputeStateTrackerInit(&frame->tracker))
+            return false;
+
+        // The prologue shares the allocator of the frame, it is recorded once the main command list is closed.
+        frame->prologueList = device->lpVtbl->CreateCommandList(device, ring->type, frame->allocator, NULL);
+        if (frame->prologueList == NULL || !frame->prologueList->lpVtbl->Close(frame->prologueList))
+        {
+            puts("Failed to create the prologue command lists!");
+            return false;
+        }
+    }
+
+    ring->stateTable = stateTable;
+    return true;
+}
+
+ComputeStateTracker* ComputeFrameRingGetStateTracker(ComputeFrameRing *ring)
+{
+    return ring->stateTable != NULL && ring->recording ? &ring->frames[ring->frameIndex].tracker : NULL;
+}
+
+ComputeCommandList* ComputeFrameRingBegin(ComputeFrameRing *ring, ComputePipelineState *pInitialState, uint32_t timeoutMs)
+{
+    if (ring->recording)
+    {
+        puts("The current frame has not been submitted!");
+        return NULL;
+    }
+
+    ComputeFrameContext *frame = &ring->frames[ring->frameIndex];
+
+    // The allocator can only be reset when the command lists recorded with it have finished execution.
+    if (!ComputeTimelineWait(ring->timeline, frame->fenceValue, timeoutMs))
+        return NULL;
+
+    if (!frame->allocator->lpVtbl->Reset(frame->allocator))
+        return NULL;
+
+    if (!frame->commandList->lpVtbl->Reset(frame->commandList, frame->allocator, pInitialState))
+        return NULL;
+
+    if (ring->stateTable != NULL)
+        ComputeStateTrackerReset(&frame->tracker);
+
+    ring->recording = true;
+    return frame->commandList;
+}
+
+uint64_t ComputeFrameRingSubmit(ComputeFrameRing *ring)
+{
+    if (!ring->recording)
+        return 0;
+
+    ComputeFrameContext *frame = &ring->frames[ring->frameIndex];
+    ring->recording = false;
+
+    if (ring->stateTable != NULL)
+        ComputeStateTrackerFinish(&frame->tracker, frame->commandList);
+
+    if (!frame->commandList->lpVtbl->Close(frame->commandList))
+        return 0;
+
+    ComputeCommandList *commandLists[2];
+    uint32_t numCommandLists = 0;
+
+    if (ring->stateTable != NULL)
+    {
+        const ComputeResourceBarrier *barriers;
+        const uint32_t numBarriers = ComputeStateTrackerResolve(&frame->tracker, ring->stateTable, &barriers);
+        if (numBarriers > 0)
+        {
+            ComputeCommandList *prologueList = frame->prologueList;
+            if (!prologueList->lpVtbl->Reset(prologueList, frame->allocator, NULL))
+                return 0;
+            prologueList->lpVtbl->ResourceBarrier(prologueList, numBarriers, barriers);
+            if (!prologueList->lpVtbl->Close(prologueList))
+                return 0;
+            commandLists[numCommandLists++] = prologueList;
+        }
+    }
+    commandLists[numCommandLists++] = frame->commandList;
+
+    COMPUTE_TRACE_CPU_BEGIN(traceScope, "Submit");
+    ComputeCommandQueue *queue = ring->timeline->queue;
+    queue->lpVtbl->ExecuteCommandLists(queue, numCommandLists, commandLists);
+
+    const uint64_t value = ComputeTimelineSignal(ring->timeline);
+    COMPUTE_TRACE_CPU_END(traceScope);
+    if (value == 0)
+        return 0;
+
+    frame->fenceValue = value;
+    ring->frameIndex = (ring->frameIndex + 1) % ring->numFrames;
+
+    return value;
+}
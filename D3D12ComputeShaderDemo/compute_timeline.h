@@ -0,0 +1,100 @@
+#ifndef COMPUTE_TIMELINE_H
+#define COMPUTE_TIMELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "resource_states.h"
+
+// The maximum number of submissions that a frame ring can keep in flight
+#define COMPUTE_MAX_FRAMES_IN_FLIGHT    8
+
+// One long-lived fence per command queue with monotonically increasing values.
+// Each submission signals the next value, so a fence value identifies a point on the queue's timeline.
+typedef struct ComputeTimeline
+{
+    ComputeCommandQueue *queue;
+    ComputeFence *fence;
+    // The event reused by every blocking wait
+    ComputeEvent event;
+    // The last value signaled on the queue. 0 means nothing has been signaled yet.
+    uint64_t lastSignaledValue;
+} ComputeTimeline;
+
+// The recording state of one submission slot
+typedef struct ComputeFrameContext
+{
+    ComputeCommandAllocator *allocator;
+    ComputeCommandList *commandList;
+    // The timeline value signaled after the slot's last submission, 0 if it has never been submitted
+    uint64_t fenceValue;
+    // With state tracking, the states needed by the command list,
+    // and the list executed before it with the barriers from the states left by the previous submissions
+    ComputeStateTracker tracker;
+    ComputeCommandList *prologueList;
+} ComputeFrameContext;
+
+// Rotates over N allocator/command list pairs so that recording the next batch
+// overlaps with the execution of the previous ones.
+typedef struct ComputeFrameRing
+{
+    ComputeTimeline *timeline;
+    ComputeCommandListType type;
+    uint32_t numFrames;
+    uint32_t frameIndex;
+    // Whether the current frame has been begun but not submitted yet
+    bool recording;
+    // The states shared by the submissions, NULL without state tracking
+    ComputeResourceStateTable *stateTable;
+    ComputeFrameContext frames[COMPUTE_MAX_FRAMES_IN_FLIGHT];
+} ComputeFrameRing;
+
+extern bool ComputeTimelineInit(ComputeTimeline *timeline, ComputeDevice *device, ComputeCommandQueue *queue);
+// Waits for all the signaled values before destroying the fence
+extern void ComputeTimelineDestroy(ComputeTimeline *timeline);
+
+// Signals the next value on the queue. Returns the signaled value, or 0 on failure.
+extern uint64_t ComputeTimelineSignal(ComputeTimeline *timeline);
+
+extern uint64_t ComputeTimelineGetCompletedValue(const ComputeTimeline *timeline);
+
+// Non-blocking poll
+extern bool ComputeTimelineIsComplete(const ComputeTimeline *timeline, uint64_t value);
+
+// Wait until the queue has reached the value.
+// timeoutMs may be 0 to poll, or COMPUTE_WAIT_INFINITE to block. Returns false when the timeout elapsed.
+extern bool ComputeTimelineWait(ComputeTimeline *timeline, uint64_t value, uint32_t timeoutMs);
+
+// Make the queue of the timeline wait on the GPU until the other timeline has reached the value,
+// so the commands submitted to it afterwards start after the other queue's work up to the value.
+// The CPU does not block. Nothing is needed when both timelines are the same.
+extern bool ComputeTimelineWaitOnQueue(ComputeTimeline *timeline, const ComputeTimeline *other, uint64_t value);
+
+// Signal and wait for the whole command queue completed
+extern bool ComputeTimelineFlush(ComputeTimeline *timeline);
+
+extern bool ComputeFrameRingInit(ComputeFrameRing *ring, ComputeDevice *device, ComputeTimeline *timeline,
+    uint32_t numFrames, ComputeCommandListType type);
+// Waits for all the in-flight frames before releasing the allocators and the command lists
+extern void ComputeFrameRingDestroy(ComputeFrameRing *ring);
+
+// Track the resource states in the command lists, resolving them against the table at submit.
+// Called once after init, before the first frame.
+extern bool ComputeFrameRingEnableStateTracking(ComputeFrameRing *ring, ComputeDevice *device, ComputeResourceStateTable *stateTable);
+
+// The state tracker of the frame being recorded, NULL without state tracking
+extern ComputeStateTracker* ComputeFrameRingGetStateTracker(ComputeFrameRing *ring);
+
+// Begin recording the next frame. The call only waits if the frame's slot is still in flight,
+// for at most timeoutMs. Returns the reset command list, or NULL on timeout or failure.
+extern ComputeCommandList* ComputeFrameRingBegin(ComputeFrameRing *ring, ComputePipelineState *pInitialState, uint32_t timeoutMs);
+
+// Close and execute the current frame's command list, then signal the timeline.
+// With state tracking, the barriers to the states the command list starts with are executed before it.
+// Returns the fence value that marks the completion of the frame, or 0 on failure.
+extern uint64_t ComputeFrameRingSubmit(ComputeFrameRing *ring);
+
+#endif // COMPUTE_TIMELINE_H
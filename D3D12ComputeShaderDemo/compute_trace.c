@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_trace.h"
+
+#ifdef COMPUTE_TRACE_ENABLED
+
+// The process ids of the two groups of tracks in the trace
+#define TRACE_CPU_PROCESS_ID    1
+#define TRACE_GPU_PROCESS_ID    2
+
+// A finished span. GPU spans are on the CPU clock once collected.
+typedef struct TraceSpan
+{
+    const char *name;
+    uint64_t startTime;
+    uint64_t endTime;
+    // The thread of a CPU span, or the track of a GPU span
+    uint32_t threadId;
+    uint32_t processId;
+} TraceSpan;
+
+// A traced queue. Span i owns the queries 2i and 2i+1 and the 16 bytes at 16i of the readback buffer.
+typedef struct TraceQueue
+{
+    ComputeTimeline *timeline;
+    const char *name;
+    ComputeQueryHeap *queryHeap;
+    ComputeResource *readbackBuffer;
+    uint64_t *pTimestamps;
+    uint64_t frequency;
+    // The spans begun since the last collection
+    uint32_t numSpans;
+    const char *spanNames[COMPUTE_TRACE_MAX_GPU_SPANS];
+} TraceQueue;
+
+static volatile int64_t s_started;
+static uint64_t s_startTime;
+
+// Reserved by an atomic increment, so the CPU spans are recorded without a lock
+static TraceSpan *s_spans;
+static volatile int64_t s_numSpans;
+static volatile int64_t s_numDroppedSpans;
+
+// The GPU spans are begun on several recording threads, the queue state is behind the mutex.
+static ComputeMutex s_mutex;
+static TraceQueue s_queues[COMPUTE_TRACE_MAX_QUEUES];
+static uint32_t s_numQueues;
+
+bool ComputeTraceStart(void)
+{
+    if (ComputeAtomicLoad64(&s_started) != 0)
+        return true;
+
+    s_spans = malloc(COMPUTE_TRACE_MAX_SPANS * sizeof(*s_spans));
+    if (s_spans == NULL)
+        return false;
+
+    ComputeMutexInit(&s_mutex);
+    s_numSpans = 0;
+    s_numDroppedSpans = 0;
+    s_numQueues = 0;
+    s_startTime = ComputeGetTimeNanoseconds();
+    ComputeAtomicStore64(&s_started, 1);
+    return true;
+}
+
+void ComputeTraceStop(void)
+{
+    if (ComputeAtomicLoad64(&s_started) == 0)
+        return;
+
+    ComputeAtomicStore64(&s_started, 0);
+
+    // The command lists in flight may still write the queries.
+    for (uint32_t i = 0; i < s_numQueues; i++)
+    {
+        TraceQueue *queue = &s_queues[i];
+        ComputeTimelineFlush(queue->timeline);
+
+        const ComputeRange writtenRange = { 0, 0 };
+        queue->readbackBuffer->lpVtbl->Unmap(queue->readbackBuffer, &writtenRange);
+        queue->readbackBuffer->lpVtbl->Release(queue->readbackBuffer);
+        queue->queryHeap->lpVtbl->Release(queue->queryHeap);
+    }
+    s_numQueues = 0;
+
+    ComputeMutexDestroy(&s_mutex);
+    free(s_spans);
+    s_spans = NULL;
+}
+
+bool ComputeTraceAddQueue(ComputeDevice *device, ComputeTimeline *timeline, ComputeCommandListType type, const char *name)
+{
+    if (ComputeAtomicLoad64(&s_started) == 0)
+        return true;
+    if (s_numQueues == COMPUTE_TRACE_MAX_QUEUES)
+        return false;
+
+    TraceQueue *queue = &s_queues[s_numQueues];
+    memset(queue, 0, sizeof(*queue));
+    queue->timeline = timeline;
+    queue->name = name;
+
+    if (!timeline->queue->lpVtbl->GetTimestampFrequency(timeline->queue, &queue->frequency) || queue->frequency == 0)
+    {
+        printf("No timestamps on the queue \"%s\", its commands are not traced.\n", name);
+        return false;
+    }
+
+    const ComputeQueryHeapDesc queryHeapDesc = {
+        type == COMPUTE_COMMAND_LIST_TYPE_COPY ? COMPUTE_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP : COMPUTE_QUERY_HEAP_TYPE_TIMESTAMP,
+        2 * COMPUTE_TRACE_MAX_GPU_SPANS
+    };
+    queue->queryHeap = device->lpVtbl->CreateQueryHeap(device, &queryHeapDesc);
+    if (queue->queryHeap == NULL)
+    {
+        printf("No timestamps on the queue \"%s\", its commands are not traced.\n", name);
+        return false;
+    }
+
+    // The queries are resolved straight into a readback buffer, which stays mapped.
+    const size_t readbackSize = 2 * COMPUTE_TRACE_MAX_GPU_SPANS * sizeof(uint64_t);
+    const ComputeResourceDesc readbackDesc = { readbackSize, COMPUTE_RESOURCE_FLAG_NONE };
+    queue->readbackBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_READBACK, &readbackDesc,
+        COMPUTE_RESOURCE_STATE_COPY_DEST);
+    const ComputeRange readRange = { 0, readbackSize };
+    if (queue->readbackBuffer == NULL ||
+        !queue->readbackBuffer->lpVtbl->Map(queue->readbackBuffer, &readRange, (void**)&queue->pTimestamps))
+    {
+        if (queue->readbackBuffer != NULL)
+            queue->readbackBuffer->lpVtbl->Release(queue->readbackBuffer);
+        queue->queryHeap->lpVtbl->Release(queue->queryHeap);
+        return false;
+    }
+
+    // Zero timestamps mark the spans that have not been resolved.
+    memset(queue->pTimestamps, 0, readbackSize);
+
+    ComputeMutexLock(&s_mutex);
+    s_numQueues++;
+    ComputeMutexUnlock(&s_mutex);
+    return true;
+}
+
+static void AddSpan(const char *name, uint64_t startTime, uint64_t endTime, uint32_t threadId, uint32_t processId)
+{
+    const int64_t index = ComputeAtomicAdd64(&s_numSpans, 1);
+    if (index >= COMPUTE_TRACE_MAX_SPANS)
+    {
+        ComputeAtomicAdd64(&s_numDroppedSpans, 1);
+        return;
+    }
+
+    TraceSpan *span = &s_spans[index];
+    span->name = name;
+    span->startTime = startTime;
+    span->endTime = endTime;
+    span->threadId = threadId;
+    span->processId = processId;
+}
+
+ComputeTraceScope ComputeTraceBeginCPU(const char *name)
+{
+    ComputeTraceScope scope = { NULL, 0 };
+    if (ComputeAtomicLoad64(&s_started) != 0)
+    {
+        scope.name = name;
+        scope.startTime = ComputeGetTimeNanoseconds();
+    }
+    return scope;
+}
+
+void ComputeTraceEndCPU(const ComputeTraceScope *scope)
+{
+    if (scope->name != NULL && ComputeAtomicLoad64(&s_started) != 0)
+        AddSpan(scope->name, scope->startTime, ComputeGetTimeNanoseconds(), ComputeGetCurrentThreadId(), TRACE_CPU_PROCESS_ID);
+}
+
+static TraceQueue* FindQueue(const ComputeTimeline *timeline)
+{
+    for (uint32_t i = 0; i < s_numQueues; i++)
+    {
+        if (s_queues[i].timeline == timeline)
+            return &s_queues[i];
+    }
+    return NULL;
+}
+
+uint32_t ComputeTraceBeginGPU(const ComputeTimeline *timeline, ComputeCommandList *commandList, const char *name)
+{
+    if (ComputeAtomicLoad64(&s_started) == 0)
+        return COMPUTE_TRACE_NO_SPAN;
+
+    ComputeMutexLock(&s_mutex);
+    TraceQueue *queue = FindQueue(timeline);
+    uint32_t span = COMPUTE_TRACE_NO_SPAN;
+    if (queue != NULL && queue->numSpans < COMPUTE_TRACE_MAX_GPU_SPANS)
+    {
+        span = queue->numSpans++;
+        queue->spanNames[span] = name;
+    }
+    else if (queue != NULL)
+        ComputeAtomicAdd64(&s_numDroppedSpans, 1);
+    ComputeMutexUnlock(&s_mutex);
+
+    if (span != COMPUTE_TRACE_NO_SPAN)
+        commandList->lpVtbl->EndQuery(commandList, queue->queryHeap, COMPUTE_QUERY_TYPE_TIMESTAMP, 2 * span);
+    return span;
+}
+
+void ComputeTraceEndGPU(const ComputeTimeline *timeline, ComputeCommandList *commandList, uint32_t span)
+{
+    if (span == COMPUTE_TRACE_NO_SPAN)
+        return;
+
+    ComputeMutexLock(&s_mutex);
+    TraceQueue *queue = FindQueue(timeline);
+    ComputeMutexUnlock(&s_mutex);
+    if (queue == NULL)
+        return;
+
+    commandList->lpVtbl->EndQuery(commandList, queue->queryHeap, COMPUTE_QUERY_TYPE_TIMESTAMP, 2 * span + 1);
+    commandList->lpVtbl->ResolveQueryData(commandList, queue->queryHeap, COMPUTE_QUERY_TYPE_TIMESTAMP, 2 * span, 2,
+        queue->readbackBuffer, 2 * span * sizeof(uint64_t));
+}
+
+bool ComputeTraceCollect(void)
+{
+    if (ComputeAtomicLoad64(&s_started) == 0)
+        return false;
+
+    bool result = true;
+    for (uint32_t i = 0; i < s_numQueues; i++)
+    {
+        TraceQueue *queue = &s_queues[i];
+        uint64_t gpuTimestamp, cpuTimestamp;
+        if (!ComputeTimelineFlush(queue->timeline) ||
+            !queue->timeline->queue->lpVtbl->GetClockCalibration(queue->timeline->queue, &gpuTimestamp, &cpuTimestamp))
+        {
+            result = false;
+            continue;
+        }
+
+        // The calibration is sampled right after the spans, so the clock drift between both is negligible.
+        const double nanosecondsPerTick = 1e9 / (double)queue->frequency;
+        for (uint32_t span = 0; span < queue->numSpans; span++)
+        {
+            const uint64_t begin = queue->pTimestamps[2 * span];
+            const uint64_t end = queue->pTimestamps[2 * span + 1];
+            if (begin == 0 || end < begin)
+            {
+                ComputeAtomicAdd64(&s_numDroppedSpans, 1);
+                continue;
+            }
+
+            const uint64_t startTime = cpuTimestamp - (uint64_t)((double)(int64_t)(gpuTimestamp - begin) * nanosecondsPerTick);
+            AddSpan(queue->spanNames[span], startTime, startTime + (uint64_t)((double)(end - begin) * nanosecondsPerTick),
+                i + 1, TRACE_GPU_PROCESS_ID);
+        }
+
+        memset(queue->pTimestamps, 0, 2 * queue->numSpans * sizeof(uint64_t));
+        queue->numSpans = 0;
+    }
+
+    return result;
+}
+
+// The names are literals of the code, only the characters JSON does not allow in strings are escaped.
+static void WriteJsonString(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*text >= 0x20)
+            fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+static double TraceMicroseconds(uint64_t time)
+{
+    return (double)(int64_t)(time - s_startTime) / 1000.0;
+}
+
+bool ComputeTraceWrite(const char *path)
+{
+    if (!ComputeTraceCollect())
+        return false;
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        printf("Failed to open %s!\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n", TRACE_CPU_PROCESS_ID);
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"GPU\"}}", TRACE_GPU_PROCESS_ID);
+    for (uint32_t i = 0; i < s_numQueues; i++)
+    {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", TRACE_GPU_PROCESS_ID, i + 1);
+        WriteJsonString(file, s_queues[i].name);
+        fputs("}}", file);
+    }
+
+    const int64_t numSpans = s_numSpans < COMPUTE_TRACE_MAX_SPANS ? s_numSpans : COMPUTE_TRACE_MAX_SPANS;
+    for (int64_t i = 0; i < numSpans; i++)
+    {
+        const TraceSpan *span = &s_spans[i];
+        fputs(",\n{\"name\":", file);
+        WriteJsonString(file, span->name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", span->processId, span->threadId,
+            TraceMicroseconds(span->startTime), (double)(span->endTime - span->startTime) / 1000.0);
+    }
+    fputs("\n]}\n", file);
+
+    const bool result = fclose(file) == 0;
+    if (s_numDroppedSpans > 0)
+        printf("The trace is missing %lld spans.\n", (long long)s_numDroppedSpans);
+    printf("Wrote %lld spans to %s.\n", (long long)numSpans, path);
+    return result;
+}
+
+#endif // COMPUTE_TRACE_ENABLED
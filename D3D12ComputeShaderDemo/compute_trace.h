@@ -0,0 +1,83 @@
+#ifndef COMPUTE_TRACE_H
+#define COMPUTE_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+
+// Spans of CPU work and of GPU commands on one timeline, written as a Chrome trace (chrome://tracing or Perfetto).
+// The CPU spans are timed with ComputeGetTimeNanoseconds on the thread that runs them. The GPU spans are pairs of
+// timestamp queries around the commands, resolved into a readback buffer and moved to the CPU clock with the
+// calibration of their queue.
+// The layer is only built with COMPUTE_TRACE_ENABLED defined. Without it the COMPUTE_TRACE_* macros expand to nothing,
+// so the instrumented code is the same as without instrumentation.
+// The span names are not copied, they must be string literals or outlive the trace.
+
+#ifdef COMPUTE_TRACE_ENABLED
+
+// The spans kept until the trace is written, more are dropped
+#define COMPUTE_TRACE_MAX_SPANS         65536
+
+// The GPU spans recorded on one queue between two collections, more are dropped
+#define COMPUTE_TRACE_MAX_GPU_SPANS     1024
+
+// The maximum number of traced queues
+#define COMPUTE_TRACE_MAX_QUEUES        4
+
+// A span that is not recorded, because the trace is not started or is full
+#define COMPUTE_TRACE_NO_SPAN           UINT32_MAX
+
+typedef struct ComputeTraceScope
+{
+    // NULL if the span is not recorded
+    const char *name;
+    uint64_t startTime;
+} ComputeTraceScope;
+
+// Start recording. Nothing is recorded before, and the calls below return right away.
+extern bool ComputeTraceStart(void);
+
+// Flush the queues and release everything. Called before the device and the timelines are destroyed.
+extern void ComputeTraceStop(void);
+
+// Trace the GPU commands of the queue of the timeline, on a track of the given name.
+// The command list type is the one of the queue: copy queues need a timestamp heap of their own,
+// which not every device supports.
+extern bool ComputeTraceAddQueue(ComputeDevice *device, ComputeTimeline *timeline, ComputeCommandListType type, const char *name);
+
+extern ComputeTraceScope ComputeTraceBeginCPU(const char *name);
+extern void ComputeTraceEndCPU(const ComputeTraceScope *scope);
+
+// Record a timestamp into the command list before the commands of the span, on the queue of the timeline.
+// Returns the span to end, or COMPUTE_TRACE_NO_SPAN.
+extern uint32_t ComputeTraceBeginGPU(const ComputeTimeline *timeline, ComputeCommandList *commandList, const char *name);
+// Record the closing timestamp and resolve both into the readback buffer of the queue
+extern void ComputeTraceEndGPU(const ComputeTimeline *timeline, ComputeCommandList *commandList, uint32_t span);
+
+// Wait for the traced queues, and move the GPU spans submitted so far to the trace.
+// No command list may be recorded with GPU spans meanwhile. The spans of lists that were never submitted are dropped.
+extern bool ComputeTraceCollect(void);
+
+// Collect the GPU spans and write the trace file
+extern bool ComputeTraceWrite(const char *path);
+
+#define COMPUTE_TRACE_CPU_BEGIN(scope, name)    const ComputeTraceScope scope = ComputeTraceBeginCPU(name)
+#define COMPUTE_TRACE_CPU_END(scope)            ComputeTraceEndCPU(&scope)
+
+#define COMPUTE_TRACE_GPU_BEGIN(span, timeline, commandList, name) \
+    const uint32_t span = ComputeTraceBeginGPU(timeline, commandList, name)
+#define COMPUTE_TRACE_GPU_END(span, timeline, commandList)  ComputeTraceEndGPU(timeline, commandList, span)
+
+#else
+
+#define COMPUTE_TRACE_CPU_BEGIN(scope, name)
+#define COMPUTE_TRACE_CPU_END(scope)
+#define COMPUTE_TRACE_GPU_BEGIN(span, timeline, commandList, name)
+#define COMPUTE_TRACE_GPU_END(span, timeline, commandList)
+
+#endif // COMPUTE_TRACE_ENABLED
+
+#endif // COMPUTE_TRACE_H
@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "compute_utils.h"
+#include "host_copy.h"
+
+// Row-by-row copy to the upload memory, in one piece when the rows and the slices are contiguous
+void MemcpySubresource(
+    const ComputeMemcpyDest* pDest,
+    const ComputeSubresourceData* pSrc,
+    size_t RowSizeInBytes,
+    uint32_t NumRows,
+    uint32_t NumSlices)
+{
+    const size_t sliceSize = RowSizeInBytes * NumRows;
+    if ((NumRows <= 1 || (pDest->RowPitch == RowSizeInBytes && (size_t)pSrc->RowPitch == RowSizeInBytes)) &&
+        (NumSlices <= 1 || (pDest->SlicePitch == sliceSize && (size_t)pSrc->SlicePitch == sliceSize)))
+    {
+        ComputeHostCopy(pDest->pData, pSrc->pData, sliceSize * NumSlices);
+        return;
+    }
+
+    for (uint32_t z = 0; z < NumSlices; ++z)
+    {
+        uint8_t* pDestSlice = (uint8_t*)(pDest->pData) + pDest->SlicePitch * z;
+        const uint8_t* pSrcSlice = (const uint8_t*)(pSrc->pData) + pSrc->SlicePitch * z;
+        for (uint32_t y = 0; y < NumRows; ++y)
+        {
+            ComputeHostCopy(pDestSlice + pDest->RowPitch * y,
+                pSrcSlice + pSrc->RowPitch * y,
+                RowSizeInBytes);
+        }
+    }
+}
+
+// Updates subresources, all the subresource arrays should be populated.
+// This function is the C-style implementation translated from C++ style inline function in the D3DX12 library,
+// reduced to the buffer case since the device abstraction only has buffer resources.
+// A buffer has exactly one subresource with one row, so its copyable footprint is the whole buffer width.
+size_t UpdateSubresources(
+    ComputeCommandList *commandList,
+    ComputeResource* pDestinationResource,
+    ComputeResource* pIntermediate,
+    uint64_t IntermediateOffset,
+    uint32_t FirstSubresource,
+    uint32_t NumSubresources,
+    const ComputeSubresourceData* pSrcData)
+{
+    ComputeResourceDesc DestinationDesc;
+    pDestinationResource->lpVtbl->GetDesc(pDestinationResource, &DestinationDesc);
+
+    ComputeResourceDesc IntermediateDesc;
+    pIntermediate->lpVtbl->GetDesc(pIntermediate, &IntermediateDesc);
+
+    const uint64_t RequiredSize = DestinationDesc.Width;
+
+    // Minor validation
+    if (IntermediateDesc.Width < RequiredSize + IntermediateOffset ||
+        RequiredSize > (size_t)-1 ||
+        FirstSubresource != 0 || NumSubresources != 1)
+    {
+        return 0;
+    }
+
+    uint8_t* pData;
+    if (!pIntermediate->lpVtbl->Map(pIntermediate, NULL, (void**)&pData))
+        return 0;
+
+    const ComputeMemcpyDest DestData = { pData + IntermediateOffset, (size_t)RequiredSize, (size_t)RequiredSize };
+    MemcpySubresource(&DestData, pSrcData, (size_t)RequiredSize, 1, 1);
+
+    pIntermediate->lpVtbl->Unmap(pIntermediate, NULL);
+
+    commandList->lpVtbl->CopyBufferRegion(commandList,
+        pDestinationResource, 0, pIntermediate, IntermediateOffset, RequiredSize);
+
+    return (size_t)RequiredSize;
+}
+
+// Same as UpdateSubresources, but stages the data in the persistently mapped upload ring,
+// so there is neither an upload heap allocation nor a Map/Unmap for each update.
+size_t UpdateSubresourcesFromRing(
+    ComputeCommandList *commandList,
+    ComputeResource* pDestinationResource,
+    ComputeUploadRing* pUploadRing,
+    uint32_t FirstSubresource,
+    uint32_t NumSubresources,
+    const ComputeSubresourceData* pSrcData)
+{
+    ComputeResourceDesc DestinationDesc;
+    pDestinationResource->lpVtbl->GetDesc(pDestinationResource, &DestinationDesc);
+
+    const uint64_t RequiredSize = DestinationDesc.Width;
+
+    // Minor validation
+    if (RequiredSize > (size_t)-1 || FirstSubresource != 0 || NumSubresources != 1)
+        return 0;
+
+    ComputeUploadAllocation allocation;
+    if (!ComputeUploadRingAllocate(pUploadRing, RequiredSize, COMPUTE_UPLOAD_ALIGNMENT, COMPUTE_WAIT_INFINITE, &allocation))
+        return 0;
+
+    const ComputeMemcpyDest DestData = { allocation.pData, (size_t)RequiredSize, (size_t)RequiredSize };
+    MemcpySubresource(&DestData, pSrcData, (size_t)RequiredSize, 1, 1);
+
+    commandList->lpVtbl->CopyBufferRegion(commandList,
+        pDestinationResource, 0, allocation.resource, allocation.offset, RequiredSize);
+
+    return (size_t)RequiredSize;
+}
+
+uint32_t ComputeFormatGetSize(ComputeFormat format)
+{
+    switch (format)
+    {
+    case COMPUTE_FORMAT_R32G32B32A32_FLOAT:
+    case COMPUTE_FORMAT_R32G32B32A32_UINT:
+        return 16;
+    case COMPUTE_FORMAT_R32G32_FLOAT:
+    case COMPUTE_FORMAT_R32G32_UINT:
+        return 8;
+    case COMPUTE_FORMAT_R32_TYPELESS:
+    case COMPUTE_FORMAT_R32_FLOAT:
+    case COMPUTE_FORMAT_R32_UINT:
+    case COMPUTE_FORMAT_R32_SINT:
+        return 4;
+    case COMPUTE_FORMAT_R16_FLOAT:
+    case COMPUTE_FORMAT_R16_UINT:
+    case COMPUTE_FORMAT_R16_SINT:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+uint32_t ComputeDispatchElements(
+    ComputeCommandList *commandList,
+    uint32_t rootParameterIndex,
+    uint32_t numElements,
+    uint32_t elementsPerGroup)
+{
+    if (elementsPerGroup == 0)
+        return 0;
+
+    // At most 2^32 - 1 groups, so the linear group index always fits in 32 bits.
+    const uint64_t totalGroups = ((uint64_t)numElements + elementsPerGroup - 1) / elementsPerGroup;
+
+    return ComputeDispatchGroupRange(commandList, rootParameterIndex, numElements, 0, (uint32_t)totalGroups);
+}
+
+uint32_t ComputeDispatchGroupRange(
+    ComputeCommandList *commandList,
+    uint32_t rootParameterIndex,
+    uint32_t numElements,
+    uint32_t firstGroup,
+    uint32_t numGroups)
+{
+    const uint64_t endGroup = (uint64_t)firstGroup + numGroups;
+
+    uint32_t numDispatches = 0;
+    for (uint64_t baseGroup = firstGroup; baseGroup < endGroup; numDispatches++)
+    {
+        const uint64_t remainingGroups = endGroup - baseGroup;
+
+        uint32_t groupsX, groupsY;
+        if (remainingGroups <= COMPUTE_MAX_DISPATCH_GROUPS)
+        {
+            groupsX = (uint32_t)remainingGroups;
+            groupsY = 1;
+        }
+        else
+        {
+            groupsX = COMPUTE_MAX_DISPATCH_GROUPS;
+            groupsY = remainingGroups / COMPUTE_MAX_DISPATCH_GROUPS < COMPUTE_MAX_DISPATCH_GROUPS ?
+                (uint32_t)(remainingGroups / COMPUTE_MAX_DISPATCH_GROUPS) : COMPUTE_MAX_DISPATCH_GROUPS;
+        }
+
+        const ComputeDispatchConstants constants = { numElements, (uint32_t)baseGroup, groupsX };
+        commandList->lpVtbl->SetComputeRoot32BitConstants(commandList, rootParameterIndex,
+            COMPUTE_DISPATCH_CONSTANTS_COUNT, &constants, 0);
+        commandList->lpVtbl->Dispatch(commandList, groupsX, groupsY, 1);
+
+        baseGroup += (uint64_t)groupsX * groupsY;
+    }
+
+    return numDispatches;
+}
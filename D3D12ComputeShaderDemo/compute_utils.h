@@ -0,0 +1,71 @@
+#ifndef COMPUTE_UTILS_H
+#define COMPUTE_UTILS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "upload_ring.h"
+
+// Layout compatible with D3D12_MEMCPY_DEST
+typedef struct ComputeMemcpyDest
+{
+    void *pData;
+    size_t RowPitch;
+    size_t SlicePitch;
+} ComputeMemcpyDest;
+
+// Layout compatible with D3D12_SUBRESOURCE_DATA
+typedef struct ComputeSubresourceData
+{
+    const void *pData;
+    intptr_t RowPitch;
+    intptr_t SlicePitch;
+} ComputeSubresourceData;
+
+// Row-by-row copy to upload memory with ComputeHostCopy
+extern void MemcpySubresource(const ComputeMemcpyDest *pDest, const ComputeSubresourceData *pSrc,
+    size_t RowSizeInBytes, uint32_t NumRows, uint32_t NumSlices);
+
+// Updates the buffer subresource through the intermediate upload buffer.
+// Returns the number of bytes staged in the intermediate buffer, or 0 on failure.
+extern size_t UpdateSubresources(ComputeCommandList *commandList, ComputeResource *pDestinationResource,
+    ComputeResource *pIntermediate, uint64_t IntermediateOffset, uint32_t FirstSubresource,
+    uint32_t NumSubresources, const ComputeSubresourceData *pSrcData);
+
+// Updates the buffer subresource through a sub-allocation of the upload ring.
+// Returns the number of bytes staged in the ring, or 0 on failure.
+extern size_t UpdateSubresourcesFromRing(ComputeCommandList *commandList, ComputeResource *pDestinationResource,
+    ComputeUploadRing *pUploadRing, uint32_t FirstSubresource, uint32_t NumSubresources, const ComputeSubresourceData *pSrcData);
+
+// The size in bytes of an element of the format, a 32-bit word for R32_TYPELESS. Returns 0 for UNKNOWN.
+extern uint32_t ComputeFormatGetSize(ComputeFormat format);
+
+// The root constants of the elementwise kernels, matching their DispatchConstants cbuffer
+typedef struct ComputeDispatchConstants
+{
+    // The number of valid elements. The threads past it do nothing.
+    uint32_t NumElements;
+    // The linear index of the first thread group of the Dispatch
+    uint32_t BaseGroup;
+    // The X size of the Dispatch. The linear group index is BaseGroup + Y * GroupsPerRow + X.
+    uint32_t GroupsPerRow;
+} ComputeDispatchConstants;
+
+#define COMPUTE_DISPATCH_CONSTANTS_COUNT    (sizeof(ComputeDispatchConstants) / sizeof(uint32_t))
+
+// Dispatches one thread group per elementsPerGroup elements, whatever the element count.
+// Up to 65535 groups are dispatched in 1D. Beyond that the groups are folded into full rows of a 2D grid,
+// followed by one more 1D Dispatch for the remainder, so that no group is launched past the last element.
+// The constants of each Dispatch are set to the root parameter rootParameterIndex.
+// Returns the number of Dispatch calls recorded.
+extern uint32_t ComputeDispatchElements(ComputeCommandList *commandList, uint32_t rootParameterIndex,
+    uint32_t numElements, uint32_t elementsPerGroup);
+
+// Dispatches the groups [firstGroup, firstGroup + numGroups) of a job of numElements elements the same way,
+// so a large job can be split across several command lists.
+extern uint32_t ComputeDispatchGroupRange(ComputeCommandList *commandList, uint32_t rootParameterIndex,
+    uint32_t numElements, uint32_t firstGroup, uint32_t numGroups);
+
+#endif // COMPUTE_UTILS_H
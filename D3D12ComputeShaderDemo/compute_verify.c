@@ -0,0 +1,350 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_verify.h"
+#include "compute_utils.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMPUTE_VERIFY_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define COMPUTE_VERIFY_NEON
+#endif
+
+// The inputs shorter than this are checked on the calling thread
+#define VERIFY_PARALLEL_THRESHOLD   (64 * 1024)
+// The maximum number of chunks of a host check
+#define VERIFY_MAX_CHUNKS           64
+// The number of generated expected elements checked at once
+#define VERIFY_BLOCK_SIZE           256
+
+// ---- Device ----
+
+bool ComputeVerifierInit(ComputeVerifier *verifier, ComputeShaderCache *shaderCache, const char *fileName, uint32_t compileFlags)
+{
+    memset(verifier, 0, sizeof(*verifier));
+
+    char maxIndices[16];
+    snprintf(maxIndices, sizeof(maxIndices), "%u", COMPUTE_VERIFY_MAX_INDICES);
+    const ComputeShaderMacro defines[] = { { "GROUP_SIZE", "256" }, { "MAX_INDICES", maxIndices }, { NULL, NULL } };
+
+    ComputeDevice *device = shaderCache->device;
+    ComputeBlob *shaders[2] = { NULL, NULL };
+    if (!ComputeShaderCacheCompile(shaderCache, fileName, defines, "VerifyElements", "cs_5_0", compileFlags, &shaders[0]) ||
+        !ComputeShaderCacheCompile(shaderCache, fileName, defines, "VerifyReset", "cs_5_0", compileFlags, &shaders[1]))
+    {
+        if (shaders[0] != NULL)
+            shaders[0]->lpVtbl->Release(shaders[0]);
+        return false;
+    }
+
+    // The reset only writes u0, so it shares the root signature of the comparison.
+    ComputePipelineStateDesc psoDescs[2] = { { 0 }, { 0 } };
+    for (uint32_t i = 0; i < 2; i++)
+        psoDescs[i].CS = (ComputeShaderBytecode){ shaders[i]->lpVtbl->GetBufferPointer(shaders[i]), shaders[i]->lpVtbl->GetBufferSize(shaders[i]) };
+
+    ComputeShaderReflection reflection;
+    bool created = device->lpVtbl->ReflectShader(device, &psoDescs[0].CS, &reflection) &&
+        ComputeRootLayoutCreate(&verifier->layout, device, &reflection, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS) &&
+        verifier->layout.numConstants[0] >= COMPUTE_DISPATCH_CONSTANTS_COUNT + COMPUTE_VERIFY_CONSTANTS_COUNT;
+    if (created)
+    {
+        psoDescs[0].pRootSignature = verifier->layout.rootSignature;
+        psoDescs[1].pRootSignature = verifier->layout.rootSignature;
+        verifier->pipelineState = ComputeShaderCacheCreatePipelineState(shaderCache, &psoDescs[0]);
+        verifier->resetPipelineState = ComputeShaderCacheCreatePipelineState(shaderCache, &psoDescs[1]);
+        verifier->groupSize = reflection.ThreadGroupSize[0];
+        created = verifier->pipelineState != NULL && verifier->resetPipelineState != NULL;
+    }
+
+    shaders[0]->lpVtbl->Release(shaders[0]);
+    shaders[1]->lpVtbl->Release(shaders[1]);
+    if (!created)
+    {
+        puts("Failed to create the verification kernels!");
+        ComputeVerifierDestroy(verifier);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeVerifierDestroy(ComputeVerifier *verifier)
+{
+    if (verifier->pipelineState != NULL)
+        verifier->pipelineState->lpVtbl->Release(verifier->pipelineState);
+    if (verifier->resetPipelineState != NULL)
+        verifier->resetPipelineState->lpVtbl->Release(verifier->resetPipelineState);
+    ComputeRootLayoutDestroy(&verifier->layout);
+    memset(verifier, 0, sizeof(*verifier));
+}
+
+bool ComputeVerifierRecord(ComputeVerifier *verifier, ComputeCommandList *commandList, const ComputeVerifyDesc *desc,
+    ComputeResource *actual, ComputeResource *expected, ComputeResource *result, uint32_t numElements)
+{
+    if ((uint32_t)desc->ElementType > COMPUTE_ELEMENT_TYPE_FLOAT ||
+        (desc->Expected == COMPUTE_VERIFY_EXPECTED_BUFFER && expected == NULL))
+    {
+        puts("Invalid verification!");
+        return false;
+    }
+
+    const ComputeRootLayout *layout = &verifier->layout;
+    commandList->lpVtbl->SetComputeRootSignature(commandList, layout->rootSignature);
+    // t1 is not read by the generator, but every root parameter is set before a Dispatch.
+    if (!ComputeRootLayoutSetSRV(layout, commandList, 0, actual, 0) ||
+        !ComputeRootLayoutSetSRV(layout, commandList, 1, expected != NULL ? expected : actual, 0) ||
+        !ComputeRootLayoutSetUAV(layout, commandList, 0, result, 0))
+        return false;
+
+    const ComputeResourceBarrier barrier = {
+        .Type = COMPUTE_RESOURCE_BARRIER_TYPE_UAV, .Flags = COMPUTE_RESOURCE_BARRIER_FLAG_NONE, .pResource = NULL
+    };
+
+    commandList->lpVtbl->SetPipelineState(commandList, verifier->resetPipelineState);
+    commandList->lpVtbl->Dispatch(commandList, 1, 1, 1);
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &barrier);
+
+    const ComputeVerifyConstants constants = {
+        (uint32_t)desc->ElementType, (uint32_t)desc->Expected, desc->First.Uint, desc->Step.Uint, desc->Tolerance
+    };
+    commandList->lpVtbl->SetPipelineState(commandList, verifier->pipelineState);
+    commandList->lpVtbl->SetComputeRoot32BitConstants(commandList, layout->constantsParameters[0], COMPUTE_VERIFY_CONSTANTS_COUNT,
+        &constants, COMPUTE_DISPATCH_CONSTANTS_COUNT);
+    ComputeDispatchElements(commandList, layout->constantsParameters[0], numElements, verifier->groupSize);
+    commandList->lpVtbl->ResourceBarrier(commandList, 1, &barrier);
+
+    return true;
+}
+
+static int CompareIndices(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+void ComputeVerifyReadResult(const void *pData, ComputeVerifyResult *result)
+{
+    uint32_t words[2 + COMPUTE_VERIFY_MAX_INDICES];
+    memcpy(words, pData, sizeof(words));
+
+    memset(result, 0, sizeof(*result));
+    result->NumMismatches = words[0];
+    result->FirstMismatch = words[0] > 0 ? words[1] : UINT64_MAX;
+    result->NumIndices = words[0] < COMPUTE_VERIFY_MAX_INDICES ? words[0] : COMPUTE_VERIFY_MAX_INDICES;
+    for (uint32_t i = 0; i < result->NumIndices; i++)
+        result->Indices[i] = words[2 + i];
+
+    // The slots are taken in the order the mismatches are found
+    qsort(result->Indices, result->NumIndices, sizeof(result->Indices[0]), CompareIndices);
+}
+
+// ---- Host ----
+
+static bool ElementsMatch(uint32_t value, uint32_t reference, bool isFloat, float tolerance)
+{
+    if (value == reference)
+        return true;
+    if (!isFloat)
+        return false;
+
+    float a, b;
+    memcpy(&a, &value, sizeof(a));
+    memcpy(&b, &reference, sizeof(b));
+    return fabsf(a - b) <= tolerance;
+}
+
+// The offset of the first mismatch of the elements, or count if they all match
+static size_t FindMismatch(const uint32_t *actual, const uint32_t *reference, size_t count, bool isFloat, float tolerance)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 vTolerance = _mm256_set1_ps(tolerance);
+    const __m256 vAbsMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(actual + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i*)(reference + i));
+        __m256 match = _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b));
+        if (isFloat)
+        {
+            const __m256 difference = _mm256_and_ps(_mm256_sub_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)), vAbsMask);
+            match = _mm256_or_ps(match, _mm256_cmp_ps(difference, vTolerance, _CMP_LE_OQ));
+        }
+        if (_mm256_movemask_ps(match) != 0xff)
+            break;
+    }
+#elif defined(COMPUTE_VERIFY_SSE2)
+    const __m128 vTolerance = _mm_set1_ps(tolerance);
+    const __m128 vAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(actual + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(reference + i));
+        __m128 match = _mm_castsi128_ps(_mm_cmpeq_epi32(a, b));
+        if (isFloat)
+        {
+            const __m128 difference = _mm_and_ps(_mm_sub_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)), vAbsMask);
+            match = _mm_or_ps(match, _mm_cmple_ps(difference, vTolerance));
+        }
+        if (_mm_movemask_ps(match) != 0xf)
+            break;
+    }
+#elif defined(COMPUTE_VERIFY_NEON)
+    const float32x4_t vTolerance = vdupq_n_f32(tolerance);
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint32x4_t a = vld1q_u32(actual + i);
+        const uint32x4_t b = vld1q_u32(reference + i);
+        uint32x4_t match = vceqq_u32(a, b);
+        if (isFloat)
+        {
+            const float32x4_t difference = vabsq_f32(vsubq_f32(vreinterpretq_f32_u32(a), vreinterpretq_f32_u32(b)));
+            match = vorrq_u32(match, vcleq_f32(difference, vTolerance));
+        }
+        uint32x2_t lanes = vpmin_u32(vget_low_u32(match), vget_high_u32(match));
+        lanes = vpmin_u32(lanes, lanes);
+        if (vget_lane_u32(lanes, 0) == 0)
+            break;
+    }
+#endif
+
+    // The rest, and the vector with the mismatch
+    for (; i < count; i++)
+    {
+        if (!ElementsMatch(actual[i], reference[i], isFloat, tolerance))
+            return i;
+    }
+    return count;
+}
+
+// The expected elements [begin, begin + count) of the linear generator
+static void GenerateExpected(const ComputeVerifyDesc *desc, size_t begin, size_t count, uint32_t *reference)
+{
+    if (desc->ElementType == COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        // The product and the sum in separate loops, so that they are not contracted into a fused multiply-add
+        // that the kernel does not do either.
+        float *values = (float*)reference;
+        for (size_t i = 0; i < count; i++)
+            values[i] = (float)(uint32_t)(begin + i) * desc->Step.Float;
+        for (size_t i = 0; i < count; i++)
+            values[i] = desc->First.Float + values[i];
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+            reference[i] = desc->First.Uint + (uint32_t)(begin + i) * desc->Step.Uint;
+    }
+}
+
+static void AddMismatch(ComputeVerifyResult *result, uint64_t index)
+{
+    if (result->NumMismatches == 0)
+        result->FirstMismatch = index;
+    if (result->NumIndices < COMPUTE_VERIFY_MAX_INDICES)
+        result->Indices[result->NumIndices++] = index;
+    result->NumMismatches++;
+}
+
+void ComputeVerifyHostRange(const ComputeVerifyDesc *desc, const void *actual, const void *expected,
+    size_t begin, size_t end, ComputeVerifyResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->FirstMismatch = UINT64_MAX;
+
+    const bool isFloat = desc->ElementType == COMPUTE_ELEMENT_TYPE_FLOAT;
+    const uint32_t *values = actual;
+    uint32_t generated[VERIFY_BLOCK_SIZE];
+
+    for (size_t blockBegin = begin; blockBegin < end; blockBegin += VERIFY_BLOCK_SIZE)
+    {
+        const size_t count = end - blockBegin < VERIFY_BLOCK_SIZE ? end - blockBegin : VERIFY_BLOCK_SIZE;
+        const uint32_t *reference = generated;
+        if (desc->Expected == COMPUTE_VERIFY_EXPECTED_BUFFER)
+            reference = (const uint32_t*)expected + blockBegin;
+        else
+            GenerateExpected(desc, blockBegin, count, generated);
+
+        // Skip to each mismatch, most blocks having none
+        for (size_t i = 0; i < count; i++)
+        {
+            i += FindMismatch(values + blockBegin + i, reference + i, count - i, isFloat, desc->Tolerance);
+            if (i < count)
+                AddMismatch(result, blockBegin + i);
+        }
+    }
+}
+
+typedef struct VerifyTask
+{
+    const ComputeVerifyDesc *desc;
+    const void *actual;
+    const void *expected;
+    size_t count;
+    size_t chunkSize;
+    ComputeVerifyResult chunkResults[VERIFY_MAX_CHUNKS];
+} VerifyTask;
+
+static void VerifyChunks(void *context, size_t begin, size_t end)
+{
+    VerifyTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        const size_t first = chunk * task->chunkSize < task->count ? chunk * task->chunkSize : task->count;
+        const size_t last = task->count - first > task->chunkSize ? first + task->chunkSize : task->count;
+        ComputeVerifyHostRange(task->desc, task->actual, task->expected, first, last, &task->chunkResults[chunk]);
+    }
+}
+
+void ComputeVerifyHost(ThreadPool *pool, const ComputeVerifyDesc *desc, const void *actual, const void *expected,
+    size_t count, ComputeVerifyResult *result)
+{
+    VerifyTask *task = malloc(sizeof(*task));
+    if (task == NULL)
+    {
+        ComputeVerifyHostRange(desc, actual, expected, 0, count, result);
+        return;
+    }
+
+    // One chunk per thread of the pool, or a single chunk when the input is small
+    size_t numChunks = 1;
+    if (pool != NULL && count >= VERIFY_PARALLEL_THRESHOLD)
+    {
+        numChunks = ThreadPoolGetThreadCount(pool);
+        if (numChunks > VERIFY_MAX_CHUNKS)
+            numChunks = VERIFY_MAX_CHUNKS;
+    }
+
+    task->desc = desc;
+    task->actual = actual;
+    task->expected = expected;
+    task->count = count;
+    task->chunkSize = (count + numChunks - 1) / numChunks;
+    if (numChunks > 1)
+        ThreadPoolParallelFor(pool, numChunks, 1, VerifyChunks, task);
+    else
+        VerifyChunks(task, 0, numChunks);
+
+    // The chunks are in order, so the first indices of the buffer are the first ones of the first chunks.
+    memset(result, 0, sizeof(*result));
+    result->FirstMismatch = UINT64_MAX;
+    for (size_t chunk = 0; chunk < numChunks; chunk++)
+    {
+        const ComputeVerifyResult *chunkResult = &task->chunkResults[chunk];
+        if (result->NumMismatches == 0)
+            result->FirstMismatch = chunkResult->FirstMismatch;
+        for (uint32_t i = 0; i < chunkResult->NumIndices && result->NumIndices < COMPUTE_VERIFY_MAX_INDICES; i++)
+            result->Indices[result->NumIndices++] = chunkResult->Indices[i];
+        result->NumMismatches += chunkResult->NumMismatches;
+    }
+
+    free(task);
+}
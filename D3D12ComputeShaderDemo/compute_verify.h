@@ -0,0 +1,109 @@
+#ifndef COMPUTE_VERIFY_H
+#define COMPUTE_VERIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "root_layout.h"
+#include "shader_cache.h"
+#include "thread_pool.h"
+#include "typed_buffer.h"
+
+// The number of mismatch indices reported, MAX_INDICES in verify.hlsl
+#define COMPUTE_VERIFY_MAX_INDICES  16
+
+// The size of the result buffer written by the device: the number of mismatches, the lowest mismatch index,
+// and the slots of the indices
+#define COMPUTE_VERIFY_RESULT_SIZE  ((2 + COMPUTE_VERIFY_MAX_INDICES) * sizeof(uint32_t))
+
+// What the elements are compared against
+typedef enum ComputeVerifyExpected
+{
+    // A buffer of the expected elements
+    COMPUTE_VERIFY_EXPECTED_BUFFER,
+    // The generator First + index * Step, so no expected data has to be uploaded
+    COMPUTE_VERIFY_EXPECTED_LINEAR
+} ComputeVerifyExpected;
+
+typedef union ComputeVerifyValue
+{
+    int32_t Int;
+    uint32_t Uint;
+    float Float;
+} ComputeVerifyValue;
+
+typedef struct ComputeVerifyDesc
+{
+    // int, uint or float
+    ComputeElementType ElementType;
+    ComputeVerifyExpected Expected;
+    // The generator of COMPUTE_VERIFY_EXPECTED_LINEAR, in the element type: the integers wrap around,
+    // and the float one rounds the product and the sum separately.
+    ComputeVerifyValue First;
+    ComputeVerifyValue Step;
+    // The largest absolute difference of matching floats. The integers and the floats of the same bits always match.
+    float Tolerance;
+} ComputeVerifyDesc;
+
+typedef struct ComputeVerifyResult
+{
+    uint64_t NumMismatches;
+    // UINT64_MAX if all the elements match
+    uint64_t FirstMismatch;
+    // The indices of the first mismatches, in ascending order. On the device they are the first ones found,
+    // so they are the first ones of the buffer only when there are no more than COMPUTE_VERIFY_MAX_INDICES of them.
+    uint32_t NumIndices;
+    uint64_t Indices[COMPUTE_VERIFY_MAX_INDICES];
+} ComputeVerifyResult;
+
+// The root constants of VerifyElements, following the ComputeDispatchConstants
+typedef struct ComputeVerifyConstants
+{
+    uint32_t ElementType;
+    uint32_t Expected;
+    uint32_t First;
+    uint32_t Step;
+    float Tolerance;
+} ComputeVerifyConstants;
+
+#define COMPUTE_VERIFY_CONSTANTS_COUNT  (sizeof(ComputeVerifyConstants) / sizeof(uint32_t))
+
+// Compares a buffer against the expected elements on the device with the kernels of verify.hlsl.
+// Only the COMPUTE_VERIFY_RESULT_SIZE bytes of the result are read back instead of the whole buffer,
+// and the matching elements take no atomic operation.
+// Recording a verification sets the root signature and the pipeline state of the command list,
+// so the caller sets its own again afterwards.
+typedef struct ComputeVerifier
+{
+    ComputeRootLayout layout;
+    ComputePipelineState *resetPipelineState;
+    ComputePipelineState *pipelineState;
+    uint32_t groupSize;
+} ComputeVerifier;
+
+extern bool ComputeVerifierInit(ComputeVerifier *verifier, ComputeShaderCache *shaderCache, const char *fileName, uint32_t compileFlags);
+// No command list recorded with the verifier may be in flight.
+extern void ComputeVerifierDestroy(ComputeVerifier *verifier);
+
+// Record the comparison of the numElements 32-bit elements of actual. expected is only read with COMPUTE_VERIFY_EXPECTED_BUFFER.
+// The buffers must be in the NON_PIXEL_SHADER_RESOURCE state, and the result buffer of COMPUTE_VERIFY_RESULT_SIZE bytes
+// in the UNORDERED_ACCESS state. The result buffer is reset first, and its writes are made visible by a UAV barrier.
+extern bool ComputeVerifierRecord(ComputeVerifier *verifier, ComputeCommandList *commandList, const ComputeVerifyDesc *desc,
+    ComputeResource *actual, ComputeResource *expected, ComputeResource *result, uint32_t numElements);
+
+// Unpack the result buffer read back from the device
+extern void ComputeVerifyReadResult(const void *pData, ComputeVerifyResult *result);
+
+// The elements [begin, end) on the host, with the widest SIMD instruction set enabled at compile time.
+// expected is indexed like actual, and ignored with COMPUTE_VERIFY_EXPECTED_LINEAR.
+extern void ComputeVerifyHostRange(const ComputeVerifyDesc *desc, const void *actual, const void *expected,
+    size_t begin, size_t end, ComputeVerifyResult *result);
+
+// The count elements on the host thread pool, one chunk per thread. The indices are the first mismatches of the buffer.
+// pool may be NULL to run everything on the calling thread.
+extern void ComputeVerifyHost(ThreadPool *pool, const ComputeVerifyDesc *desc, const void *actual, const void *expected,
+    size_t count, ComputeVerifyResult *result);
+
+#endif // COMPUTE_VERIFY_H
@@ -0,0 +1,1719 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_backend.h"
+#include "compute_utils.h"
+#include "cpu_kernels.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+// The CPU backend executes the recorded command lists on one worker thread per command queue.
+// The thread groups of a dispatch are spread across the cores with the device thread pool.
+
+// Resource memory alignment, enough for the widest SIMD loads and stores
+#define CPU_RESOURCE_ALIGNMENT      64
+
+// The number of commands in one allocation chunk of a command allocator
+#define CPU_COMMAND_CHUNK_SIZE      256
+
+// The number of root constants stored in one command. Larger updates are split into several commands.
+#define CPU_COMMAND_MAX_ROOT_CONSTANTS  8
+
+typedef struct CpuDevice CpuDevice;
+
+// ---- Blob ----
+
+typedef struct CpuBlob
+{
+    const ComputeBlobVtbl *lpVtbl;
+    size_t size;
+    void *pData;
+} CpuBlob;
+
+static void CpuBlob_Release(ComputeBlob *This)
+{
+    CpuBlob *blob = (CpuBlob*)This;
+    free(blob->pData);
+    free(blob);
+}
+
+static void* CpuBlob_GetBufferPointer(ComputeBlob *This)
+{
+    return ((CpuBlob*)This)->pData;
+}
+
+static size_t CpuBlob_GetBufferSize(ComputeBlob *This)
+{
+    return ((CpuBlob*)This)->size;
+}
+
+static const ComputeBlobVtbl s_cpuBlobVtbl = {
+    CpuBlob_Release, CpuBlob_GetBufferPointer, CpuBlob_GetBufferSize
+};
+
+static ComputeBlob* CreateCpuBlob(const void *pData, size_t size)
+{
+    CpuBlob *blob = calloc(1, sizeof(*blob));
+    if (blob == NULL)
+        return NULL;
+
+    blob->pData = malloc(size > 0 ? size : 1);
+    if (blob->pData == NULL)
+    {
+        free(blob);
+        return NULL;
+    }
+
+    blob->lpVtbl = &s_cpuBlobVtbl;
+    blob->size = size;
+    if (pData != NULL)
+        memcpy(blob->pData, pData, size);
+
+    return (ComputeBlob*)blob;
+}
+
+// ---- Heap ----
+
+typedef struct CpuHeap
+{
+    const ComputeHeapVtbl *lpVtbl;
+    ComputeHeapDesc desc;
+    uint8_t *pData;
+    // The heap object and each resource placed in it hold a reference
+    ComputeMutex mutex;
+    uint32_t refCount;
+} CpuHeap;
+
+static void ReleaseCpuHeap(CpuHeap *heap)
+{
+    ComputeMutexLock(&heap->mutex);
+    const uint32_t refCount = --heap->refCount;
+    ComputeMutexUnlock(&heap->mutex);
+
+    if (refCount > 0)
+        return;
+
+    ComputeMutexDestroy(&heap->mutex);
+    ComputeAlignedFree(heap->pData);
+    free(heap);
+}
+
+static void CpuHeap_Release(ComputeHeap *This)
+{
+    ReleaseCpuHeap((CpuHeap*)This);
+}
+
+static void CpuHeap_GetDesc(ComputeHeap *This, ComputeHeapDesc *pDesc)
+{
+    *pDesc = ((CpuHeap*)This)->desc;
+}
+
+static const ComputeHeapVtbl s_cpuHeapVtbl = { CpuHeap_Release, CpuHeap_GetDesc };
+
+// ---- Resource ----
+
+typedef struct CpuResource
+{
+    const ComputeResourceVtbl *lpVtbl;
+    ComputeHeapType heapType;
+    ComputeResourceDesc desc;
+    uint8_t *pData;
+    // The heap of a placed resource, which owns pData. NULL for committed resources.
+    CpuHeap *heap;
+} CpuResource;
+
+static void CpuResource_Release(ComputeResource *This)
+{
+    CpuResource *resource = (CpuResource*)This;
+    if (resource->heap != NULL)
+        ReleaseCpuHeap(resource->heap);
+    else
+        ComputeAlignedFree(resource->pData);
+    free(resource);
+}
+
+static void CpuResource_GetDesc(ComputeResource *This, ComputeResourceDesc *pDesc)
+{
+    *pDesc = ((CpuResource*)This)->desc;
+}
+
+// The host memory is the device memory, so mapping simply exposes it.
+static bool CpuResource_Map(ComputeResource *This, const ComputeRange *pReadRange, void **ppData)
+{
+    (void)pReadRange;
+    *ppData = ((CpuResource*)This)->pData;
+    return true;
+}
+
+static void CpuResource_Unmap(ComputeResource *This, const ComputeRange *pWrittenRange)
+{
+    (void)This;
+    (void)pWrittenRange;
+}
+
+// The kernels address the host memory directly.
+static ComputeGPUVirtualAddress CpuResource_GetGPUVirtualAddress(ComputeResource *This)
+{
+    return (ComputeGPUVirtualAddress)(uintptr_t)((CpuResource*)This)->pData;
+}
+
+static const ComputeResourceVtbl s_cpuResourceVtbl = {
+    CpuResource_Release, CpuResource_GetDesc, CpuResource_Map, CpuResource_Unmap, CpuResource_GetGPUVirtualAddress
+};
+
+// ---- Descriptor heap ----
+
+typedef enum CpuDescriptorType
+{
+    CPU_DESCRIPTOR_TYPE_NONE,
+    CPU_DESCRIPTOR_TYPE_SRV,
+    CPU_DESCRIPTOR_TYPE_UAV
+} CpuDescriptorType;
+
+typedef struct CpuDescriptor
+{
+    CpuDescriptorType type;
+    CpuResource *resource;
+    ComputeBufferViewDesc view;
+} CpuDescriptor;
+
+typedef struct CpuDescriptorHeap
+{
+    const ComputeDescriptorHeapVtbl *lpVtbl;
+    uint32_t numDescriptors;
+    CpuDescriptor *descriptors;
+} CpuDescriptorHeap;
+
+static void CpuDescriptorHeap_Release(ComputeDescriptorHeap *This)
+{
+    CpuDescriptorHeap *heap = (CpuDescriptorHeap*)This;
+    free(heap->descriptors);
+    free(heap);
+}
+
+// Descriptor handles are the addresses of the descriptors, on both "timelines".
+static ComputeCPUDescriptorHandle CpuDescriptorHeap_GetCPUDescriptorHandleForHeapStart(ComputeDescriptorHeap *This)
+{
+    const ComputeCPUDescriptorHandle handle = { (size_t)((CpuDescriptorHeap*)This)->descriptors };
+    return handle;
+}
+
+static ComputeGPUDescriptorHandle CpuDescriptorHeap_GetGPUDescriptorHandleForHeapStart(ComputeDescriptorHeap *This)
+{
+    const ComputeGPUDescriptorHandle handle = { (uint64_t)(size_t)((CpuDescriptorHeap*)This)->descriptors };
+    return handle;
+}
+
+static const ComputeDescriptorHeapVtbl s_cpuDescriptorHeapVtbl = {
+    CpuDescriptorHeap_Release, CpuDescriptorHeap_GetCPUDescriptorHandleForHeapStart,
+    CpuDescriptorHeap_GetGPUDescriptorHandleForHeapStart
+};
+
+// ---- Root signature and pipeline state ----
+
+typedef struct CpuRootParameter
+{
+    ComputeRootParameterType type;
+    // Descriptor table
+    uint32_t numRanges;
+    ComputeDescriptorRange *ranges;
+    // 32-bit constants, stored at constantsOffset in the root constants of the execution state
+    ComputeRootConstants constants;
+    uint32_t constantsOffset;
+    // Root SRV or UAV
+    ComputeRootDescriptor descriptor;
+} CpuRootParameter;
+
+typedef struct CpuRootSignature
+{
+    const ComputeRootSignatureVtbl *lpVtbl;
+    uint32_t numParameters;
+    CpuRootParameter parameters[COMPUTE_MAX_ROOT_PARAMETERS];
+    // FNV-1a hash of the parameters, standing in for the serialized root signature of D3D12
+    uint64_t hash;
+} CpuRootSignature;
+
+static void CpuRootSignature_Release(ComputeRootSignature *This)
+{
+    CpuRootSignature *rootSignature = (CpuRootSignature*)This;
+    for (uint32_t i = 0; i < rootSignature->numParameters; i++)
+        free(rootSignature->parameters[i].ranges);
+    free(rootSignature);
+}
+
+static uint64_t CpuRootSignature_GetHash(ComputeRootSignature *This)
+{
+    return ((CpuRootSignature*)This)->hash;
+}
+
+static const ComputeRootSignatureVtbl s_cpuRootSignatureVtbl = { CpuRootSignature_Release, CpuRootSignature_GetHash };
+
+static uint64_t HashRootSignatureBytes(uint64_t hash, const void *pData, size_t size)
+{
+    const uint8_t *pBytes = pData;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Hash the parameters member by member, the structure having padding and pointers
+static uint64_t HashRootSignature(const CpuRootSignature *rootSignature)
+{
+    uint64_t hash = HashRootSignatureBytes(0xcbf29ce484222325ULL, &rootSignature->numParameters, sizeof(rootSignature->numParameters));
+    for (uint32_t i = 0; i < rootSignature->numParameters; i++)
+    {
+        const CpuRootParameter *parameter = &rootSignature->parameters[i];
+        hash = HashRootSignatureBytes(hash, &parameter->type, sizeof(parameter->type));
+        hash = HashRootSignatureBytes(hash, &parameter->numRanges, sizeof(parameter->numRanges));
+        if (parameter->numRanges > 0)
+            hash = HashRootSignatureBytes(hash, parameter->ranges, parameter->numRanges * sizeof(*parameter->ranges));
+        hash = HashRootSignatureBytes(hash, &parameter->constants, sizeof(parameter->constants));
+        hash = HashRootSignatureBytes(hash, &parameter->descriptor, sizeof(parameter->descriptor));
+    }
+    return hash;
+}
+
+typedef struct CpuPipelineState
+{
+    const ComputePipelineStateVtbl *lpVtbl;
+    const CpuKernelDesc *kernel;
+    uint32_t numThreads[3];
+    // The parameters of the group function, resolved from the macros of the bytecode
+    uint64_t params[CPU_KERNEL_MAX_PARAMS_SIZE / sizeof(uint64_t)];
+    // The bytecode also serves as the cached blob
+    CpuShaderBytecode bytecode;
+} CpuPipelineState;
+
+static void CpuPipelineState_Release(ComputePipelineState *This)
+{
+    free(This);
+}
+
+static bool CpuPipelineState_GetCachedBlob(ComputePipelineState *This, ComputeBlob **ppBlob)
+{
+    const CpuPipelineState *pipelineState = (const CpuPipelineState*)This;
+    *ppBlob = CreateCpuBlob(&pipelineState->bytecode, sizeof(pipelineState->bytecode));
+    return *ppBlob != NULL;
+}
+
+static const ComputePipelineStateVtbl s_cpuPipelineStateVtbl = { CpuPipelineState_Release, CpuPipelineState_GetCachedBlob };
+
+// ---- Query heap ----
+
+// The timestamps are nanoseconds of ComputeGetTimeNanoseconds, written by the queue thread
+typedef struct CpuQueryHeap
+{
+    const ComputeQueryHeapVtbl *lpVtbl;
+    uint32_t count;
+    uint64_t *timestamps;
+} CpuQueryHeap;
+
+static void CpuQueryHeap_Release(ComputeQueryHeap *This)
+{
+    CpuQueryHeap *heap = (CpuQueryHeap*)This;
+    free(heap->timestamps);
+    free(heap);
+}
+
+static const ComputeQueryHeapVtbl s_cpuQueryHeapVtbl = { CpuQueryHeap_Release };
+
+// ---- Command allocator ----
+
+typedef enum CpuCommandType
+{
+    CPU_COMMAND_SET_PIPELINE_STATE,
+    CPU_COMMAND_SET_ROOT_SIGNATURE,
+    CPU_COMMAND_SET_ROOT_DESCRIPTOR_TABLE,
+    CPU_COMMAND_SET_ROOT_CONSTANTS,
+    CPU_COMMAND_SET_ROOT_DESCRIPTOR,
+    CPU_COMMAND_DISPATCH,
+    CPU_COMMAND_COPY_BUFFER_REGION,
+    CPU_COMMAND_END_QUERY,
+    CPU_COMMAND_RESOLVE_QUERY_DATA
+} CpuCommandType;
+
+typedef struct CpuCommand
+{
+    struct CpuCommand *next;
+    CpuCommandType type;
+    union
+    {
+        CpuPipelineState *pipelineState;
+        CpuRootSignature *rootSignature;
+        struct
+        {
+            uint32_t rootParameterIndex;
+            uint64_t baseDescriptor;
+        } descriptorTable;
+        struct
+        {
+            uint32_t rootParameterIndex;
+            uint32_t destOffset;
+            uint32_t numValues;
+            uint32_t values[CPU_COMMAND_MAX_ROOT_CONSTANTS];
+        } rootConstants;
+        struct
+        {
+            uint32_t rootParameterIndex;
+            ComputeRootParameterType type;
+            ComputeGPUVirtualAddress bufferLocation;
+        } rootDescriptor;
+        struct
+        {
+            uint32_t x, y, z;
+        } dispatch;
+        struct
+        {
+            CpuResource *dst;
+            uint64_t dstOffset;
+            CpuResource *src;
+            uint64_t srcOffset;
+            uint64_t numBytes;
+        } copy;
+        struct
+        {
+            CpuQueryHeap *heap;
+            uint32_t index;
+            uint32_t count;
+            CpuResource *dst;
+            uint64_t dstOffset;
+        } query;
+    };
+} CpuCommand;
+
+// The recorded commands live in the allocator, so that a command list can be reset
+// and recorded again while its previous commands are still executing.
+typedef struct CpuCommandAllocator
+{
+    const ComputeCommandAllocatorVtbl *lpVtbl;
+    ComputeCommandListType type;
+    CpuCommand **chunks;
+    size_t numChunks;
+    size_t currentChunk;
+    size_t usedInCurrentChunk;
+} CpuCommandAllocator;
+
+static void CpuCommandAllocator_Release(ComputeCommandAllocator *This)
+{
+    CpuCommandAllocator *allocator = (CpuCommandAllocator*)This;
+    for (size_t i = 0; i < allocator->numChunks; i++)
+        free(allocator->chunks[i]);
+    free(allocator->chunks);
+    free(allocator);
+}
+
+static bool CpuCommandAllocator_Reset(ComputeCommandAllocator *This)
+{
+    CpuCommandAllocator *allocator = (CpuCommandAllocator*)This;
+    allocator->currentChunk = 0;
+    allocator->usedInCurrentChunk = 0;
+    return true;
+}
+
+static const ComputeCommandAllocatorVtbl s_cpuCommandAllocatorVtbl = {
+    CpuCommandAllocator_Release, CpuCommandAllocator_Reset
+};
+
+static CpuCommand* AllocateCpuCommand(CpuCommandAllocator *allocator)
+{
+    if (allocator->numChunks == 0 || allocator->usedInCurrentChunk == CPU_COMMAND_CHUNK_SIZE)
+    {
+        const size_t nextChunk = allocator->numChunks == 0 ? 0 : allocator->currentChunk + 1;
+        if (nextChunk == allocator->numChunks)
+        {
+            CpuCommand **chunks = realloc(allocator->chunks, (allocator->numChunks + 1) * sizeof(*chunks));
+            if (chunks == NULL)
+                return NULL;
+            allocator->chunks = chunks;
+
+            chunks[allocator->numChunks] = malloc(CPU_COMMAND_CHUNK_SIZE * sizeof(CpuCommand));
+            if (chunks[allocator->numChunks] == NULL)
+                return NULL;
+            allocator->numChunks++;
+        }
+        allocator->currentChunk = nextChunk;
+        allocator->usedInCurrentChunk = 0;
+    }
+
+    CpuCommand *command = &allocator->chunks[allocator->currentChunk][allocator->usedInCurrentChunk++];
+    command->next = NULL;
+    return command;
+}
+
+// ---- Command list ----
+
+typedef struct CpuCommandList
+{
+    const ComputeCommandListVtbl *lpVtbl;
+    ComputeCommandListType type;
+    CpuCommandAllocator *allocator;
+    CpuCommand *head;
+    CpuCommand *tail;
+    bool closed;
+    // Set when a command could not be recorded. Close will fail.
+    bool error;
+} CpuCommandList;
+
+static CpuCommand* RecordCpuCommand(CpuCommandList *list, CpuCommandType type)
+{
+    if (list->closed)
+    {
+        puts("CPU backend: recording into a closed command list!");
+        list->error = true;
+        return NULL;
+    }
+
+    CpuCommand *command = AllocateCpuCommand(list->allocator);
+    if (command == NULL)
+    {
+        list->error = true;
+        return NULL;
+    }
+
+    command->type = type;
+    if (list->tail != NULL)
+        list->tail->next = command;
+    else
+        list->head = command;
+    list->tail = command;
+
+    return command;
+}
+
+static void CpuCommandList_Release(ComputeCommandList *This)
+{
+    free(This);
+}
+
+static bool CpuCommandList_Close(ComputeCommandList *This)
+{
+    CpuCommandList *list = (CpuCommandList*)This;
+    if (list->closed)
+        return false;
+
+    list->closed = true;
+    return !list->error;
+}
+
+static void CpuCommandList_SetPipelineState(ComputeCommandList *This, ComputePipelineState *pPipelineState)
+{
+    CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_SET_PIPELINE_STATE);
+    if (command != NULL)
+        command->pipelineState = (CpuPipelineState*)pPipelineState;
+}
+
+static bool CpuCommandList_Reset(ComputeCommandList *This, ComputeCommandAllocator *pAllocator, ComputePipelineState *pInitialState)
+{
+    CpuCommandList *list = (CpuCommandList*)This;
+    list->allocator = (CpuCommandAllocator*)pAllocator;
+    list->head = NULL;
+    list->tail = NULL;
+    list->closed = false;
+    list->error = false;
+
+    if (pInitialState != NULL)
+        CpuCommandList_SetPipelineState(This, pInitialState);
+
+    return !list->error;
+}
+
+static void CpuCommandList_SetComputeRootSignature(ComputeCommandList *This, ComputeRootSignature *pRootSignature)
+{
+    CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_SET_ROOT_SIGNATURE);
+    if (command != NULL)
+        command->rootSignature = (CpuRootSignature*)pRootSignature;
+}
+
+// The descriptors are addressed directly through the handles, so there is no heap state to set.
+static void CpuCommandList_SetDescriptorHeaps(ComputeCommandList *This, uint32_t NumDescriptorHeaps, ComputeDescriptorHeap *const *ppDescriptorHeaps)
+{
+    (void)This;
+    (void)NumDescriptorHeaps;
+    (void)ppDescriptorHeaps;
+}
+
+static void CpuCommandList_SetComputeRootDescriptorTable(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUDescriptorHandle BaseDescriptor)
+{
+    CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_SET_ROOT_DESCRIPTOR_TABLE);
+    if (command != NULL)
+    {
+        command->descriptorTable.rootParameterIndex = RootParameterIndex;
+        command->descriptorTable.baseDescriptor = BaseDescriptor.ptr;
+    }
+}
+
+static void CpuCommandList_SetComputeRoot32BitConstants(ComputeCommandList *This, uint32_t RootParameterIndex, uint32_t Num32BitValuesToSet,
+    const void *pSrcData, uint32_t DestOffsetIn32BitValues)
+{
+    const uint32_t *values = pSrcData;
+
+    // The values are copied at record time, like on the device.
+    for (uint32_t i = 0; i < Num32BitValuesToSet; i += CPU_COMMAND_MAX_ROOT_CONSTANTS)
+    {
+        CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_SET_ROOT_CONSTANTS);
+        if (command == NULL)
+            return;
+
+        const uint32_t numValues = Num32BitValuesToSet - i < CPU_COMMAND_MAX_ROOT_CONSTANTS ?
+            Num32BitValuesToSet - i : CPU_COMMAND_MAX_ROOT_CONSTANTS;
+        command->rootConstants.rootParameterIndex = RootParameterIndex;
+        command->rootConstants.destOffset = DestOffsetIn32BitValues + i;
+        command->rootConstants.numValues = numValues;
+        memcpy(command->rootConstants.values, values + i, numValues * sizeof(uint32_t));
+    }
+}
+
+static void RecordCpuRootDescriptor(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeRootParameterType type,
+    ComputeGPUVirtualAddress BufferLocation)
+{
+    CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_SET_ROOT_DESCRIPTOR);
+    if (command != NULL)
+    {
+        command->rootDescriptor.rootParameterIndex = RootParameterIndex;
+        command->rootDescriptor.type = type;
+        command->rootDescriptor.bufferLocation = BufferLocation;
+    }
+}
+
+static void CpuCommandList_SetComputeRootShaderResourceView(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation)
+{
+    RecordCpuRootDescriptor(This, RootParameterIndex, COMPUTE_ROOT_PARAMETER_TYPE_SRV, BufferLocation);
+}
+
+static void CpuCommandList_SetComputeRootUnorderedAccessView(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation)
+{
+    RecordCpuRootDescriptor(This, RootParameterIndex, COMPUTE_ROOT_PARAMETER_TYPE_UAV, BufferLocation);
+}
+
+static void CpuCommandList_Dispatch(ComputeCommandList *This, uint32_t ThreadGroupCountX, uint32_t ThreadGroupCountY, uint32_t ThreadGroupCountZ)
+{
+    CpuCommandList *list = (CpuCommandList*)This;
+    if (list->type == COMPUTE_COMMAND_LIST_TYPE_COPY)
+    {
+        puts("CPU backend: dispatching on a copy command list!");
+        list->error = true;
+        return;
+    }
+
+    CpuCommand *command = RecordCpuCommand(list, CPU_COMMAND_DISPATCH);
+    if (command != NULL)
+    {
+        command->dispatch.x = ThreadGroupCountX;
+        command->dispatch.y = ThreadGroupCountY;
+        command->dispatch.z = ThreadGroupCountZ;
+    }
+}
+
+// Commands of one queue execute strictly in order and each command completes before the next one starts,
+// so transitions, UAV barriers and aliasing barriers need no work here.
+static void CpuCommandList_ResourceBarrier(ComputeCommandList *This, uint32_t NumBarriers, const ComputeResourceBarrier *pBarriers)
+{
+    (void)This;
+    (void)NumBarriers;
+    (void)pBarriers;
+}
+
+static void CpuCommandList_CopyBufferRegion(ComputeCommandList *This, ComputeResource *pDstBuffer, uint64_t DstOffset,
+    ComputeResource *pSrcBuffer, uint64_t SrcOffset, uint64_t NumBytes)
+{
+    CpuCommand *command = RecordCpuCommand((CpuCommandList*)This, CPU_COMMAND_COPY_BUFFER_REGION);
+    if (command != NULL)
+    {
+        command->copy.dst = (CpuResource*)pDstBuffer;
+        command->copy.dstOffset = DstOffset;
+        command->copy.src = (CpuResource*)pSrcBuffer;
+        command->copy.srcOffset = SrcOffset;
+        command->copy.numBytes = NumBytes;
+    }
+}
+
+static void CpuCommandList_CopyResource(ComputeCommandList *This, ComputeResource *pDstResource, ComputeResource *pSrcResource)
+{
+    const CpuResource *dst = (const CpuResource*)pDstResource;
+    const CpuResource *src = (const CpuResource*)pSrcResource;
+    const uint64_t size = dst->desc.Width < src->desc.Width ? dst->desc.Width : src->desc.Width;
+    CpuCommandList_CopyBufferRegion(This, pDstResource, 0, pSrcResource, 0, size);
+}
+
+static void CpuCommandList_EndQuery(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t Index)
+{
+    CpuCommandList *list = (CpuCommandList*)This;
+    CpuQueryHeap *heap = (CpuQueryHeap*)pQueryHeap;
+    if (Type != COMPUTE_QUERY_TYPE_TIMESTAMP || Index >= heap->count)
+    {
+        puts("CPU backend: invalid query!");
+        list->error = true;
+        return;
+    }
+
+    CpuCommand *command = RecordCpuCommand(list, CPU_COMMAND_END_QUERY);
+    if (command != NULL)
+    {
+        command->query.heap = heap;
+        command->query.index = Index;
+    }
+}
+
+static void CpuCommandList_ResolveQueryData(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t StartIndex,
+    uint32_t NumQueries, ComputeResource *pDestinationBuffer, uint64_t AlignedDestinationBufferOffset)
+{
+    CpuCommandList *list = (CpuCommandList*)This;
+    CpuQueryHeap *heap = (CpuQueryHeap*)pQueryHeap;
+    CpuResource *dst = (CpuResource*)pDestinationBuffer;
+    if (Type != COMPUTE_QUERY_TYPE_TIMESTAMP || StartIndex > heap->count || NumQueries > heap->count - StartIndex ||
+        AlignedDestinationBufferOffset % sizeof(uint64_t) != 0 ||
+        AlignedDestinationBufferOffset + (uint64_t)NumQueries * sizeof(uint64_t) > dst->desc.Width)
+    {
+        puts("CPU backend: invalid query resolve!");
+        list->error = true;
+        return;
+    }
+
+    CpuCommand *command = RecordCpuCommand(list, CPU_COMMAND_RESOLVE_QUERY_DATA);
+    if (command != NULL)
+    {
+        command->query.heap = heap;
+        command->query.index = StartIndex;
+        command->query.count = NumQueries;
+        command->query.dst = dst;
+        command->query.dstOffset = AlignedDestinationBufferOffset;
+    }
+}
+
+static const ComputeCommandListVtbl s_cpuCommandListVtbl = {
+    CpuCommandList_Release, CpuCommandList_Close, CpuCommandList_Reset, CpuCommandList_SetPipelineState,
+    CpuCommandList_SetComputeRootSignature, CpuCommandList_SetDescriptorHeaps, CpuCommandList_SetComputeRootDescriptorTable,
+    CpuCommandList_SetComputeRoot32BitConstants, CpuCommandList_SetComputeRootShaderResourceView,
+    CpuCommandList_SetComputeRootUnorderedAccessView, CpuCommandList_Dispatch, CpuCommandList_ResourceBarrier, CpuCommandList_CopyBufferRegion, CpuCommandList_CopyResource,
+    CpuCommandList_EndQuery, CpuCommandList_ResolveQueryData
+};
+
+// ---- Fence ----
+
+typedef struct CpuFenceEvent
+{
+    uint64_t value;
+    ComputeEvent event;
+    struct CpuFenceEvent *next;
+} CpuFenceEvent;
+
+typedef struct CpuFence
+{
+    const ComputeFenceVtbl *lpVtbl;
+    // Queued signals and waits hold a reference so that the fence outlives them.
+    volatile int64_t refCount;
+    volatile int64_t value;
+    ComputeMutex mutex;
+    ComputeCondition cond;
+    // The pending SetEventOnCompletion requests
+    CpuFenceEvent *events;
+} CpuFence;
+
+static void CpuFence_Release(ComputeFence *This)
+{
+    CpuFence *fence = (CpuFence*)This;
+    if (ComputeAtomicAdd64(&fence->refCount, -1) != 1)
+        return;
+
+    while (fence->events != NULL)
+    {
+        CpuFenceEvent *next = fence->events->next;
+        free(fence->events);
+        fence->events = next;
+    }
+    ComputeConditionDestroy(&fence->cond);
+    ComputeMutexDestroy(&fence->mutex);
+    free(fence);
+}
+
+static uint64_t CpuFence_GetCompletedValue(ComputeFence *This)
+{
+    return (uint64_t)ComputeAtomicLoad64(&((CpuFence*)This)->value);
+}
+
+// Block until the fence reaches the value
+static void CpuFenceWait(CpuFence *fence, uint64_t value)
+{
+    ComputeMutexLock(&fence->mutex);
+    while ((uint64_t)ComputeAtomicLoad64(&fence->value) < value)
+        ComputeConditionWait(&fence->cond, &fence->mutex);
+    ComputeMutexUnlock(&fence->mutex);
+}
+
+static bool CpuFence_SetEventOnCompletion(ComputeFence *This, uint64_t Value, ComputeEvent hEvent)
+{
+    CpuFence *fence = (CpuFence*)This;
+
+    // Like D3D12, a NULL event means waiting right here.
+    if (hEvent == NULL)
+    {
+        CpuFenceWait(fence, Value);
+        return true;
+    }
+
+    ComputeMutexLock(&fence->mutex);
+    if ((uint64_t)ComputeAtomicLoad64(&fence->value) >= Value)
+    {
+        ComputeMutexUnlock(&fence->mutex);
+        ComputeEventSet(hEvent);
+        return true;
+    }
+
+    CpuFenceEvent *entry = malloc(sizeof(*entry));
+    if (entry == NULL)
+    {
+        ComputeMutexUnlock(&fence->mutex);
+        return false;
+    }
+    entry->value = Value;
+    entry->event = hEvent;
+    entry->next = fence->events;
+    fence->events = entry;
+    ComputeMutexUnlock(&fence->mutex);
+
+    return true;
+}
+
+static bool CpuFence_Signal(ComputeFence *This, uint64_t Value)
+{
+    CpuFence *fence = (CpuFence*)This;
+
+    CpuFenceEvent *completed = NULL;
+
+    ComputeMutexLock(&fence->mutex);
+    ComputeAtomicStore64(&fence->value, (int64_t)Value);
+
+    // Detach the completed requests, and fire them outside the lock.
+    CpuFenceEvent **link = &fence->events;
+    while (*link != NULL)
+    {
+        CpuFenceEvent *entry = *link;
+        if (entry->value <= Value)
+        {
+            *link = entry->next;
+            entry->next = completed;
+            completed = entry;
+        }
+        else
+            link = &entry->next;
+    }
+
+    ComputeConditionBroadcast(&fence->cond);
+    ComputeMutexUnlock(&fence->mutex);
+
+    while (completed != NULL)
+    {
+        CpuFenceEvent *next = completed->next;
+        ComputeEventSet(completed->event);
+        free(completed);
+        completed = next;
+    }
+
+    return true;
+}
+
+static const ComputeFenceVtbl s_cpuFenceVtbl = {
+    CpuFence_Release, CpuFence_GetCompletedValue, CpuFence_SetEventOnCompletion, CpuFence_Signal
+};
+
+// ---- Command queue ----
+
+typedef enum CpuQueueItemType
+{
+    CPU_QUEUE_ITEM_EXECUTE,
+    CPU_QUEUE_ITEM_SIGNAL,
+    CPU_QUEUE_ITEM_WAIT
+} CpuQueueItemType;
+
+typedef struct CpuQueueItem
+{
+    struct CpuQueueItem *next;
+    CpuQueueItemType type;
+    const CpuCommand *commands;
+    CpuFence *fence;
+    uint64_t value;
+} CpuQueueItem;
+
+typedef struct CpuCommandQueue
+{
+    const ComputeCommandQueueVtbl *lpVtbl;
+    CpuDevice *device;
+    ComputeCommandListType type;
+    ComputeMutex mutex;
+    ComputeCondition cond;
+    CpuQueueItem *head;
+    CpuQueueItem *tail;
+    bool shutdown;
+    ComputeThread thread;
+} CpuCommandQueue;
+
+struct CpuDevice
+{
+    const ComputeDeviceVtbl *lpVtbl;
+    ThreadPool *threadPool;
+    // 100 at the speed of the host
+    uint32_t speedPercent;
+};
+
+// The pipeline state while a queue walks through a command list
+typedef struct CpuExecutionState
+{
+    const CpuPipelineState *pipelineState;
+    const CpuRootSignature *rootSignature;
+    uint64_t rootDescriptorTables[COMPUTE_MAX_ROOT_PARAMETERS];
+    ComputeGPUVirtualAddress rootDescriptors[COMPUTE_MAX_ROOT_PARAMETERS];
+    uint32_t rootConstants[COMPUTE_MAX_ROOT_CONSTANTS];
+} CpuExecutionState;
+
+typedef struct CpuDispatchTask
+{
+    const CpuKernelContext *context;
+    CpuKernelGroupFunc groupFunc;
+} CpuDispatchTask;
+
+static void RunThreadGroups(void *context, size_t begin, size_t end)
+{
+    const CpuDispatchTask *task = context;
+    const uint32_t *numGroups = task->context->numGroups;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const uint32_t x = (uint32_t)(i % numGroups[0]);
+        const uint32_t y = (uint32_t)(i / numGroups[0] % numGroups[1]);
+        const uint32_t z = (uint32_t)(i / ((size_t)numGroups[0] * numGroups[1]));
+        task->groupFunc(task->context, x, y, z);
+    }
+}
+
+static void BindKernelBuffer(CpuKernelBuffer *buffer, const CpuDescriptor *descriptor)
+{
+    const CpuResource *resource = descriptor->resource;
+
+    // The elements of the typed and raw views have the size of their format.
+    const uint32_t elementSize = descriptor->view.Format == COMPUTE_FORMAT_UNKNOWN ?
+        descriptor->view.StructureByteStride : ComputeFormatGetSize(descriptor->view.Format);
+    const uint64_t offset = descriptor->view.FirstElement * elementSize;
+
+    buffer->pData = resource->pData + offset;
+    buffer->numElements = descriptor->view.NumElements;
+    buffer->structureByteStride = elementSize;
+    buffer->format = descriptor->view.Format;
+
+    // Clamp the view to the resource like the device does.
+    const uint64_t available = offset < resource->desc.Width ? resource->desc.Width - offset : 0;
+    if (buffer->structureByteStride > 0 && (uint64_t)buffer->numElements * buffer->structureByteStride > available)
+        buffer->numElements = (uint32_t)(available / buffer->structureByteStride);
+}
+
+// A root descriptor has no view and so no bounds, like on the device: the kernel sees 32-bit words up to the end of the address space.
+// The structured and raw kernels only rely on their own constants to stay within the buffer.
+static void BindKernelRootDescriptor(CpuKernelBuffer *buffer, ComputeGPUVirtualAddress bufferLocation)
+{
+    buffer->pData = (uint8_t*)(uintptr_t)bufferLocation;
+    buffer->numElements = UINT32_MAX;
+    buffer->structureByteStride = sizeof(uint32_t);
+    buffer->format = COMPUTE_FORMAT_UNKNOWN;
+}
+
+static void ExecuteCpuDispatch(CpuDevice *device, const CpuExecutionState *state, uint32_t x, uint32_t y, uint32_t z)
+{
+    if (state->pipelineState == NULL || state->rootSignature == NULL)
+    {
+        puts("CPU backend: Dispatch without pipeline state or root signature!");
+        return;
+    }
+
+    CpuKernelContext context;
+    memset(&context, 0, sizeof(context));
+    memcpy(context.numThreads, state->pipelineState->numThreads, sizeof(context.numThreads));
+    context.params = state->pipelineState->params;
+    context.numGroups[0] = x;
+    context.numGroups[1] = y;
+    context.numGroups[2] = z;
+
+    // Resolve the root parameters to the t# and u# registers.
+    const CpuRootSignature *rootSignature = state->rootSignature;
+    for (uint32_t i = 0; i < rootSignature->numParameters; i++)
+    {
+        const CpuRootParameter *parameter = &rootSignature->parameters[i];
+        if (parameter->type == COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+        {
+            const uint32_t reg = parameter->constants.ShaderRegister;
+            if (reg < COMPUTE_MAX_SHADER_REGISTERS)
+            {
+                context.cbv[reg].pData = &state->rootConstants[parameter->constantsOffset];
+                context.cbv[reg].numValues = parameter->constants.Num32BitValues;
+            }
+            continue;
+        }
+        if (parameter->type == COMPUTE_ROOT_PARAMETER_TYPE_SRV || parameter->type == COMPUTE_ROOT_PARAMETER_TYPE_UAV)
+        {
+            const uint32_t reg = parameter->descriptor.ShaderRegister;
+            if (reg < COMPUTE_MAX_SHADER_REGISTERS && state->rootDescriptors[i] != 0)
+            {
+                BindKernelRootDescriptor(parameter->type == COMPUTE_ROOT_PARAMETER_TYPE_SRV ? &context.srv[reg] : &context.uav[reg],
+                    state->rootDescriptors[i]);
+            }
+            continue;
+        }
+
+        const CpuDescriptor *table = (const CpuDescriptor*)(size_t)state->rootDescriptorTables[i];
+        if (table == NULL)
+            continue;
+
+        for (uint32_t r = 0; r < parameter->numRanges; r++)
+        {
+            const ComputeDescriptorRange *range = &parameter->ranges[r];
+            for (uint32_t d = 0; d < range->NumDescriptors; d++, table++)
+            {
+                const uint32_t reg = range->BaseShaderRegister + d;
+                if (reg >= COMPUTE_MAX_SHADER_REGISTERS || table->resource == NULL)
+                    continue;
+
+                if (range->RangeType == COMPUTE_DESCRIPTOR_RANGE_TYPE_SRV && table->type == CPU_DESCRIPTOR_TYPE_SRV)
+                    BindKernelBuffer(&context.srv[reg], table);
+                else if (range->RangeType == COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV && table->type == CPU_DESCRIPTOR_TYPE_UAV)
+                    BindKernelBuffer(&context.uav[reg], table);
+            }
+        }
+    }
+
+    const size_t totalGroups = (size_t)x * y * z;
+    CpuDispatchTask task = { &context, state->pipelineState->kernel->groupFunc };
+    ThreadPoolParallelFor(device->threadPool, totalGroups, 0, RunThreadGroups, &task);
+}
+
+static void ExecuteCpuCommands(CpuDevice *device, const CpuCommand *command)
+{
+    CpuExecutionState state;
+    memset(&state, 0, sizeof(state));
+
+    for (; command != NULL; command = command->next)
+    {
+        switch (command->type)
+        {
+        case CPU_COMMAND_SET_PIPELINE_STATE:
+            state.pipelineState = command->pipelineState;
+            break;
+
+        case CPU_COMMAND_SET_ROOT_SIGNATURE:
+            state.rootSignature = command->rootSignature;
+            memset(state.rootDescriptorTables, 0, sizeof(state.rootDescriptorTables));
+            memset(state.rootDescriptors, 0, sizeof(state.rootDescriptors));
+            memset(state.rootConstants, 0, sizeof(state.rootConstants));
+            break;
+
+        case CPU_COMMAND_SET_ROOT_DESCRIPTOR_TABLE:
+            if (command->descriptorTable.rootParameterIndex < COMPUTE_MAX_ROOT_PARAMETERS)
+                state.rootDescriptorTables[command->descriptorTable.rootParameterIndex] = command->descriptorTable.baseDescriptor;
+            break;
+
+        case CPU_COMMAND_SET_ROOT_CONSTANTS:
+        {
+            // The constants are placed by the layout of the root signature being set.
+            const uint32_t index = command->rootConstants.rootParameterIndex;
+            if (state.rootSignature == NULL || index >= state.rootSignature->numParameters ||
+                state.rootSignature->parameters[index].type != COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+            {
+                puts("CPU backend: SetComputeRoot32BitConstants on a parameter that holds no constants!");
+                break;
+            }
+
+            const CpuRootParameter *parameter = &state.rootSignature->parameters[index];
+            if (command->rootConstants.destOffset + command->rootConstants.numValues > parameter->constants.Num32BitValues)
+            {
+                puts("CPU backend: SetComputeRoot32BitConstants out of range!");
+                break;
+            }
+            memcpy(&state.rootConstants[parameter->constantsOffset + command->rootConstants.destOffset],
+                command->rootConstants.values, command->rootConstants.numValues * sizeof(uint32_t));
+            break;
+        }
+
+        case CPU_COMMAND_SET_ROOT_DESCRIPTOR:
+        {
+            const uint32_t index = command->rootDescriptor.rootParameterIndex;
+            if (state.rootSignature == NULL || index >= state.rootSignature->numParameters ||
+                state.rootSignature->parameters[index].type != command->rootDescriptor.type)
+            {
+                puts("CPU backend: root SRV or UAV set on a parameter of another type!");
+                break;
+            }
+            state.rootDescriptors[index] = command->rootDescriptor.bufferLocation;
+            break;
+        }
+
+        case CPU_COMMAND_DISPATCH:
+            ExecuteCpuDispatch(device, &state, command->dispatch.x, command->dispatch.y, command->dispatch.z);
+            break;
+
+        case CPU_COMMAND_COPY_BUFFER_REGION:
+        {
+            const CpuResource *dst = command->copy.dst;
+            const CpuResource *src = command->copy.src;
+            if (command->copy.dstOffset + command->copy.numBytes > dst->desc.Width ||
+                command->copy.srcOffset + command->copy.numBytes > src->desc.Width)
+            {
+                puts("CPU backend: CopyBufferRegion out of range!");
+                break;
+            }
+            memmove(dst->pData + command->copy.dstOffset, src->pData + command->copy.srcOffset, (size_t)command->copy.numBytes);
+            break;
+        }
+
+        // Every command completes before the next one starts, so the time now is the end of the previous commands.
+        case CPU_COMMAND_END_QUERY:
+            command->query.heap->timestamps[command->query.index] = ComputeGetTimeNanoseconds();
+            break;
+
+        case CPU_COMMAND_RESOLVE_QUERY_DATA:
+            memcpy(command->query.dst->pData + command->query.dstOffset, &command->query.heap->timestamps[command->query.index],
+                command->query.count * sizeof(uint64_t));
+            break;
+        }
+    }
+}
+
+static void QueueThreadProc(void *context)
+{
+    CpuCommandQueue *queue = context;
+
+    for (;;)
+    {
+        ComputeMutexLock(&queue->mutex);
+        while (queue->head == NULL && !queue->shutdown)
+            ComputeConditionWait(&queue->cond, &queue->mutex);
+
+        CpuQueueItem *item = queue->head;
+        if (item == NULL)
+        {
+            // Shut down after all the submitted work has been processed.
+            ComputeMutexUnlock(&queue->mutex);
+            break;
+        }
+        queue->head = item->next;
+        if (queue->head == NULL)
+            queue->tail = NULL;
+        ComputeMutexUnlock(&queue->mutex);
+
+        switch (item->type)
+        {
+        case CPU_QUEUE_ITEM_EXECUTE:
+        {
+            const uint64_t startTime = ComputeGetTimeNanoseconds();
+            ExecuteCpuCommands(queue->device, item->commands);
+
+            // A slower device is simulated by idling the queue for the rest of the stretched duration.
+            const uint32_t speedPercent = queue->device->speedPercent;
+            if (speedPercent < 100)
+            {
+                const uint64_t elapsed = ComputeGetTimeNanoseconds() - startTime;
+                ComputeSleepMicroseconds(elapsed * (100 - speedPercent) / speedPercent / 1000);
+            }
+            break;
+        }
+
+        case CPU_QUEUE_ITEM_SIGNAL:
+            CpuFence_Signal((ComputeFence*)item->fence, item->value);
+            break;
+
+        case CPU_QUEUE_ITEM_WAIT:
+            CpuFenceWait(item->fence, item->value);
+            break;
+        }
+        if (item->fence != NULL)
+            CpuFence_Release((ComputeFence*)item->fence);
+        free(item);
+    }
+}
+
+static bool PushCpuQueueItem(CpuCommandQueue *queue, CpuQueueItemType type, const CpuCommand *commands, CpuFence *fence, uint64_t value)
+{
+    CpuQueueItem *item = malloc(sizeof(*item));
+    if (item == NULL)
+        return false;
+
+    item->next = NULL;
+    item->type = type;
+    item->commands = commands;
+    item->fence = fence;
+    item->value = value;
+    if (fence != NULL)
+        ComputeAtomicAdd64(&fence->refCount, 1);
+
+    ComputeMutexLock(&queue->mutex);
+    if (queue->tail != NULL)
+        queue->tail->next = item;
+    else
+        queue->head = item;
+    queue->tail = item;
+    ComputeConditionSignal(&queue->cond);
+    ComputeMutexUnlock(&queue->mutex);
+
+    return true;
+}
+
+static void CpuCommandQueue_Release(ComputeCommandQueue *This)
+{
+    CpuCommandQueue *queue = (CpuCommandQueue*)This;
+
+    ComputeMutexLock(&queue->mutex);
+    queue->shutdown = true;
+    ComputeConditionSignal(&queue->cond);
+    ComputeMutexUnlock(&queue->mutex);
+
+    ComputeThreadJoin(queue->thread);
+    ComputeConditionDestroy(&queue->cond);
+    ComputeMutexDestroy(&queue->mutex);
+    free(queue);
+}
+
+static void CpuCommandQueue_ExecuteCommandLists(ComputeCommandQueue *This, uint32_t NumCommandLists, ComputeCommandList *const *ppCommandLists)
+{
+    CpuCommandQueue *queue = (CpuCommandQueue*)This;
+    for (uint32_t i = 0; i < NumCommandLists; i++)
+    {
+        const CpuCommandList *list = (const CpuCommandList*)ppCommandLists[i];
+        if (!list->closed)
+        {
+            puts("CPU backend: executing a command list that is not closed!");
+            continue;
+        }
+        if (list->type != queue->type)
+        {
+            puts("CPU backend: executing a command list on a queue of another type!");
+            continue;
+        }
+        if (list->head != NULL && !PushCpuQueueItem(queue, CPU_QUEUE_ITEM_EXECUTE, list->head, NULL, 0))
+            puts("CPU backend: failed to submit a command list!");
+    }
+}
+
+static bool CpuCommandQueue_Signal(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value)
+{
+    return PushCpuQueueItem((CpuCommandQueue*)This, CPU_QUEUE_ITEM_SIGNAL, NULL, (CpuFence*)pFence, Value);
+}
+
+static bool CpuCommandQueue_Wait(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value)
+{
+    return PushCpuQueueItem((CpuCommandQueue*)This, CPU_QUEUE_ITEM_WAIT, NULL, (CpuFence*)pFence, Value);
+}
+
+// The timestamps are taken on the host clock.
+static bool CpuCommandQueue_GetTimestampFrequency(ComputeCommandQueue *This, uint64_t *pFrequency)
+{
+    (void)This;
+    *pFrequency = 1000000000ULL;
+    return true;
+}
+
+static bool CpuCommandQueue_GetClockCalibration(ComputeCommandQueue *This, uint64_t *pGpuTimestamp, uint64_t *pCpuTimestamp)
+{
+    (void)This;
+    *pGpuTimestamp = *pCpuTimestamp = ComputeGetTimeNanoseconds();
+    return true;
+}
+
+static const ComputeCommandQueueVtbl s_cpuCommandQueueVtbl = {
+    CpuCommandQueue_Release, CpuCommandQueue_ExecuteCommandLists, CpuCommandQueue_Signal, CpuCommandQueue_Wait,
+    CpuCommandQueue_GetTimestampFrequency, CpuCommandQueue_GetClockCalibration
+};
+
+// ---- Device ----
+
+static void CpuDevice_Release(ComputeDevice *This)
+{
+    CpuDevice *device = (CpuDevice*)This;
+    ReleaseThreadPool(device->threadPool);
+    free(device);
+}
+
+static ComputeBackendType CpuDevice_GetBackendType(ComputeDevice *This)
+{
+    (void)This;
+    return COMPUTE_BACKEND_CPU;
+}
+
+// There is no HLSL compiler on the host. The "bytecode" names the native port of the entry point
+// and records the macros, which the kernel resolves when the pipeline state is created.
+// Only the sources generated at run time are read, for the program their kernel interprets.
+static bool CpuDevice_CompileShaderFromFile(ComputeDevice *This, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode)
+{
+    (void)This;
+    (void)pTarget;
+    (void)Flags;
+
+    const CpuKernelDesc *kernel = FindCpuKernel(pFileName, pEntryPoint);
+    if (kernel == NULL)
+    {
+        printf("CPU backend: no native kernel for %s in %s!\n", pEntryPoint, pFileName);
+        return false;
+    }
+
+    CpuShaderBytecode bytecode;
+    memset(&bytecode, 0, sizeof(bytecode));
+    bytecode.magic = CPU_SHADER_BYTECODE_MAGIC;
+    memcpy(bytecode.numThreads, kernel->numThreads, sizeof(bytecode.numThreads));
+    strncpy(bytecode.fileName, kernel->pFileName, CPU_SHADER_MAX_NAME_LENGTH - 1);
+    strncpy(bytecode.entryPoint, kernel->pEntryPoint, CPU_SHADER_MAX_NAME_LENGTH - 1);
+
+    for (const ComputeShaderMacro *macro = pDefines; macro != NULL && macro->Name != NULL; macro++)
+    {
+        const char *definition = macro->Definition != NULL ? macro->Definition : "";
+        if (bytecode.numDefines == CPU_SHADER_MAX_DEFINES ||
+            strlen(macro->Name) >= CPU_SHADER_MAX_DEFINE_LENGTH || strlen(definition) >= CPU_SHADER_MAX_DEFINE_LENGTH)
+        {
+            printf("CPU backend: too many or too long macros for %s!\n", pEntryPoint);
+            return false;
+        }
+
+        CpuShaderDefine *define = &bytecode.defines[bytecode.numDefines++];
+        strcpy(define->name, macro->Name);
+        strcpy(define->definition, definition);
+    }
+
+    if (kernel->loadFunc != NULL)
+    {
+        ComputeMappedFile source;
+        if (!ComputeMappedFileOpenRead(&source, pFileName))
+        {
+            printf("CPU backend: failed to read %s!\n", pFileName);
+            return false;
+        }
+
+        const bool loaded = kernel->loadFunc((const char*)source.pData, (size_t)source.size, &bytecode);
+        ComputeMappedFileClose(&source);
+        if (!loaded)
+        {
+            printf("CPU backend: %s is not a source the kernel %s interprets!\n", pFileName, pEntryPoint);
+            return false;
+        }
+    }
+
+    // Report invalid macro values at compile time, like the HLSL compiler would.
+    uint64_t params[CPU_KERNEL_MAX_PARAMS_SIZE / sizeof(uint64_t)];
+    if (kernel->specializeFunc != NULL && !kernel->specializeFunc(&bytecode, bytecode.numThreads, params))
+    {
+        printf("CPU backend: invalid macros for %s in %s!\n", pEntryPoint, pFileName);
+        return false;
+    }
+
+    *ppCode = CreateCpuBlob(&bytecode, sizeof(bytecode));
+    return *ppCode != NULL;
+}
+
+static bool CpuDevice_ReflectShader(ComputeDevice *This, const ComputeShaderBytecode *pBytecode, ComputeShaderReflection *pReflection)
+{
+    (void)This;
+
+    const CpuShaderBytecode *bytecode = pBytecode->pShaderBytecode;
+    if (bytecode == NULL || pBytecode->BytecodeLength < sizeof(*bytecode) || bytecode->magic != CPU_SHADER_BYTECODE_MAGIC)
+    {
+        puts("CPU backend: invalid shader bytecode!");
+        return false;
+    }
+
+    // The compiler has already resolved [numthreads] for the macros of the variant.
+    memcpy(pReflection->ThreadGroupSize, bytecode->numThreads, sizeof(pReflection->ThreadGroupSize));
+
+    // The bindings are declared along with the native kernel, or loaded with the generated ones.
+    const CpuKernelDesc *kernel = FindCpuKernel(bytecode->fileName, bytecode->entryPoint);
+    if (kernel == NULL)
+        return false;
+    const uint32_t numBindings = kernel->loadFunc != NULL ? bytecode->numBindings : kernel->numBindings;
+    const ComputeShaderInputBinding *pBindings = kernel->loadFunc != NULL ? bytecode->bindings : kernel->pBindings;
+    if (numBindings > COMPUTE_MAX_SHADER_BINDINGS)
+        return false;
+    pReflection->NumBoundResources = numBindings;
+    memcpy(pReflection->BoundResources, pBindings, numBindings * sizeof(*pBindings));
+    return true;
+}
+
+static ComputeResource* CpuDevice_CreateCommittedResource(ComputeDevice *This, ComputeHeapType HeapType, const ComputeResourceDesc *pDesc,
+    ComputeResourceStates InitialResourceState)
+{
+    (void)This;
+    (void)InitialResourceState;
+
+    CpuResource *resource = calloc(1, sizeof(*resource));
+    if (resource == NULL)
+        return NULL;
+
+    resource->lpVtbl = &s_cpuResourceVtbl;
+    resource->heapType = HeapType;
+    resource->desc = *pDesc;
+    resource->pData = ComputeAlignedAlloc((size_t)pDesc->Width, CPU_RESOURCE_ALIGNMENT);
+    if (resource->pData == NULL)
+    {
+        free(resource);
+        return NULL;
+    }
+
+    // Committed resources are zero initialized.
+    memset(resource->pData, 0, (size_t)pDesc->Width);
+
+    return (ComputeResource*)resource;
+}
+
+static ComputeHeap* CpuDevice_CreateHeap(ComputeDevice *This, const ComputeHeapDesc *pDesc)
+{
+    (void)This;
+
+    if (pDesc->SizeInBytes == 0 || pDesc->SizeInBytes % COMPUTE_PLACEMENT_ALIGNMENT != 0)
+        return NULL;
+
+    CpuHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+        return NULL;
+
+    heap->lpVtbl = &s_cpuHeapVtbl;
+    heap->desc = *pDesc;
+    heap->pData = ComputeAlignedAlloc((size_t)pDesc->SizeInBytes, CPU_RESOURCE_ALIGNMENT);
+    if (heap->pData == NULL)
+    {
+        free(heap);
+        return NULL;
+    }
+    ComputeMutexInit(&heap->mutex);
+    heap->refCount = 1;
+
+    return (ComputeHeap*)heap;
+}
+
+static ComputeResource* CpuDevice_CreatePlacedResource(ComputeDevice *This, ComputeHeap *pHeap, uint64_t HeapOffset,
+    const ComputeResourceDesc *pDesc, ComputeResourceStates InitialState)
+{
+    (void)This;
+    (void)InitialState;
+
+    CpuHeap *heap = (CpuHeap*)pHeap;
+    if (HeapOffset % COMPUTE_PLACEMENT_ALIGNMENT != 0 || HeapOffset > heap->desc.SizeInBytes ||
+        pDesc->Width > heap->desc.SizeInBytes - HeapOffset)
+        return NULL;
+
+    CpuResource *resource = calloc(1, sizeof(*resource));
+    if (resource == NULL)
+        return NULL;
+
+    // The memory is shared with the other resources placed in the range, and is not cleared.
+    resource->lpVtbl = &s_cpuResourceVtbl;
+    resource->heapType = heap->desc.Type;
+    resource->desc = *pDesc;
+    resource->pData = heap->pData + HeapOffset;
+    resource->heap = heap;
+
+    ComputeMutexLock(&heap->mutex);
+    heap->refCount++;
+    ComputeMutexUnlock(&heap->mutex);
+
+    return (ComputeResource*)resource;
+}
+
+static ComputeDescriptorHeap* CpuDevice_CreateDescriptorHeap(ComputeDevice *This, const ComputeDescriptorHeapDesc *pDesc)
+{
+    (void)This;
+
+    CpuDescriptorHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+        return NULL;
+
+    heap->descriptors = calloc(pDesc->NumDescriptors > 0 ? pDesc->NumDescriptors : 1, sizeof(*heap->descriptors));
+    if (heap->descriptors == NULL)
+    {
+        free(heap);
+        return NULL;
+    }
+
+    heap->lpVtbl = &s_cpuDescriptorHeapVtbl;
+    heap->numDescriptors = pDesc->NumDescriptors;
+
+    return (ComputeDescriptorHeap*)heap;
+}
+
+static uint32_t CpuDevice_GetDescriptorHandleIncrementSize(ComputeDevice *This)
+{
+    (void)This;
+    return (uint32_t)sizeof(CpuDescriptor);
+}
+
+static void CpuDevice_CreateShaderResourceView(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+    ComputeCPUDescriptorHandle DestDescriptor)
+{
+    (void)This;
+
+    CpuDescriptor *descriptor = (CpuDescriptor*)DestDescriptor.ptr;
+    descriptor->type = CPU_DESCRIPTOR_TYPE_SRV;
+    descriptor->resource = (CpuResource*)pResource;
+    descriptor->view = *pDesc;
+}
+
+static void CpuDevice_CreateUnorderedAccessView(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+    ComputeCPUDescriptorHandle DestDescriptor)
+{
+    (void)This;
+
+    CpuDescriptor *descriptor = (CpuDescriptor*)DestDescriptor.ptr;
+    descriptor->type = CPU_DESCRIPTOR_TYPE_UAV;
+    descriptor->resource = (CpuResource*)pResource;
+    descriptor->view = *pDesc;
+}
+
+static void CpuDevice_CopyDescriptors(ComputeDevice *This, uint32_t NumDestDescriptorRanges, const ComputeCPUDescriptorHandle *pDestDescriptorRangeStarts,
+    const uint32_t *pDestDescriptorRangeSizes, uint32_t NumSrcDescriptorRanges, const ComputeCPUDescriptorHandle *pSrcDescriptorRangeStarts,
+    const uint32_t *pSrcDescriptorRangeSizes)
+{
+    (void)This;
+
+    // Walk both lists of ranges in step, one descriptor at a time.
+    uint32_t destRange = 0, destIndex = 0;
+    uint32_t srcRange = 0, srcIndex = 0;
+    while (destRange < NumDestDescriptorRanges && srcRange < NumSrcDescriptorRanges)
+    {
+        if (destIndex >= (pDestDescriptorRangeSizes != NULL ? pDestDescriptorRangeSizes[destRange] : 1))
+        {
+            destRange++;
+            destIndex = 0;
+            continue;
+        }
+        if (srcIndex >= (pSrcDescriptorRangeSizes != NULL ? pSrcDescriptorRangeSizes[srcRange] : 1))
+        {
+            srcRange++;
+            srcIndex = 0;
+            continue;
+        }
+
+        CpuDescriptor *dest = (CpuDescriptor*)pDestDescriptorRangeStarts[destRange].ptr + destIndex++;
+        *dest = *((const CpuDescriptor*)pSrcDescriptorRangeStarts[srcRange].ptr + srcIndex++);
+    }
+}
+
+static ComputeRootSignature* CpuDevice_CreateRootSignature(ComputeDevice *This, const ComputeRootSignatureDesc *pDesc)
+{
+    (void)This;
+
+    if (pDesc->NumParameters > COMPUTE_MAX_ROOT_PARAMETERS)
+        return NULL;
+
+    CpuRootSignature *rootSignature = calloc(1, sizeof(*rootSignature));
+    if (rootSignature == NULL)
+        return NULL;
+
+    rootSignature->lpVtbl = &s_cpuRootSignatureVtbl;
+    rootSignature->numParameters = pDesc->NumParameters;
+
+    uint32_t numConstants = 0;
+    for (uint32_t i = 0; i < pDesc->NumParameters; i++)
+    {
+        const ComputeRootParameter *src = &pDesc->pParameters[i];
+        CpuRootParameter *dst = &rootSignature->parameters[i];
+        dst->type = src->ParameterType;
+
+        if (src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+        {
+            if (numConstants + src->Constants.Num32BitValues > COMPUTE_MAX_ROOT_CONSTANTS)
+            {
+                puts("CPU backend: too many root constants!");
+                CpuRootSignature_Release((ComputeRootSignature*)rootSignature);
+                return NULL;
+            }
+            dst->constants = src->Constants;
+            dst->constantsOffset = numConstants;
+            numConstants += src->Constants.Num32BitValues;
+            continue;
+        }
+        if (src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_SRV || src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_UAV)
+        {
+            dst->descriptor = src->Descriptor;
+            continue;
+        }
+        if (src->ParameterType != COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+            continue;
+
+        dst->numRanges = src->DescriptorTable.NumDescriptorRanges;
+        dst->ranges = malloc((dst->numRanges > 0 ? dst->numRanges : 1) * sizeof(*dst->ranges));
+        if (dst->ranges == NULL)
+        {
+            CpuRootSignature_Release((ComputeRootSignature*)rootSignature);
+            return NULL;
+        }
+        memcpy(dst->ranges, src->DescriptorTable.pDescriptorRanges, dst->numRanges * sizeof(*dst->ranges));
+    }
+    rootSignature->hash = HashRootSignature(rootSignature);
+
+    return (ComputeRootSignature*)rootSignature;
+}
+
+static ComputePipelineState* CpuDevice_CreateComputePipelineState(ComputeDevice *This, const ComputePipelineStateDesc *pDesc)
+{
+    (void)This;
+
+    const CpuShaderBytecode *bytecode = pDesc->CS.pShaderBytecode;
+    if (bytecode == NULL || pDesc->CS.BytecodeLength < sizeof(*bytecode) || bytecode->magic != CPU_SHADER_BYTECODE_MAGIC)
+    {
+        puts("CPU backend: invalid shader bytecode!");
+        return NULL;
+    }
+
+    // Like D3D12, a cached blob that does not match the description is an error.
+    if (pDesc->CachedPSO.pCachedBlob != NULL &&
+        (pDesc->CachedPSO.CachedBlobSizeInBytes != sizeof(*bytecode) ||
+        memcmp(pDesc->CachedPSO.pCachedBlob, bytecode, sizeof(*bytecode)) != 0))
+    {
+        puts("CPU backend: the cached PSO does not match the shader bytecode!");
+        return NULL;
+    }
+
+    const CpuKernelDesc *kernel = FindCpuKernel(bytecode->fileName, bytecode->entryPoint);
+    if (kernel == NULL)
+        return NULL;
+
+    CpuPipelineState *pipelineState = calloc(1, sizeof(*pipelineState));
+    if (pipelineState == NULL)
+        return NULL;
+
+    pipelineState->lpVtbl = &s_cpuPipelineStateVtbl;
+    pipelineState->kernel = kernel;
+    memcpy(pipelineState->numThreads, bytecode->numThreads, sizeof(pipelineState->numThreads));
+    pipelineState->bytecode = *bytecode;
+
+    // The parameters may point into the bytecode, so it is the copy that lives as long as the pipeline state.
+    if (kernel->specializeFunc != NULL &&
+        !kernel->specializeFunc(&pipelineState->bytecode, pipelineState->numThreads, pipelineState->params))
+    {
+        puts("CPU backend: invalid shader bytecode!");
+        free(pipelineState);
+        return NULL;
+    }
+
+    return (ComputePipelineState*)pipelineState;
+}
+
+static ComputeCommandQueue* CpuDevice_CreateCommandQueue(ComputeDevice *This, ComputeCommandListType Type)
+{
+    CpuCommandQueue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL)
+        return NULL;
+
+    queue->lpVtbl = &s_cpuCommandQueueVtbl;
+    queue->device = (CpuDevice*)This;
+    queue->type = Type;
+    ComputeMutexInit(&queue->mutex);
+    ComputeConditionInit(&queue->cond);
+
+    if (!ComputeThreadCreate(&queue->thread, QueueThreadProc, queue))
+    {
+        ComputeConditionDestroy(&queue->cond);
+        ComputeMutexDestroy(&queue->mutex);
+        free(queue);
+        return NULL;
+    }
+
+    return (ComputeCommandQueue*)queue;
+}
+
+static ComputeCommandAllocator* CpuDevice_CreateCommandAllocator(ComputeDevice *This, ComputeCommandListType Type)
+{
+    (void)This;
+
+    CpuCommandAllocator *allocator = calloc(1, sizeof(*allocator));
+    if (allocator == NULL)
+        return NULL;
+
+    allocator->lpVtbl = &s_cpuCommandAllocatorVtbl;
+    allocator->type = Type;
+
+    return (ComputeCommandAllocator*)allocator;
+}
+
+static ComputeCommandList* CpuDevice_CreateCommandList(ComputeDevice *This, ComputeCommandListType Type,
+    ComputeCommandAllocator *pCommandAllocator, ComputePipelineState *pInitialState)
+{
+    (void)This;
+
+    CpuCommandList *list = calloc(1, sizeof(*list));
+    if (list == NULL)
+        return NULL;
+
+    list->lpVtbl = &s_cpuCommandListVtbl;
+    list->type = Type;
+
+    // Command lists are created in the recording state.
+    CpuCommandList_Reset((ComputeCommandList*)list, pCommandAllocator, pInitialState);
+
+    return (ComputeCommandList*)list;
+}
+
+static ComputeFence* CpuDevice_CreateFence(ComputeDevice *This, uint64_t InitialValue)
+{
+    (void)This;
+
+    CpuFence *fence = calloc(1, sizeof(*fence));
+    if (fence == NULL)
+        return NULL;
+
+    fence->lpVtbl = &s_cpuFenceVtbl;
+    fence->refCount = 1;
+    fence->value = (int64_t)InitialValue;
+    ComputeMutexInit(&fence->mutex);
+    ComputeConditionInit(&fence->cond);
+
+    return (ComputeFence*)fence;
+}
+
+static ComputeQueryHeap* CpuDevice_CreateQueryHeap(ComputeDevice *This, const ComputeQueryHeapDesc *pDesc)
+{
+    (void)This;
+
+    if (pDesc->Type != COMPUTE_QUERY_HEAP_TYPE_TIMESTAMP && pDesc->Type != COMPUTE_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP)
+        return NULL;
+
+    CpuQueryHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+        return NULL;
+
+    heap->timestamps = calloc(pDesc->Count > 0 ? pDesc->Count : 1, sizeof(*heap->timestamps));
+    if (heap->timestamps == NULL)
+    {
+        free(heap);
+        return NULL;
+    }
+
+    heap->lpVtbl = &s_cpuQueryHeapVtbl;
+    heap->count = pDesc->Count;
+
+    return (ComputeQueryHeap*)heap;
+}
+
+static const ComputeDeviceVtbl s_cpuDeviceVtbl = {
+    CpuDevice_Release, CpuDevice_GetBackendType, CpuDevice_CompileShaderFromFile, CpuDevice_ReflectShader,
+    CpuDevice_CreateCommittedResource, CpuDevice_CreateHeap, CpuDevice_CreatePlacedResource, CpuDevice_CreateDescriptorHeap, CpuDevice_GetDescriptorHandleIncrementSize,
+    CpuDevice_CreateShaderResourceView, CpuDevice_CreateUnorderedAccessView, CpuDevice_CopyDescriptors,
+    CpuDevice_CreateRootSignature, CpuDevice_CreateComputePipelineState,
+    CpuDevice_CreateCommandQueue, CpuDevice_CreateCommandAllocator, CpuDevice_CreateCommandList, CpuDevice_CreateFence,
+    CpuDevice_CreateQueryHeap
+};
+
+ComputeDevice* CreateCPUComputeDevice(const ComputeCPUDeviceDesc *pDesc)
+{
+    CpuDevice *device = calloc(1, sizeof(*device));
+    if (device == NULL)
+        return NULL;
+
+    device->lpVtbl = &s_cpuDeviceVtbl;
+    device->speedPercent = pDesc != NULL && pDesc->SpeedPercent != 0 ? pDesc->SpeedPercent : 100;
+    device->threadPool = CreateThreadPool(pDesc != NULL ? pDesc->NumThreads : 0);
+    if (device->threadPool == NULL)
+    {
+        free(device);
+        return NULL;
+    }
+
+    return (ComputeDevice*)device;
+}
@@ -0,0 +1,843 @@
+#include "cpu_kernels.h"
+#include "compute_thread.h"
+#include "compute_verify.h"
+#include "kernel_fusion.h"
+#include "typed_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_KERNELS_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CPU_KERNELS_NEON
+#endif
+
+// dst[i] = src[i] + operand, vectorized with the widest instruction set enabled at compile time
+static void AddConstantInt32(int32_t *dst, const int32_t *src, size_t count, int32_t operand)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i vOperand = _mm256_set1_epi32(operand);
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi32(v, vOperand));
+    }
+#elif defined(CPU_KERNELS_SSE2)
+    const __m128i vOperand = _mm_set1_epi32(operand);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(v, vOperand));
+    }
+#elif defined(CPU_KERNELS_NEON)
+    const int32x4_t vOperand = vdupq_n_s32(operand);
+    for (; i + 4 <= count; i += 4)
+        vst1q_s32(dst + i, vaddq_s32(vld1q_s32(src + i), vOperand));
+#endif
+
+    for (; i < count; i++)
+        dst[i] = src[i] + operand;
+}
+
+// dst[i] = src[i] + operand on floats
+static void AddConstantFloat32(float *dst, const float *src, size_t count, float operand)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 vOperand = _mm256_set1_ps(operand);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(src + i), vOperand));
+#elif defined(CPU_KERNELS_SSE2)
+    const __m128 vOperand = _mm_set1_ps(operand);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(src + i), vOperand));
+#elif defined(CPU_KERNELS_NEON)
+    const float32x4_t vOperand = vdupq_n_f32(operand);
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(dst + i, vaddq_f32(vld1q_f32(src + i), vOperand));
+#endif
+
+    for (; i < count; i++)
+        dst[i] = src[i] + operand;
+}
+
+// Parse a numeric macro. An undefined macro takes the default value of the HLSL source.
+static bool GetNumericDefine(const CpuShaderBytecode *bytecode, const char *name, double defaultValue, double *pValue)
+{
+    const char *definition = GetCpuShaderDefine(bytecode, name);
+    if (definition == NULL)
+    {
+        *pValue = defaultValue;
+        return true;
+    }
+
+    char *end;
+    *pValue = strtod(definition, &end);
+    return end != definition && *end == '\0';
+}
+
+// The ELEM_TYPE values of compute.hlsl
+typedef enum AddConstantElementType
+{
+    ADD_CONSTANT_ELEMENT_INT,
+    ADD_CONSTANT_ELEMENT_UINT,
+    ADD_CONSTANT_ELEMENT_FLOAT
+} AddConstantElementType;
+
+typedef struct AddConstantParams
+{
+    AddConstantElementType elementType;
+    // GROUP_SIZE * UNROLL
+    uint32_t elementsPerGroup;
+    // (ELEM_TYPE)OPERAND
+    union
+    {
+        int32_t i;
+        float f;
+    } operand;
+} AddConstantParams;
+
+// The macros of compute.hlsl: OPERAND, GROUP_SIZE, ELEM_TYPE and UNROLL
+static bool CSMain_Specialize(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params)
+{
+    AddConstantParams *addParams = params;
+
+    double operand, groupSize, unroll;
+    if (!GetNumericDefine(bytecode, "OPERAND", 10, &operand) ||
+        !GetNumericDefine(bytecode, "GROUP_SIZE", 1024, &groupSize) ||
+        !GetNumericDefine(bytecode, "UNROLL", 1, &unroll))
+        return false;
+
+    // The limits of cs_5_0
+    if (groupSize < 1 || groupSize > 1024 || unroll < 1 || groupSize * unroll > UINT32_MAX)
+        return false;
+
+    const char *elementType = GetCpuShaderDefine(bytecode, "ELEM_TYPE");
+    if (elementType == NULL || strcmp(elementType, "int") == 0)
+    {
+        addParams->elementType = ADD_CONSTANT_ELEMENT_INT;
+        addParams->operand.i = (int32_t)operand;
+    }
+    else if (strcmp(elementType, "uint") == 0)
+    {
+        addParams->elementType = ADD_CONSTANT_ELEMENT_UINT;
+        addParams->operand.i = (int32_t)(uint32_t)(int64_t)operand;
+    }
+    else if (strcmp(elementType, "float") == 0)
+    {
+        addParams->elementType = ADD_CONSTANT_ELEMENT_FLOAT;
+        addParams->operand.f = (float)operand;
+    }
+    else
+        return false;
+
+    numThreads[0] = (uint32_t)groupSize;
+    numThreads[1] = 1;
+    numThreads[2] = 1;
+    addParams->elementsPerGroup = (uint32_t)groupSize * (uint32_t)unroll;
+
+    return true;
+}
+
+// AddOperand of compute.hlsl: dstBuffer[index] = srcBuffer[index] + operand
+// Each group covers GROUP_SIZE * UNROLL consecutive elements.
+static void AddOperand_Group(const CpuKernelContext *context, const AddConstantParams *params, uint32_t groupX, uint32_t groupY)
+{
+    const CpuKernelBuffer *src = &context->srv[0];
+    const CpuKernelBuffer *dst = &context->uav[0];
+
+    // The DispatchConstants cbuffer: NumElements, BaseGroup, GroupsPerRow
+    const CpuKernelConstants *constants = &context->cbv[0];
+    if (constants->numValues < 3)
+        return;
+    const uint32_t numElements = constants->pData[0];
+    const uint32_t group = constants->pData[1] + groupY * constants->pData[2] + groupX;
+
+    // Like on the device, out of bounds reads return 0 and out of bounds writes are discarded.
+    const uint64_t begin = (uint64_t)group * params->elementsPerGroup;
+    uint64_t end = begin + params->elementsPerGroup;
+    if (end > numElements)
+        end = numElements;
+    if (end > dst->numElements)
+        end = dst->numElements;
+    if (begin >= end)
+        return;
+
+    const uint64_t inBoundsEnd = end < src->numElements ? end : (src->numElements > begin ? src->numElements : begin);
+
+    // Signed and unsigned additions produce the same bits.
+    if (params->elementType == ADD_CONSTANT_ELEMENT_FLOAT)
+    {
+        float *pDst = (float*)dst->pData;
+        const float *pSrc = (const float*)src->pData;
+        AddConstantFloat32(pDst + begin, pSrc + begin, (size_t)(inBoundsEnd - begin), params->operand.f);
+        for (uint64_t i = inBoundsEnd; i < end; i++)
+            pDst[i] = params->operand.f;
+    }
+    else
+    {
+        int32_t *pDst = (int32_t*)dst->pData;
+        const int32_t *pSrc = (const int32_t*)src->pData;
+        AddConstantInt32(pDst + begin, pSrc + begin, (size_t)(inBoundsEnd - begin), params->operand.i);
+        for (uint64_t i = inBoundsEnd; i < end; i++)
+            pDst[i] = params->operand.i;
+    }
+}
+
+// CSMain of compute.hlsl, with the operand (ELEM_TYPE)OPERAND
+static void CSMain_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+    AddOperand_Group(context, context->params, groupX, groupY);
+}
+
+// CSMainDynamic of compute.hlsl, with the operand of the OperandConstants cbuffer
+static void CSMainDynamic_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    const CpuKernelConstants *constants = &context->cbv[1];
+    if (constants->numValues < 1)
+        return;
+
+    // The bits of the int, uint or float
+    AddConstantParams params = *(const AddConstantParams*)context->params;
+    params.operand.i = (int32_t)constants->pData[0];
+    AddOperand_Group(context, &params, groupX, groupY);
+}
+
+// ---- primitives.hlsl ----
+
+// The Flags of primitives.hlsl
+#define PRIMITIVE_FLAG_READ_SCRATCH     1
+#define PRIMITIVE_FLAG_WRITE_SCRATCH    2
+#define PRIMITIVE_FLAG_READ_OUTPUT      4
+#define PRIMITIVE_FLAG_PREDICATE        8
+#define PRIMITIVE_FLAG_VALUES           16
+
+#define PRIMITIVE_RADIX_BITS    4
+#define PRIMITIVE_RADIX_SIZE    (1 << PRIMITIVE_RADIX_BITS)
+
+typedef struct PrimitiveParams
+{
+    // GROUP_SIZE * ITEMS_PER_THREAD
+    uint32_t blockSize;
+} PrimitiveParams;
+
+// The PrimitiveConstants cbuffer
+typedef struct PrimitiveConstants
+{
+    uint32_t numElements;
+    uint32_t baseGroup;
+    uint32_t groupsPerRow;
+    uint32_t inputOffset;
+    uint32_t outputOffset;
+    uint32_t sumsOffset;
+    uint32_t flags;
+    uint32_t shift;
+    uint32_t valuesOffset;
+} PrimitiveConstants;
+
+// The macros of primitives.hlsl: GROUP_SIZE and ITEMS_PER_THREAD
+static bool Primitive_Specialize(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params)
+{
+    PrimitiveParams *primitiveParams = params;
+
+    double groupSize, itemsPerThread;
+    if (!GetNumericDefine(bytecode, "GROUP_SIZE", 256, &groupSize) ||
+        !GetNumericDefine(bytecode, "ITEMS_PER_THREAD", 4, &itemsPerThread))
+        return false;
+
+    // The radix sort packs the digit counts of a block in 16 bits, and has one thread per digit.
+    const uint32_t size = (uint32_t)groupSize;
+    if (groupSize != size || size < PRIMITIVE_RADIX_SIZE || size > 1024 || (size & (size - 1)) != 0 ||
+        itemsPerThread < 1 || groupSize * itemsPerThread >= 65536)
+        return false;
+
+    numThreads[0] = size;
+    numThreads[1] = 1;
+    numThreads[2] = 1;
+    primitiveParams->blockSize = size * (uint32_t)itemsPerThread;
+
+    return true;
+}
+
+// The constants of the Dispatch, and the linear index of the group. Returns false if the constants are not bound.
+static bool GetPrimitiveConstants(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY,
+    PrimitiveConstants *pConstants, uint32_t *pGroup)
+{
+    const CpuKernelConstants *constants = &context->cbv[0];
+    if (constants->numValues < sizeof(PrimitiveConstants) / sizeof(uint32_t))
+        return false;
+
+    memcpy(pConstants, constants->pData, sizeof(*pConstants));
+    *pGroup = pConstants->baseGroup + groupY * pConstants->groupsPerRow + groupX;
+    return true;
+}
+
+// Like on the device, out of bounds reads return 0 and out of bounds writes are discarded.
+static uint32_t LoadUint(const CpuKernelBuffer *buffer, uint64_t index)
+{
+    return index < buffer->numElements ? ((const uint32_t*)buffer->pData)[index] : 0;
+}
+
+static void StoreUint(const CpuKernelBuffer *buffer, uint64_t index, uint32_t value)
+{
+    if (index < buffer->numElements)
+        ((uint32_t*)buffer->pData)[index] = value;
+}
+
+static uint32_t LoadPrimitiveInput(const CpuKernelContext *context, const PrimitiveConstants *constants, uint32_t index)
+{
+    if (index >= constants->numElements)
+        return 0;
+    if (constants->flags & PRIMITIVE_FLAG_PREDICATE)
+        return LoadUint(&context->srv[1], index) != 0 ? 1 : 0;
+    if (constants->flags & PRIMITIVE_FLAG_READ_SCRATCH)
+        return LoadUint(&context->uav[1], (uint64_t)constants->inputOffset + index);
+    if (constants->flags & PRIMITIVE_FLAG_READ_OUTPUT)
+        return LoadUint(&context->uav[0], index);
+    return LoadUint(&context->srv[0], index);
+}
+
+static void StorePrimitiveOutput(const CpuKernelContext *context, const PrimitiveConstants *constants, uint32_t index, uint32_t value)
+{
+    if (index >= constants->numElements)
+        return;
+    if (constants->flags & PRIMITIVE_FLAG_WRITE_SCRATCH)
+        StoreUint(&context->uav[1], (uint64_t)constants->outputOffset + index, value);
+    else
+        StoreUint(&context->uav[0], index, value);
+}
+
+static uint32_t LoadPrimitiveValue(const CpuKernelContext *context, const PrimitiveConstants *constants, uint32_t index)
+{
+    if (index >= constants->numElements)
+        return 0;
+    if (constants->flags & PRIMITIVE_FLAG_READ_SCRATCH)
+        return LoadUint(&context->uav[1], (uint64_t)constants->valuesOffset + index);
+    if (constants->flags & PRIMITIVE_FLAG_READ_OUTPUT)
+        return LoadUint(&context->uav[2], index);
+    return LoadUint(&context->srv[1], index);
+}
+
+static void StorePrimitiveValue(const CpuKernelContext *context, const PrimitiveConstants *constants, uint32_t index, uint32_t value)
+{
+    if (index >= constants->numElements)
+        return;
+    if (constants->flags & PRIMITIVE_FLAG_WRITE_SCRATCH)
+        StoreUint(&context->uav[1], (uint64_t)constants->valuesOffset + index, value);
+    else
+        StoreUint(&context->uav[2], index, value);
+}
+
+// The elements [*pBegin, *pEnd) of the block of the group
+static void GetPrimitiveBlock(const CpuKernelContext *context, const PrimitiveConstants *constants, uint32_t group,
+    uint32_t *pBegin, uint32_t *pEnd)
+{
+    const PrimitiveParams *params = context->params;
+    const uint64_t begin = (uint64_t)group * params->blockSize;
+    const uint64_t end = begin + params->blockSize;
+    *pBegin = begin < constants->numElements ? (uint32_t)begin : constants->numElements;
+    *pEnd = end < constants->numElements ? (uint32_t)end : constants->numElements;
+}
+
+// Reduce of primitives.hlsl: the sum of the block
+static void Reduce_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    uint32_t sum = 0;
+    for (uint32_t i = begin; i < end; i++)
+        sum += LoadPrimitiveInput(context, &constants, i);
+
+    if (constants.flags & PRIMITIVE_FLAG_WRITE_SCRATCH)
+        StoreUint(&context->uav[1], (uint64_t)constants.outputOffset + group, sum);
+    else
+        StoreUint(&context->uav[0], group, sum);
+}
+
+// ScanBlocks of primitives.hlsl: exclusive scan of the block, and the total of the block.
+// Each element is read before it is written, so the scan may be in place.
+static void ScanBlocks_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    uint32_t sum = 0;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const uint32_t value = LoadPrimitiveInput(context, &constants, i);
+        StorePrimitiveOutput(context, &constants, i, sum);
+        sum += value;
+    }
+
+    StoreUint(&context->uav[1], (uint64_t)constants.sumsOffset + group, sum);
+}
+
+// AddBlockOffsets of primitives.hlsl: add the scanned sum of the previous blocks to the block
+static void AddBlockOffsets_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    const uint32_t offset = LoadUint(&context->uav[1], (uint64_t)constants.sumsOffset + group);
+    const CpuKernelBuffer *output = (constants.flags & PRIMITIVE_FLAG_WRITE_SCRATCH) ? &context->uav[1] : &context->uav[0];
+    const uint64_t outputOffset = (constants.flags & PRIMITIVE_FLAG_WRITE_SCRATCH) ? constants.outputOffset : 0;
+
+    for (uint32_t i = begin; i < end; i++)
+        StoreUint(output, outputOffset + i, LoadUint(output, outputOffset + i) + offset);
+}
+
+// CompactScatter of primitives.hlsl: move the flagged elements to their scanned positions
+static void CompactScatter_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        if (LoadUint(&context->srv[1], i) != 0)
+        {
+            const uint32_t position = LoadUint(&context->uav[1], (uint64_t)constants.inputOffset + i);
+            StoreUint(&context->uav[0], position, LoadUint(&context->srv[0], i));
+        }
+    }
+
+    if (group == 0)
+        StoreUint(&context->uav[2], 0, LoadUint(&context->uav[1], constants.sumsOffset));
+}
+
+// RadixHistogram of primitives.hlsl: the digit counts of the block, stored digit-major
+static void RadixHistogram_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    const PrimitiveParams *params = context->params;
+    const uint64_t numBlocks = ((uint64_t)constants.numElements + params->blockSize - 1) / params->blockSize;
+
+    uint32_t counts[PRIMITIVE_RADIX_SIZE] = { 0 };
+    for (uint32_t i = begin; i < end; i++)
+        counts[(LoadPrimitiveInput(context, &constants, i) >> constants.shift) & (PRIMITIVE_RADIX_SIZE - 1)]++;
+
+    for (uint32_t digit = 0; digit < PRIMITIVE_RADIX_SIZE; digit++)
+        StoreUint(&context->uav[1], constants.sumsOffset + digit * numBlocks + group, counts[digit]);
+}
+
+// RadixScatter of primitives.hlsl: move the keys, and the values, to the scanned positions of their digit.
+// The elements are visited in order, so the sort is stable.
+static void RadixScatter_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    PrimitiveConstants constants;
+    uint32_t group, begin, end;
+    if (!GetPrimitiveConstants(context, groupX, groupY, &constants, &group))
+        return;
+    GetPrimitiveBlock(context, &constants, group, &begin, &end);
+
+    const PrimitiveParams *params = context->params;
+    const uint64_t numBlocks = ((uint64_t)constants.numElements + params->blockSize - 1) / params->blockSize;
+
+    uint32_t offsets[PRIMITIVE_RADIX_SIZE];
+    for (uint32_t digit = 0; digit < PRIMITIVE_RADIX_SIZE; digit++)
+        offsets[digit] = LoadUint(&context->uav[1], constants.sumsOffset + digit * numBlocks + group);
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const uint32_t key = LoadPrimitiveInput(context, &constants, i);
+        const uint32_t position = offsets[(key >> constants.shift) & (PRIMITIVE_RADIX_SIZE - 1)]++;
+        StorePrimitiveOutput(context, &constants, position, key);
+        if (constants.flags & PRIMITIVE_FLAG_VALUES)
+            StorePrimitiveValue(context, &constants, position, LoadPrimitiveValue(context, &constants, i));
+    }
+}
+
+// ---- records.hlsl ----
+
+typedef struct RecordsParams
+{
+    uint32_t groupSize;
+} RecordsParams;
+
+// The RecordConstants cbuffer
+typedef struct RecordConstants
+{
+    uint32_t numElements;
+    uint32_t baseGroup;
+    uint32_t groupsPerRow;
+    uint32_t valueOffset;
+    uint32_t scaleOffset;
+    uint32_t idOffset;
+    int32_t idIncrement;
+} RecordConstants;
+
+// The macro of records.hlsl: GROUP_SIZE
+static bool Records_Specialize(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params)
+{
+    RecordsParams *recordsParams = params;
+
+    double groupSize;
+    if (!GetNumericDefine(bytecode, "GROUP_SIZE", 256, &groupSize) || groupSize < 1 || groupSize > 1024)
+        return false;
+
+    numThreads[0] = (uint32_t)groupSize;
+    numThreads[1] = 1;
+    numThreads[2] = 1;
+    recordsParams->groupSize = (uint32_t)groupSize;
+    return true;
+}
+
+// The raw buffer accesses: like on the device, out of bounds loads return 0 and out of bounds stores are discarded.
+static void LoadRaw(const CpuKernelBuffer *buffer, uint64_t address, void *pData, uint32_t size)
+{
+    if (address + size <= (uint64_t)buffer->numElements * buffer->structureByteStride)
+        memcpy(pData, buffer->pData + address, size);
+    else
+        memset(pData, 0, size);
+}
+
+static void StoreRaw(const CpuKernelBuffer *buffer, uint64_t address, const void *pData, uint32_t size)
+{
+    if (address + size <= (uint64_t)buffer->numElements * buffer->structureByteStride)
+        memcpy(buffer->pData + address, pData, size);
+}
+
+// UpdateRecords of records.hlsl: value *= scale, id += IdIncrement on the SoA fields
+static void UpdateRecords_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    const RecordsParams *params = context->params;
+    const CpuKernelBuffer *records = &context->uav[0];
+
+    RecordConstants constants;
+    if (context->cbv[0].numValues < sizeof(constants) / sizeof(uint32_t))
+        return;
+    memcpy(&constants, context->cbv[0].pData, sizeof(constants));
+
+    const uint32_t group = constants.baseGroup + groupY * constants.groupsPerRow + groupX;
+    const uint64_t begin = (uint64_t)group * params->groupSize;
+    const uint64_t end = begin + params->groupSize < constants.numElements ? begin + params->groupSize : constants.numElements;
+
+    for (uint64_t i = begin; i < end; i++)
+    {
+        uint16_t scale;
+        float value;
+        LoadRaw(records, constants.scaleOffset + i * 2, &scale, sizeof(scale));
+        LoadRaw(records, constants.valueOffset + i * 4, &value, sizeof(value));
+        value *= ComputeHalfToFloat(scale);
+        StoreRaw(records, constants.valueOffset + i * 4, &value, sizeof(value));
+
+        uint64_t id;
+        LoadRaw(records, constants.idOffset + i * 8, &id, sizeof(id));
+        id += (uint64_t)(int64_t)constants.idIncrement;
+        StoreRaw(records, constants.idOffset + i * 8, &id, sizeof(id));
+    }
+}
+
+// ---- The fused kernels of kernel_fusion.c ----
+
+typedef struct FusedParams
+{
+    // The expression in the bytecode of the pipeline state
+    const ComputeFusedExpression *expr;
+} FusedParams;
+
+// The expression is read back from the comments of the generated source. Its registers are the ones
+// of the HLSL: t#n for the n-th input, u#n for the n-th output, and the DispatchConstants.
+static bool Fused_Load(const char *pSource, size_t sourceSize, CpuShaderBytecode *bytecode)
+{
+    ComputeFusedExpression *expr = (ComputeFusedExpression*)bytecode->program;
+    if (sizeof(*expr) > sizeof(bytecode->program) || !ComputeFusedExpressionParse(expr, pSource, sourceSize))
+        return false;
+
+    uint32_t numBindings = 0;
+    for (uint32_t i = 0; i < expr->numInputs; i++)
+        bytecode->bindings[numBindings++] = (ComputeShaderInputBinding){ COMPUTE_SHADER_INPUT_STRUCTURED_SRV, i, 0, 0 };
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+        bytecode->bindings[numBindings++] = (ComputeShaderInputBinding){ COMPUTE_SHADER_INPUT_STRUCTURED_UAV, i, 0, 0 };
+    bytecode->bindings[numBindings++] = (ComputeShaderInputBinding){ COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, 3 * sizeof(uint32_t) };
+    bytecode->numBindings = numBindings;
+    return true;
+}
+
+static bool Fused_Specialize(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params)
+{
+    FusedParams *fusedParams = params;
+    fusedParams->expr = (const ComputeFusedExpression*)bytecode->program;
+
+    numThreads[0] = COMPUTE_FUSED_GROUP_SIZE;
+    numThreads[1] = 1;
+    numThreads[2] = 1;
+    return ComputeFusedExpressionValidate(fusedParams->expr);
+}
+
+// FusedMain of a generated source: the host evaluation of the expression over the elements of the group
+static void FusedMain_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    const ComputeFusedExpression *expr = ((const FusedParams*)context->params)->expr;
+
+    const CpuKernelConstants *constants = &context->cbv[0];
+    if (constants->numValues < 3)
+        return;
+    const uint32_t numElements = constants->pData[0];
+    const uint32_t group = constants->pData[1] + groupY * constants->pData[2] + groupX;
+
+    // Past the end of a buffer bound through a table, the elements are skipped instead of reading 0 like on the device.
+    // The root descriptors the fused kernels are bound with have no bounds anyway.
+    const uint64_t begin = (uint64_t)group * COMPUTE_FUSED_GROUP_SIZE;
+    uint64_t end = begin + COMPUTE_FUSED_GROUP_SIZE < numElements ? begin + COMPUTE_FUSED_GROUP_SIZE : numElements;
+
+    const void *inputs[COMPUTE_FUSED_MAX_INPUTS];
+    void *outputs[COMPUTE_FUSED_MAX_OUTPUTS];
+    for (uint32_t i = 0; i < expr->numInputs; i++)
+    {
+        inputs[i] = context->srv[i].pData;
+        if (end > context->srv[i].numElements)
+            end = context->srv[i].numElements;
+    }
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+    {
+        outputs[i] = context->uav[i].pData;
+        if (end > context->uav[i].numElements)
+            end = context->uav[i].numElements;
+    }
+
+    if (begin < end)
+        ComputeFusedEvaluate(expr, inputs, outputs, (size_t)begin, (size_t)end);
+}
+
+// ---- verify.hlsl ----
+
+typedef struct VerifyParams
+{
+    uint32_t groupSize;
+    uint32_t maxIndices;
+} VerifyParams;
+
+// The VerifyConstants cbuffer
+typedef struct VerifyConstants
+{
+    uint32_t numElements;
+    uint32_t baseGroup;
+    uint32_t groupsPerRow;
+    ComputeVerifyConstants verify;
+} VerifyConstants;
+
+// The macros of verify.hlsl: GROUP_SIZE and MAX_INDICES, the host checker keeping up to COMPUTE_VERIFY_MAX_INDICES
+static bool Verify_Specialize(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params)
+{
+    VerifyParams *verifyParams = params;
+
+    double groupSize, maxIndices;
+    if (!GetNumericDefine(bytecode, "GROUP_SIZE", 256, &groupSize) || groupSize < 1 || groupSize > 1024 ||
+        !GetNumericDefine(bytecode, "MAX_INDICES", 16, &maxIndices) || maxIndices < 0 || maxIndices > COMPUTE_VERIFY_MAX_INDICES)
+        return false;
+
+    // VerifyReset has a single thread, whatever the macros.
+    if (strcmp(bytecode->entryPoint, "VerifyElements") == 0)
+        numThreads[0] = (uint32_t)groupSize;
+    verifyParams->groupSize = (uint32_t)groupSize;
+    verifyParams->maxIndices = (uint32_t)maxIndices;
+    return true;
+}
+
+static void VerifyReset_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupX;
+    (void)groupY;
+    (void)groupZ;
+
+    StoreUint(&context->uav[0], 0, 0);
+    StoreUint(&context->uav[0], 1, UINT32_MAX);
+}
+
+// VerifyElements of verify.hlsl: the SIMD host checker over the elements of the group,
+// of which the mismatches are added to the result with the same atomics as the kernel
+static void VerifyElements_Group(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+{
+    (void)groupZ;
+
+    const VerifyParams *params = context->params;
+
+    VerifyConstants constants;
+    if (context->cbv[0].numValues < sizeof(constants) / sizeof(uint32_t))
+        return;
+    memcpy(&constants, context->cbv[0].pData, sizeof(constants));
+
+    const ComputeVerifyDesc desc = {
+        (ComputeElementType)constants.verify.ElementType, (ComputeVerifyExpected)constants.verify.Expected,
+        { .Uint = constants.verify.First }, { .Uint = constants.verify.Step }, constants.verify.Tolerance
+    };
+    if ((uint32_t)desc.ElementType > COMPUTE_ELEMENT_TYPE_FLOAT)
+        return;
+
+    // The root descriptors have no bounds, the table views clamp the range.
+    const uint32_t group = constants.baseGroup + groupY * constants.groupsPerRow + groupX;
+    const uint64_t begin = (uint64_t)group * params->groupSize;
+    uint64_t end = begin + params->groupSize < constants.numElements ? begin + params->groupSize : constants.numElements;
+    if (end > context->srv[0].numElements)
+        end = context->srv[0].numElements;
+    if (desc.Expected == COMPUTE_VERIFY_EXPECTED_BUFFER && end > context->srv[1].numElements)
+        end = context->srv[1].numElements;
+    if (begin >= end)
+        return;
+
+    ComputeVerifyResult groupResult;
+    ComputeVerifyHostRange(&desc, context->srv[0].pData, context->srv[1].pData, (size_t)begin, (size_t)end, &groupResult);
+    if (groupResult.NumMismatches == 0)
+        return;
+
+    const CpuKernelBuffer *result = &context->uav[0];
+    if ((uint64_t)result->numElements * result->structureByteStride < (2 + params->maxIndices) * sizeof(uint32_t))
+        return;
+    volatile uint32_t *words = (volatile uint32_t*)result->pData;
+
+    const uint32_t slot = ComputeAtomicAdd32(&words[0], (uint32_t)groupResult.NumMismatches);
+    for (uint32_t i = 0; i < groupResult.NumIndices && slot + i < params->maxIndices; i++)
+        words[2 + slot + i] = (uint32_t)groupResult.Indices[i];
+
+    uint32_t first = words[1];
+    while ((uint32_t)groupResult.FirstMismatch < first &&
+        !ComputeAtomicCompareExchange32(&words[1], first, (uint32_t)groupResult.FirstMismatch))
+        first = words[1];
+}
+
+// The registers of the kernels, with the sizes of the cbuffers in bytes
+static const ComputeShaderInputBinding s_csMainBindings[] = {
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, 3 * sizeof(uint32_t) }
+};
+
+static const ComputeShaderInputBinding s_csMainDynamicBindings[] = {
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, 3 * sizeof(uint32_t) },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 1, 0, sizeof(uint32_t) }
+};
+
+// The declarations of primitives.hlsl, of which each entry point uses a subset
+static const ComputeShaderInputBinding s_primitiveBindings[] = {
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 1, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 1, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 2, 0, 0 },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, sizeof(PrimitiveConstants) }
+};
+
+static const ComputeShaderInputBinding s_recordsBindings[] = {
+    { COMPUTE_SHADER_INPUT_RAW_UAV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, sizeof(RecordConstants) }
+};
+
+#define KERNEL_BINDINGS(bindings)   sizeof(bindings) / sizeof(bindings[0]), bindings
+
+static const ComputeShaderInputBinding s_verifyElementsBindings[] = {
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_SRV, 1, 0, 0 },
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 0, 0, 0 },
+    { COMPUTE_SHADER_INPUT_CBUFFER, 0, 0, sizeof(VerifyConstants) }
+};
+
+static const ComputeShaderInputBinding s_verifyResetBindings[] = {
+    { COMPUTE_SHADER_INPUT_STRUCTURED_UAV, 0, 0, 0 }
+};
+
+static const CpuKernelDesc s_cpuKernels[] = {
+    { "compute.hlsl", "CSMain", { 1024, 1, 1 }, CSMain_Group, CSMain_Specialize, KERNEL_BINDINGS(s_csMainBindings), NULL },
+    { "compute.hlsl", "CSMainDynamic", { 1024, 1, 1 }, CSMainDynamic_Group, CSMain_Specialize, KERNEL_BINDINGS(s_csMainDynamicBindings), NULL },
+    { "primitives.hlsl", "Reduce", { 256, 1, 1 }, Reduce_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "primitives.hlsl", "ScanBlocks", { 256, 1, 1 }, ScanBlocks_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "primitives.hlsl", "AddBlockOffsets", { 256, 1, 1 }, AddBlockOffsets_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "primitives.hlsl", "CompactScatter", { 256, 1, 1 }, CompactScatter_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "primitives.hlsl", "RadixHistogram", { 256, 1, 1 }, RadixHistogram_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "primitives.hlsl", "RadixScatter", { 256, 1, 1 }, RadixScatter_Group, Primitive_Specialize, KERNEL_BINDINGS(s_primitiveBindings), NULL },
+    { "records.hlsl", "UpdateRecords", { 256, 1, 1 }, UpdateRecords_Group, Records_Specialize, KERNEL_BINDINGS(s_recordsBindings), NULL },
+    { "verify.hlsl", "VerifyReset", { 1, 1, 1 }, VerifyReset_Group, Verify_Specialize, KERNEL_BINDINGS(s_verifyResetBindings), NULL },
+    { "verify.hlsl", "VerifyElements", { 256, 1, 1 }, VerifyElements_Group, Verify_Specialize, KERNEL_BINDINGS(s_verifyElementsBindings), NULL },
+    { "fused_*", COMPUTE_FUSED_ENTRY_POINT, { COMPUTE_FUSED_GROUP_SIZE, 1, 1 }, FusedMain_Group, Fused_Specialize, 0, NULL, Fused_Load }
+};
+
+// Strip the directory part of a path
+static const char* GetFileNamePart(const char *path)
+{
+    const char *name = path;
+    for (const char *p = path; *p != '\0'; p++)
+    {
+        if (*p == '/' || *p == '\\')
+            name = p + 1;
+    }
+    return name;
+}
+
+// Compare the file name to the name of a kernel desc, which may end with a '*'
+static bool MatchFileName(const char *pattern, const char *name)
+{
+    const size_t length = strlen(pattern);
+    if (length > 0 && pattern[length - 1] == '*')
+        return strncmp(pattern, name, length - 1) == 0;
+    return strcmp(pattern, name) == 0;
+}
+
+const CpuKernelDesc* FindCpuKernel(const char *pFileName, const char *pEntryPoint)
+{
+    const char *fileName = GetFileNamePart(pFileName);
+    for (size_t i = 0; i < sizeof(s_cpuKernels) / sizeof(s_cpuKernels[0]); i++)
+    {
+        if (MatchFileName(s_cpuKernels[i].pFileName, fileName) && strcmp(s_cpuKernels[i].pEntryPoint, pEntryPoint) == 0)
+            return &s_cpuKernels[i];
+    }
+    return NULL;
+}
+
+const char* GetCpuShaderDefine(const CpuShaderBytecode *bytecode, const char *name)
+{
+    // Like the preprocessor, the last definition wins.
+    const char *definition = NULL;
+    for (uint32_t i = 0; i < bytecode->numDefines && i < CPU_SHADER_MAX_DEFINES; i++)
+    {
+        if (strcmp(bytecode->defines[i].name, name) == 0)
+            definition = bytecode->defines[i].definition;
+    }
+    return definition;
+}
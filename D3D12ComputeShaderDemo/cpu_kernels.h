@@ -0,0 +1,112 @@
+#ifndef CPU_KERNELS_H
+#define CPU_KERNELS_H
+
+// Native ports of the HLSL compute kernels for the CPU backend.
+// Each kernel processes one whole thread group per call, so groupshared memory
+// and group barriers map to plain sequential code inside the group function.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+
+// The content of the "bytecode" blob produced by the CPU backend compiler
+#define CPU_SHADER_BYTECODE_MAGIC       0x4b555043U     // 'CPUK'
+#define CPU_SHADER_MAX_NAME_LENGTH      64
+#define CPU_SHADER_MAX_DEFINES          8
+#define CPU_SHADER_MAX_DEFINE_LENGTH    32
+// The size of the program of a kernel generated at run time
+#define CPU_SHADER_MAX_PROGRAM_SIZE     2048
+
+// The size of the parameters a kernel derives from the macros
+#define CPU_KERNEL_MAX_PARAMS_SIZE      64
+
+// A macro the kernel was "compiled" with
+typedef struct CpuShaderDefine
+{
+    char name[CPU_SHADER_MAX_DEFINE_LENGTH];
+    char definition[CPU_SHADER_MAX_DEFINE_LENGTH];
+} CpuShaderDefine;
+
+typedef struct CpuShaderBytecode
+{
+    uint32_t magic;
+    uint32_t numThreads[3];
+    char fileName[CPU_SHADER_MAX_NAME_LENGTH];
+    char entryPoint[CPU_SHADER_MAX_NAME_LENGTH];
+    uint32_t numDefines;
+    CpuShaderDefine defines[CPU_SHADER_MAX_DEFINES];
+    // The kernels generated at run time have their registers and their program loaded from the source,
+    // the native kernel being an interpreter of the program.
+    uint32_t numBindings;
+    ComputeShaderInputBinding bindings[COMPUTE_MAX_SHADER_BINDINGS];
+    uint64_t program[CPU_SHADER_MAX_PROGRAM_SIZE / sizeof(uint64_t)];
+} CpuShaderBytecode;
+
+// A buffer view bound to a t# or u# register
+typedef struct CpuKernelBuffer
+{
+    uint8_t *pData;
+    uint32_t numElements;
+    // The size of an element, also for the typed and raw views
+    uint32_t structureByteStride;
+    // UNKNOWN for a structured view, R32_TYPELESS for a raw one, or the format of a typed one
+    ComputeFormat format;
+} CpuKernelBuffer;
+
+// Root constants bound to a b# register
+typedef struct CpuKernelConstants
+{
+    const uint32_t *pData;
+    uint32_t numValues;
+} CpuKernelConstants;
+
+typedef struct CpuKernelContext
+{
+    CpuKernelBuffer srv[COMPUTE_MAX_SHADER_REGISTERS];
+    CpuKernelBuffer uav[COMPUTE_MAX_SHADER_REGISTERS];
+    CpuKernelConstants cbv[COMPUTE_MAX_SHADER_REGISTERS];
+    uint32_t numThreads[3];
+    uint32_t numGroups[3];
+    // The parameters filled by the kernel's specialization function
+    const void *params;
+} CpuKernelContext;
+
+// Execute all the threads of the thread group (groupX, groupY, groupZ)
+typedef void (*CpuKernelGroupFunc)(const CpuKernelContext *context, uint32_t groupX, uint32_t groupY, uint32_t groupZ);
+
+// Resolve the macros recorded in the bytecode, the way the HLSL preprocessor would,
+// into the [numthreads] of the variant and the parameters of the group function.
+// Returns false if a macro has an invalid value.
+typedef bool (*CpuKernelSpecializeFunc)(const CpuShaderBytecode *bytecode, uint32_t numThreads[3], void *params);
+
+// Read the program and the registers of a generated kernel from its source into the bytecode.
+// Returns false if the source is not one the kernel interprets.
+typedef bool (*CpuKernelLoadFunc)(const char *pSource, size_t sourceSize, CpuShaderBytecode *bytecode);
+
+typedef struct CpuKernelDesc
+{
+    // May end with a '*' matching the rest of the file name, for the generated sources
+    const char *pFileName;
+    const char *pEntryPoint;
+    // The [numthreads] attribute of the HLSL kernel without any macro
+    uint32_t numThreads[3];
+    CpuKernelGroupFunc groupFunc;
+    // NULL if the kernel has no macros
+    CpuKernelSpecializeFunc specializeFunc;
+    // The registers of the HLSL kernel, as reflected from its bytecode
+    uint32_t numBindings;
+    const ComputeShaderInputBinding *pBindings;
+    // NULL for the kernels written by hand, whose macros are all that varies.
+    // Otherwise the registers are the ones of the bytecode.
+    CpuKernelLoadFunc loadFunc;
+} CpuKernelDesc;
+
+// Look up the native kernel for the entry point of a HLSL file. Only the file name part of the path is compared.
+extern const CpuKernelDesc* FindCpuKernel(const char *pFileName, const char *pEntryPoint);
+
+// The definition of a macro recorded in the bytecode, or NULL if the macro is not defined
+extern const char* GetCpuShaderDefine(const CpuShaderBytecode *bytecode, const char *name);
+
+#endif // CPU_KERNELS_H
@@ -0,0 +1,1398 @@
+#include <windows.h>
+#include <d3d12.h>
+#include <d3dcompiler.h>
+#include <d3d12shader.h>
+#include <dxgi1_4.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_backend.h"
+
+// The D3D12 backend. Each object wraps the corresponding D3D12 interface and forwards the calls to it.
+
+// The number of barriers/command lists that are translated on the stack
+#define D3D12_BACKEND_LOCAL_ARRAY_SIZE      16
+
+// The function is used to amend ID3D12Resource::GetDesc bridged to COM API
+static inline void GetResourceDesc(ID3D12Resource *resource, D3D12_RESOURCE_DESC *pDesc)
+{
+    void (WINAPI *pFunc)(ID3D12Resource*, D3D12_RESOURCE_DESC*) = (void (WINAPI *)(ID3D12Resource*, D3D12_RESOURCE_DESC*))resource->lpVtbl->GetDesc;
+    pFunc(resource, pDesc);
+}
+
+// The function is used to amend ID3D12Heap::GetDesc bridged to COM API
+static inline void GetHeapDesc(ID3D12Heap *heap, D3D12_HEAP_DESC *pDesc)
+{
+    void (WINAPI *pFunc)(ID3D12Heap*, D3D12_HEAP_DESC*) = (void (WINAPI *)(ID3D12Heap*, D3D12_HEAP_DESC*))heap->lpVtbl->GetDesc;
+    pFunc(heap, pDesc);
+}
+
+// The function is used to amend ID3D12DescriptorHeap::GetCPUDescriptorHandleForHeapStart bridged to COM API
+static inline void GetCPUDescriptorHandleForHeapStart(ID3D12DescriptorHeap* heap, D3D12_CPU_DESCRIPTOR_HANDLE* pHandle)
+{
+    if (heap == NULL || pHandle == NULL)
+        return;
+
+    void (WINAPI* const pFunc)(ID3D12DescriptorHeap*, D3D12_CPU_DESCRIPTOR_HANDLE*) = (void (WINAPI*)(ID3D12DescriptorHeap*, D3D12_CPU_DESCRIPTOR_HANDLE*))heap->lpVtbl->GetCPUDescriptorHandleForHeapStart;
+    pFunc(heap, pHandle);
+}
+
+// The function is used to amend ID3D12DescriptorHeap::GetGPUDescriptorHandleForHeapStart bridged to COM API
+static inline void GetGPUDescriptorHandleForHeapStart(ID3D12DescriptorHeap* heap, D3D12_GPU_DESCRIPTOR_HANDLE* pHandle)
+{
+    if (heap == NULL || pHandle == NULL)
+        return;
+
+    void (WINAPI* const pFunc)(ID3D12DescriptorHeap*, D3D12_GPU_DESCRIPTOR_HANDLE*) = (void (WINAPI*)(ID3D12DescriptorHeap*, D3D12_GPU_DESCRIPTOR_HANDLE*))heap->lpVtbl->GetGPUDescriptorHandleForHeapStart;
+    pFunc(heap, pHandle);
+}
+
+//------------------------------------------------------------------------------------------------
+// D3D12 exports a new method for serializing root signatures in the Windows 10 Anniversary Update.
+// To help enable root signature 1.1 features when they are available and not require maintaining
+// two code paths for building root signatures, this helper method reconstructs a 1.0 signature when
+// 1.1 is not supported.
+static inline HRESULT D3DX12SerializeVersionedRootSignature(
+    _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
+    D3D_ROOT_SIGNATURE_VERSION MaxVersion,
+    _Outptr_ ID3DBlob** ppBlob,
+    _Always_(_Outptr_opt_result_maybenull_) ID3DBlob** ppErrorBlob)
+{
+    switch (MaxVersion)
+    {
+    case D3D_ROOT_SIGNATURE_VERSION_1_0:
+        switch (pRootSignatureDesc->Version)
+        {
+        case D3D_ROOT_SIGNATURE_VERSION_1_0:
+            return D3D12SerializeRootSignature(&pRootSignatureDesc->Desc_1_0, D3D_ROOT_SIGNATURE_VERSION_1, ppBlob, ppErrorBlob);
+
+        case D3D_ROOT_SIGNATURE_VERSION_1_1:
+        {
+            const D3D12_ROOT_SIGNATURE_DESC1* desc_1_1 = &pRootSignatureDesc->Desc_1_1;
+
+            SIZE_T ParametersSize = sizeof(D3D12_ROOT_PARAMETER) * desc_1_1->NumParameters;
+            void* pParameters = (ParametersSize > 0) ? HeapAlloc(GetProcessHeap(), 0, ParametersSize) : NULL;
+            D3D12_ROOT_PARAMETER* pParameters_1_0 = (D3D12_ROOT_PARAMETER*)pParameters;
+
+            for (UINT n = 0; n < desc_1_1->NumParameters; n++)
+            {
+                pParameters_1_0[n].ParameterType = desc_1_1->pParameters[n].ParameterType;
+                pParameters_1_0[n].ShaderVisibility = desc_1_1->pParameters[n].ShaderVisibility;
+
+                switch (desc_1_1->pParameters[n].ParameterType)
+                {
+                case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+                    pParameters_1_0[n].Constants.Num32BitValues = desc_1_1->pParameters[n].Constants.Num32BitValues;
+                    pParameters_1_0[n].Constants.RegisterSpace = desc_1_1->pParameters[n].Constants.RegisterSpace;
+                    pParameters_1_0[n].Constants.ShaderRegister = desc_1_1->pParameters[n].Constants.ShaderRegister;
+                    break;
+
+                case D3D12_ROOT_PARAMETER_TYPE_CBV:
+                case D3D12_ROOT_PARAMETER_TYPE_SRV:
+                case D3D12_ROOT_PARAMETER_TYPE_UAV:
+                    pParameters_1_0[n].Descriptor.RegisterSpace = desc_1_1->pParameters[n].Descriptor.RegisterSpace;
+                    pParameters_1_0[n].Descriptor.ShaderRegister = desc_1_1->pParameters[n].Descriptor.ShaderRegister;
+                    break;
+
+                case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+                {
+                    const D3D12_ROOT_DESCRIPTOR_TABLE1* table_1_1 = &desc_1_1->pParameters[n].DescriptorTable;
+
+                    SIZE_T DescriptorRangesSize = sizeof(D3D12_DESCRIPTOR_RANGE) * table_1_1->NumDescriptorRanges;
+                    void* pDescriptorRanges = (DescriptorRangesSize > 0) ? HeapAlloc(GetProcessHeap(), 0, DescriptorRangesSize) : NULL;
+                    D3D12_DESCRIPTOR_RANGE* pDescriptorRanges_1_0 = (D3D12_DESCRIPTOR_RANGE*)pDescriptorRanges;
+
+                    for (UINT x = 0; x < table_1_1->NumDescriptorRanges; x++)
+                    {
+                        pDescriptorRanges_1_0[x].BaseShaderRegister = table_1_1->pDescriptorRanges[x].BaseShaderRegister;
+                        pDescriptorRanges_1_0[x].NumDescriptors = table_1_1->pDescriptorRanges[x].NumDescriptors;
+                        pDescriptorRanges_1_0[x].OffsetInDescriptorsFromTableStart = table_1_1->pDescriptorRanges[x].OffsetInDescriptorsFromTableStart;
+                        pDescriptorRanges_1_0[x].RangeType = table_1_1->pDescriptorRanges[x].RangeType;
+                        pDescriptorRanges_1_0[x].RegisterSpace = table_1_1->pDescriptorRanges[x].RegisterSpace;
+                    }
+
+                    D3D12_ROOT_DESCRIPTOR_TABLE *table_1_0 = &pParameters_1_0[n].DescriptorTable;
+                    table_1_0->NumDescriptorRanges = table_1_1->NumDescriptorRanges;
+                    table_1_0->pDescriptorRanges = pDescriptorRanges_1_0;
+                }
+                }
+            }
+
+            D3D12_ROOT_SIGNATURE_DESC desc_1_0 = {
+                desc_1_1->NumParameters, pParameters_1_0, desc_1_1->NumStaticSamplers,
+                desc_1_1->pStaticSamplers, desc_1_1->Flags
+            };
+
+            HRESULT hr = D3D12SerializeRootSignature(&desc_1_0, D3D_ROOT_SIGNATURE_VERSION_1, ppBlob, ppErrorBlob);
+
+            for (UINT n = 0; n < desc_1_0.NumParameters; n++)
+            {
+                if (desc_1_0.pParameters[n].ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+                {
+                    HeapFree(GetProcessHeap(), 0, (LPVOID)pParameters_1_0[n].DescriptorTable.pDescriptorRanges);
+                }
+            }
+            HeapFree(GetProcessHeap(), 0, pParameters);
+            return hr;
+        }
+        }
+        break;
+
+    case D3D_ROOT_SIGNATURE_VERSION_1_1:
+        return D3D12SerializeVersionedRootSignature(pRootSignatureDesc, ppBlob, ppErrorBlob);
+    }
+
+    return E_INVALIDARG;
+}
+
+// ---- Wrapper objects ----
+
+typedef struct D3D12BackendBlob
+{
+    const ComputeBlobVtbl *lpVtbl;
+    ID3DBlob *blob;
+} D3D12BackendBlob;
+
+typedef struct D3D12BackendResource
+{
+    const ComputeResourceVtbl *lpVtbl;
+    ID3D12Resource *resource;
+} D3D12BackendResource;
+
+typedef struct D3D12BackendHeap
+{
+    const ComputeHeapVtbl *lpVtbl;
+    ID3D12Heap *heap;
+} D3D12BackendHeap;
+
+typedef struct D3D12BackendDescriptorHeap
+{
+    const ComputeDescriptorHeapVtbl *lpVtbl;
+    ID3D12DescriptorHeap *heap;
+} D3D12BackendDescriptorHeap;
+
+typedef struct D3D12BackendQueryHeap
+{
+    const ComputeQueryHeapVtbl *lpVtbl;
+    ID3D12QueryHeap *heap;
+} D3D12BackendQueryHeap;
+
+typedef struct D3D12BackendRootSignature
+{
+    const ComputeRootSignatureVtbl *lpVtbl;
+    ID3D12RootSignature *rootSignature;
+    // FNV-1a hash of the serialized root signature
+    uint64_t hash;
+} D3D12BackendRootSignature;
+
+typedef struct D3D12BackendPipelineState
+{
+    const ComputePipelineStateVtbl *lpVtbl;
+    ID3D12PipelineState *pipelineState;
+} D3D12BackendPipelineState;
+
+typedef struct D3D12BackendCommandAllocator
+{
+    const ComputeCommandAllocatorVtbl *lpVtbl;
+    ID3D12CommandAllocator *allocator;
+} D3D12BackendCommandAllocator;
+
+typedef struct D3D12BackendCommandList
+{
+    const ComputeCommandListVtbl *lpVtbl;
+    ID3D12GraphicsCommandList *commandList;
+} D3D12BackendCommandList;
+
+typedef struct D3D12BackendCommandQueue
+{
+    const ComputeCommandQueueVtbl *lpVtbl;
+    ID3D12CommandQueue *commandQueue;
+} D3D12BackendCommandQueue;
+
+typedef struct D3D12BackendFence
+{
+    const ComputeFenceVtbl *lpVtbl;
+    ID3D12Fence *fence;
+} D3D12BackendFence;
+
+typedef struct D3D12BackendDevice
+{
+    const ComputeDeviceVtbl *lpVtbl;
+    ID3D12Device *device;
+} D3D12BackendDevice;
+
+static inline ID3D12Resource* NativeResource(ComputeResource *resource)
+{
+    return resource != NULL ? ((D3D12BackendResource*)resource)->resource : NULL;
+}
+
+static inline ID3D12PipelineState* NativePipelineState(ComputePipelineState *pipelineState)
+{
+    return pipelineState != NULL ? ((D3D12BackendPipelineState*)pipelineState)->pipelineState : NULL;
+}
+
+// ---- Blob ----
+
+static void D3D12Blob_Release(ComputeBlob *This)
+{
+    D3D12BackendBlob *blob = (D3D12BackendBlob*)This;
+    blob->blob->lpVtbl->Release(blob->blob);
+    free(blob);
+}
+
+static void* D3D12Blob_GetBufferPointer(ComputeBlob *This)
+{
+    ID3DBlob *blob = ((D3D12BackendBlob*)This)->blob;
+    return blob->lpVtbl->GetBufferPointer(blob);
+}
+
+static size_t D3D12Blob_GetBufferSize(ComputeBlob *This)
+{
+    ID3DBlob *blob = ((D3D12BackendBlob*)This)->blob;
+    return blob->lpVtbl->GetBufferSize(blob);
+}
+
+static const ComputeBlobVtbl s_d3d12BlobVtbl = {
+    D3D12Blob_Release, D3D12Blob_GetBufferPointer, D3D12Blob_GetBufferSize
+};
+
+// ---- Resource ----
+
+static void D3D12Resource_Release(ComputeResource *This)
+{
+    D3D12BackendResource *resource = (D3D12BackendResource*)This;
+    resource->resource->lpVtbl->Release(resource->resource);
+    free(resource);
+}
+
+static void D3D12Resource_GetDesc(ComputeResource *This, ComputeResourceDesc *pDesc)
+{
+    D3D12_RESOURCE_DESC desc;
+    GetResourceDesc(((D3D12BackendResource*)This)->resource, &desc);
+    pDesc->Width = desc.Width;
+    pDesc->Flags = (ComputeResourceFlags)(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+}
+
+static bool D3D12Resource_Map(ComputeResource *This, const ComputeRange *pReadRange, void **ppData)
+{
+    ID3D12Resource *resource = ((D3D12BackendResource*)This)->resource;
+    return SUCCEEDED(resource->lpVtbl->Map(resource, 0, (const D3D12_RANGE*)pReadRange, ppData));
+}
+
+static void D3D12Resource_Unmap(ComputeResource *This, const ComputeRange *pWrittenRange)
+{
+    ID3D12Resource *resource = ((D3D12BackendResource*)This)->resource;
+    resource->lpVtbl->Unmap(resource, 0, (const D3D12_RANGE*)pWrittenRange);
+}
+
+static ComputeGPUVirtualAddress D3D12Resource_GetGPUVirtualAddress(ComputeResource *This)
+{
+    ID3D12Resource *resource = ((D3D12BackendResource*)This)->resource;
+    return resource->lpVtbl->GetGPUVirtualAddress(resource);
+}
+
+static const ComputeResourceVtbl s_d3d12ResourceVtbl = {
+    D3D12Resource_Release, D3D12Resource_GetDesc, D3D12Resource_Map, D3D12Resource_Unmap, D3D12Resource_GetGPUVirtualAddress
+};
+
+// ---- Heap ----
+
+static void D3D12Heap_Release(ComputeHeap *This)
+{
+    D3D12BackendHeap *heap = (D3D12BackendHeap*)This;
+    heap->heap->lpVtbl->Release(heap->heap);
+    free(heap);
+}
+
+static void D3D12Heap_GetDesc(ComputeHeap *This, ComputeHeapDesc *pDesc)
+{
+    D3D12_HEAP_DESC desc;
+    GetHeapDesc(((D3D12BackendHeap*)This)->heap, &desc);
+    pDesc->SizeInBytes = desc.SizeInBytes;
+    pDesc->Type = (ComputeHeapType)desc.Properties.Type;
+}
+
+static const ComputeHeapVtbl s_d3d12HeapVtbl = { D3D12Heap_Release, D3D12Heap_GetDesc };
+
+// ---- Descriptor heap ----
+
+static void D3D12DescriptorHeap_Release(ComputeDescriptorHeap *This)
+{
+    D3D12BackendDescriptorHeap *heap = (D3D12BackendDescriptorHeap*)This;
+    heap->heap->lpVtbl->Release(heap->heap);
+    free(heap);
+}
+
+static ComputeCPUDescriptorHandle D3D12DescriptorHeap_GetCPUDescriptorHandleForHeapStart(ComputeDescriptorHeap *This)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE nativeHandle = { 0 };
+    GetCPUDescriptorHandleForHeapStart(((D3D12BackendDescriptorHeap*)This)->heap, &nativeHandle);
+
+    const ComputeCPUDescriptorHandle handle = { nativeHandle.ptr };
+    return handle;
+}
+
+static ComputeGPUDescriptorHandle D3D12DescriptorHeap_GetGPUDescriptorHandleForHeapStart(ComputeDescriptorHeap *This)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE nativeHandle = { 0 };
+    GetGPUDescriptorHandleForHeapStart(((D3D12BackendDescriptorHeap*)This)->heap, &nativeHandle);
+
+    const ComputeGPUDescriptorHandle handle = { nativeHandle.ptr };
+    return handle;
+}
+
+static const ComputeDescriptorHeapVtbl s_d3d12DescriptorHeapVtbl = {
+    D3D12DescriptorHeap_Release, D3D12DescriptorHeap_GetCPUDescriptorHandleForHeapStart,
+    D3D12DescriptorHeap_GetGPUDescriptorHandleForHeapStart
+};
+
+// ---- Root signature and pipeline state ----
+
+static void D3D12RootSignature_Release(ComputeRootSignature *This)
+{
+    D3D12BackendRootSignature *rootSignature = (D3D12BackendRootSignature*)This;
+    rootSignature->rootSignature->lpVtbl->Release(rootSignature->rootSignature);
+    free(rootSignature);
+}
+
+static uint64_t D3D12RootSignature_GetHash(ComputeRootSignature *This)
+{
+    return ((D3D12BackendRootSignature*)This)->hash;
+}
+
+static const ComputeRootSignatureVtbl s_d3d12RootSignatureVtbl = { D3D12RootSignature_Release, D3D12RootSignature_GetHash };
+
+static void D3D12PipelineState_Release(ComputePipelineState *This)
+{
+    D3D12BackendPipelineState *pipelineState = (D3D12BackendPipelineState*)This;
+    pipelineState->pipelineState->lpVtbl->Release(pipelineState->pipelineState);
+    free(pipelineState);
+}
+
+static bool D3D12PipelineState_GetCachedBlob(ComputePipelineState *This, ComputeBlob **ppBlob)
+{
+    ID3D12PipelineState *pipelineState = ((D3D12BackendPipelineState*)This)->pipelineState;
+
+    ID3DBlob *cachedBlob = NULL;
+    if (FAILED(pipelineState->lpVtbl->GetCachedBlob(pipelineState, &cachedBlob)))
+        return false;
+
+    D3D12BackendBlob *blob = calloc(1, sizeof(*blob));
+    if (blob == NULL)
+    {
+        cachedBlob->lpVtbl->Release(cachedBlob);
+        return false;
+    }
+    blob->lpVtbl = &s_d3d12BlobVtbl;
+    blob->blob = cachedBlob;
+
+    *ppBlob = (ComputeBlob*)blob;
+    return true;
+}
+
+static const ComputePipelineStateVtbl s_d3d12PipelineStateVtbl = { D3D12PipelineState_Release, D3D12PipelineState_GetCachedBlob };
+
+// ---- Command allocator and command list ----
+
+static void D3D12CommandAllocator_Release(ComputeCommandAllocator *This)
+{
+    D3D12BackendCommandAllocator *allocator = (D3D12BackendCommandAllocator*)This;
+    allocator->allocator->lpVtbl->Release(allocator->allocator);
+    free(allocator);
+}
+
+static bool D3D12CommandAllocator_Reset(ComputeCommandAllocator *This)
+{
+    ID3D12CommandAllocator *allocator = ((D3D12BackendCommandAllocator*)This)->allocator;
+    return SUCCEEDED(allocator->lpVtbl->Reset(allocator));
+}
+
+static const ComputeCommandAllocatorVtbl s_d3d12CommandAllocatorVtbl = {
+    D3D12CommandAllocator_Release, D3D12CommandAllocator_Reset
+};
+
+static void D3D12CommandList_Release(ComputeCommandList *This)
+{
+    D3D12BackendCommandList *list = (D3D12BackendCommandList*)This;
+    list->commandList->lpVtbl->Release(list->commandList);
+    free(list);
+}
+
+static bool D3D12CommandList_Close(ComputeCommandList *This)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    return SUCCEEDED(list->lpVtbl->Close(list));
+}
+
+static bool D3D12CommandList_Reset(ComputeCommandList *This, ComputeCommandAllocator *pAllocator, ComputePipelineState *pInitialState)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    return SUCCEEDED(list->lpVtbl->Reset(list, ((D3D12BackendCommandAllocator*)pAllocator)->allocator, NativePipelineState(pInitialState)));
+}
+
+static void D3D12CommandList_SetPipelineState(ComputeCommandList *This, ComputePipelineState *pPipelineState)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->SetPipelineState(list, NativePipelineState(pPipelineState));
+}
+
+static void D3D12CommandList_SetComputeRootSignature(ComputeCommandList *This, ComputeRootSignature *pRootSignature)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->SetComputeRootSignature(list, ((D3D12BackendRootSignature*)pRootSignature)->rootSignature);
+}
+
+static void D3D12CommandList_SetDescriptorHeaps(ComputeCommandList *This, uint32_t NumDescriptorHeaps, ComputeDescriptorHeap *const *ppDescriptorHeaps)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+
+    // At most one CBV/SRV/UAV heap and one sampler heap can be set.
+    ID3D12DescriptorHeap *ppHeaps[2];
+    if (NumDescriptorHeaps > _countof(ppHeaps))
+        NumDescriptorHeaps = _countof(ppHeaps);
+    for (uint32_t i = 0; i < NumDescriptorHeaps; i++)
+        ppHeaps[i] = ((D3D12BackendDescriptorHeap*)ppDescriptorHeaps[i])->heap;
+
+    list->lpVtbl->SetDescriptorHeaps(list, NumDescriptorHeaps, ppHeaps);
+}
+
+static void D3D12CommandList_SetComputeRootDescriptorTable(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUDescriptorHandle BaseDescriptor)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    const D3D12_GPU_DESCRIPTOR_HANDLE handle = { BaseDescriptor.ptr };
+    list->lpVtbl->SetComputeRootDescriptorTable(list, RootParameterIndex, handle);
+}
+
+static void D3D12CommandList_SetComputeRoot32BitConstants(ComputeCommandList *This, uint32_t RootParameterIndex, uint32_t Num32BitValuesToSet,
+    const void *pSrcData, uint32_t DestOffsetIn32BitValues)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->SetComputeRoot32BitConstants(list, RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
+}
+
+static void D3D12CommandList_SetComputeRootShaderResourceView(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->SetComputeRootShaderResourceView(list, RootParameterIndex, BufferLocation);
+}
+
+static void D3D12CommandList_SetComputeRootUnorderedAccessView(ComputeCommandList *This, uint32_t RootParameterIndex, ComputeGPUVirtualAddress BufferLocation)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->SetComputeRootUnorderedAccessView(list, RootParameterIndex, BufferLocation);
+}
+
+static void D3D12CommandList_Dispatch(ComputeCommandList *This, uint32_t ThreadGroupCountX, uint32_t ThreadGroupCountY, uint32_t ThreadGroupCountZ)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->Dispatch(list, ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+}
+
+static void D3D12CommandList_ResourceBarrier(ComputeCommandList *This, uint32_t NumBarriers, const ComputeResourceBarrier *pBarriers)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    if (NumBarriers == 0)
+        return;
+
+    D3D12_RESOURCE_BARRIER localBarriers[D3D12_BACKEND_LOCAL_ARRAY_SIZE];
+    D3D12_RESOURCE_BARRIER *barriers = localBarriers;
+    if (NumBarriers > _countof(localBarriers))
+    {
+        barriers = HeapAlloc(GetProcessHeap(), 0, NumBarriers * sizeof(*barriers));
+        if (barriers == NULL)
+            return;
+    }
+
+    for (uint32_t i = 0; i < NumBarriers; i++)
+    {
+        const ComputeResourceBarrier *src = &pBarriers[i];
+        D3D12_RESOURCE_BARRIER *dst = &barriers[i];
+        dst->Type = (D3D12_RESOURCE_BARRIER_TYPE)src->Type;
+        dst->Flags = (D3D12_RESOURCE_BARRIER_FLAGS)src->Flags;
+
+        if (src->Type == COMPUTE_RESOURCE_BARRIER_TYPE_UAV)
+            dst->UAV.pResource = NativeResource(src->pResource);
+        else if (src->Type == COMPUTE_RESOURCE_BARRIER_TYPE_ALIASING)
+        {
+            dst->Aliasing.pResourceBefore = NativeResource(src->pResourceBefore);
+            dst->Aliasing.pResourceAfter = NativeResource(src->pResource);
+        }
+        else
+        {
+            dst->Transition.pResource = NativeResource(src->pResource);
+            dst->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            dst->Transition.StateBefore = (D3D12_RESOURCE_STATES)src->StateBefore;
+            dst->Transition.StateAfter = (D3D12_RESOURCE_STATES)src->StateAfter;
+        }
+    }
+
+    list->lpVtbl->ResourceBarrier(list, NumBarriers, barriers);
+
+    if (barriers != localBarriers)
+        HeapFree(GetProcessHeap(), 0, barriers);
+}
+
+static void D3D12CommandList_CopyBufferRegion(ComputeCommandList *This, ComputeResource *pDstBuffer, uint64_t DstOffset,
+    ComputeResource *pSrcBuffer, uint64_t SrcOffset, uint64_t NumBytes)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->CopyBufferRegion(list, NativeResource(pDstBuffer), DstOffset, NativeResource(pSrcBuffer), SrcOffset, NumBytes);
+}
+
+static void D3D12CommandList_CopyResource(ComputeCommandList *This, ComputeResource *pDstResource, ComputeResource *pSrcResource)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->CopyResource(list, NativeResource(pDstResource), NativeResource(pSrcResource));
+}
+
+static void D3D12CommandList_EndQuery(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t Index)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->EndQuery(list, ((D3D12BackendQueryHeap*)pQueryHeap)->heap, (D3D12_QUERY_TYPE)Type, Index);
+}
+
+static void D3D12CommandList_ResolveQueryData(ComputeCommandList *This, ComputeQueryHeap *pQueryHeap, ComputeQueryType Type, uint32_t StartIndex,
+    uint32_t NumQueries, ComputeResource *pDestinationBuffer, uint64_t AlignedDestinationBufferOffset)
+{
+    ID3D12GraphicsCommandList *list = ((D3D12BackendCommandList*)This)->commandList;
+    list->lpVtbl->ResolveQueryData(list, ((D3D12BackendQueryHeap*)pQueryHeap)->heap, (D3D12_QUERY_TYPE)Type, StartIndex, NumQueries,
+        NativeResource(pDestinationBuffer), AlignedDestinationBufferOffset);
+}
+
+static const ComputeCommandListVtbl s_d3d12CommandListVtbl = {
+    D3D12CommandList_Release, D3D12CommandList_Close, D3D12CommandList_Reset, D3D12CommandList_SetPipelineState,
+    D3D12CommandList_SetComputeRootSignature, D3D12CommandList_SetDescriptorHeaps, D3D12CommandList_SetComputeRootDescriptorTable,
+    D3D12CommandList_SetComputeRoot32BitConstants, D3D12CommandList_SetComputeRootShaderResourceView,
+    D3D12CommandList_SetComputeRootUnorderedAccessView, D3D12CommandList_Dispatch, D3D12CommandList_ResourceBarrier, D3D12CommandList_CopyBufferRegion, D3D12CommandList_CopyResource,
+    D3D12CommandList_EndQuery, D3D12CommandList_ResolveQueryData
+};
+
+// ---- Command queue and fence ----
+
+static void D3D12CommandQueue_Release(ComputeCommandQueue *This)
+{
+    D3D12BackendCommandQueue *queue = (D3D12BackendCommandQueue*)This;
+    queue->commandQueue->lpVtbl->Release(queue->commandQueue);
+    free(queue);
+}
+
+static void D3D12CommandQueue_ExecuteCommandLists(ComputeCommandQueue *This, uint32_t NumCommandLists, ComputeCommandList *const *ppCommandLists)
+{
+    ID3D12CommandQueue *queue = ((D3D12BackendCommandQueue*)This)->commandQueue;
+    if (NumCommandLists == 0)
+        return;
+
+    ID3D12CommandList *localLists[D3D12_BACKEND_LOCAL_ARRAY_SIZE];
+    ID3D12CommandList **lists = localLists;
+    if (NumCommandLists > _countof(localLists))
+    {
+        lists = HeapAlloc(GetProcessHeap(), 0, NumCommandLists * sizeof(*lists));
+        if (lists == NULL)
+            return;
+    }
+
+    for (uint32_t i = 0; i < NumCommandLists; i++)
+        lists[i] = (ID3D12CommandList*)((D3D12BackendCommandList*)ppCommandLists[i])->commandList;
+
+    queue->lpVtbl->ExecuteCommandLists(queue, NumCommandLists, lists);
+
+    if (lists != localLists)
+        HeapFree(GetProcessHeap(), 0, lists);
+}
+
+static bool D3D12CommandQueue_Signal(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value)
+{
+    ID3D12CommandQueue *queue = ((D3D12BackendCommandQueue*)This)->commandQueue;
+    return SUCCEEDED(queue->lpVtbl->Signal(queue, ((D3D12BackendFence*)pFence)->fence, Value));
+}
+
+static bool D3D12CommandQueue_Wait(ComputeCommandQueue *This, ComputeFence *pFence, uint64_t Value)
+{
+    ID3D12CommandQueue *queue = ((D3D12BackendCommandQueue*)This)->commandQueue;
+    return SUCCEEDED(queue->lpVtbl->Wait(queue, ((D3D12BackendFence*)pFence)->fence, Value));
+}
+
+static bool D3D12CommandQueue_GetTimestampFrequency(ComputeCommandQueue *This, uint64_t *pFrequency)
+{
+    ID3D12CommandQueue *queue = ((D3D12BackendCommandQueue*)This)->commandQueue;
+    return SUCCEEDED(queue->lpVtbl->GetTimestampFrequency(queue, pFrequency));
+}
+
+static bool D3D12CommandQueue_GetClockCalibration(ComputeCommandQueue *This, uint64_t *pGpuTimestamp, uint64_t *pCpuTimestamp)
+{
+    ID3D12CommandQueue *queue = ((D3D12BackendCommandQueue*)This)->commandQueue;
+
+    // The CPU timestamp is a QueryPerformanceCounter value, converted like ComputeGetTimeNanoseconds does.
+    uint64_t counter;
+    if (FAILED(queue->lpVtbl->GetClockCalibration(queue, pGpuTimestamp, &counter)))
+        return false;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    *pCpuTimestamp = counter / (uint64_t)frequency.QuadPart * 1000000000ULL +
+        counter % (uint64_t)frequency.QuadPart * 1000000000ULL / (uint64_t)frequency.QuadPart;
+    return true;
+}
+
+static const ComputeCommandQueueVtbl s_d3d12CommandQueueVtbl = {
+    D3D12CommandQueue_Release, D3D12CommandQueue_ExecuteCommandLists, D3D12CommandQueue_Signal, D3D12CommandQueue_Wait,
+    D3D12CommandQueue_GetTimestampFrequency, D3D12CommandQueue_GetClockCalibration
+};
+
+static void D3D12Fence_Release(ComputeFence *This)
+{
+    D3D12BackendFence *fence = (D3D12BackendFence*)This;
+    fence->fence->lpVtbl->Release(fence->fence);
+    free(fence);
+}
+
+static uint64_t D3D12Fence_GetCompletedValue(ComputeFence *This)
+{
+    ID3D12Fence *fence = ((D3D12BackendFence*)This)->fence;
+    return fence->lpVtbl->GetCompletedValue(fence);
+}
+
+static bool D3D12Fence_SetEventOnCompletion(ComputeFence *This, uint64_t Value, ComputeEvent hEvent)
+{
+    ID3D12Fence *fence = ((D3D12BackendFence*)This)->fence;
+    return SUCCEEDED(fence->lpVtbl->SetEventOnCompletion(fence, Value, (HANDLE)hEvent));
+}
+
+static bool D3D12Fence_Signal(ComputeFence *This, uint64_t Value)
+{
+    ID3D12Fence *fence = ((D3D12BackendFence*)This)->fence;
+    return SUCCEEDED(fence->lpVtbl->Signal(fence, Value));
+}
+
+static const ComputeFenceVtbl s_d3d12FenceVtbl = {
+    D3D12Fence_Release, D3D12Fence_GetCompletedValue, D3D12Fence_SetEventOnCompletion, D3D12Fence_Signal
+};
+
+// ---- Device ----
+
+static void D3D12Device_Release(ComputeDevice *This)
+{
+    D3D12BackendDevice *device = (D3D12BackendDevice*)This;
+    device->device->lpVtbl->Release(device->device);
+    free(device);
+}
+
+static ComputeBackendType D3D12Device_GetBackendType(ComputeDevice *This)
+{
+    (void)This;
+    return COMPUTE_BACKEND_D3D12;
+}
+
+static bool D3D12Device_CompileShaderFromFile(ComputeDevice *This, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode)
+{
+    (void)This;
+
+    WCHAR fileName[MAX_PATH];
+    if (MultiByteToWideChar(CP_UTF8, 0, pFileName, -1, fileName, MAX_PATH) == 0)
+        return false;
+
+    UINT compileFlags = 0;
+    if ((Flags & COMPUTE_COMPILE_DEBUG) != 0)
+        compileFlags |= D3DCOMPILE_DEBUG;
+    if ((Flags & COMPUTE_COMPILE_SKIP_OPTIMIZATION) != 0)
+        compileFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+    if ((Flags & COMPUTE_COMPILE_OPTIMIZATION_LEVEL3) != 0)
+        compileFlags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
+
+    ID3DBlob *code = NULL;
+    ID3DBlob *errors = NULL;
+    HRESULT hr = D3DCompileFromFile(fileName, (const D3D_SHADER_MACRO*)pDefines, NULL, pEntryPoint, pTarget, compileFlags, 0, &code, &errors);
+    if (errors != NULL)
+    {
+        printf("%s\n", (const char*)errors->lpVtbl->GetBufferPointer(errors));
+        errors->lpVtbl->Release(errors);
+    }
+    if (FAILED(hr))
+        return false;
+
+    D3D12BackendBlob *blob = calloc(1, sizeof(*blob));
+    if (blob == NULL)
+    {
+        code->lpVtbl->Release(code);
+        return false;
+    }
+    blob->lpVtbl = &s_d3d12BlobVtbl;
+    blob->blob = code;
+
+    *ppCode = (ComputeBlob*)blob;
+    return true;
+}
+
+static bool D3D12Device_ReflectShader(ComputeDevice *This, const ComputeShaderBytecode *pBytecode, ComputeShaderReflection *pReflection)
+{
+    (void)This;
+
+    ID3D12ShaderReflection *reflection = NULL;
+    if (FAILED(D3DReflect(pBytecode->pShaderBytecode, pBytecode->BytecodeLength, &IID_ID3D12ShaderReflection, (void**)&reflection)))
+    {
+        puts("Failed to reflect the shader!");
+        return false;
+    }
+
+    UINT x, y, z;
+    reflection->lpVtbl->GetThreadGroupSize(reflection, &x, &y, &z);
+    pReflection->ThreadGroupSize[0] = x;
+    pReflection->ThreadGroupSize[1] = y;
+    pReflection->ThreadGroupSize[2] = z;
+
+    D3D12_SHADER_DESC shaderDesc;
+    reflection->lpVtbl->GetDesc(reflection, &shaderDesc);
+
+    bool succeeded = true;
+    pReflection->NumBoundResources = 0;
+    for (UINT i = 0; i < shaderDesc.BoundResources && succeeded; i++)
+    {
+        D3D12_SHADER_INPUT_BIND_DESC bindDesc;
+        reflection->lpVtbl->GetResourceBindingDesc(reflection, i, &bindDesc);
+
+        ComputeShaderInputBinding binding = { COMPUTE_SHADER_INPUT_UNSUPPORTED, bindDesc.BindPoint, bindDesc.Space, 0 };
+        switch (bindDesc.Type)
+        {
+        case D3D_SIT_CBUFFER:
+        {
+            // The size up to the end of the last variable, without the padding to 16 bytes of the cbuffer
+            binding.Type = COMPUTE_SHADER_INPUT_CBUFFER;
+            ID3D12ShaderReflectionConstantBuffer *cbuffer = reflection->lpVtbl->GetConstantBufferByName(reflection, bindDesc.Name);
+            D3D12_SHADER_BUFFER_DESC bufferDesc;
+            cbuffer->lpVtbl->GetDesc(cbuffer, &bufferDesc);
+            for (UINT v = 0; v < bufferDesc.Variables; v++)
+            {
+                ID3D12ShaderReflectionVariable *variable = cbuffer->lpVtbl->GetVariableByIndex(cbuffer, v);
+                D3D12_SHADER_VARIABLE_DESC variableDesc;
+                variable->lpVtbl->GetDesc(variable, &variableDesc);
+                if (variableDesc.StartOffset + variableDesc.Size > binding.Size)
+                    binding.Size = variableDesc.StartOffset + variableDesc.Size;
+            }
+            break;
+        }
+        case D3D_SIT_TEXTURE:
+            if (bindDesc.Dimension == D3D_SRV_DIMENSION_BUFFER)
+                binding.Type = COMPUTE_SHADER_INPUT_TYPED_SRV;
+            break;
+        case D3D_SIT_STRUCTURED:
+            binding.Type = COMPUTE_SHADER_INPUT_STRUCTURED_SRV;
+            break;
+        case D3D_SIT_BYTEADDRESS:
+            binding.Type = COMPUTE_SHADER_INPUT_RAW_SRV;
+            break;
+        case D3D_SIT_UAV_RWTYPED:
+            if (bindDesc.Dimension == D3D_SRV_DIMENSION_BUFFER)
+                binding.Type = COMPUTE_SHADER_INPUT_TYPED_UAV;
+            break;
+        case D3D_SIT_UAV_RWSTRUCTURED:
+            binding.Type = COMPUTE_SHADER_INPUT_STRUCTURED_UAV;
+            break;
+        case D3D_SIT_UAV_RWBYTEADDRESS:
+            binding.Type = COMPUTE_SHADER_INPUT_RAW_UAV;
+            break;
+        default:
+            break;
+        }
+
+        // An array takes the registers that follow its bind point.
+        for (UINT r = 0; r < bindDesc.BindCount; r++, binding.BindPoint++)
+        {
+            if (pReflection->NumBoundResources == COMPUTE_MAX_SHADER_BINDINGS)
+            {
+                puts("The shader binds too many resources!");
+                succeeded = false;
+                break;
+            }
+            pReflection->BoundResources[pReflection->NumBoundResources++] = binding;
+        }
+    }
+
+    reflection->lpVtbl->Release(reflection);
+    return succeeded;
+}
+
+static ComputeResource* D3D12Device_CreateCommittedResource(ComputeDevice *This, ComputeHeapType HeapType, const ComputeResourceDesc *pDesc,
+    ComputeResourceStates InitialResourceState)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_HEAP_PROPERTIES heapProperties = { (D3D12_HEAP_TYPE)HeapType, D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+        D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
+    D3D12_RESOURCE_DESC resourceDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, pDesc->Width, 1, 1, 1,
+        DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, (D3D12_RESOURCE_FLAGS)pDesc->Flags };
+
+    ID3D12Resource *nativeResource = NULL;
+    HRESULT hr = device->lpVtbl->CreateCommittedResource(device, &heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+        (D3D12_RESOURCE_STATES)InitialResourceState, NULL, &IID_ID3D12Resource, (void**)&nativeResource);
+    if (FAILED(hr))
+        return NULL;
+
+    D3D12BackendResource *resource = calloc(1, sizeof(*resource));
+    if (resource == NULL)
+    {
+        nativeResource->lpVtbl->Release(nativeResource);
+        return NULL;
+    }
+    resource->lpVtbl = &s_d3d12ResourceVtbl;
+    resource->resource = nativeResource;
+
+    return (ComputeResource*)resource;
+}
+
+static ComputeHeap* D3D12Device_CreateHeap(ComputeDevice *This, const ComputeHeapDesc *pDesc)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_HEAP_DESC heapDesc = { 0 };
+    heapDesc.SizeInBytes = pDesc->SizeInBytes;
+    heapDesc.Properties.Type = (D3D12_HEAP_TYPE)pDesc->Type;
+    heapDesc.Properties.CreationNodeMask = 1;
+    heapDesc.Properties.VisibleNodeMask = 1;
+    heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+    ID3D12Heap *nativeHeap = NULL;
+    if (FAILED(device->lpVtbl->CreateHeap(device, &heapDesc, &IID_ID3D12Heap, (void**)&nativeHeap)))
+        return NULL;
+
+    D3D12BackendHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+    {
+        nativeHeap->lpVtbl->Release(nativeHeap);
+        return NULL;
+    }
+    heap->lpVtbl = &s_d3d12HeapVtbl;
+    heap->heap = nativeHeap;
+
+    return (ComputeHeap*)heap;
+}
+
+static ComputeResource* D3D12Device_CreatePlacedResource(ComputeDevice *This, ComputeHeap *pHeap, uint64_t HeapOffset,
+    const ComputeResourceDesc *pDesc, ComputeResourceStates InitialState)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_RESOURCE_DESC resourceDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, pDesc->Width, 1, 1, 1,
+        DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, (D3D12_RESOURCE_FLAGS)pDesc->Flags };
+
+    ID3D12Resource *nativeResource = NULL;
+    HRESULT hr = device->lpVtbl->CreatePlacedResource(device, ((D3D12BackendHeap*)pHeap)->heap, HeapOffset, &resourceDesc,
+        (D3D12_RESOURCE_STATES)InitialState, NULL, &IID_ID3D12Resource, (void**)&nativeResource);
+    if (FAILED(hr))
+        return NULL;
+
+    D3D12BackendResource *resource = calloc(1, sizeof(*resource));
+    if (resource == NULL)
+    {
+        nativeResource->lpVtbl->Release(nativeResource);
+        return NULL;
+    }
+    resource->lpVtbl = &s_d3d12ResourceVtbl;
+    resource->resource = nativeResource;
+
+    return (ComputeResource*)resource;
+}
+
+static ComputeDescriptorHeap* D3D12Device_CreateDescriptorHeap(ComputeDevice *This, const ComputeDescriptorHeapDesc *pDesc)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = { 0 };
+    heapDesc.NumDescriptors = pDesc->NumDescriptors;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    heapDesc.Flags = pDesc->ShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+    ID3D12DescriptorHeap *nativeHeap = NULL;
+    if (FAILED(device->lpVtbl->CreateDescriptorHeap(device, &heapDesc, &IID_ID3D12DescriptorHeap, (void**)&nativeHeap)))
+        return NULL;
+
+    D3D12BackendDescriptorHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+    {
+        nativeHeap->lpVtbl->Release(nativeHeap);
+        return NULL;
+    }
+    heap->lpVtbl = &s_d3d12DescriptorHeapVtbl;
+    heap->heap = nativeHeap;
+
+    return (ComputeDescriptorHeap*)heap;
+}
+
+static uint32_t D3D12Device_GetDescriptorHandleIncrementSize(ComputeDevice *This)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+    return device->lpVtbl->GetDescriptorHandleIncrementSize(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+static void D3D12Device_CreateShaderResourceView(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+    ComputeCPUDescriptorHandle DestDescriptor)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = { 0 };
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = (DXGI_FORMAT)pDesc->Format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = pDesc->FirstElement;
+    srvDesc.Buffer.NumElements = pDesc->NumElements;
+    srvDesc.Buffer.StructureByteStride = pDesc->StructureByteStride;
+    srvDesc.Buffer.Flags = (D3D12_BUFFER_SRV_FLAGS)pDesc->Flags;
+
+    const D3D12_CPU_DESCRIPTOR_HANDLE handle = { DestDescriptor.ptr };
+    device->lpVtbl->CreateShaderResourceView(device, NativeResource(pResource), &srvDesc, handle);
+}
+
+static void D3D12Device_CreateUnorderedAccessView(ComputeDevice *This, ComputeResource *pResource, const ComputeBufferViewDesc *pDesc,
+    ComputeCPUDescriptorHandle DestDescriptor)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = { 0 };
+    uavDesc.Format = (DXGI_FORMAT)pDesc->Format;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.FirstElement = pDesc->FirstElement;
+    uavDesc.Buffer.NumElements = pDesc->NumElements;
+    uavDesc.Buffer.StructureByteStride = pDesc->StructureByteStride;
+    uavDesc.Buffer.CounterOffsetInBytes = 0;
+    uavDesc.Buffer.Flags = (D3D12_BUFFER_UAV_FLAGS)pDesc->Flags;
+
+    const D3D12_CPU_DESCRIPTOR_HANDLE handle = { DestDescriptor.ptr };
+    device->lpVtbl->CreateUnorderedAccessView(device, NativeResource(pResource), NULL, &uavDesc, handle);
+}
+
+static void D3D12Device_CopyDescriptors(ComputeDevice *This, uint32_t NumDestDescriptorRanges, const ComputeCPUDescriptorHandle *pDestDescriptorRangeStarts,
+    const uint32_t *pDestDescriptorRangeSizes, uint32_t NumSrcDescriptorRanges, const ComputeCPUDescriptorHandle *pSrcDescriptorRangeStarts,
+    const uint32_t *pSrcDescriptorRangeSizes)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    // ComputeCPUDescriptorHandle has the layout of D3D12_CPU_DESCRIPTOR_HANDLE.
+    device->lpVtbl->CopyDescriptors(device, NumDestDescriptorRanges, (const D3D12_CPU_DESCRIPTOR_HANDLE*)pDestDescriptorRangeStarts,
+        pDestDescriptorRangeSizes, NumSrcDescriptorRanges, (const D3D12_CPU_DESCRIPTOR_HANDLE*)pSrcDescriptorRangeStarts,
+        pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+static ComputeRootSignature* D3D12Device_CreateRootSignature(ComputeDevice *This, const ComputeRootSignatureDesc *pDesc)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    if (pDesc->NumParameters > COMPUTE_MAX_ROOT_PARAMETERS)
+        return NULL;
+
+    D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = { 0 };
+
+    // This is the highest version the sample supports. If CheckFeatureSupport succeeds, the HighestVersion returned will not be greater than this.
+    featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+    if (device->lpVtbl->CheckFeatureSupport(device, D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData)) < 0)
+        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+
+    // Count the descriptor ranges of all the tables so that they can be translated in one allocation.
+    UINT totalRanges = 0;
+    for (uint32_t i = 0; i < pDesc->NumParameters; i++)
+    {
+        if (pDesc->pParameters[i].ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+            totalRanges += pDesc->pParameters[i].DescriptorTable.NumDescriptorRanges;
+    }
+
+    D3D12_DESCRIPTOR_RANGE1 *ranges = NULL;
+    if (totalRanges > 0)
+    {
+        ranges = HeapAlloc(GetProcessHeap(), 0, totalRanges * sizeof(*ranges));
+        if (ranges == NULL)
+            return NULL;
+    }
+
+    D3D12_ROOT_PARAMETER1 rootParameters[COMPUTE_MAX_ROOT_PARAMETERS];
+    UINT rangeIndex = 0;
+    for (uint32_t i = 0; i < pDesc->NumParameters; i++)
+    {
+        const ComputeRootParameter *src = &pDesc->pParameters[i];
+        D3D12_ROOT_PARAMETER1 *dst = &rootParameters[i];
+        dst->ParameterType = (D3D12_ROOT_PARAMETER_TYPE)src->ParameterType;
+        dst->ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+        if (src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+        {
+            dst->Constants.ShaderRegister = src->Constants.ShaderRegister;
+            dst->Constants.RegisterSpace = 0;
+            dst->Constants.Num32BitValues = src->Constants.Num32BitValues;
+            continue;
+        }
+        if (src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_SRV || src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_UAV)
+        {
+            dst->Descriptor.ShaderRegister = src->Descriptor.ShaderRegister;
+            dst->Descriptor.RegisterSpace = 0;
+            // The same guarantees as the descriptor tables
+            dst->Descriptor.Flags = src->ParameterType == COMPUTE_ROOT_PARAMETER_TYPE_UAV ?
+                D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE : D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+            continue;
+        }
+
+        dst->DescriptorTable.NumDescriptorRanges = src->DescriptorTable.NumDescriptorRanges;
+        dst->DescriptorTable.pDescriptorRanges = &ranges[rangeIndex];
+        for (uint32_t r = 0; r < src->DescriptorTable.NumDescriptorRanges; r++)
+        {
+            const ComputeDescriptorRange *srcRange = &src->DescriptorTable.pDescriptorRanges[r];
+            D3D12_DESCRIPTOR_RANGE1 *dstRange = &ranges[rangeIndex++];
+            dstRange->RangeType = (D3D12_DESCRIPTOR_RANGE_TYPE)srcRange->RangeType;
+            dstRange->NumDescriptors = srcRange->NumDescriptors;
+            dstRange->BaseShaderRegister = srcRange->BaseShaderRegister;
+            dstRange->RegisterSpace = 0;
+            // The source data is only guaranteed to be stable while the table is set, the UAV data is written by the shader.
+            dstRange->Flags = srcRange->RangeType == COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV ?
+                D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE : D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE;
+            dstRange->OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+        }
+    }
+
+    D3D12_VERSIONED_ROOT_SIGNATURE_DESC computeRootSignatureDesc = {
+        D3D_ROOT_SIGNATURE_VERSION_1_1,
+        .Desc_1_1 = { pDesc->NumParameters, rootParameters, 0, NULL, D3D12_ROOT_SIGNATURE_FLAG_NONE }
+    };
+
+    ID3DBlob *signature = NULL;
+    ID3DBlob *error = NULL;
+    HRESULT hr = D3DX12SerializeVersionedRootSignature(&computeRootSignatureDesc, featureData.HighestVersion, &signature, &error);
+    if (ranges != NULL)
+        HeapFree(GetProcessHeap(), 0, ranges);
+    if (error != NULL)
+        error->lpVtbl->Release(error);
+    if (FAILED(hr))
+    {
+        puts("Failed to serialize versioned root signature");
+        return NULL;
+    }
+
+    const uint8_t *pSignatureBytes = signature->lpVtbl->GetBufferPointer(signature);
+    const SIZE_T signatureSize = signature->lpVtbl->GetBufferSize(signature);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (SIZE_T i = 0; i < signatureSize; i++)
+    {
+        hash ^= pSignatureBytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    ID3D12RootSignature *nativeRootSignature = NULL;
+    hr = device->lpVtbl->CreateRootSignature(device, 0, pSignatureBytes, signatureSize, &IID_ID3D12RootSignature,
+        (void**)&nativeRootSignature);
+    signature->lpVtbl->Release(signature);
+    if (FAILED(hr))
+    {
+        puts("Failed to create root signature!");
+        return NULL;
+    }
+
+    D3D12BackendRootSignature *rootSignature = calloc(1, sizeof(*rootSignature));
+    if (rootSignature == NULL)
+    {
+        nativeRootSignature->lpVtbl->Release(nativeRootSignature);
+        return NULL;
+    }
+    rootSignature->lpVtbl = &s_d3d12RootSignatureVtbl;
+    rootSignature->rootSignature = nativeRootSignature;
+    rootSignature->hash = hash;
+
+    return (ComputeRootSignature*)rootSignature;
+}
+
+static ComputePipelineState* D3D12Device_CreateComputePipelineState(ComputeDevice *This, const ComputePipelineStateDesc *pDesc)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    // Describe and create the compute pipeline state object (PSO).
+    D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = { 0 };
+    computePsoDesc.pRootSignature = ((D3D12BackendRootSignature*)pDesc->pRootSignature)->rootSignature;
+    computePsoDesc.CS = (D3D12_SHADER_BYTECODE){ pDesc->CS.pShaderBytecode, pDesc->CS.BytecodeLength };
+    computePsoDesc.CachedPSO = (D3D12_CACHED_PIPELINE_STATE){ pDesc->CachedPSO.pCachedBlob, pDesc->CachedPSO.CachedBlobSizeInBytes };
+    computePsoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+    ID3D12PipelineState *nativePipelineState = NULL;
+    if (FAILED(device->lpVtbl->CreateComputePipelineState(device, &computePsoDesc, &IID_ID3D12PipelineState, (void**)&nativePipelineState)))
+        return NULL;
+
+    D3D12BackendPipelineState *pipelineState = calloc(1, sizeof(*pipelineState));
+    if (pipelineState == NULL)
+    {
+        nativePipelineState->lpVtbl->Release(nativePipelineState);
+        return NULL;
+    }
+    pipelineState->lpVtbl = &s_d3d12PipelineStateVtbl;
+    pipelineState->pipelineState = nativePipelineState;
+
+    return (ComputePipelineState*)pipelineState;
+}
+
+static ComputeCommandQueue* D3D12Device_CreateCommandQueue(ComputeDevice *This, ComputeCommandListType Type)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = { (D3D12_COMMAND_LIST_TYPE)Type, 0, D3D12_COMMAND_QUEUE_FLAG_NONE };
+    ID3D12CommandQueue *nativeQueue = NULL;
+    if (FAILED(device->lpVtbl->CreateCommandQueue(device, &queueDesc, &IID_ID3D12CommandQueue, (void**)&nativeQueue)))
+        return NULL;
+
+    D3D12BackendCommandQueue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL)
+    {
+        nativeQueue->lpVtbl->Release(nativeQueue);
+        return NULL;
+    }
+    queue->lpVtbl = &s_d3d12CommandQueueVtbl;
+    queue->commandQueue = nativeQueue;
+
+    return (ComputeCommandQueue*)queue;
+}
+
+static ComputeCommandAllocator* D3D12Device_CreateCommandAllocator(ComputeDevice *This, ComputeCommandListType Type)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    ID3D12CommandAllocator *nativeAllocator = NULL;
+    if (FAILED(device->lpVtbl->CreateCommandAllocator(device, (D3D12_COMMAND_LIST_TYPE)Type,
+        &IID_ID3D12CommandAllocator, (void**)&nativeAllocator)))
+        return NULL;
+
+    D3D12BackendCommandAllocator *allocator = calloc(1, sizeof(*allocator));
+    if (allocator == NULL)
+    {
+        nativeAllocator->lpVtbl->Release(nativeAllocator);
+        return NULL;
+    }
+    allocator->lpVtbl = &s_d3d12CommandAllocatorVtbl;
+    allocator->allocator = nativeAllocator;
+
+    return (ComputeCommandAllocator*)allocator;
+}
+
+static ComputeCommandList* D3D12Device_CreateCommandList(ComputeDevice *This, ComputeCommandListType Type,
+    ComputeCommandAllocator *pCommandAllocator, ComputePipelineState *pInitialState)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    ID3D12GraphicsCommandList *nativeList = NULL;
+    if (FAILED(device->lpVtbl->CreateCommandList(device, 0, (D3D12_COMMAND_LIST_TYPE)Type,
+        ((D3D12BackendCommandAllocator*)pCommandAllocator)->allocator, NativePipelineState(pInitialState),
+        &IID_ID3D12GraphicsCommandList, (void**)&nativeList)))
+        return NULL;
+
+    D3D12BackendCommandList *list = calloc(1, sizeof(*list));
+    if (list == NULL)
+    {
+        nativeList->lpVtbl->Release(nativeList);
+        return NULL;
+    }
+    list->lpVtbl = &s_d3d12CommandListVtbl;
+    list->commandList = nativeList;
+
+    return (ComputeCommandList*)list;
+}
+
+static ComputeFence* D3D12Device_CreateFence(ComputeDevice *This, uint64_t InitialValue)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    ID3D12Fence *nativeFence = NULL;
+    if (FAILED(device->lpVtbl->CreateFence(device, InitialValue, D3D12_FENCE_FLAG_NONE, &IID_ID3D12Fence, (void**)&nativeFence)))
+        return NULL;
+
+    D3D12BackendFence *fence = calloc(1, sizeof(*fence));
+    if (fence == NULL)
+    {
+        nativeFence->lpVtbl->Release(nativeFence);
+        return NULL;
+    }
+    fence->lpVtbl = &s_d3d12FenceVtbl;
+    fence->fence = nativeFence;
+
+    return (ComputeFence*)fence;
+}
+
+static void D3D12QueryHeap_Release(ComputeQueryHeap *This)
+{
+    D3D12BackendQueryHeap *heap = (D3D12BackendQueryHeap*)This;
+    heap->heap->lpVtbl->Release(heap->heap);
+    free(heap);
+}
+
+static const ComputeQueryHeapVtbl s_d3d12QueryHeapVtbl = { D3D12QueryHeap_Release };
+
+static ComputeQueryHeap* D3D12Device_CreateQueryHeap(ComputeDevice *This, const ComputeQueryHeapDesc *pDesc)
+{
+    ID3D12Device *device = ((D3D12BackendDevice*)This)->device;
+
+    // Not every device writes timestamps on copy queues.
+    if (pDesc->Type == COMPUTE_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP)
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options = { 0 };
+        if (FAILED(device->lpVtbl->CheckFeatureSupport(device, D3D12_FEATURE_D3D12_OPTIONS3, &options, sizeof(options))) ||
+            !options.CopyQueueTimestampQueriesSupported)
+            return NULL;
+    }
+
+    const D3D12_QUERY_HEAP_DESC queryHeapDesc = { (D3D12_QUERY_HEAP_TYPE)pDesc->Type, pDesc->Count, 0 };
+    ID3D12QueryHeap *nativeHeap = NULL;
+    if (FAILED(device->lpVtbl->CreateQueryHeap(device, &queryHeapDesc, &IID_ID3D12QueryHeap, (void**)&nativeHeap)))
+        return NULL;
+
+    D3D12BackendQueryHeap *heap = calloc(1, sizeof(*heap));
+    if (heap == NULL)
+    {
+        nativeHeap->lpVtbl->Release(nativeHeap);
+        return NULL;
+    }
+    heap->lpVtbl = &s_d3d12QueryHeapVtbl;
+    heap->heap = nativeHeap;
+
+    return (ComputeQueryHeap*)heap;
+}
+
+static const ComputeDeviceVtbl s_d3d12DeviceVtbl = {
+    D3D12Device_Release, D3D12Device_GetBackendType, D3D12Device_CompileShaderFromFile, D3D12Device_ReflectShader,
+    D3D12Device_CreateCommittedResource, D3D12Device_CreateHeap, D3D12Device_CreatePlacedResource,
+    D3D12Device_CreateDescriptorHeap, D3D12Device_GetDescriptorHandleIncrementSize,
+    D3D12Device_CreateShaderResourceView, D3D12Device_CreateUnorderedAccessView, D3D12Device_CopyDescriptors,
+    D3D12Device_CreateRootSignature, D3D12Device_CreateComputePipelineState,
+    D3D12Device_CreateCommandQueue, D3D12Device_CreateCommandAllocator, D3D12Device_CreateCommandList, D3D12Device_CreateFence,
+    D3D12Device_CreateQueryHeap
+};
+
+// Create the device on the adapter
+static ComputeDevice* CreateDeviceOnAdapter(IUnknown *adapter)
+{
+    // In debug mode
+    ID3D12Debug *debugController;
+    if (D3D12GetDebugInterface(&IID_ID3D12Debug, (void**)&debugController) >= 0)
+    {
+        debugController->lpVtbl->EnableDebugLayer(debugController);
+        debugController->lpVtbl->Release(debugController);
+    }
+
+    // Create the D3D12 device
+    ID3D12Device *nativeDevice;
+    HRESULT hr = D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_12_0, &IID_ID3D12Device, (void**)&nativeDevice);
+    if (hr < 0)
+        return NULL;
+
+    // Check 4X MSAA quality support for our back buffer format.
+    // All Direct3D 11 capable devices support 4X MSAA for all render
+    // target formats, so we only need to check quality support.
+    // This step is optional.
+    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msQualityLevels;
+    msQualityLevels.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    msQualityLevels.SampleCount = 4;
+    msQualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+    msQualityLevels.NumQualityLevels = 0;
+    hr = nativeDevice->lpVtbl->CheckFeatureSupport(nativeDevice,
+        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS,
+        &msQualityLevels,
+        sizeof(msQualityLevels));
+    if (hr < 0)
+    {
+        nativeDevice->lpVtbl->Release(nativeDevice);
+        return NULL;
+    }
+
+    unsigned msaaQuality = msQualityLevels.NumQualityLevels;
+    printf("msaaQuality: %u\n", msaaQuality);
+
+    D3D12BackendDevice *device = calloc(1, sizeof(*device));
+    if (device == NULL)
+    {
+        nativeDevice->lpVtbl->Release(nativeDevice);
+        return NULL;
+    }
+    device->lpVtbl = &s_d3d12DeviceVtbl;
+    device->device = nativeDevice;
+
+    return (ComputeDevice*)device;
+}
+
+ComputeDevice* CreateD3D12ComputeDevice(void)
+{
+    IDXGIFactory4 *factory;
+    if (CreateDXGIFactory1(&IID_IDXGIFactory4, (void**)&factory) < 0)
+        return NULL;
+
+    // Here, we shall use a warp device
+    IDXGIAdapter *warpAdapter;
+    HRESULT hr = factory->lpVtbl->EnumWarpAdapter(factory, &IID_IDXGIAdapter, (void**)&warpAdapter);
+    factory->lpVtbl->Release(factory);
+    if (hr < 0)
+        return NULL;
+
+    ComputeDevice *device = CreateDeviceOnAdapter((IUnknown*)warpAdapter);
+    warpAdapter->lpVtbl->Release(warpAdapter);
+
+    return device;
+}
+
+// Find the adapter of the index among the ones that support Direct3D 12.
+// Without ppAdapter, counts them and fills the descriptions up to maxAdapters.
+static uint32_t FindD3D12Adapters(uint32_t adapterIndex, IDXGIAdapter1 **ppAdapter, ComputeAdapterDesc *pDescs, uint32_t maxAdapters)
+{
+    IDXGIFactory4 *factory;
+    if (CreateDXGIFactory1(&IID_IDXGIFactory4, (void**)&factory) < 0)
+        return 0;
+
+    uint32_t numAdapters = 0;
+    IDXGIAdapter1 *adapter;
+    for (UINT i = 0; factory->lpVtbl->EnumAdapters1(factory, i, &adapter) != DXGI_ERROR_NOT_FOUND; i++)
+    {
+        // Only check that the device can be created, without creating it.
+        if (D3D12CreateDevice((IUnknown*)adapter, D3D_FEATURE_LEVEL_12_0, &IID_ID3D12Device, NULL) < 0)
+        {
+            adapter->lpVtbl->Release(adapter);
+            continue;
+        }
+
+        if (ppAdapter != NULL && numAdapters == adapterIndex)
+        {
+            *ppAdapter = adapter;
+            factory->lpVtbl->Release(factory);
+            return numAdapters + 1;
+        }
+
+        if (pDescs != NULL && numAdapters < maxAdapters)
+        {
+            DXGI_ADAPTER_DESC1 nativeDesc;
+            ComputeAdapterDesc *desc = &pDescs[numAdapters];
+            memset(desc, 0, sizeof(*desc));
+            if (adapter->lpVtbl->GetDesc1(adapter, &nativeDesc) >= 0)
+            {
+                // The conversion fails when the description does not fit, which leaves it empty.
+                if (WideCharToMultiByte(CP_UTF8, 0, nativeDesc.Description, -1, desc->Description, (int)sizeof(desc->Description),
+                    NULL, NULL) == 0)
+                    desc->Description[0] = '\0';
+                desc->DedicatedVideoMemory = nativeDesc.DedicatedVideoMemory;
+                desc->Software = (nativeDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0;
+            }
+        }
+        adapter->lpVtbl->Release(adapter);
+        numAdapters++;
+    }
+    factory->lpVtbl->Release(factory);
+
+    return ppAdapter != NULL ? 0 : numAdapters;
+}
+
+uint32_t EnumD3D12ComputeAdapters(ComputeAdapterDesc *pDescs, uint32_t maxAdapters)
+{
+    return FindD3D12Adapters(0, NULL, pDescs, maxAdapters);
+}
+
+ComputeDevice* CreateD3D12ComputeDeviceOnAdapter(uint32_t adapterIndex)
+{
+    IDXGIAdapter1 *adapter = NULL;
+    if (FindD3D12Adapters(adapterIndex, &adapter, NULL, 0) == 0)
+        return NULL;
+
+    ComputeDevice *device = CreateDeviceOnAdapter((IUnknown*)adapter);
+    adapter->lpVtbl->Release(adapter);
+
+    return device;
+}
@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descriptor_allocator.h"
+
+// ---- Free list ----
+
+static bool FreeListInit(ComputeDescriptorFreeList *list, uint32_t numDescriptors)
+{
+    list->capacity = 16;
+    list->ranges = malloc(list->capacity * sizeof(*list->ranges));
+    if (list->ranges == NULL)
+        return false;
+
+    list->numRanges = 0;
+    if (numDescriptors > 0)
+        list->ranges[list->numRanges++] = (ComputeDescriptorFreeRange){ 0, numDescriptors };
+
+    return true;
+}
+
+static bool FreeListAllocate(ComputeDescriptorFreeList *list, uint32_t count, uint32_t *pBegin)
+{
+    for (uint32_t i = 0; i < list->numRanges; i++)
+    {
+        ComputeDescriptorFreeRange *range = &list->ranges[i];
+        if (range->count < count)
+            continue;
+
+        *pBegin = range->begin;
+        range->begin += count;
+        range->count -= count;
+        if (range->count == 0)
+        {
+            memmove(range, range + 1, (list->numRanges - i - 1) * sizeof(*range));
+            list->numRanges--;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static bool FreeListFree(ComputeDescriptorFreeList *list, uint32_t begin, uint32_t count)
+{
+    // Find the first free range after the freed one.
+    uint32_t low = 0, high = list->numRanges;
+    while (low < high)
+    {
+        const uint32_t middle = (low + high) / 2;
+        if (list->ranges[middle].begin < begin)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    ComputeDescriptorFreeRange *prev = low > 0 ? &list->ranges[low - 1] : NULL;
+    ComputeDescriptorFreeRange *next = low < list->numRanges ? &list->ranges[low] : NULL;
+    const bool mergePrev = prev != NULL && prev->begin + prev->count == begin;
+    const bool mergeNext = next != NULL && begin + count == next->begin;
+
+    if (mergePrev && mergeNext)
+    {
+        prev->count += count + next->count;
+        memmove(next, next + 1, (list->numRanges - low - 1) * sizeof(*next));
+        list->numRanges--;
+    }
+    else if (mergePrev)
+        prev->count += count;
+    else if (mergeNext)
+    {
+        next->begin = begin;
+        next->count += count;
+    }
+    else
+    {
+        if (list->numRanges == list->capacity)
+        {
+            ComputeDescriptorFreeRange *ranges = realloc(list->ranges, list->capacity * 2 * sizeof(*ranges));
+            if (ranges == NULL)
+                return false;
+            list->ranges = ranges;
+            list->capacity *= 2;
+        }
+
+        memmove(&list->ranges[low + 1], &list->ranges[low], (list->numRanges - low) * sizeof(*list->ranges));
+        list->ranges[low] = (ComputeDescriptorFreeRange){ begin, count };
+        list->numRanges++;
+    }
+
+    return true;
+}
+
+// ---- Allocator ----
+
+static void FillAllocation(const ComputeDescriptorAllocator *allocator, ComputeCPUDescriptorHandle cpuStart,
+    ComputeGPUDescriptorHandle gpuStart, uint32_t index, uint32_t count, ComputeDescriptorAllocation *pAllocation)
+{
+    pAllocation->index = index;
+    pAllocation->count = count;
+    pAllocation->cpuHandle.ptr = cpuStart.ptr + (size_t)index * allocator->descriptorSize;
+    pAllocation->gpuHandle.ptr = gpuStart.ptr != 0 ? gpuStart.ptr + (uint64_t)index * allocator->descriptorSize : 0;
+}
+
+bool ComputeDescriptorAllocatorInit(ComputeDescriptorAllocator *allocator, ComputeDevice *device, ComputeTimeline *timeline,
+    const ComputeDescriptorAllocatorDesc *desc)
+{
+    memset(allocator, 0, sizeof(*allocator));
+    allocator->device = device;
+    allocator->timeline = timeline;
+    allocator->descriptorSize = device->lpVtbl->GetDescriptorHandleIncrementSize(device);
+    allocator->numPersistent = desc->NumPersistent;
+    ComputeRingAllocatorInit(&allocator->transientRing, timeline, desc->NumTransient, "descriptor ring");
+
+    const ComputeDescriptorHeapDesc heapDesc = { desc->NumPersistent + desc->NumTransient, true };
+    allocator->heap = device->lpVtbl->CreateDescriptorHeap(device, &heapDesc);
+    if (allocator->heap == NULL)
+    {
+        puts("Failed to create the shader visible descriptor heap!");
+        return false;
+    }
+    allocator->heapCpuStart = allocator->heap->lpVtbl->GetCPUDescriptorHandleForHeapStart(allocator->heap);
+    allocator->heapGpuStart = allocator->heap->lpVtbl->GetGPUDescriptorHandleForHeapStart(allocator->heap);
+
+    if (desc->NumStaging > 0)
+    {
+        const ComputeDescriptorHeapDesc stagingDesc = { desc->NumStaging, false };
+        allocator->stagingHeap = device->lpVtbl->CreateDescriptorHeap(device, &stagingDesc);
+        if (allocator->stagingHeap == NULL)
+        {
+            puts("Failed to create the staging descriptor heap!");
+            ComputeDescriptorAllocatorDestroy(allocator);
+            return false;
+        }
+        allocator->stagingCpuStart = allocator->stagingHeap->lpVtbl->GetCPUDescriptorHandleForHeapStart(allocator->stagingHeap);
+    }
+
+    if (!FreeListInit(&allocator->persistentFreeList, desc->NumPersistent) ||
+        !FreeListInit(&allocator->stagingFreeList, desc->NumStaging))
+    {
+        ComputeDescriptorAllocatorDestroy(allocator);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeDescriptorAllocatorDestroy(ComputeDescriptorAllocator *allocator)
+{
+    // The transient ring waits for the last table. Wait for the persistent descriptors freed last as well.
+    uint64_t lastFenceValue = 0;
+    for (uint32_t i = 0; i < allocator->numDeferredFrees; i++)
+    {
+        if (allocator->deferredFrees[i].fenceValue > lastFenceValue)
+            lastFenceValue = allocator->deferredFrees[i].fenceValue;
+    }
+    if (lastFenceValue != 0 && lastFenceValue <= allocator->timeline->lastSignaledValue)
+        ComputeTimelineWait(allocator->timeline, lastFenceValue, COMPUTE_WAIT_INFINITE);
+
+    ComputeRingAllocatorDestroy(&allocator->transientRing);
+
+    if (allocator->heap != NULL)
+        allocator->heap->lpVtbl->Release(allocator->heap);
+    if (allocator->stagingHeap != NULL)
+        allocator->stagingHeap->lpVtbl->Release(allocator->stagingHeap);
+
+    free(allocator->persistentFreeList.ranges);
+    free(allocator->stagingFreeList.ranges);
+    free(allocator->deferredFrees);
+    memset(allocator, 0, sizeof(*allocator));
+}
+
+// Give the persistent descriptors whose fence value has been reached back to the free list
+static void ReclaimPersistent(ComputeDescriptorAllocator *allocator)
+{
+    if (allocator->numDeferredFrees == 0)
+        return;
+
+    const uint64_t completedValue = ComputeTimelineGetCompletedValue(allocator->timeline);
+
+    uint32_t numPending = 0;
+    for (uint32_t i = 0; i < allocator->numDeferredFrees; i++)
+    {
+        const ComputeDescriptorDeferredFree *deferredFree = &allocator->deferredFrees[i];
+        if (deferredFree->fenceValue > completedValue ||
+            !FreeListFree(&allocator->persistentFreeList, deferredFree->index, deferredFree->count))
+            allocator->deferredFrees[numPending++] = *deferredFree;
+    }
+    allocator->numDeferredFrees = numPending;
+}
+
+bool ComputeDescriptorAllocatorAllocatePersistent(ComputeDescriptorAllocator *allocator, uint32_t count,
+    ComputeDescriptorAllocation *pAllocation)
+{
+    ReclaimPersistent(allocator);
+
+    uint32_t index;
+    if (count == 0 || !FreeListAllocate(&allocator->persistentFreeList, count, &index))
+    {
+        printf("Failed to allocate %u persistent descriptors!\n", count);
+        return false;
+    }
+
+    FillAllocation(allocator, allocator->heapCpuStart, allocator->heapGpuStart, index, count, pAllocation);
+    return true;
+}
+
+void ComputeDescriptorAllocatorFreePersistent(ComputeDescriptorAllocator *allocator, const ComputeDescriptorAllocation *allocation)
+{
+    if (allocation->count == 0)
+        return;
+
+    if (allocator->numDeferredFrees == allocator->deferredFreeCapacity)
+    {
+        const uint32_t newCapacity = allocator->deferredFreeCapacity == 0 ? 16 : allocator->deferredFreeCapacity * 2;
+        ComputeDescriptorDeferredFree *deferredFrees = realloc(allocator->deferredFrees, newCapacity * sizeof(*deferredFrees));
+        if (deferredFrees == NULL)
+        {
+            puts("Failed to free the persistent descriptors!");
+            return;
+        }
+        allocator->deferredFrees = deferredFrees;
+        allocator->deferredFreeCapacity = newCapacity;
+    }
+
+    // The command list being recorded may still reference the descriptors.
+    ComputeDescriptorDeferredFree *deferredFree = &allocator->deferredFrees[allocator->numDeferredFrees++];
+    deferredFree->fenceValue = allocator->timeline->lastSignaledValue + 1;
+    deferredFree->index = allocation->index;
+    deferredFree->count = allocation->count;
+}
+
+bool ComputeDescriptorAllocatorAllocateStaging(ComputeDescriptorAllocator *allocator, uint32_t count,
+    ComputeDescriptorAllocation *pAllocation)
+{
+    uint32_t index;
+    if (count == 0 || !FreeListAllocate(&allocator->stagingFreeList, count, &index))
+    {
+        printf("Failed to allocate %u staging descriptors!\n", count);
+        return false;
+    }
+
+    const ComputeGPUDescriptorHandle noGpuHandle = { 0 };
+    FillAllocation(allocator, allocator->stagingCpuStart, noGpuHandle, index, count, pAllocation);
+    return true;
+}
+
+void ComputeDescriptorAllocatorFreeStaging(ComputeDescriptorAllocator *allocator, const ComputeDescriptorAllocation *allocation)
+{
+    if (allocation->count > 0 && !FreeListFree(&allocator->stagingFreeList, allocation->index, allocation->count))
+        puts("Failed to free the staging descriptors!");
+}
+
+bool ComputeDescriptorAllocatorAllocateTable(ComputeDescriptorAllocator *allocator, uint32_t count, uint32_t timeoutMs,
+    ComputeDescriptorAllocation *pAllocation)
+{
+    uint64_t offset;
+    if (!ComputeRingAllocatorAllocate(&allocator->transientRing, count, 1, timeoutMs, &offset))
+        return false;
+
+    FillAllocation(allocator, allocator->heapCpuStart, allocator->heapGpuStart,
+        allocator->numPersistent + (uint32_t)offset, count, pAllocation);
+    return true;
+}
+
+bool ComputeDescriptorAllocatorCopyTable(ComputeDescriptorAllocator *allocator, uint32_t count,
+    const ComputeCPUDescriptorHandle *pSrcHandles, uint32_t timeoutMs, ComputeDescriptorAllocation *pAllocation)
+{
+    if (count > COMPUTE_DESCRIPTOR_TABLE_MAX_SIZE)
+    {
+        printf("A descriptor table of %u descriptors is too large!\n", count);
+        return false;
+    }
+
+    if (!ComputeDescriptorAllocatorAllocateTable(allocator, count, timeoutMs, pAllocation))
+        return false;
+
+    // Merge the consecutive source descriptors into ranges.
+    ComputeCPUDescriptorHandle srcStarts[COMPUTE_DESCRIPTOR_TABLE_MAX_SIZE];
+    uint32_t srcSizes[COMPUTE_DESCRIPTOR_TABLE_MAX_SIZE];
+    uint32_t numSrcRanges = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (numSrcRanges > 0 &&
+            pSrcHandles[i].ptr == srcStarts[numSrcRanges - 1].ptr + (size_t)srcSizes[numSrcRanges - 1] * allocator->descriptorSize)
+        {
+            srcSizes[numSrcRanges - 1]++;
+            continue;
+        }
+        srcStarts[numSrcRanges] = pSrcHandles[i];
+        srcSizes[numSrcRanges] = 1;
+        numSrcRanges++;
+    }
+
+    ComputeDevice *device = allocator->device;
+    device->lpVtbl->CopyDescriptors(device, 1, &pAllocation->cpuHandle, &count, numSrcRanges, srcStarts, srcSizes);
+    return true;
+}
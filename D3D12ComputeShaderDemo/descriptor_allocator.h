@@ -0,0 +1,126 @@
+#ifndef DESCRIPTOR_ALLOCATOR_H
+#define DESCRIPTOR_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+#include "ring_allocator.h"
+
+// The maximum number of descriptors of a transient table copied with ComputeDescriptorAllocatorCopyTable
+#define COMPUTE_DESCRIPTOR_TABLE_MAX_SIZE   64
+
+// A contiguous run of descriptors
+typedef struct ComputeDescriptorAllocation
+{
+    // Index of the first descriptor in its heap
+    uint32_t index;
+    uint32_t count;
+    ComputeCPUDescriptorHandle cpuHandle;
+    // Not valid for staging descriptors
+    ComputeGPUDescriptorHandle gpuHandle;
+} ComputeDescriptorAllocation;
+
+// A free run of descriptors
+typedef struct ComputeDescriptorFreeRange
+{
+    uint32_t begin;
+    uint32_t count;
+} ComputeDescriptorFreeRange;
+
+// First-fit free list of descriptor runs, sorted by index, with adjacent runs merged
+typedef struct ComputeDescriptorFreeList
+{
+    ComputeDescriptorFreeRange *ranges;
+    uint32_t numRanges;
+    uint32_t capacity;
+} ComputeDescriptorFreeList;
+
+// A persistent run freed while the GPU may still read it, reusable once the timeline reaches fenceValue
+typedef struct ComputeDescriptorDeferredFree
+{
+    uint64_t fenceValue;
+    uint32_t index;
+    uint32_t count;
+} ComputeDescriptorDeferredFree;
+
+typedef struct ComputeDescriptorAllocatorDesc
+{
+    // Long-lived descriptors in the shader visible heap
+    uint32_t NumPersistent;
+    // Descriptors of the transient tables, recycled per submission
+    uint32_t NumTransient;
+    // Descriptors of the CPU-only staging heap
+    uint32_t NumStaging;
+} ComputeDescriptorAllocatorDesc;
+
+// One shader visible heap for all the kernels, so that it is set once per command list
+// and binding a table costs one root descriptor table whatever the number of kernels.
+// The start of the heap holds the persistent descriptors, managed by a free list.
+// The rest is a linear ring of transient tables; each table is owned by the next value signaled on the timeline.
+// Views are usually created in the CPU-only staging heap and copied to a transient table in bulk when bound.
+// Like the upload ring, the allocator is meant to be used by the single thread that records the command lists.
+typedef struct ComputeDescriptorAllocator
+{
+    ComputeDevice *device;
+    ComputeTimeline *timeline;
+    uint32_t descriptorSize;
+    ComputeDescriptorHeap *heap;
+    ComputeCPUDescriptorHandle heapCpuStart;
+    ComputeGPUDescriptorHandle heapGpuStart;
+    ComputeDescriptorHeap *stagingHeap;
+    ComputeCPUDescriptorHandle stagingCpuStart;
+    uint32_t numPersistent;
+    ComputeDescriptorFreeList persistentFreeList;
+    ComputeDescriptorFreeList stagingFreeList;
+    ComputeDescriptorDeferredFree *deferredFrees;
+    uint32_t numDeferredFrees;
+    uint32_t deferredFreeCapacity;
+    ComputeRingAllocator transientRing;
+} ComputeDescriptorAllocator;
+
+extern bool ComputeDescriptorAllocatorInit(ComputeDescriptorAllocator *allocator, ComputeDevice *device, ComputeTimeline *timeline,
+    const ComputeDescriptorAllocatorDesc *desc);
+// Waits for all the submitted work that may read the descriptors before releasing the heaps
+extern void ComputeDescriptorAllocatorDestroy(ComputeDescriptorAllocator *allocator);
+
+// Allocate count contiguous persistent descriptors in the shader visible heap
+extern bool ComputeDescriptorAllocatorAllocatePersistent(ComputeDescriptorAllocator *allocator, uint32_t count,
+    ComputeDescriptorAllocation *pAllocation);
+// The descriptors are reused once the commands recorded so far have completed.
+extern void ComputeDescriptorAllocatorFreePersistent(ComputeDescriptorAllocator *allocator, const ComputeDescriptorAllocation *allocation);
+
+// Allocate count contiguous descriptors in the staging heap
+extern bool ComputeDescriptorAllocatorAllocateStaging(ComputeDescriptorAllocator *allocator, uint32_t count,
+    ComputeDescriptorAllocation *pAllocation);
+// Staging descriptors are only read by CopyDescriptors, so they are reusable at once.
+extern void ComputeDescriptorAllocatorFreeStaging(ComputeDescriptorAllocator *allocator, const ComputeDescriptorAllocation *allocation);
+
+// Allocate a transient table of count descriptors, valid until the next signal of the timeline has completed.
+// When the ring is full, waits for the oldest tables for at most timeoutMs.
+extern bool ComputeDescriptorAllocatorAllocateTable(ComputeDescriptorAllocator *allocator, uint32_t count, uint32_t timeoutMs,
+    ComputeDescriptorAllocation *pAllocation);
+
+// Allocate a transient table and fill it with the staging descriptors pSrcHandles[0..count) in a single CopyDescriptors.
+// Consecutive source handles are copied as one range.
+extern bool ComputeDescriptorAllocatorCopyTable(ComputeDescriptorAllocator *allocator, uint32_t count,
+    const ComputeCPUDescriptorHandle *pSrcHandles, uint32_t timeoutMs, ComputeDescriptorAllocation *pAllocation);
+
+// The handles of the i-th descriptor of an allocation
+static inline ComputeCPUDescriptorHandle ComputeDescriptorCPUHandle(const ComputeDescriptorAllocator *allocator,
+    const ComputeDescriptorAllocation *allocation, uint32_t i)
+{
+    const ComputeCPUDescriptorHandle handle = { allocation->cpuHandle.ptr + (size_t)i * allocator->descriptorSize };
+    return handle;
+}
+
+static inline ComputeGPUDescriptorHandle ComputeDescriptorGPUHandle(const ComputeDescriptorAllocator *allocator,
+    const ComputeDescriptorAllocation *allocation, uint32_t i)
+{
+    const ComputeGPUDescriptorHandle handle = { allocation->gpuHandle.ptr + (uint64_t)i * allocator->descriptorSize };
+    return handle;
+}
+
+#endif // DESCRIPTOR_ALLOCATOR_H
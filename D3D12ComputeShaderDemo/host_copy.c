@@ -0,0 +1,374 @@
+#include <string.h>
+
+#include "host_copy.h"
+#include "compute_thread.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HOST_COPY_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only compile the intrinsics of the instruction sets enabled for the function,
+// MSVC compiles all of them everywhere.
+#if defined(HOST_COPY_X64) && !defined(_MSC_VER)
+#define HOST_COPY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define HOST_COPY_TARGET(isa)
+#endif
+
+// The size of the pieces of a parallel copy, a multiple of the page size
+#define HOST_COPY_PARALLEL_CHUNK    (1024 * 1024)
+
+// The records of a transposition are processed in tiles, which stay in the cache while each of their fields is copied
+#define HOST_TRANSPOSE_TILE_RECORDS 1024
+
+typedef void (*HostCopyFunc)(uint8_t *dst, const uint8_t *src, size_t size);
+
+// The kernel in use and the best supported one, -1 until they are detected
+static volatile int64_t s_kernel = -1;
+static volatile int64_t s_bestKernel = -1;
+
+static ThreadPool *s_threadPool;
+
+static void CopyScalar(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+#ifdef HOST_COPY_X64
+
+// Each kernel copies the unaligned head with memcpy, then streams whole vectors to the aligned destination,
+// four at a time to keep a full cache line of write-combining buffer in flight, and copies the tail with memcpy.
+// The stores are fenced so that they are visible to the GPU, and to the other threads, once the kernel returns.
+
+static void CopySse2(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    for (; size >= 64; size -= 64, dst += 64, src += 64)
+    {
+        const __m128i v0 = _mm_loadu_si128((const __m128i*)src);
+        const __m128i v1 = _mm_loadu_si128((const __m128i*)(src + 16));
+        const __m128i v2 = _mm_loadu_si128((const __m128i*)(src + 32));
+        const __m128i v3 = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)dst, v0);
+        _mm_stream_si128((__m128i*)(dst + 16), v1);
+        _mm_stream_si128((__m128i*)(dst + 32), v2);
+        _mm_stream_si128((__m128i*)(dst + 48), v3);
+    }
+    for (; size >= 16; size -= 16, dst += 16, src += 16)
+        _mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+
+    _mm_sfence();
+    memcpy(dst, src, size);
+}
+
+HOST_COPY_TARGET("avx2")
+static void CopyAvx2(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    size_t head = (32 - ((uintptr_t)dst & 31)) & 31;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    for (; size >= 128; size -= 128, dst += 128, src += 128)
+    {
+        const __m256i v0 = _mm256_loadu_si256((const __m256i*)src);
+        const __m256i v1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+        const __m256i v2 = _mm256_loadu_si256((const __m256i*)(src + 64));
+        const __m256i v3 = _mm256_loadu_si256((const __m256i*)(src + 96));
+        _mm256_stream_si256((__m256i*)dst, v0);
+        _mm256_stream_si256((__m256i*)(dst + 32), v1);
+        _mm256_stream_si256((__m256i*)(dst + 64), v2);
+        _mm256_stream_si256((__m256i*)(dst + 96), v3);
+    }
+    for (; size >= 32; size -= 32, dst += 32, src += 32)
+        _mm256_stream_si256((__m256i*)dst, _mm256_loadu_si256((const __m256i*)src));
+
+    _mm_sfence();
+    // Avoid the penalty of mixing AVX and SSE code in the memcpy of the tail.
+    _mm256_zeroupper();
+    memcpy(dst, src, size);
+}
+
+HOST_COPY_TARGET("avx512f")
+static void CopyAvx512(uint8_t *dst, const uint8_t *src, size_t size)
+{
+    size_t head = (64 - ((uintptr_t)dst & 63)) & 63;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    for (; size >= 256; size -= 256, dst += 256, src += 256)
+    {
+        const __m512i v0 = _mm512_loadu_si512((const void*)src);
+        const __m512i v1 = _mm512_loadu_si512((const void*)(src + 64));
+        const __m512i v2 = _mm512_loadu_si512((const void*)(src + 128));
+        const __m512i v3 = _mm512_loadu_si512((const void*)(src + 192));
+        _mm512_stream_si512((void*)dst, v0);
+        _mm512_stream_si512((void*)(dst + 64), v1);
+        _mm512_stream_si512((void*)(dst + 128), v2);
+        _mm512_stream_si512((void*)(dst + 192), v3);
+    }
+    for (; size >= 64; size -= 64, dst += 64, src += 64)
+        _mm512_stream_si512((void*)dst, _mm512_loadu_si512((const void*)src));
+
+    _mm_sfence();
+    _mm256_zeroupper();
+    memcpy(dst, src, size);
+}
+
+#endif // HOST_COPY_X64
+
+static ComputeHostCopyKernel DetectBestKernel(void)
+{
+#if defined(HOST_COPY_X64) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    // The OS has to save the AVX registers (XCR0 bits 1-2) and the AVX-512 ones (bits 5-7).
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+
+    bool avx2 = false, avx512 = false;
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+    }
+
+    if (avx512)
+        return COMPUTE_HOST_COPY_KERNEL_AVX512;
+    if (avx2)
+        return COMPUTE_HOST_COPY_KERNEL_AVX2;
+    return COMPUTE_HOST_COPY_KERNEL_SSE2;
+#elif defined(HOST_COPY_X64)
+    // The builtins also check that the OS saves the registers.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return COMPUTE_HOST_COPY_KERNEL_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return COMPUTE_HOST_COPY_KERNEL_AVX2;
+    return COMPUTE_HOST_COPY_KERNEL_SSE2;
+#else
+    return COMPUTE_HOST_COPY_KERNEL_SCALAR;
+#endif
+}
+
+ComputeHostCopyKernel ComputeHostCopyGetBestKernel(void)
+{
+    int64_t kernel = ComputeAtomicLoad64(&s_bestKernel);
+    if (kernel < 0)
+    {
+        // Detecting twice is harmless.
+        kernel = DetectBestKernel();
+        ComputeAtomicStore64(&s_bestKernel, kernel);
+    }
+    return (ComputeHostCopyKernel)kernel;
+}
+
+ComputeHostCopyKernel ComputeHostCopySetKernel(ComputeHostCopyKernel kernel)
+{
+    // The kernels are ordered by width, each CPU supports the ones up to its best.
+    const ComputeHostCopyKernel bestKernel = ComputeHostCopyGetBestKernel();
+    if (kernel > bestKernel)
+        kernel = bestKernel;
+
+    ComputeAtomicStore64(&s_kernel, kernel);
+    return kernel;
+}
+
+const char* ComputeHostCopyGetKernelName(ComputeHostCopyKernel kernel)
+{
+    switch (kernel)
+    {
+    case COMPUTE_HOST_COPY_KERNEL_SSE2:
+        return "SSE2";
+    case COMPUTE_HOST_COPY_KERNEL_AVX2:
+        return "AVX2";
+    case COMPUTE_HOST_COPY_KERNEL_AVX512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+
+void ComputeHostCopySetThreadPool(ThreadPool *pool)
+{
+    s_threadPool = pool;
+}
+
+static HostCopyFunc GetCopyFunc(size_t size)
+{
+    if (size < COMPUTE_HOST_COPY_STREAMING_THRESHOLD)
+        return CopyScalar;
+
+    int64_t kernel = ComputeAtomicLoad64(&s_kernel);
+    if (kernel < 0)
+        kernel = ComputeHostCopySetKernel(ComputeHostCopyGetBestKernel());
+
+    switch (kernel)
+    {
+#ifdef HOST_COPY_X64
+    case COMPUTE_HOST_COPY_KERNEL_SSE2:
+        return CopySse2;
+    case COMPUTE_HOST_COPY_KERNEL_AVX2:
+        return CopyAvx2;
+    case COMPUTE_HOST_COPY_KERNEL_AVX512:
+        return CopyAvx512;
+#endif
+    default:
+        return CopyScalar;
+    }
+}
+
+// One copy split into HOST_COPY_PARALLEL_CHUNK pieces
+typedef struct HostCopyTask
+{
+    uint8_t *dst;
+    const uint8_t *src;
+    size_t size;
+    HostCopyFunc func;
+} HostCopyTask;
+
+static void RunHostCopyChunks(void *context, size_t begin, size_t end)
+{
+    const HostCopyTask *task = context;
+
+    const size_t offset = begin * HOST_COPY_PARALLEL_CHUNK;
+    size_t size = (end - begin) * HOST_COPY_PARALLEL_CHUNK;
+    if (size > task->size - offset)
+        size = task->size - offset;
+
+    task->func(task->dst + offset, task->src + offset, size);
+}
+
+void ComputeHostCopy(void *dst, const void *src, size_t size)
+{
+    const HostCopyFunc func = GetCopyFunc(size);
+    ThreadPool *pool = s_threadPool;
+
+    // A single core cannot saturate the memory bandwidth, so the large copies are spread over the pool.
+    if (pool != NULL && size >= COMPUTE_HOST_COPY_PARALLEL_THRESHOLD && ThreadPoolGetThreadCount(pool) > 1)
+    {
+        HostCopyTask task = { dst, src, size, func };
+        ThreadPoolParallelFor(pool, (size + HOST_COPY_PARALLEL_CHUNK - 1) / HOST_COPY_PARALLEL_CHUNK, 1,
+            RunHostCopyChunks, &task);
+        return;
+    }
+
+    func(dst, src, size);
+}
+
+// One AoS-SoA transposition, split into tiles of HOST_TRANSPOSE_TILE_RECORDS records
+typedef struct HostTransposeTask
+{
+    uint8_t *records;
+    uint8_t *const *fieldArrays;
+    const ComputeStructLayout *layout;
+    uint32_t fieldSizes[COMPUTE_STRUCT_MAX_FIELDS];
+    size_t numRecords;
+    bool toSoA;
+} HostTransposeTask;
+
+// Copy count fields of size bytes from src to dst with their strides.
+// The cases of the common sizes let the compiler turn each memcpy into a single move.
+static void TransposeField(uint8_t *dst, size_t dstStride, const uint8_t *src, size_t srcStride, size_t size, size_t count)
+{
+    switch (size)
+    {
+    case 2:
+        for (size_t i = 0; i < count; i++)
+            memcpy(dst + i * dstStride, src + i * srcStride, 2);
+        break;
+    case 4:
+        for (size_t i = 0; i < count; i++)
+            memcpy(dst + i * dstStride, src + i * srcStride, 4);
+        break;
+    case 8:
+        for (size_t i = 0; i < count; i++)
+            memcpy(dst + i * dstStride, src + i * srcStride, 8);
+        break;
+    case 16:
+        for (size_t i = 0; i < count; i++)
+            memcpy(dst + i * dstStride, src + i * srcStride, 16);
+        break;
+    default:
+        for (size_t i = 0; i < count; i++)
+            memcpy(dst + i * dstStride, src + i * srcStride, size);
+        break;
+    }
+}
+
+static void RunHostTransposeTiles(void *context, size_t begin, size_t end)
+{
+    const HostTransposeTask *task = context;
+    const ComputeStructLayout *layout = task->layout;
+
+    for (size_t tile = begin; tile < end; tile++)
+    {
+        const size_t first = tile * HOST_TRANSPOSE_TILE_RECORDS;
+        const size_t count = task->numRecords - first < HOST_TRANSPOSE_TILE_RECORDS ?
+            task->numRecords - first : HOST_TRANSPOSE_TILE_RECORDS;
+
+        for (uint32_t field = 0; field < layout->NumFields; field++)
+        {
+            const size_t size = task->fieldSizes[field];
+            uint8_t *record = task->records + first * layout->Size + layout->Fields[field].Offset;
+            uint8_t *array = task->fieldArrays[field] + first * size;
+
+            if (task->toSoA)
+                TransposeField(array, size, record, layout->Size, size, count);
+            else
+                TransposeField(record, layout->Size, array, size, size, count);
+        }
+    }
+}
+
+static void HostTranspose(HostTransposeTask *task)
+{
+    for (uint32_t field = 0; field < task->layout->NumFields; field++)
+        task->fieldSizes[field] = ComputeStructLayoutGetFieldSize(task->layout, field);
+
+    const size_t numTiles = (task->numRecords + HOST_TRANSPOSE_TILE_RECORDS - 1) / HOST_TRANSPOSE_TILE_RECORDS;
+    ThreadPool *pool = s_threadPool;
+
+    if (pool != NULL && task->numRecords * task->layout->Size >= COMPUTE_HOST_COPY_PARALLEL_THRESHOLD &&
+        ThreadPoolGetThreadCount(pool) > 1)
+    {
+        ThreadPoolParallelFor(pool, numTiles, 1, RunHostTransposeTiles, task);
+        return;
+    }
+
+    RunHostTransposeTiles(task, 0, numTiles);
+}
+
+void ComputeHostAoSToSoA(void *const fieldArrays[], const void *records, const ComputeStructLayout *layout, size_t numRecords)
+{
+    HostTransposeTask task = { (uint8_t*)records, (uint8_t *const*)fieldArrays, layout, { 0 }, numRecords, true };
+    HostTranspose(&task);
+}
+
+void ComputeHostSoAToAoS(void *records, const void *const fieldArrays[], const ComputeStructLayout *layout, size_t numRecords)
+{
+    HostTransposeTask task = { records, (uint8_t *const*)fieldArrays, layout, { 0 }, numRecords, false };
+    HostTranspose(&task);
+}
@@ -0,0 +1,51 @@
+#ifndef HOST_COPY_H
+#define HOST_COPY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "thread_pool.h"
+#include "typed_buffer.h"
+
+// The copies of at least this many bytes are split over the thread pool, if there is one
+#define COMPUTE_HOST_COPY_PARALLEL_THRESHOLD    (4 * 1024 * 1024)
+
+// The copies shorter than this use memcpy, the streaming stores only pay off for large copies
+#define COMPUTE_HOST_COPY_STREAMING_THRESHOLD   (16 * 1024)
+
+typedef enum ComputeHostCopyKernel
+{
+    // memcpy
+    COMPUTE_HOST_COPY_KERNEL_SCALAR,
+    // Non-temporal stores of 16, 32 and 64 bytes
+    COMPUTE_HOST_COPY_KERNEL_SSE2,
+    COMPUTE_HOST_COPY_KERNEL_AVX2,
+    COMPUTE_HOST_COPY_KERNEL_AVX512
+} ComputeHostCopyKernel;
+
+// The widest kernel the CPU supports, detected when the first copy is made
+extern ComputeHostCopyKernel ComputeHostCopyGetBestKernel(void);
+
+// Force a kernel, or go back to the best one with ComputeHostCopyGetBestKernel().
+// A kernel the CPU does not support is replaced by the best one. Returns the kernel in use.
+extern ComputeHostCopyKernel ComputeHostCopySetKernel(ComputeHostCopyKernel kernel);
+
+extern const char* ComputeHostCopyGetKernelName(ComputeHostCopyKernel kernel);
+
+// Let the large copies run on the threads of the pool, or only on the calling thread with NULL.
+// The pool must outlive the copies.
+extern void ComputeHostCopySetThreadPool(ThreadPool *pool);
+
+// Copy to memory that the CPU is not going to read back, typically the write-combined memory of an upload heap.
+// Large copies bypass the caches with non-temporal stores, which are fenced before the function returns.
+extern void ComputeHostCopy(void *dst, const void *src, size_t size);
+
+// Split the records into one array per field of the layout, fieldArrays[i] receiving the field i of each record in turn.
+// Each array is written sequentially, so they may be in upload memory. Large transpositions are split over the thread pool.
+extern void ComputeHostAoSToSoA(void *const fieldArrays[], const void *records, const ComputeStructLayout *layout, size_t numRecords);
+
+// Gather the fields of the records back from their arrays
+extern void ComputeHostSoAToAoS(void *records, const void *const fieldArrays[], const ComputeStructLayout *layout, size_t numRecords);
+
+#endif // HOST_COPY_H
@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_primitives.h"
+
+#define HOST_RADIX_SIZE     (1 << COMPUTE_HOST_RADIX_BITS)
+
+// The maximum number of chunks of a primitive
+#define HOST_PRIMITIVES_MAX_CHUNKS  64
+
+typedef struct HostPrimitiveTask
+{
+    const uint32_t *src;
+    const uint32_t *flags;
+    uint32_t *dst;
+    const uint32_t *srcValues;
+    uint32_t *dstValues;
+    size_t count;
+    size_t chunkSize;
+    // The result of each chunk, then the combined result of the chunks before it
+    uint64_t chunkResults[HOST_PRIMITIVES_MAX_CHUNKS];
+    // The radix sort pass: the first bit of the digit, and the digit counts, then the output positions, of each chunk
+    uint32_t shift;
+    size_t (*histograms)[HOST_RADIX_SIZE];
+} HostPrimitiveTask;
+
+// Split the input into one chunk per thread of the pool, or a single chunk when it is small
+static size_t GetNumChunks(ThreadPool *pool, size_t count, size_t *pChunkSize)
+{
+    size_t numChunks = 1;
+    if (pool != NULL && count >= COMPUTE_HOST_PRIMITIVES_PARALLEL_THRESHOLD)
+    {
+        numChunks = ThreadPoolGetThreadCount(pool);
+        if (numChunks > HOST_PRIMITIVES_MAX_CHUNKS)
+            numChunks = HOST_PRIMITIVES_MAX_CHUNKS;
+    }
+
+    *pChunkSize = (count + numChunks - 1) / numChunks;
+    return numChunks;
+}
+
+static void RunChunks(ThreadPool *pool, size_t numChunks, ThreadPoolTaskFunc func, HostPrimitiveTask *task)
+{
+    if (pool != NULL && numChunks > 1)
+        ThreadPoolParallelFor(pool, numChunks, 1, func, task);
+    else
+        func(task, 0, numChunks);
+}
+
+// The elements [*pBegin, *pEnd) of a chunk
+static void GetChunk(const HostPrimitiveTask *task, size_t chunk, size_t *pBegin, size_t *pEnd)
+{
+    const size_t begin = chunk * task->chunkSize;
+    *pBegin = begin < task->count ? begin : task->count;
+    *pEnd = task->count - *pBegin > task->chunkSize ? *pBegin + task->chunkSize : task->count;
+}
+
+// Replace the chunk results by the sum of the results before them, and return the sum of all of them
+static uint64_t ScanChunkResults(HostPrimitiveTask *task, size_t numChunks)
+{
+    uint64_t sum = 0;
+    for (size_t chunk = 0; chunk < numChunks; chunk++)
+    {
+        const uint64_t result = task->chunkResults[chunk];
+        task->chunkResults[chunk] = sum;
+        sum += result;
+    }
+    return sum;
+}
+
+static void ReduceChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        // Plain loop, which the compiler vectorizes
+        uint32_t sum = 0;
+        for (size_t i = first; i < last; i++)
+            sum += task->src[i];
+        task->chunkResults[chunk] = sum;
+    }
+}
+
+uint32_t ComputeHostReduce(ThreadPool *pool, const uint32_t *src, size_t count)
+{
+    HostPrimitiveTask task = { .src = src, .count = count };
+    const size_t numChunks = GetNumChunks(pool, count, &task.chunkSize);
+
+    RunChunks(pool, numChunks, ReduceChunks, &task);
+    return (uint32_t)ScanChunkResults(&task, numChunks);
+}
+
+static void ScanChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        uint32_t sum = (uint32_t)task->chunkResults[chunk];
+        for (size_t i = first; i < last; i++)
+        {
+            const uint32_t value = task->src[i];
+            task->dst[i] = sum;
+            sum += value;
+        }
+    }
+}
+
+uint32_t ComputeHostScan(ThreadPool *pool, const uint32_t *src, uint32_t *dst, size_t count)
+{
+    HostPrimitiveTask task = { .src = src, .dst = dst, .count = count };
+    const size_t numChunks = GetNumChunks(pool, count, &task.chunkSize);
+
+    RunChunks(pool, numChunks, ReduceChunks, &task);
+    const uint32_t total = (uint32_t)ScanChunkResults(&task, numChunks);
+    RunChunks(pool, numChunks, ScanChunks, &task);
+    return total;
+}
+
+static void CountFlagChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        size_t numFlags = 0;
+        for (size_t i = first; i < last; i++)
+            numFlags += task->flags[i] != 0;
+        task->chunkResults[chunk] = numFlags;
+    }
+}
+
+static void CompactChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        uint32_t *dst = task->dst + task->chunkResults[chunk];
+        for (size_t i = first; i < last; i++)
+        {
+            if (task->flags[i] != 0)
+                *dst++ = task->src[i];
+        }
+    }
+}
+
+size_t ComputeHostCompact(ThreadPool *pool, const uint32_t *src, const uint32_t *flags, uint32_t *dst, size_t count)
+{
+    HostPrimitiveTask task = { .src = src, .flags = flags, .dst = dst, .count = count };
+    const size_t numChunks = GetNumChunks(pool, count, &task.chunkSize);
+
+    RunChunks(pool, numChunks, CountFlagChunks, &task);
+    const size_t numFlags = (size_t)ScanChunkResults(&task, numChunks);
+    RunChunks(pool, numChunks, CompactChunks, &task);
+    return numFlags;
+}
+
+static void HistogramChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        size_t *histogram = task->histograms[chunk];
+        memset(histogram, 0, HOST_RADIX_SIZE * sizeof(size_t));
+        for (size_t i = first; i < last; i++)
+            histogram[(task->src[i] >> task->shift) & (HOST_RADIX_SIZE - 1)]++;
+    }
+}
+
+// Each chunk moves its elements in order, after those of the chunks before it, so the sort is stable.
+static void RadixScatterChunks(void *context, size_t begin, size_t end)
+{
+    HostPrimitiveTask *task = context;
+
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+        size_t first, last;
+        GetChunk(task, chunk, &first, &last);
+
+        size_t *positions = task->histograms[chunk];
+        for (size_t i = first; i < last; i++)
+        {
+            const size_t position = positions[(task->src[i] >> task->shift) & (HOST_RADIX_SIZE - 1)]++;
+            task->dst[position] = task->src[i];
+            if (task->dstValues != NULL)
+                task->dstValues[position] = task->srcValues[i];
+        }
+    }
+}
+
+bool ComputeHostSort(ThreadPool *pool, uint32_t *keys, uint32_t *values, size_t count, uint32_t numBits)
+{
+    HostPrimitiveTask task = { .src = keys, .srcValues = values, .count = count };
+    const size_t numChunks = GetNumChunks(pool, count, &task.chunkSize);
+
+    // The passes alternate between the arrays and temporary ones.
+    uint32_t *tmpKeys = malloc(count * sizeof(uint32_t) + 1);
+    uint32_t *tmpValues = values != NULL ? malloc(count * sizeof(uint32_t) + 1) : NULL;
+    task.histograms = malloc(numChunks * sizeof(*task.histograms));
+    if (tmpKeys == NULL || (values != NULL && tmpValues == NULL) || task.histograms == NULL)
+    {
+        free(tmpKeys);
+        free(tmpValues);
+        free(task.histograms);
+        return false;
+    }
+
+    task.dst = tmpKeys;
+    task.dstValues = tmpValues;
+
+    const uint32_t numPasses = (numBits + COMPUTE_HOST_RADIX_BITS - 1) / COMPUTE_HOST_RADIX_BITS;
+    for (uint32_t pass = 0; pass < numPasses; pass++)
+    {
+        task.shift = pass * COMPUTE_HOST_RADIX_BITS;
+        RunChunks(pool, numChunks, HistogramChunks, &task);
+
+        // The output position of each digit of each chunk, digit-major
+        size_t position = 0;
+        for (uint32_t digit = 0; digit < HOST_RADIX_SIZE; digit++)
+        {
+            for (size_t chunk = 0; chunk < numChunks; chunk++)
+            {
+                const size_t digitCount = task.histograms[chunk][digit];
+                task.histograms[chunk][digit] = position;
+                position += digitCount;
+            }
+        }
+
+        RunChunks(pool, numChunks, RadixScatterChunks, &task);
+
+        uint32_t *swapKeys = (uint32_t*)task.src;
+        task.src = task.dst;
+        task.dst = swapKeys;
+        uint32_t *swapValues = (uint32_t*)task.srcValues;
+        task.srcValues = task.dstValues;
+        task.dstValues = swapValues;
+    }
+
+    // After an odd number of passes, the result is in the temporary arrays.
+    if (task.src != keys)
+    {
+        memcpy(keys, task.src, count * sizeof(uint32_t));
+        if (values != NULL)
+            memcpy(values, task.srcValues, count * sizeof(uint32_t));
+    }
+
+    free(tmpKeys);
+    free(tmpValues);
+    free(task.histograms);
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_PRIMITIVES_H
+#define HOST_PRIMITIVES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "thread_pool.h"
+
+// The inputs shorter than this are processed on the calling thread
+#define COMPUTE_HOST_PRIMITIVES_PARALLEL_THRESHOLD  (64 * 1024)
+
+// The number of key bits sorted per pass of the host radix sort
+#define COMPUTE_HOST_RADIX_BITS     8
+
+// The primitives of compute_primitives.h on the host, the reference the device results are checked against.
+// The input is split into one chunk per thread of the pool: each chunk is reduced, the chunk results are combined
+// on the calling thread, then each chunk is processed again with the result of the chunks before it.
+// pool may be NULL to run everything on the calling thread.
+
+// Returns src[0] + ... + src[count - 1]
+extern uint32_t ComputeHostReduce(ThreadPool *pool, const uint32_t *src, size_t count);
+
+// dst[i] = src[0] + ... + src[i - 1]. src and dst may be the same array. Returns the sum of all the elements.
+extern uint32_t ComputeHostScan(ThreadPool *pool, const uint32_t *src, uint32_t *dst, size_t count);
+
+// Move the elements src[i] with flags[i] != 0 to the start of dst, in order. Returns their number.
+extern size_t ComputeHostCompact(ThreadPool *pool, const uint32_t *src, const uint32_t *flags, uint32_t *dst, size_t count);
+
+// Stable sort of the keys by their numBits low bits, the bits above them being zero, with the values moved along if not NULL.
+// Returns false if the temporary arrays cannot be allocated.
+extern bool ComputeHostSort(ThreadPool *pool, uint32_t *keys, uint32_t *values, size_t count, uint32_t numBits);
+
+#endif // HOST_PRIMITIVES_H
@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "job_graph.h"
+#include "compute_utils.h"
+
+static inline bool IsWriteState(ComputeResourceStates state)
+{
+    return (state & (COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS | COMPUTE_RESOURCE_STATE_COPY_DEST)) != 0;
+}
+
+static ComputeJobBuffer* FindJobBuffer(ComputeJobGraph *graph, const ComputeResource *resource)
+{
+    for (uint32_t i = 0; i < graph->numBuffers; i++)
+    {
+        if (graph->buffers[i].resource == resource)
+            return &graph->buffers[i];
+    }
+    return NULL;
+}
+
+void ComputeJobGraphInit(ComputeJobGraph *graph)
+{
+    memset(graph, 0, sizeof(*graph));
+}
+
+void ComputeJobGraphDestroy(ComputeJobGraph *graph)
+{
+    if (graph->fenceValue != 0)
+        ComputeTimelineWait(graph->timeline, graph->fenceValue, COMPUTE_WAIT_INFINITE);
+
+    if (graph->commandList != NULL)
+        graph->commandList->lpVtbl->Release(graph->commandList);
+    if (graph->allocator != NULL)
+        graph->allocator->lpVtbl->Release(graph->allocator);
+
+    free(graph->nodes);
+    free(graph->buffers);
+    memset(graph, 0, sizeof(*graph));
+}
+
+bool ComputeJobGraphAddBuffer(ComputeJobGraph *graph, ComputeResource *resource, ComputeResourceStates restingState)
+{
+    if (graph->commandList != NULL || resource == NULL || FindJobBuffer(graph, resource) != NULL)
+    {
+        puts("Invalid job graph buffer!");
+        return false;
+    }
+
+    if (graph->numBuffers == graph->bufferCapacity)
+    {
+        const uint32_t capacity = graph->bufferCapacity > 0 ? graph->bufferCapacity * 2 : 8;
+        ComputeJobBuffer *buffers = realloc(graph->buffers, capacity * sizeof(*buffers));
+        if (buffers == NULL)
+            return false;
+        graph->buffers = buffers;
+        graph->bufferCapacity = capacity;
+    }
+
+    ComputeJobBuffer *buffer = &graph->buffers[graph->numBuffers++];
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->resource = resource;
+    buffer->restingState = restingState;
+    return true;
+}
+
+// Place the node on the first level after all the nodes it depends on, and append it
+static bool AddJobNode(ComputeJobGraph *graph, ComputeJobNode *node)
+{
+    if (graph->commandList != NULL)
+    {
+        puts("The job graph has already been compiled!");
+        return false;
+    }
+
+    // The writer and reader levels of the buffers are stored plus one, 0 meaning none.
+    uint32_t level = 0;
+    for (uint32_t i = 0; i < node->numAccesses; i++)
+    {
+        const ComputeJobBuffer *buffer = FindJobBuffer(graph, node->accesses[i].Resource);
+        if (buffer == NULL)
+        {
+            puts("A job graph node accesses an undeclared buffer!");
+            return false;
+        }
+
+        if (buffer->writerLevel > level)
+            level = buffer->writerLevel;
+        if (IsWriteState(node->accesses[i].State) && buffer->readerLevel > level)
+            level = buffer->readerLevel;
+    }
+
+    if (graph->numNodes == graph->nodeCapacity)
+    {
+        const uint32_t capacity = graph->nodeCapacity > 0 ? graph->nodeCapacity * 2 : 8;
+        ComputeJobNode *nodes = realloc(graph->nodes, capacity * sizeof(*nodes));
+        if (nodes == NULL)
+            return false;
+        graph->nodes = nodes;
+        graph->nodeCapacity = capacity;
+    }
+
+    for (uint32_t i = 0; i < node->numAccesses; i++)
+    {
+        ComputeJobBuffer *buffer = FindJobBuffer(graph, node->accesses[i].Resource);
+        if (IsWriteState(node->accesses[i].State))
+            buffer->writerLevel = level + 1;
+        else if (buffer->readerLevel < level + 1)
+            buffer->readerLevel = level + 1;
+    }
+
+    node->level = level;
+    if (graph->numLevels < level + 1)
+        graph->numLevels = level + 1;
+
+    graph->nodes[graph->numNodes++] = *node;
+    return true;
+}
+
+bool ComputeJobGraphAddKernel(ComputeJobGraph *graph, const ComputeJobKernelDesc *pDesc)
+{
+    if (pDesc->NumDescriptorTables > COMPUTE_JOB_MAX_TABLES || pDesc->NumRootDescriptors > COMPUTE_JOB_MAX_ROOT_DESCRIPTORS ||
+        pDesc->NumAccesses > COMPUTE_JOB_MAX_ACCESSES ||
+        pDesc->PipelineState == NULL || pDesc->RootSignature == NULL)
+    {
+        puts("Invalid job graph kernel!");
+        return false;
+    }
+
+    ComputeJobNode node;
+    memset(&node, 0, sizeof(node));
+    node.type = COMPUTE_JOB_NODE_KERNEL;
+    node.kernel = *pDesc;
+    // A kernel may bind its buffers through the tables, the root descriptors or both.
+    if (pDesc->NumDescriptorTables > 0)
+        memcpy(node.tables, pDesc->pDescriptorTables, pDesc->NumDescriptorTables * sizeof(*node.tables));
+    if (pDesc->NumRootDescriptors > 0)
+        memcpy(node.rootDescriptors, pDesc->pRootDescriptors, pDesc->NumRootDescriptors * sizeof(*node.rootDescriptors));
+    memcpy(node.accesses, pDesc->pAccesses, pDesc->NumAccesses * sizeof(*node.accesses));
+    node.numAccesses = pDesc->NumAccesses;
+    // The arrays of the description are not kept.
+    node.kernel.pDescriptorTables = NULL;
+    node.kernel.pRootDescriptors = NULL;
+    node.kernel.pAccesses = NULL;
+
+    return AddJobNode(graph, &node);
+}
+
+bool ComputeJobGraphAddCopy(ComputeJobGraph *graph, const ComputeJobCopyDesc *pDesc)
+{
+    ComputeJobNode node;
+    memset(&node, 0, sizeof(node));
+    node.type = COMPUTE_JOB_NODE_COPY;
+    node.copy = *pDesc;
+    node.accesses[0].Resource = pDesc->SrcBuffer;
+    node.accesses[0].State = COMPUTE_RESOURCE_STATE_COPY_SOURCE;
+    node.accesses[1].Resource = pDesc->DstBuffer;
+    node.accesses[1].State = COMPUTE_RESOURCE_STATE_COPY_DEST;
+    node.numAccesses = 2;
+
+    return AddJobNode(graph, &node);
+}
+
+// Gather the barriers from the current states of the buffers to the states required by the nodes of the level
+static uint32_t GetLevelBarriers(ComputeJobGraph *graph, uint32_t level, ComputeResourceStates *requiredStates,
+    ComputeResourceBarrier *barriers)
+{
+    memset(requiredStates, 0, graph->numBuffers * sizeof(*requiredStates));
+
+    for (uint32_t i = 0; i < graph->numNodes; i++)
+    {
+        const ComputeJobNode *node = &graph->nodes[i];
+        if (node->level != level)
+            continue;
+
+        for (uint32_t j = 0; j < node->numAccesses; j++)
+        {
+            const ComputeJobBuffer *buffer = FindJobBuffer(graph, node->accesses[j].Resource);
+            requiredStates[buffer - graph->buffers] |= node->accesses[j].State;
+        }
+    }
+
+    uint32_t numBarriers = 0;
+    for (uint32_t i = 0; i < graph->numBuffers; i++)
+    {
+        ComputeJobBuffer *buffer = &graph->buffers[i];
+        const ComputeResourceStates required = requiredStates[i];
+        if (required == COMPUTE_RESOURCE_STATE_COMMON)
+            continue;
+
+        ComputeResourceBarrier *barrier = &barriers[numBarriers];
+        barrier->Flags = COMPUTE_RESOURCE_BARRIER_FLAG_NONE;
+        barrier->pResource = buffer->resource;
+        barrier->StateBefore = buffer->state;
+        barrier->StateAfter = required;
+        barrier->pResourceBefore = NULL;
+
+        // A read state that is already included needs nothing, which also spares the upload heaps a transition.
+        const bool included = !IsWriteState(required) && !IsWriteState(buffer->state) &&
+            buffer->state != COMPUTE_RESOURCE_STATE_COMMON && (buffer->state & required) == required;
+
+        if (required != buffer->state && !included)
+        {
+            barrier->Type = COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION;
+            buffer->state = required;
+            numBarriers++;
+        }
+        else if (required == COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS && buffer->uavWritten)
+        {
+            // The previous level that touched the buffer wrote it as a UAV too.
+            barrier->Type = COMPUTE_RESOURCE_BARRIER_TYPE_UAV;
+            numBarriers++;
+        }
+
+        buffer->uavWritten = required == COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS;
+    }
+
+    return numBarriers;
+}
+
+static void RecordJobNodes(ComputeJobGraph *graph, uint32_t level, ComputeRootSignature **ppRootSignature,
+    ComputePipelineState **ppPipelineState, ComputeDescriptorHeap **ppHeap)
+{
+    ComputeCommandList *commandList = graph->commandList;
+
+    for (uint32_t i = 0; i < graph->numNodes; i++)
+    {
+        const ComputeJobNode *node = &graph->nodes[i];
+        if (node->level != level)
+            continue;
+
+        if (node->type == COMPUTE_JOB_NODE_COPY)
+        {
+            commandList->lpVtbl->CopyBufferRegion(commandList, node->copy.DstBuffer, node->copy.DstOffset,
+                node->copy.SrcBuffer, node->copy.SrcOffset, node->copy.NumBytes);
+            continue;
+        }
+
+        // Only the bindings that change between consecutive kernels are recorded again.
+        const ComputeJobKernelDesc *kernel = &node->kernel;
+        if (kernel->PipelineState != *ppPipelineState)
+        {
+            commandList->lpVtbl->SetPipelineState(commandList, kernel->PipelineState);
+            *ppPipelineState = kernel->PipelineState;
+        }
+        if (kernel->DescriptorHeap != NULL && kernel->DescriptorHeap != *ppHeap)
+        {
+            ComputeDescriptorHeap *ppHeaps[] = { kernel->DescriptorHeap };
+            commandList->lpVtbl->SetDescriptorHeaps(commandList, 1, ppHeaps);
+            *ppHeap = kernel->DescriptorHeap;
+        }
+        if (kernel->RootSignature != *ppRootSignature)
+        {
+            commandList->lpVtbl->SetComputeRootSignature(commandList, kernel->RootSignature);
+            *ppRootSignature = kernel->RootSignature;
+        }
+
+        for (uint32_t j = 0; j < kernel->NumDescriptorTables; j++)
+            commandList->lpVtbl->SetComputeRootDescriptorTable(commandList, node->tables[j].RootParameterIndex,
+                node->tables[j].BaseDescriptor);
+        for (uint32_t j = 0; j < kernel->NumRootDescriptors; j++)
+        {
+            const ComputeJobRootDescriptor *descriptor = &node->rootDescriptors[j];
+            if (descriptor->Type == COMPUTE_ROOT_PARAMETER_TYPE_SRV)
+                commandList->lpVtbl->SetComputeRootShaderResourceView(commandList, descriptor->RootParameterIndex,
+                    descriptor->BufferLocation);
+            else
+                commandList->lpVtbl->SetComputeRootUnorderedAccessView(commandList, descriptor->RootParameterIndex,
+                    descriptor->BufferLocation);
+        }
+
+        ComputeDispatchElements(commandList, kernel->ConstantsRootParameter, kernel->NumElements, kernel->ElementsPerGroup);
+    }
+}
+
+bool ComputeJobGraphCompile(ComputeJobGraph *graph, ComputeDevice *device, ComputeCommandListType type)
+{
+    if (graph->commandList != NULL || graph->numNodes == 0)
+    {
+        puts("The job graph cannot be compiled!");
+        return false;
+    }
+
+    graph->allocator = device->lpVtbl->CreateCommandAllocator(device, type);
+    if (graph->allocator == NULL)
+        return false;
+
+    // Command lists are created in the recording state.
+    graph->commandList = device->lpVtbl->CreateCommandList(device, type, graph->allocator, NULL);
+    if (graph->commandList == NULL)
+        return false;
+
+    // At most one barrier per buffer and level, or to return to the resting state
+    ComputeResourceStates *requiredStates = malloc(graph->numBuffers * sizeof(*requiredStates));
+    ComputeResourceBarrier *barriers = malloc(graph->numBuffers * sizeof(*barriers));
+    if (requiredStates == NULL || barriers == NULL)
+    {
+        free(requiredStates);
+        free(barriers);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < graph->numBuffers; i++)
+    {
+        graph->buffers[i].state = graph->buffers[i].restingState;
+        graph->buffers[i].uavWritten = false;
+    }
+
+    ComputeRootSignature *rootSignature = NULL;
+    ComputePipelineState *pipelineState = NULL;
+    ComputeDescriptorHeap *heap = NULL;
+    ComputeCommandList *commandList = graph->commandList;
+
+    for (uint32_t level = 0; level < graph->numLevels; level++)
+    {
+        const uint32_t numBarriers = GetLevelBarriers(graph, level, requiredStates, barriers);
+        if (numBarriers > 0)
+            commandList->lpVtbl->ResourceBarrier(commandList, numBarriers, barriers);
+
+        RecordJobNodes(graph, level, &rootSignature, &pipelineState, &heap);
+    }
+
+    uint32_t numBarriers = 0;
+    for (uint32_t i = 0; i < graph->numBuffers; i++)
+    {
+        ComputeJobBuffer *buffer = &graph->buffers[i];
+        if (buffer->state == buffer->restingState)
+            continue;
+
+        const ComputeResourceBarrier barrier = { COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE,
+            buffer->resource, buffer->state, buffer->restingState, NULL };
+        barriers[numBarriers++] = barrier;
+        buffer->state = buffer->restingState;
+    }
+    if (numBarriers > 0)
+        commandList->lpVtbl->ResourceBarrier(commandList, numBarriers, barriers);
+
+    free(requiredStates);
+    free(barriers);
+
+    return commandList->lpVtbl->Close(commandList);
+}
+
+uint64_t ComputeJobGraphExecute(ComputeJobGraph *graph, ComputeTimeline *timeline)
+{
+    if (graph->commandList == NULL)
+    {
+        puts("The job graph has not been compiled!");
+        return 0;
+    }
+
+    // A command list cannot be executed again while it is in flight.
+    if (graph->fenceValue != 0 && !ComputeTimelineWait(graph->timeline, graph->fenceValue, COMPUTE_WAIT_INFINITE))
+        return 0;
+
+    ComputeCommandQueue *queue = timeline->queue;
+    queue->lpVtbl->ExecuteCommandLists(queue, 1, &graph->commandList);
+
+    const uint64_t value = ComputeTimelineSignal(timeline);
+    if (value == 0)
+        return 0;
+
+    graph->timeline = timeline;
+    graph->fenceValue = value;
+    return value;
+}
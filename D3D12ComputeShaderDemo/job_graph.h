@@ -0,0 +1,141 @@
+#ifndef JOB_GRAPH_H
+#define JOB_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+
+// The limits of one kernel node
+#define COMPUTE_JOB_MAX_TABLES      4
+#define COMPUTE_JOB_MAX_ROOT_DESCRIPTORS    4
+#define COMPUTE_JOB_MAX_ACCESSES    8
+
+// How a node accesses a buffer. Writes are the unordered access and copy destination states,
+// every other state is a read.
+typedef struct ComputeJobAccess
+{
+    ComputeResource *Resource;
+    ComputeResourceStates State;
+} ComputeJobAccess;
+
+typedef struct ComputeJobDescriptorTable
+{
+    uint32_t RootParameterIndex;
+    ComputeGPUDescriptorHandle BaseDescriptor;
+} ComputeJobDescriptorTable;
+
+// A buffer bound to a root SRV or UAV, Type being COMPUTE_ROOT_PARAMETER_TYPE_SRV or COMPUTE_ROOT_PARAMETER_TYPE_UAV
+typedef struct ComputeJobRootDescriptor
+{
+    uint32_t RootParameterIndex;
+    ComputeRootParameterType Type;
+    ComputeGPUVirtualAddress BufferLocation;
+} ComputeJobRootDescriptor;
+
+// A kernel dispatched over NumElements elements by ComputeDispatchElements
+typedef struct ComputeJobKernelDesc
+{
+    ComputePipelineState *PipelineState;
+    ComputeRootSignature *RootSignature;
+    ComputeDescriptorHeap *DescriptorHeap;
+    uint32_t NumDescriptorTables;
+    const ComputeJobDescriptorTable *pDescriptorTables;
+    uint32_t NumRootDescriptors;
+    const ComputeJobRootDescriptor *pRootDescriptors;
+    // The root parameter of the dispatch constants
+    uint32_t ConstantsRootParameter;
+    uint32_t NumElements;
+    uint32_t ElementsPerGroup;
+    // The buffers the kernel reads and writes through its descriptor tables and root descriptors
+    uint32_t NumAccesses;
+    const ComputeJobAccess *pAccesses;
+} ComputeJobKernelDesc;
+
+// A copy between two buffers, reading the source in the copy source state and writing the destination
+// in the copy destination state
+typedef struct ComputeJobCopyDesc
+{
+    ComputeResource *DstBuffer;
+    uint64_t DstOffset;
+    ComputeResource *SrcBuffer;
+    uint64_t SrcOffset;
+    uint64_t NumBytes;
+} ComputeJobCopyDesc;
+
+typedef enum ComputeJobNodeType
+{
+    COMPUTE_JOB_NODE_KERNEL,
+    COMPUTE_JOB_NODE_COPY
+} ComputeJobNodeType;
+
+typedef struct ComputeJobNode
+{
+    ComputeJobNodeType type;
+    ComputeJobKernelDesc kernel;
+    ComputeJobDescriptorTable tables[COMPUTE_JOB_MAX_TABLES];
+    ComputeJobRootDescriptor rootDescriptors[COMPUTE_JOB_MAX_ROOT_DESCRIPTORS];
+    ComputeJobCopyDesc copy;
+    ComputeJobAccess accesses[COMPUTE_JOB_MAX_ACCESSES];
+    uint32_t numAccesses;
+    // The nodes of a level only depend on the nodes of the levels before it
+    uint32_t level;
+} ComputeJobNode;
+
+// A buffer of the graph. The graph starts from and returns to its resting state,
+// so the compiled command list can be executed again as is.
+typedef struct ComputeJobBuffer
+{
+    ComputeResource *resource;
+    ComputeResourceStates restingState;
+    // Used while compiling: the state of the buffer, and the levels of its last writer and its last readers
+    ComputeResourceStates state;
+    bool uavWritten;
+    uint32_t writerLevel;
+    uint32_t readerLevel;
+} ComputeJobBuffer;
+
+// A declarative batch of kernels and copies. The dependencies between the nodes follow from the order they are added in
+// and the buffers they access: a node runs after the last writer of every buffer it accesses,
+// and a write runs after the readers of the previous content.
+// Compile records the whole graph once into a command list, with the nodes grouped by dependency level:
+// the nodes of a level only need one batch of barriers before them. The compiled list can then be executed
+// any number of times, typically after new inputs have been written to its buffers, without being recorded again.
+typedef struct ComputeJobGraph
+{
+    ComputeJobNode *nodes;
+    uint32_t numNodes;
+    uint32_t nodeCapacity;
+    ComputeJobBuffer *buffers;
+    uint32_t numBuffers;
+    uint32_t bufferCapacity;
+    uint32_t numLevels;
+    // The compiled command list
+    ComputeCommandAllocator *allocator;
+    ComputeCommandList *commandList;
+    // The timeline and the value of the last execution, which has to complete before the list is executed again
+    ComputeTimeline *timeline;
+    uint64_t fenceValue;
+} ComputeJobGraph;
+
+extern void ComputeJobGraphInit(ComputeJobGraph *graph);
+// Waits for the last execution before releasing the command list
+extern void ComputeJobGraphDestroy(ComputeJobGraph *graph);
+
+// Declare a buffer used by the nodes, and the state it is in before and after each execution
+extern bool ComputeJobGraphAddBuffer(ComputeJobGraph *graph, ComputeResource *resource, ComputeResourceStates restingState);
+
+extern bool ComputeJobGraphAddKernel(ComputeJobGraph *graph, const ComputeJobKernelDesc *pDesc);
+extern bool ComputeJobGraphAddCopy(ComputeJobGraph *graph, const ComputeJobCopyDesc *pDesc);
+
+// Record the command list of the graph. No node can be added afterwards.
+extern bool ComputeJobGraphCompile(ComputeJobGraph *graph, ComputeDevice *device, ComputeCommandListType type);
+
+// Execute the compiled command list on the queue of the timeline and signal it.
+// If the previous execution is still in flight, the call waits for it first.
+// Returns the fence value that marks the completion of the execution, or 0 on failure.
+extern uint64_t ComputeJobGraphExecute(ComputeJobGraph *graph, ComputeTimeline *timeline);
+
+#endif // JOB_GRAPH_H
@@ -0,0 +1,783 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel_fusion.h"
+#include "compute_utils.h"
+
+// The size of the generated sources: a comment and a statement of a few dozen characters per node
+#define FUSED_MAX_SOURCE_SIZE   16384
+// The number of elements evaluated node by node on the host
+#define FUSED_EVALUATE_BLOCK    64
+
+static const char* const s_typeNames[] = { "int", "uint", "float" };
+
+// The number of operands of each ComputeFusedOp
+static const uint32_t s_numOperands[COMPUTE_FUSED_OP_COUNT] = { 0, 0, 2, 2, 2, 2, 2, 3, 1 };
+
+// ---- Expressions ----
+
+static ComputeFusedValue AddNode(ComputeFusedExpression *expr, ComputeFusedOp op, ComputeElementType type,
+    uint32_t a, uint32_t b, uint32_t c, uint32_t value)
+{
+    if (expr->error)
+        return 0;
+    if (expr->numNodes == COMPUTE_FUSED_MAX_NODES)
+    {
+        puts("Too many nodes in the fused expression!");
+        expr->error = true;
+        return 0;
+    }
+
+    ComputeFusedNode *node = &expr->nodes[expr->numNodes];
+    node->Op = (uint8_t)op;
+    node->Type = (uint8_t)type;
+    node->Reserved = 0;
+    node->Operands[0] = a;
+    node->Operands[1] = b;
+    node->Operands[2] = c;
+    node->Value = value;
+    return expr->numNodes++;
+}
+
+static bool IsValue(const ComputeFusedExpression *expr, ComputeFusedValue value)
+{
+    return value < expr->numNodes;
+}
+
+// The operations other than the casts take operands of their own type.
+static ComputeFusedValue AddOperation(ComputeFusedExpression *expr, ComputeFusedOp op, ComputeFusedValue a, ComputeFusedValue b,
+    ComputeFusedValue c)
+{
+    if (expr->error)
+        return 0;
+
+    const uint32_t numOperands = s_numOperands[op];
+    const ComputeFusedValue operands[3] = { a, b, c };
+    for (uint32_t i = 0; i < numOperands; i++)
+    {
+        if (!IsValue(expr, operands[i]) || expr->nodes[operands[i]].Type != expr->nodes[a].Type)
+        {
+            puts("The operands of a fused operation are invalid or of different types!");
+            expr->error = true;
+            return 0;
+        }
+    }
+
+    return AddNode(expr, op, (ComputeElementType)expr->nodes[a].Type, a, numOperands > 1 ? b : 0, numOperands > 2 ? c : 0, 0);
+}
+
+void ComputeFusedExpressionInit(ComputeFusedExpression *expr)
+{
+    // The unused members are zero, so that the nodes compare and hash as bytes.
+    memset(expr, 0, sizeof(*expr));
+}
+
+ComputeFusedValue ComputeFusedInput(ComputeFusedExpression *expr, ComputeElementType type)
+{
+    if (expr->error)
+        return 0;
+    if (expr->numInputs == COMPUTE_FUSED_MAX_INPUTS || (uint32_t)type > COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        puts("Too many inputs in the fused expression, or an input of a type other than int, uint or float!");
+        expr->error = true;
+        return 0;
+    }
+
+    const ComputeFusedValue value = AddNode(expr, COMPUTE_FUSED_OP_INPUT, type, expr->numInputs, 0, 0, 0);
+    if (!expr->error)
+        expr->numInputs++;
+    return value;
+}
+
+ComputeFusedValue ComputeFusedConstantInt(ComputeFusedExpression *expr, int32_t value)
+{
+    return AddNode(expr, COMPUTE_FUSED_OP_CONSTANT, COMPUTE_ELEMENT_TYPE_INT, 0, 0, 0, (uint32_t)value);
+}
+
+ComputeFusedValue ComputeFusedConstantUint(ComputeFusedExpression *expr, uint32_t value)
+{
+    return AddNode(expr, COMPUTE_FUSED_OP_CONSTANT, COMPUTE_ELEMENT_TYPE_UINT, 0, 0, 0, value);
+}
+
+ComputeFusedValue ComputeFusedConstantFloat(ComputeFusedExpression *expr, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return AddNode(expr, COMPUTE_FUSED_OP_CONSTANT, COMPUTE_ELEMENT_TYPE_FLOAT, 0, 0, 0, bits);
+}
+
+ComputeFusedValue ComputeFusedAdd(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_ADD, a, b, 0);
+}
+
+ComputeFusedValue ComputeFusedSub(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_SUB, a, b, 0);
+}
+
+ComputeFusedValue ComputeFusedMul(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_MUL, a, b, 0);
+}
+
+ComputeFusedValue ComputeFusedMin(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_MIN, a, b, 0);
+}
+
+ComputeFusedValue ComputeFusedMax(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_MAX, a, b, 0);
+}
+
+ComputeFusedValue ComputeFusedClamp(ComputeFusedExpression *expr, ComputeFusedValue x, ComputeFusedValue low,
+    ComputeFusedValue high)
+{
+    return AddOperation(expr, COMPUTE_FUSED_OP_CLAMP, x, low, high);
+}
+
+ComputeFusedValue ComputeFusedCast(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeElementType type)
+{
+    if (expr->error)
+        return 0;
+    if (!IsValue(expr, a) || (uint32_t)type > COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        puts("Invalid fused cast!");
+        expr->error = true;
+        return 0;
+    }
+
+    return AddNode(expr, COMPUTE_FUSED_OP_CAST, type, a, 0, 0, 0);
+}
+
+void ComputeFusedOutput(ComputeFusedExpression *expr, ComputeFusedValue value)
+{
+    if (expr->error)
+        return;
+    if (expr->numOutputs == COMPUTE_FUSED_MAX_OUTPUTS || !IsValue(expr, value))
+    {
+        puts("Too many outputs in the fused expression, or an invalid output value!");
+        expr->error = true;
+        return;
+    }
+
+    expr->outputs[expr->numOutputs++] = value;
+}
+
+bool ComputeFusedExpressionValidate(const ComputeFusedExpression *expr)
+{
+    if (expr->error || expr->numNodes == 0 || expr->numNodes > COMPUTE_FUSED_MAX_NODES ||
+        expr->numOutputs == 0 || expr->numOutputs > COMPUTE_FUSED_MAX_OUTPUTS || expr->numInputs > COMPUTE_FUSED_MAX_INPUTS)
+        return false;
+
+    // The parsed expressions did not go through the builder, so the nodes are checked again.
+    uint32_t numInputs = 0;
+    for (uint32_t i = 0; i < expr->numNodes; i++)
+    {
+        const ComputeFusedNode *node = &expr->nodes[i];
+        if (node->Op >= COMPUTE_FUSED_OP_COUNT || node->Type > COMPUTE_ELEMENT_TYPE_FLOAT)
+            return false;
+
+        if (node->Op == COMPUTE_FUSED_OP_INPUT)
+        {
+            if (node->Operands[0] != numInputs++)
+                return false;
+        }
+        else if (node->Op == COMPUTE_FUSED_OP_CAST)
+        {
+            if (node->Operands[0] >= i)
+                return false;
+        }
+        else
+        {
+            for (uint32_t j = 0; j < s_numOperands[node->Op]; j++)
+            {
+                if (node->Operands[j] >= i || expr->nodes[node->Operands[j]].Type != node->Type)
+                    return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+    {
+        if (expr->outputs[i] >= expr->numNodes)
+            return false;
+    }
+
+    return numInputs == expr->numInputs;
+}
+
+static bool ExpressionsEqual(const ComputeFusedExpression *a, const ComputeFusedExpression *b)
+{
+    return a->numNodes == b->numNodes && a->numInputs == b->numInputs && a->numOutputs == b->numOutputs &&
+        memcmp(a->outputs, b->outputs, a->numOutputs * sizeof(a->outputs[0])) == 0 &&
+        memcmp(a->nodes, b->nodes, a->numNodes * sizeof(a->nodes[0])) == 0;
+}
+
+static uint64_t HashWords(uint64_t hash, const uint32_t *words, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        hash ^= words[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t ComputeFusedExpressionHash(const ComputeFusedExpression *expr)
+{
+    // The members are hashed one by one, the nodes have no padding.
+    const uint32_t counts[3] = { expr->numNodes, expr->numInputs, expr->numOutputs };
+    uint64_t hash = HashWords(14695981039346656037ULL, counts, 3);
+    hash = HashWords(hash, expr->outputs, expr->numOutputs);
+    for (uint32_t i = 0; i < expr->numNodes; i++)
+    {
+        const ComputeFusedNode *node = &expr->nodes[i];
+        const uint32_t words[5] = { (uint32_t)node->Op | (uint32_t)node->Type << 8, node->Operands[0], node->Operands[1],
+            node->Operands[2], node->Value };
+        hash = HashWords(hash, words, 5);
+    }
+    return hash;
+}
+
+// ---- HLSL generation ----
+
+// Appends to the source, recording an overflow in the length
+typedef struct SourceWriter
+{
+    char *pSource;
+    size_t size;
+    size_t length;
+    bool overflow;
+} SourceWriter;
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 2, 3)))
+#endif
+static void Append(SourceWriter *writer, const char *format, ...)
+{
+    if (writer->overflow)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(writer->pSource + writer->length, writer->size - writer->length, format, args);
+    va_end(args);
+
+    if (length < 0 || (size_t)length >= writer->size - writer->length)
+        writer->overflow = true;
+    else
+        writer->length += (size_t)length;
+}
+
+static void AppendStatement(SourceWriter *writer, const ComputeFusedExpression *expr, uint32_t index)
+{
+    static const char* const s_binaryOperators[] = { NULL, NULL, "+", "-", "*" };
+
+    const ComputeFusedNode *node = &expr->nodes[index];
+    const char *type = s_typeNames[node->Type];
+    const uint32_t *operands = node->Operands;
+
+    // The float values are precise, so that the compiler neither contracts a mul and an add into a mad
+    // nor reassociates: the host evaluation then matches the device bit for bit, denormals aside.
+    Append(writer, "    %sconst %s v%u = ", node->Type == COMPUTE_ELEMENT_TYPE_FLOAT ? "precise " : "", type, index);
+
+    switch (node->Op)
+    {
+    case COMPUTE_FUSED_OP_INPUT:
+        Append(writer, "input%u[index];\n", operands[0]);
+        break;
+    case COMPUTE_FUSED_OP_CONSTANT:
+        // The bit pattern, so that no float is rounded through its decimal form
+        if (node->Type == COMPUTE_ELEMENT_TYPE_UINT)
+            Append(writer, "0x%08xu;\n", node->Value);
+        else
+            Append(writer, "as%s(0x%08xu);\n", type, node->Value);
+        break;
+    case COMPUTE_FUSED_OP_ADD:
+    case COMPUTE_FUSED_OP_SUB:
+    case COMPUTE_FUSED_OP_MUL:
+        Append(writer, "v%u %s v%u;\n", operands[0], s_binaryOperators[node->Op], operands[1]);
+        break;
+    case COMPUTE_FUSED_OP_MIN:
+        Append(writer, "min(v%u, v%u);\n", operands[0], operands[1]);
+        break;
+    case COMPUTE_FUSED_OP_MAX:
+        Append(writer, "max(v%u, v%u);\n", operands[0], operands[1]);
+        break;
+    case COMPUTE_FUSED_OP_CLAMP:
+        Append(writer, "clamp(v%u, v%u, v%u);\n", operands[0], operands[1], operands[2]);
+        break;
+    case COMPUTE_FUSED_OP_CAST:
+        Append(writer, "(%s)v%u;\n", type, operands[0]);
+        break;
+    }
+}
+
+size_t ComputeFusedExpressionWriteHLSL(const ComputeFusedExpression *expr, char *pSource, size_t sourceSize)
+{
+    if (!ComputeFusedExpressionValidate(expr) || sourceSize == 0)
+        return 0;
+
+    SourceWriter writer = { pSource, sourceSize, 0, false };
+
+    Append(&writer, "// Generated by kernel_fusion.c, the expression being read back from the comments below.\n");
+    Append(&writer, "// fused %u %u %u\n", expr->numNodes, expr->numInputs, expr->numOutputs);
+    for (uint32_t i = 0; i < expr->numNodes; i++)
+    {
+        const ComputeFusedNode *node = &expr->nodes[i];
+        Append(&writer, "// node %u %u %u %u %u %08x\n", node->Op, node->Type,
+            node->Operands[0], node->Operands[1], node->Operands[2], node->Value);
+    }
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+        Append(&writer, "// output %u\n", expr->outputs[i]);
+    Append(&writer, "\n");
+
+    for (uint32_t i = 0; i < expr->numNodes; i++)
+    {
+        if (expr->nodes[i].Op == COMPUTE_FUSED_OP_INPUT)
+            Append(&writer, "StructuredBuffer<%s> input%u : register(t%u);\n", s_typeNames[expr->nodes[i].Type],
+                expr->nodes[i].Operands[0], expr->nodes[i].Operands[0]);
+    }
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+        Append(&writer, "RWStructuredBuffer<%s> output%u : register(u%u);\n", s_typeNames[expr->nodes[expr->outputs[i]].Type], i, i);
+
+    Append(&writer,
+        "\n"
+        "// Root constants set by ComputeDispatchElements for each Dispatch\n"
+        "cbuffer DispatchConstants : register(b0)\n"
+        "{\n"
+        "    uint NumElements;\n"
+        "    uint BaseGroup;\n"
+        "    uint GroupsPerRow;\n"
+        "};\n"
+        "\n"
+        "[numthreads(%u, 1, 1)]\n"
+        "void %s(uint3 groupID : SV_GroupID, uint3 localTID : SV_GroupThreadID)\n"
+        "{\n"
+        "    const uint index = (BaseGroup + groupID.y * GroupsPerRow + groupID.x) * %u + localTID.x;\n"
+        "    if (index >= NumElements)\n"
+        "        return;\n"
+        "\n",
+        COMPUTE_FUSED_GROUP_SIZE, COMPUTE_FUSED_ENTRY_POINT, COMPUTE_FUSED_GROUP_SIZE);
+
+    for (uint32_t i = 0; i < expr->numNodes; i++)
+        AppendStatement(&writer, expr, i);
+
+    Append(&writer, "\n");
+    for (uint32_t i = 0; i < expr->numOutputs; i++)
+        Append(&writer, "    output%u[index] = v%u;\n", i, expr->outputs[i]);
+    Append(&writer, "}\n");
+
+    return writer.overflow ? 0 : writer.length;
+}
+
+bool ComputeFusedExpressionParse(ComputeFusedExpression *expr, const char *pSource, size_t sourceSize)
+{
+    ComputeFusedExpressionInit(expr);
+
+    uint32_t numNodes = 0, numOutputs = 0;
+    bool header = false;
+
+    // The comments are at the beginning of the source, up to the first empty line.
+    size_t offset = 0;
+    while (offset < sourceSize)
+    {
+        char line[128];
+        size_t length = 0;
+        while (offset < sourceSize && pSource[offset] != '\n')
+        {
+            if (length + 1 < sizeof(line))
+                line[length++] = pSource[offset];
+            offset++;
+        }
+        offset++;
+        while (length > 0 && line[length - 1] == '\r')
+            length--;
+        line[length] = '\0';
+
+        if (length == 0)
+            break;
+
+        unsigned op, type, a, b, c, value;
+        if (sscanf(line, "// fused %u %u %u", &expr->numNodes, &expr->numInputs, &expr->numOutputs) == 3)
+        {
+            if (expr->numNodes > COMPUTE_FUSED_MAX_NODES || expr->numOutputs > COMPUTE_FUSED_MAX_OUTPUTS)
+                return false;
+            header = true;
+        }
+        else if (header && sscanf(line, "// node %u %u %u %u %u %x", &op, &type, &a, &b, &c, &value) == 6)
+        {
+            if (numNodes == expr->numNodes || op >= COMPUTE_FUSED_OP_COUNT || type > COMPUTE_ELEMENT_TYPE_FLOAT)
+                return false;
+            expr->nodes[numNodes++] = (ComputeFusedNode){ (uint8_t)op, (uint8_t)type, 0, { a, b, c }, value };
+        }
+        else if (header && sscanf(line, "// output %u", &a) == 1)
+        {
+            if (numOutputs == expr->numOutputs)
+                return false;
+            expr->outputs[numOutputs++] = a;
+        }
+    }
+
+    return header && numNodes == expr->numNodes && numOutputs == expr->numOutputs && ComputeFusedExpressionValidate(expr);
+}
+
+// ---- Host evaluation ----
+
+typedef union FusedScalar
+{
+    int32_t i;
+    uint32_t u;
+    float f;
+} FusedScalar;
+
+// The float to integer conversions of the device: truncated, saturated, and NaN is 0
+static int32_t FloatToInt(float value)
+{
+    if (value != value)
+        return 0;
+    if (value >= 2147483648.0f)
+        return INT32_MAX;
+    if (value <= -2147483648.0f)
+        return INT32_MIN;
+    return (int32_t)value;
+}
+
+static uint32_t FloatToUint(float value)
+{
+    if (!(value > 0.0f))
+        return 0;
+    if (value >= 4294967296.0f)
+        return UINT32_MAX;
+    return (uint32_t)value;
+}
+
+static void EvaluateCast(FusedScalar *dst, const FusedScalar *src, ComputeElementType dstType, ComputeElementType srcType,
+    size_t count)
+{
+    if (srcType == COMPUTE_ELEMENT_TYPE_FLOAT && dstType == COMPUTE_ELEMENT_TYPE_INT)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i].i = FloatToInt(src[i].f);
+    }
+    else if (srcType == COMPUTE_ELEMENT_TYPE_FLOAT && dstType == COMPUTE_ELEMENT_TYPE_UINT)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i].u = FloatToUint(src[i].f);
+    }
+    else if (srcType == COMPUTE_ELEMENT_TYPE_INT && dstType == COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i].f = (float)src[i].i;
+    }
+    else if (srcType == COMPUTE_ELEMENT_TYPE_UINT && dstType == COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i].f = (float)src[i].u;
+    }
+    else
+    {
+        // Between int and uint, or to the same type: the bits are kept.
+        memcpy(dst, src, count * sizeof(*dst));
+    }
+}
+
+// The integer additions, subtractions and multiplications produce the same bits for int and uint.
+static void EvaluateBinary(FusedScalar *dst, const FusedScalar *a, const FusedScalar *b, ComputeFusedOp op,
+    ComputeElementType type, size_t count)
+{
+    const bool isFloat = type == COMPUTE_ELEMENT_TYPE_FLOAT;
+    const bool isInt = type == COMPUTE_ELEMENT_TYPE_INT;
+
+    // One loop per case, the branches being outside of the loops so that they vectorize
+    switch (op)
+    {
+    case COMPUTE_FUSED_OP_ADD:
+        if (isFloat)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].f = a[i].f + b[i].f;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].u = a[i].u + b[i].u;
+        }
+        break;
+    case COMPUTE_FUSED_OP_SUB:
+        if (isFloat)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].f = a[i].f - b[i].f;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].u = a[i].u - b[i].u;
+        }
+        break;
+    case COMPUTE_FUSED_OP_MUL:
+        if (isFloat)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].f = a[i].f * b[i].f;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].u = a[i].u * b[i].u;
+        }
+        break;
+    case COMPUTE_FUSED_OP_MIN:
+        // Like the device, min and max of a NaN and a number return the number.
+        if (isFloat)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].f = fminf(a[i].f, b[i].f);
+        }
+        else if (isInt)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].i = a[i].i < b[i].i ? a[i].i : b[i].i;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].u = a[i].u < b[i].u ? a[i].u : b[i].u;
+        }
+        break;
+    case COMPUTE_FUSED_OP_MAX:
+        if (isFloat)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].f = fmaxf(a[i].f, b[i].f);
+        }
+        else if (isInt)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].i = a[i].i > b[i].i ? a[i].i : b[i].i;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i].u = a[i].u > b[i].u ? a[i].u : b[i].u;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void ComputeFusedEvaluate(const ComputeFusedExpression *expr, const void *const *inputs, void *const *outputs,
+    size_t begin, size_t end)
+{
+    // The values of all the nodes for a block of elements, each node being evaluated over the whole block
+    FusedScalar values[COMPUTE_FUSED_MAX_NODES][FUSED_EVALUATE_BLOCK];
+
+    for (size_t blockBegin = begin; blockBegin < end; blockBegin += FUSED_EVALUATE_BLOCK)
+    {
+        const size_t count = end - blockBegin < FUSED_EVALUATE_BLOCK ? end - blockBegin : FUSED_EVALUATE_BLOCK;
+
+        for (uint32_t n = 0; n < expr->numNodes; n++)
+        {
+            const ComputeFusedNode *node = &expr->nodes[n];
+            FusedScalar *dst = values[n];
+            switch (node->Op)
+            {
+            case COMPUTE_FUSED_OP_INPUT:
+                memcpy(dst, (const FusedScalar*)inputs[node->Operands[0]] + blockBegin, count * sizeof(*dst));
+                break;
+            case COMPUTE_FUSED_OP_CONSTANT:
+                for (size_t i = 0; i < count; i++)
+                    dst[i].u = node->Value;
+                break;
+            case COMPUTE_FUSED_OP_CLAMP:
+                // clamp(x, low, high) is min(max(x, low), high)
+                EvaluateBinary(dst, values[node->Operands[0]], values[node->Operands[1]], COMPUTE_FUSED_OP_MAX,
+                    (ComputeElementType)node->Type, count);
+                EvaluateBinary(dst, dst, values[node->Operands[2]], COMPUTE_FUSED_OP_MIN, (ComputeElementType)node->Type, count);
+                break;
+            case COMPUTE_FUSED_OP_CAST:
+                EvaluateCast(dst, values[node->Operands[0]], (ComputeElementType)node->Type,
+                    (ComputeElementType)expr->nodes[node->Operands[0]].Type, count);
+                break;
+            default:
+                EvaluateBinary(dst, values[node->Operands[0]], values[node->Operands[1]], (ComputeFusedOp)node->Op,
+                    (ComputeElementType)node->Type, count);
+                break;
+            }
+        }
+
+        for (uint32_t i = 0; i < expr->numOutputs; i++)
+            memcpy((FusedScalar*)outputs[i] + blockBegin, values[expr->outputs[i]], count * sizeof(FusedScalar));
+    }
+}
+
+// ---- Kernels ----
+
+static bool WriteSourceFile(const char *path, const char *pSource, size_t length)
+{
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return false;
+
+    const bool written = fwrite(pSource, 1, length, fp) == length;
+    return fclose(fp) == 0 && written;
+}
+
+static bool CreateKernel(ComputeFusedKernelCache *cache, const ComputeFusedExpression *expr, uint64_t hash,
+    ComputeFusedKernel *kernel)
+{
+    char *pSource = malloc(FUSED_MAX_SOURCE_SIZE);
+    if (pSource == NULL)
+        return false;
+
+    // The source is named after the hash of the expression, so the shader cache keys the bytecode on the expression.
+    char path[COMPUTE_SHADER_CACHE_MAX_PATH + 32];
+    snprintf(path, sizeof(path), "%s/fused_%016llx.hlsl", cache->shaderCache->directory, (unsigned long long)hash);
+
+    const size_t length = ComputeFusedExpressionWriteHLSL(expr, pSource, FUSED_MAX_SOURCE_SIZE);
+    const bool written = length > 0 && WriteSourceFile(path, pSource, length);
+    free(pSource);
+    if (!written)
+    {
+        printf("Failed to write the fused kernel %s!\n", path);
+        return false;
+    }
+
+    ComputeBlob *shader;
+    if (!ComputeShaderCacheCompile(cache->shaderCache, path, NULL, COMPUTE_FUSED_ENTRY_POINT, cache->target, cache->compileFlags, &shader))
+        return false;
+
+    ComputeDevice *device = cache->shaderCache->device;
+    const ComputeShaderBytecode bytecode = { shader->lpVtbl->GetBufferPointer(shader), shader->lpVtbl->GetBufferSize(shader) };
+    ComputeShaderReflection reflection;
+    if (!device->lpVtbl->ReflectShader(device, &bytecode, &reflection) ||
+        !ComputeRootLayoutCreate(&kernel->layout, device, &reflection, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS))
+    {
+        shader->lpVtbl->Release(shader);
+        return false;
+    }
+
+    ComputePipelineStateDesc psoDesc = { 0 };
+    psoDesc.pRootSignature = kernel->layout.rootSignature;
+    psoDesc.CS = bytecode;
+    kernel->pipelineState = ComputeShaderCacheCreatePipelineState(cache->shaderCache, &psoDesc);
+    shader->lpVtbl->Release(shader);
+    if (kernel->pipelineState == NULL)
+    {
+        ComputeRootLayoutDestroy(&kernel->layout);
+        return false;
+    }
+
+    kernel->hash = hash;
+    kernel->expr = *expr;
+    return true;
+}
+
+bool ComputeFusedKernelCacheInit(ComputeFusedKernelCache *cache, ComputeShaderCache *shaderCache, const char *target,
+    uint32_t compileFlags)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->shaderCache = shaderCache;
+    cache->target = target;
+    cache->compileFlags = compileFlags;
+    ComputeMutexInit(&cache->mutex);
+
+    return true;
+}
+
+void ComputeFusedKernelCacheDestroy(ComputeFusedKernelCache *cache)
+{
+    if (cache->shaderCache == NULL)
+        return;
+
+    for (uint32_t i = 0; i < COMPUTE_FUSED_MAX_KERNELS; i++)
+    {
+        ComputeFusedKernel *kernel = &cache->kernels[i];
+        if (kernel->pipelineState != NULL)
+        {
+            kernel->pipelineState->lpVtbl->Release(kernel->pipelineState);
+            ComputeRootLayoutDestroy(&kernel->layout);
+        }
+    }
+
+    ComputeMutexDestroy(&cache->mutex);
+    memset(cache, 0, sizeof(*cache));
+}
+
+const ComputeFusedKernel* ComputeFusedKernelCacheGet(ComputeFusedKernelCache *cache, const ComputeFusedExpression *expr)
+{
+    if (!ComputeFusedExpressionValidate(expr))
+    {
+        puts("Invalid fused expression!");
+        return NULL;
+    }
+
+    const uint64_t hash = ComputeFusedExpressionHash(expr);
+    const ComputeFusedKernel *result = NULL;
+
+    ComputeMutexLock(&cache->mutex);
+
+    // Probe until the expression or an empty slot is found
+    uint32_t index = (uint32_t)(hash % COMPUTE_FUSED_MAX_KERNELS);
+    for (uint32_t probe = 0; probe < COMPUTE_FUSED_MAX_KERNELS; probe++)
+    {
+        ComputeFusedKernel *kernel = &cache->kernels[index];
+        if (kernel->pipelineState == NULL)
+        {
+            // Keep one slot empty so that probing always terminates.
+            if (cache->numKernels + 1 >= COMPUTE_FUSED_MAX_KERNELS)
+            {
+                puts("Too many fused kernels!");
+                break;
+            }
+
+            if (!CreateKernel(cache, expr, hash, kernel))
+            {
+                printf("Failed to compile the fused kernel %016llx!\n", (unsigned long long)hash);
+                memset(kernel, 0, sizeof(*kernel));
+                break;
+            }
+
+            cache->numKernels++;
+            result = kernel;
+            break;
+        }
+
+        if (kernel->hash == hash && ExpressionsEqual(&kernel->expr, expr))
+        {
+            result = kernel;
+            break;
+        }
+
+        index = (index + 1) % COMPUTE_FUSED_MAX_KERNELS;
+    }
+
+    ComputeMutexUnlock(&cache->mutex);
+    return result;
+}
+
+uint32_t ComputeFusedKernelDispatch(const ComputeFusedKernel *kernel, ComputeCommandList *commandList,
+    ComputeResource *const *inputs, ComputeResource *const *outputs, uint32_t numElements)
+{
+    const ComputeRootLayout *layout = &kernel->layout;
+    commandList->lpVtbl->SetPipelineState(commandList, kernel->pipelineState);
+    commandList->lpVtbl->SetComputeRootSignature(commandList, layout->rootSignature);
+
+    // An input the expression does not use is compiled out of the kernel, and has no root parameter.
+    for (uint32_t i = 0; i < kernel->expr.numInputs; i++)
+    {
+        if (layout->srvParameters[i] != COMPUTE_ROOT_LAYOUT_UNUSED)
+            ComputeRootLayoutSetSRV(layout, commandList, i, inputs[i], 0);
+    }
+    for (uint32_t i = 0; i < kernel->expr.numOutputs; i++)
+        ComputeRootLayoutSetUAV(layout, commandList, i, outputs[i], 0);
+
+    return ComputeDispatchElements(commandList, layout->constantsParameters[0], numElements, COMPUTE_FUSED_GROUP_SIZE);
+}
@@ -0,0 +1,156 @@
+#ifndef KERNEL_FUSION_H
+#define KERNEL_FUSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "root_layout.h"
+#include "shader_cache.h"
+#include "typed_buffer.h"
+
+// The limits of an expression
+#define COMPUTE_FUSED_MAX_NODES     64
+#define COMPUTE_FUSED_MAX_INPUTS    4
+#define COMPUTE_FUSED_MAX_OUTPUTS   4
+// The maximum number of fused kernels of a cache
+#define COMPUTE_FUSED_MAX_KERNELS   32
+// The [numthreads] of the fused kernels
+#define COMPUTE_FUSED_GROUP_SIZE    256
+// The entry point of the generated HLSL
+#define COMPUTE_FUSED_ENTRY_POINT   "FusedMain"
+
+typedef enum ComputeFusedOp
+{
+    // The element of the input buffer Operands[0], bound to t#Operands[0]
+    COMPUTE_FUSED_OP_INPUT,
+    // The 32-bit pattern Value of the type
+    COMPUTE_FUSED_OP_CONSTANT,
+    COMPUTE_FUSED_OP_ADD,
+    COMPUTE_FUSED_OP_SUB,
+    COMPUTE_FUSED_OP_MUL,
+    COMPUTE_FUSED_OP_MIN,
+    COMPUTE_FUSED_OP_MAX,
+    // clamp(Operands[0], Operands[1], Operands[2])
+    COMPUTE_FUSED_OP_CLAMP,
+    // The HLSL conversion of Operands[0] to the type
+    COMPUTE_FUSED_OP_CAST,
+    COMPUTE_FUSED_OP_COUNT
+} ComputeFusedOp;
+
+// A node of the expression. The operands are the indices of earlier nodes, so the nodes are in evaluation order.
+typedef struct ComputeFusedNode
+{
+    uint8_t Op;
+    // A ComputeElementType: int, uint or float
+    uint8_t Type;
+    uint16_t Reserved;
+    uint32_t Operands[3];
+    uint32_t Value;
+} ComputeFusedNode;
+
+// The index of a node, as returned by the builder functions
+typedef uint32_t ComputeFusedValue;
+
+// An elementwise expression over 32-bit buffers: out[i] = f(in0[i], in1[i], ...) for each output.
+// The whole chain runs as one kernel, the intermediate values staying in registers
+// instead of going through a buffer between the steps.
+// The builder functions record an error instead of failing one by one, it is reported when the kernel is requested.
+typedef struct ComputeFusedExpression
+{
+    uint32_t numNodes;
+    uint32_t numInputs;
+    uint32_t numOutputs;
+    // The node written to the buffer bound to u#n
+    uint32_t outputs[COMPUTE_FUSED_MAX_OUTPUTS];
+    bool error;
+    ComputeFusedNode nodes[COMPUTE_FUSED_MAX_NODES];
+} ComputeFusedExpression;
+
+extern void ComputeFusedExpressionInit(ComputeFusedExpression *expr);
+
+// The next input buffer, bound to t#n for the n-th call
+extern ComputeFusedValue ComputeFusedInput(ComputeFusedExpression *expr, ComputeElementType type);
+extern ComputeFusedValue ComputeFusedConstantInt(ComputeFusedExpression *expr, int32_t value);
+extern ComputeFusedValue ComputeFusedConstantUint(ComputeFusedExpression *expr, uint32_t value);
+extern ComputeFusedValue ComputeFusedConstantFloat(ComputeFusedExpression *expr, float value);
+
+// Both operands have the same type, the conversions are explicit casts.
+// The integer operations wrap around, like on the device.
+extern ComputeFusedValue ComputeFusedAdd(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b);
+extern ComputeFusedValue ComputeFusedSub(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b);
+extern ComputeFusedValue ComputeFusedMul(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b);
+extern ComputeFusedValue ComputeFusedMin(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b);
+extern ComputeFusedValue ComputeFusedMax(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeFusedValue b);
+extern ComputeFusedValue ComputeFusedClamp(ComputeFusedExpression *expr, ComputeFusedValue x, ComputeFusedValue low,
+    ComputeFusedValue high);
+// Converts like HLSL: the float to integer conversions truncate and saturate, NaN becoming 0,
+// and the conversions between int and uint keep the bits.
+extern ComputeFusedValue ComputeFusedCast(ComputeFusedExpression *expr, ComputeFusedValue a, ComputeElementType type);
+
+// The value becomes the next output, written to u#n for the n-th call
+extern void ComputeFusedOutput(ComputeFusedExpression *expr, ComputeFusedValue value);
+
+// Returns false if a builder function failed or the expression has no output
+extern bool ComputeFusedExpressionValidate(const ComputeFusedExpression *expr);
+
+// The hash of the nodes and the outputs, which name the generated kernel
+extern uint64_t ComputeFusedExpressionHash(const ComputeFusedExpression *expr);
+
+// Generate the HLSL kernel of the expression. The nodes are also written as comments, which Parse reads back,
+// so the source alone describes the kernel. Returns the length of the source,
+// or 0 if it does not fit in the buffer.
+extern size_t ComputeFusedExpressionWriteHLSL(const ComputeFusedExpression *expr, char *pSource, size_t sourceSize);
+
+// Read the expression back from a source generated by WriteHLSL
+extern bool ComputeFusedExpressionParse(ComputeFusedExpression *expr, const char *pSource, size_t sourceSize);
+
+// Evaluate the elements [begin, end) of the expression on the host, the way the generated kernel does.
+// The buffers hold 32-bit elements of the types of the inputs and the outputs.
+extern void ComputeFusedEvaluate(const ComputeFusedExpression *expr, const void *const *inputs, void *const *outputs,
+    size_t begin, size_t end);
+
+// The generated kernel of an expression
+typedef struct ComputeFusedKernel
+{
+    uint64_t hash;
+    ComputeFusedExpression expr;
+    ComputePipelineState *pipelineState;
+    // Generated from the reflection: the inputs and the outputs are root descriptors, the DispatchConstants root constants
+    ComputeRootLayout layout;
+} ComputeFusedKernel;
+
+// The fused kernels, found by the hash of their expression. A new expression generates its HLSL source
+// in the directory of the shader cache, named after the hash, and compiles it through the cache,
+// so that the bytecode of an expression seen by an earlier run is loaded instead of compiled.
+// Get may be called from any thread.
+typedef struct ComputeFusedKernelCache
+{
+    ComputeShaderCache *shaderCache;
+    const char *target;
+    uint32_t compileFlags;
+    ComputeMutex mutex;
+    // Open addressing hash table. A slot without pipeline state is empty.
+    ComputeFusedKernel kernels[COMPUTE_FUSED_MAX_KERNELS];
+    uint32_t numKernels;
+} ComputeFusedKernelCache;
+
+// The target must stay valid until the cache is destroyed.
+extern bool ComputeFusedKernelCacheInit(ComputeFusedKernelCache *cache, ComputeShaderCache *shaderCache, const char *target,
+    uint32_t compileFlags);
+// Releases all the kernels. No command list that uses one may be in flight.
+extern void ComputeFusedKernelCacheDestroy(ComputeFusedKernelCache *cache);
+
+// Find the kernel of the expression, generating and compiling it on the first request.
+// Returns NULL if the expression is invalid or the compilation fails.
+// The kernel stays valid until the cache is destroyed.
+extern const ComputeFusedKernel* ComputeFusedKernelCacheGet(ComputeFusedKernelCache *cache, const ComputeFusedExpression *expr);
+
+// Record the kernel over numElements elements: sets the pipeline state, the root signature and the buffers,
+// the n-th input buffer to t#n and the n-th output buffer to u#n. Returns the number of Dispatch calls recorded.
+extern uint32_t ComputeFusedKernelDispatch(const ComputeFusedKernel *kernel, ComputeCommandList *commandList,
+    ComputeResource *const *inputs, ComputeResource *const *outputs, uint32_t numElements);
+
+#endif // KERNEL_FUSION_H
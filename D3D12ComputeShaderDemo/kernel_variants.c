@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "kernel_variants.h"
+
+static const char* const s_elementTypeNames[] = { "int", "uint", "float" };
+
+static bool KeysEqual(const ComputeKernelVariantKey *a, const ComputeKernelVariantKey *b)
+{
+    return a->Operand == b->Operand && a->GroupSize == b->GroupSize &&
+        a->ElementType == b->ElementType && a->Unroll == b->Unroll;
+}
+
+static uint32_t HashKey(const ComputeKernelVariantKey *key)
+{
+    // The members are hashed one by one, the padding of the struct is undefined.
+    const uint32_t values[4] = { (uint32_t)key->Operand, key->GroupSize, (uint32_t)key->ElementType, key->Unroll };
+    uint32_t hash = 2166136261U;
+    for (int i = 0; i < 4; i++)
+    {
+        hash ^= values[i];
+        hash *= 16777619U;
+        hash ^= hash >> 15;
+    }
+    return hash;
+}
+
+// Compile the variant of the key, reflect its thread group size and create its pipeline state
+static bool CreateVariant(ComputeKernelRegistry *registry, const ComputeKernelVariantKey *key, ComputeKernelVariant *variant)
+{
+    char operand[16], groupSize[16], unroll[16];
+    snprintf(operand, sizeof(operand), "%d", key->Operand);
+    snprintf(groupSize, sizeof(groupSize), "%u", key->GroupSize);
+    snprintf(unroll, sizeof(unroll), "%u", key->Unroll);
+
+    const ComputeShaderMacro defines[] = {
+        { "OPERAND", operand },
+        { "GROUP_SIZE", groupSize },
+        { "ELEM_TYPE", s_elementTypeNames[key->ElementType] },
+        { "UNROLL", unroll },
+        { NULL, NULL }
+    };
+
+    ComputeBlob *shader;
+    if (!ComputeShaderCacheCompile(registry->shaderCache, registry->fileName, defines, registry->entryPoint,
+        registry->target, registry->compileFlags, &shader))
+        return false;
+
+    ComputePipelineStateDesc psoDesc = { 0 };
+    psoDesc.pRootSignature = registry->rootSignature;
+    psoDesc.CS = (ComputeShaderBytecode){ shader->lpVtbl->GetBufferPointer(shader), shader->lpVtbl->GetBufferSize(shader) };
+
+    // The dispatch sizes are computed from the group size of the bytecode, not from the requested one.
+    ComputeDevice *device = registry->shaderCache->device;
+    ComputeShaderReflection reflection;
+    if (!device->lpVtbl->ReflectShader(device, &psoDesc.CS, &reflection))
+    {
+        shader->lpVtbl->Release(shader);
+        return false;
+    }
+
+    variant->pipelineState = ComputeShaderCacheCreatePipelineState(registry->shaderCache, &psoDesc);
+    shader->lpVtbl->Release(shader);
+    if (variant->pipelineState == NULL)
+        return false;
+
+    variant->key = *key;
+    memcpy(variant->threadGroupSize, reflection.ThreadGroupSize, sizeof(variant->threadGroupSize));
+    variant->elementsPerGroup = reflection.ThreadGroupSize[0] * key->Unroll;
+    return true;
+}
+
+bool ComputeKernelRegistryInit(ComputeKernelRegistry *registry, ComputeShaderCache *shaderCache,
+    ComputeRootSignature *rootSignature, const char *fileName, const char *entryPoint, const char *target, uint32_t compileFlags)
+{
+    memset(registry, 0, sizeof(*registry));
+    registry->shaderCache = shaderCache;
+    registry->rootSignature = rootSignature;
+    registry->fileName = fileName;
+    registry->entryPoint = entryPoint;
+    registry->target = target;
+    registry->compileFlags = compileFlags;
+    ComputeMutexInit(&registry->mutex);
+
+    return true;
+}
+
+void ComputeKernelRegistryDestroy(ComputeKernelRegistry *registry)
+{
+    if (registry->shaderCache == NULL)
+        return;
+
+    for (uint32_t i = 0; i < COMPUTE_KERNEL_MAX_VARIANTS; i++)
+    {
+        ComputePipelineState *pipelineState = registry->variants[i].pipelineState;
+        if (pipelineState != NULL)
+            pipelineState->lpVtbl->Release(pipelineState);
+    }
+
+    ComputeMutexDestroy(&registry->mutex);
+    memset(registry, 0, sizeof(*registry));
+}
+
+const ComputeKernelVariant* ComputeKernelRegistryGet(ComputeKernelRegistry *registry, const ComputeKernelVariantKey *key)
+{
+    // The limits of cs_5_0
+    if (key->GroupSize == 0 || key->GroupSize > 1024 || key->Unroll == 0 ||
+        (uint64_t)key->GroupSize * key->Unroll > UINT32_MAX || (uint32_t)key->ElementType > COMPUTE_ELEMENT_TYPE_FLOAT)
+    {
+        puts("Invalid kernel variant key!");
+        return NULL;
+    }
+
+    const ComputeKernelVariant *result = NULL;
+
+    ComputeMutexLock(&registry->mutex);
+
+    // Probe until the key or an empty slot is found
+    uint32_t index = HashKey(key) % COMPUTE_KERNEL_MAX_VARIANTS;
+    for (uint32_t probe = 0; probe < COMPUTE_KERNEL_MAX_VARIANTS; probe++)
+    {
+        ComputeKernelVariant *variant = &registry->variants[index];
+        if (variant->pipelineState == NULL)
+        {
+            // Keep one slot empty so that probing always terminates.
+            if (registry->numVariants + 1 >= COMPUTE_KERNEL_MAX_VARIANTS)
+            {
+                puts("Too many kernel variants!");
+                break;
+            }
+
+            if (!CreateVariant(registry, key, variant))
+            {
+                printf("Failed to compile the variant OPERAND=%d GROUP_SIZE=%u ELEM_TYPE=%s UNROLL=%u of %s!\n",
+                    key->Operand, key->GroupSize, s_elementTypeNames[key->ElementType], key->Unroll, registry->entryPoint);
+                break;
+            }
+
+            registry->numVariants++;
+            result = variant;
+            break;
+        }
+
+        if (KeysEqual(&variant->key, key))
+        {
+            result = variant;
+            break;
+        }
+
+        index = (index + 1) % COMPUTE_KERNEL_MAX_VARIANTS;
+    }
+
+    ComputeMutexUnlock(&registry->mutex);
+
+    return result;
+}
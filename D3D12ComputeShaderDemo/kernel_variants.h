@@ -0,0 +1,69 @@
+#ifndef KERNEL_VARIANTS_H
+#define KERNEL_VARIANTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "shader_cache.h"
+#include "typed_buffer.h"
+
+// The maximum number of variants of one kernel
+#define COMPUTE_KERNEL_MAX_VARIANTS     64
+
+// The specialization tuple of a variant. Every member becomes a macro of the shader,
+// so a variant has no runtime branches on any of them.
+typedef struct ComputeKernelVariantKey
+{
+    // OPERAND
+    int32_t Operand;
+    // GROUP_SIZE, the [numthreads] of the variant
+    uint32_t GroupSize;
+    // ELEM_TYPE: int, uint or float
+    ComputeElementType ElementType;
+    // UNROLL, the number of elements per thread
+    uint32_t Unroll;
+} ComputeKernelVariantKey;
+
+typedef struct ComputeKernelVariant
+{
+    ComputeKernelVariantKey key;
+    ComputePipelineState *pipelineState;
+    // The [numthreads] reflected from the compiled shader
+    uint32_t threadGroupSize[3];
+    // Number of elements covered by one thread group, threadGroupSize[0] * Unroll
+    uint32_t elementsPerGroup;
+} ComputeKernelVariant;
+
+// The compiled variants of one kernel entry point, all sharing the same root signature.
+// Each variant is compiled (through the shader cache) the first time it is requested,
+// and afterwards found by its key without compiling again.
+// Get may be called from any thread.
+typedef struct ComputeKernelRegistry
+{
+    ComputeShaderCache *shaderCache;
+    ComputeRootSignature *rootSignature;
+    const char *fileName;
+    const char *entryPoint;
+    const char *target;
+    uint32_t compileFlags;
+    ComputeMutex mutex;
+    // Open addressing hash table. A slot without pipeline state is empty.
+    ComputeKernelVariant variants[COMPUTE_KERNEL_MAX_VARIANTS];
+    uint32_t numVariants;
+} ComputeKernelRegistry;
+
+// The strings must stay valid until the registry is destroyed.
+extern bool ComputeKernelRegistryInit(ComputeKernelRegistry *registry, ComputeShaderCache *shaderCache,
+    ComputeRootSignature *rootSignature, const char *fileName, const char *entryPoint, const char *target, uint32_t compileFlags);
+// Releases the pipeline states of all the variants. No command list that uses one may be in flight.
+extern void ComputeKernelRegistryDestroy(ComputeKernelRegistry *registry);
+
+// Find the variant of the key, compiling it on the first request.
+// Returns NULL if the key is invalid or the compilation fails.
+// The variant stays valid until the registry is destroyed.
+extern const ComputeKernelVariant* ComputeKernelRegistryGet(ComputeKernelRegistry *registry, const ComputeKernelVariantKey *key);
+
+#endif // KERNEL_VARIANTS_H
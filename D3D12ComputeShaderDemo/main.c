@@ -1,783 +1,2135 @@
-#include <windows.h>
-#include <d3d12.h>
-#include <d3dcompiler.h>
-#include <dxgi1_4.h>
-
-#include <stdio.h>
-#include <stdint.h>
-#include <stdbool.h>
-#include <stdlib.h>
-
-
-// Test data element count
-#define TEST_DATA_COUNT     4096
-
-// The compatible D3D12 device object
-static ID3D12Device *s_device;
-
-// The root signature for compute pipeline state object
-static ID3D12RootSignature *s_computeRootSignature;
-
-// The compute pipeline state object
-static ID3D12PipelineState *s_computeState;
-
-// The descriptor heap resource object. 
-// In this sample, there're two slots in this heap. 
-// The first slot stores the shader view resource descriptor, 
-// and the second slot stores the unordered access view descriptor.
-static ID3D12DescriptorHeap* s_heap;
-
-// The destination buffer object with unordered access view type
-static ID3D12Resource *s_dstDataBuffer;
-
-// The source buffer object with shader source view type
-static ID3D12Resource *s_srcDataBuffer;
-
-// The intermediate buffer object used to copy the source data to the SRV buffer
-static ID3D12Resource* s_uploadBuffer;
-
-// The heap descriptor(of SRV, UAV and CBV type)  size
-static size_t s_srvUavDescriptorSize;
-
-// The command allocator object
-static ID3D12CommandAllocator *s_computeAllocator;
-
-// The command queue object
-static ID3D12CommandQueue *s_computeCommandQueue;
-
-// The command list object
-static ID3D12GraphicsCommandList *s_computeCommandList;
-
-// The function is used to amend ID3D12Resource::GetDesc bridged to COM API
-static inline void GetResourceDesc(ID3D12Resource *resource, D3D12_RESOURCE_DESC *pDesc)
-{
-    void (WINAPI *pFunc)(ID3D12Resource*, D3D12_RESOURCE_DESC*) = (void (WINAPI *)(ID3D12Resource*, D3D12_RESOURCE_DESC*))resource->lpVtbl->GetDesc;
-    pFunc(resource, pDesc);
-}
-
-// The function is used to amend ID3D12DescriptorHeap::GetCPUDescriptorHandleForHeapStart bridged to COM API
-static inline void GetCPUDescriptorHandleForHeapStart(ID3D12DescriptorHeap* heap, D3D12_CPU_DESCRIPTOR_HANDLE* pHandle)
-{
-    if (heap == NULL || pHandle == NULL)
-        return;
-
-    void (WINAPI* const pFunc)(ID3D12DescriptorHeap*, D3D12_CPU_DESCRIPTOR_HANDLE*) = (void (WINAPI*)(ID3D12DescriptorHeap*, D3D12_CPU_DESCRIPTOR_HANDLE*))heap->lpVtbl->GetCPUDescriptorHandleForHeapStart;
-    pFunc(heap, pHandle);
-}
-
-// The function is used to amend ID3D12DescriptorHeap::GetGPUDescriptorHandleForHeapStart bridged to COM API
-static inline void GetGPUDescriptorHandleForHeapStart(ID3D12DescriptorHeap* heap, D3D12_GPU_DESCRIPTOR_HANDLE* pHandle)
-{
-    if (heap == NULL || pHandle == NULL)
-        return;
-
-    void (WINAPI* const pFunc)(ID3D12DescriptorHeap*, D3D12_GPU_DESCRIPTOR_HANDLE*) = (void (WINAPI*)(ID3D12DescriptorHeap*, D3D12_GPU_DESCRIPTOR_HANDLE*))heap->lpVtbl->GetGPUDescriptorHandleForHeapStart;
-    pFunc(heap, pHandle);
-}
-
-//------------------------------------------------------------------------------------------------
-// D3D12 exports a new method for serializing root signatures in the Windows 10 Anniversary Update.
-// To help enable root signature 1.1 features when they are available and not require maintaining
-// two code paths for building root signatures, this helper method reconstructs a 1.0 signature when
-// 1.1 is not supported.
-static inline HRESULT D3DX12SerializeVersionedRootSignature(
-    _In_ const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
-    D3D_ROOT_SIGNATURE_VERSION MaxVersion,
-    _Outptr_ ID3DBlob** ppBlob,
-    _Always_(_Outptr_opt_result_maybenull_) ID3DBlob** ppErrorBlob)
-{
-    switch (MaxVersion)
-    {
-    case D3D_ROOT_SIGNATURE_VERSION_1_0:
-        switch (pRootSignatureDesc->Version)
-        {
-        case D3D_ROOT_SIGNATURE_VERSION_1_0:
-            return D3D12SerializeRootSignature(&pRootSignatureDesc->Desc_1_0, D3D_ROOT_SIGNATURE_VERSION_1, ppBlob, ppErrorBlob);
-
-        case D3D_ROOT_SIGNATURE_VERSION_1_1:
-        {
-            const D3D12_ROOT_SIGNATURE_DESC1* desc_1_1 = &pRootSignatureDesc->Desc_1_1;
-
-            SIZE_T ParametersSize = sizeof(D3D12_ROOT_PARAMETER) * desc_1_1->NumParameters;
-            void* pParameters = (ParametersSize > 0) ? HeapAlloc(GetProcessHeap(), 0, ParametersSize) : NULL;
-            D3D12_ROOT_PARAMETER* pParameters_1_0 = (D3D12_ROOT_PARAMETER*)pParameters;
-
-            for (UINT n = 0; n < desc_1_1->NumParameters; n++)
-            {
-                pParameters_1_0[n].ParameterType = desc_1_1->pParameters[n].ParameterType;
-                pParameters_1_0[n].ShaderVisibility = desc_1_1->pParameters[n].ShaderVisibility;
-
-                switch (desc_1_1->pParameters[n].ParameterType)
-                {
-                case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
-                    pParameters_1_0[n].Constants.Num32BitValues = desc_1_1->pParameters[n].Constants.Num32BitValues;
-                    pParameters_1_0[n].Constants.RegisterSpace = desc_1_1->pParameters[n].Constants.RegisterSpace;
-                    pParameters_1_0[n].Constants.ShaderRegister = desc_1_1->pParameters[n].Constants.ShaderRegister;
-                    break;
-
-                case D3D12_ROOT_PARAMETER_TYPE_CBV:
-                case D3D12_ROOT_PARAMETER_TYPE_SRV:
-                case D3D12_ROOT_PARAMETER_TYPE_UAV:
-                    pParameters_1_0[n].Descriptor.RegisterSpace = desc_1_1->pParameters[n].Descriptor.RegisterSpace;
-                    pParameters_1_0[n].Descriptor.ShaderRegister = desc_1_1->pParameters[n].Descriptor.ShaderRegister;
-                    break;
-
-                case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
-                {
-                    const D3D12_ROOT_DESCRIPTOR_TABLE1* table_1_1 = &desc_1_1->pParameters[n].DescriptorTable;
-
-                    SIZE_T DescriptorRangesSize = sizeof(D3D12_DESCRIPTOR_RANGE) * table_1_1->NumDescriptorRanges;
-                    void* pDescriptorRanges = (DescriptorRangesSize > 0) ? HeapAlloc(GetProcessHeap(), 0, DescriptorRangesSize) : NULL;
-                    D3D12_DESCRIPTOR_RANGE* pDescriptorRanges_1_0 = (D3D12_DESCRIPTOR_RANGE*)pDescriptorRanges;
-
-                    for (UINT x = 0; x < table_1_1->NumDescriptorRanges; x++)
-                    {
-                        pDescriptorRanges_1_0[x].BaseShaderRegister = table_1_1->pDescriptorRanges[x].BaseShaderRegister;
-                        pDescriptorRanges_1_0[x].NumDescriptors = table_1_1->pDescriptorRanges[x].NumDescriptors;
-                        pDescriptorRanges_1_0[x].OffsetInDescriptorsFromTableStart = table_1_1->pDescriptorRanges[x].OffsetInDescriptorsFromTableStart;
-                        pDescriptorRanges_1_0[x].RangeType = table_1_1->pDescriptorRanges[x].RangeType;
-                        pDescriptorRanges_1_0[x].RegisterSpace = table_1_1->pDescriptorRanges[x].RegisterSpace;
-                    }
-
-                    D3D12_ROOT_DESCRIPTOR_TABLE *table_1_0 = &pParameters_1_0[n].DescriptorTable;
-                    table_1_0->NumDescriptorRanges = table_1_1->NumDescriptorRanges;
-                    table_1_0->pDescriptorRanges = pDescriptorRanges_1_0;
-                }
-                }
-            }
-
-            D3D12_ROOT_SIGNATURE_DESC desc_1_0 = {
-                desc_1_1->NumParameters, pParameters_1_0, desc_1_1->NumStaticSamplers, 
-                desc_1_1->pStaticSamplers, desc_1_1->Flags
-            };
-
-            HRESULT hr = D3D12SerializeRootSignature(&desc_1_0, D3D_ROOT_SIGNATURE_VERSION_1, ppBlob, ppErrorBlob);
-
-            for (UINT n = 0; n < desc_1_0.NumParameters; n++)
-            {
-                if (desc_1_0.pParameters[n].ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
-                {
-                    HeapFree(GetProcessHeap(), 0, (LPVOID)pParameters_1_0[n].DescriptorTable.pDescriptorRanges);
-                }
-            }
-            HeapFree(GetProcessHeap(), 0, pParameters);
-            return hr;
-        }
-        }
-        break;
-
-    case D3D_ROOT_SIGNATURE_VERSION_1_1:
-        return D3D12SerializeVersionedRootSignature(pRootSignatureDesc, ppBlob, ppErrorBlob);
-    }
-
-    return E_INVALIDARG;
-}
-
-// Row-by-row memcpy
-static void MemcpySubresource(
-    _In_ const D3D12_MEMCPY_DEST* pDest,
-    _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
-    SIZE_T RowSizeInBytes,
-    UINT NumRows,
-    UINT NumSlices)
-{
-    for (UINT z = 0; z < NumSlices; ++z)
-    {
-        BYTE* pDestSlice = (BYTE*)(pDest->pData) + pDest->SlicePitch * z;
-        const BYTE* pSrcSlice = (const BYTE*)(pSrc->pData) + pSrc->SlicePitch * z;
-        for (UINT y = 0; y < NumRows; ++y)
-        {
-            memcpy(pDestSlice + pDest->RowPitch * y,
-                pSrcSlice + pSrc->RowPitch * y,
-                RowSizeInBytes);
-        }
-    }
-}
-
-// Updates subresources, all the subresource arrays should be populated.
-// This function is the C-style implementation translated from C++ style inline function in the D3DX12 library.
-static size_t UpdateSubresources(
-    _In_ ID3D12Device *device,
-    _In_ ID3D12GraphicsCommandList *commandList,
-    _In_ ID3D12Resource* pDestinationResource,
-    _In_ ID3D12Resource* pIntermediate,
-    UINT64 IntermediateOffset,
-    _In_range_(0, 1) UINT FirstSubresource,
-    _In_range_(0, 1 - FirstSubresource) UINT NumSubresources,
-    _In_reads_(NumSubresources) D3D12_SUBRESOURCE_DATA* pSrcData)
-{
-    size_t RequiredSize = 0;
-    size_t MemToAlloc = (sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) + sizeof(UINT) + sizeof(UINT64)) * NumSubresources;
-    if (MemToAlloc > SIZE_MAX)
-        return 0;
-
-    void* pMem = HeapAlloc(GetProcessHeap(), 0, MemToAlloc);
-    if (pMem == NULL)
-        return 0;
-
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts = (D3D12_PLACED_SUBRESOURCE_FOOTPRINT*)pMem;
-    size_t* pRowSizesInBytes = (size_t*)(pLayouts + NumSubresources);
-    UINT* pNumRows = (UINT*)(pRowSizesInBytes + NumSubresources);
-
-    D3D12_RESOURCE_DESC Desc;
-    GetResourceDesc(pDestinationResource, &Desc);
-
-    device->lpVtbl->GetCopyableFootprints(device, &Desc, FirstSubresource, NumSubresources, IntermediateOffset, pLayouts, pNumRows, pRowSizesInBytes, &RequiredSize);
-
-    // Minor validation
-    D3D12_RESOURCE_DESC IntermediateDesc;
-    GetResourceDesc(pIntermediate, &IntermediateDesc);
-
-    D3D12_RESOURCE_DESC DestinationDesc;
-    GetResourceDesc(pDestinationResource, &DestinationDesc);
-
-    if (IntermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
-        IntermediateDesc.Width < RequiredSize + pLayouts[0].Offset ||
-        RequiredSize >(SIZE_T) - 1 ||
-        (DestinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER &&
-        (FirstSubresource != 0 || NumSubresources != 1)))
-    {
-        return 0;
-    }
-
-    BYTE* pData;
-    HRESULT hr = pIntermediate->lpVtbl->Map(pIntermediate, 0, NULL, (void**)(&pData));
-    if (FAILED(hr))
-        return 0;
-
-    for (UINT i = 0; i < NumSubresources; ++i)
-    {
-        if (pRowSizesInBytes[i] >(SIZE_T)-1) return 0;
-        D3D12_MEMCPY_DEST DestData = { pData + pLayouts[i].Offset, pLayouts[i].Footprint.RowPitch, 
-                                        pLayouts[i].Footprint.RowPitch * pNumRows[i] };
-        MemcpySubresource(&DestData, &pSrcData[i], (SIZE_T)pRowSizesInBytes[i], pNumRows[i], pLayouts[i].Footprint.Depth);
-    }
-    pIntermediate->lpVtbl->Unmap(pIntermediate, 0, NULL);
-
-    if (DestinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
-    {
-        commandList->lpVtbl->CopyBufferRegion(commandList,
-            pDestinationResource, 0, pIntermediate, pLayouts[0].Offset, pLayouts[0].Footprint.Width);
-    }
-    else
-    {
-        for (UINT i = 0; i < NumSubresources; ++i)
-        {
-            D3D12_TEXTURE_COPY_LOCATION dst = { pDestinationResource, D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-            { .PlacedFootprint = i + FirstSubresource } };
-            D3D12_TEXTURE_COPY_LOCATION src = { pIntermediate, D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-            { .PlacedFootprint = pLayouts[i] } };
-
-            commandList->lpVtbl->CopyTextureRegion(commandList, &dst, 0, 0, 0, &src, NULL);
-        }
-    }
-    
-    HeapFree(GetProcessHeap(), 0, pMem);
-
-    return RequiredSize;
-}
-
-// Wait for the whole command queue completed
-static void SyncCommandQueue(ID3D12CommandQueue *commandQueue, ID3D12Device *device, UINT64 signalValue)
-{
-    ID3D12Fence *fence;
-    if(device->lpVtbl->CreateFence(device, 0, D3D12_FENCE_FLAG_NONE, &IID_ID3D12Fence, (void**)&fence)  < 0)
-        return;
-
-    // Add an instruction to the command queue to set a new fence point.  Because we 
-    // are on the GPU timeline, the new fence point won't be set until the GPU finishes
-    // processing all the commands prior to this Signal().
-    if (commandQueue->lpVtbl->Signal(commandQueue, fence, signalValue) < 0)
-        puts("Signal failed!");
-
-    // Wait until the GPU has completed commands up to this fence point.
-    HANDLE eventHandle = CreateEvent(NULL, FALSE, FALSE, NULL);
-    if (eventHandle == NULL)
-    {
-        puts("Failed to create event handle!");
-        return;
-    }
-
-    // Fire event when GPU hits current fence.  
-    if (fence->lpVtbl->SetEventOnCompletion(fence, signalValue, eventHandle) < 0)
-        puts("Set event failed!");
-
-    // Wait until the GPU hits current fence event is fired.
-    WaitForSingleObject(eventHandle, INFINITE);
-    CloseHandle(eventHandle);
-
-    fence->lpVtbl->Release(fence);
-}
-
-// Create the Shader Resource View buffer object
-static ID3D12Resource* CreateSRVBuffer(const void* inputData, size_t dataSize)
-{
-    ID3D12Resource *resultBuffer = NULL;
-    HRESULT hr;
-
-    do
-    {
-        D3D12_HEAP_PROPERTIES heapProperties = { D3D12_HEAP_TYPE_DEFAULT, D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-            D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
-        D3D12_HEAP_PROPERTIES heapUploadProperties = { D3D12_HEAP_TYPE_UPLOAD, D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-            D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
-
-        D3D12_RESOURCE_DESC resourceDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, dataSize, 1, 1, 1,
-            DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, D3D12_RESOURCE_FLAG_NONE };
-        D3D12_RESOURCE_DESC uploadBufferDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, dataSize, 1, 1, 1,
-            DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, D3D12_RESOURCE_FLAG_NONE };
-
-        // Create the SRV buffer and make it as the copy destination.
-        hr = s_device->lpVtbl->CreateCommittedResource(s_device, &heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST, NULL, &IID_ID3D12Resource, (void**)&resultBuffer);
-
-        if (FAILED(hr))
-            break;
-
-        // Create the upload buffer and make it as the generic read intermediate.
-        hr = s_device->lpVtbl->CreateCommittedResource(s_device, &heapUploadProperties, D3D12_HEAP_FLAG_NONE, &uploadBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, NULL, &IID_ID3D12Resource, (void**)&s_uploadBuffer);
-
-        if (FAILED(hr))
-            break;
-
-        // Describe the data we want to copy into the SRV buffer.
-        D3D12_SUBRESOURCE_DATA subResourceData = { 0 };
-        subResourceData.pData = inputData;
-        subResourceData.RowPitch = dataSize;
-        subResourceData.SlicePitch = subResourceData.RowPitch;
-        UpdateSubresources(s_device, s_computeCommandList, resultBuffer, s_uploadBuffer, 0, 0, 1, &subResourceData);
-
-        // Insert a barrier to sync the copy operation, 
-        // and transit the SRV buffer to non pixel shader resource state.
-        D3D12_RESOURCE_BARRIER barrier = { D3D12_RESOURCE_BARRIER_TYPE_TRANSITION, D3D12_RESOURCE_BARRIER_FLAG_NONE,
-            .Transition = { resultBuffer, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, 
-            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE } };
-        s_computeCommandList->lpVtbl->ResourceBarrier(s_computeCommandList, 1, &barrier);
-
-        // Attention! None of the operations above has been executed.
-        // They have just been put into the command list.
-        // So the intermediate buffer s_uploadBuffer MUST NOT be released here.
-
-        // Setup the SRV descriptor. This will be stored in the first slot of the heap.
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = { 0 };
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-        srvDesc.Buffer.FirstElement = 0;
-        srvDesc.Buffer.NumElements = TEST_DATA_COUNT;
-        srvDesc.Buffer.StructureByteStride = sizeof(int);
-        srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-
-        // Get the descriptor handle from the descriptor heap.
-        D3D12_CPU_DESCRIPTOR_HANDLE srvHandle;
-        GetCPUDescriptorHandleForHeapStart(s_heap, &srvHandle);
-
-        // Create the SRV for the buffer with the descriptor handle
-        s_device->lpVtbl->CreateShaderResourceView(s_device, resultBuffer, &srvDesc, srvHandle);
-
-    } while (false);
-
-    if (FAILED(hr))
-    {
-        puts("CreateSRVBuffer failed!");
-        return NULL;
-    }
-
-    return resultBuffer;
-}
-
-// Create the Unordered Access View buffer object
-static ID3D12Resource* CreateUAV_RWBuffer(const void* inputData, size_t dataSize)
-{
-    ID3D12Resource *resultBuffer = NULL;
-    HRESULT hr;
-
-    do
-    {
-        D3D12_HEAP_PROPERTIES heapProperties = { D3D12_HEAP_TYPE_DEFAULT, D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-            D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
-        D3D12_RESOURCE_DESC resourceDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, dataSize, 1, 1, 1,
-            DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
-
-        // Create the UAV buffer and make it in the unordered access state.
-        hr = s_device->lpVtbl->CreateCommittedResource(s_device, &heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, NULL, &IID_ID3D12Resource, (void**)&resultBuffer);
-
-        if (FAILED(hr))
-        {
-            puts("Failed to create resultBuffer!");
-            return NULL;
-        }
-
-        // Setup the UAV descriptor. This will be stored in the second slot of the heap.
-        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = { 0 };
-        uavDesc.Format = DXGI_FORMAT_UNKNOWN;
-        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
-        uavDesc.Buffer.FirstElement = 0;
-        uavDesc.Buffer.NumElements = TEST_DATA_COUNT;
-        uavDesc.Buffer.StructureByteStride = sizeof(int);
-        uavDesc.Buffer.CounterOffsetInBytes = 0;
-        uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
-
-        // Get the descriptor handle from the descriptor heap.
-        D3D12_CPU_DESCRIPTOR_HANDLE uavHandle;
-        GetCPUDescriptorHandleForHeapStart(s_heap, &uavHandle);
-        // It will occupy the second slot.
-        uavHandle.ptr += 1 * s_srvUavDescriptorSize;
-
-        s_device->lpVtbl->CreateUnorderedAccessView(s_device, resultBuffer, NULL, &uavDesc, uavHandle);
-
-    } while (false);
-
-    if (FAILED(hr))
-    {
-        puts("Create UAV Buffer failed!");
-        return NULL;
-    }
-
-    return resultBuffer;
-}
-
-// Initialize all the necessary assets
-static bool InitAssets(void)
-{
-    // ---- Load Pipeline ----
-
-    // In debug mode
-    ID3D12Debug *debugController;
-    if(D3D12GetDebugInterface(&IID_ID3D12Debug, (void**)&debugController) >= 0)
-        debugController->lpVtbl->EnableDebugLayer(debugController);
-
-    IDXGIFactory4 *factory;
-    if (CreateDXGIFactory1(&IID_IDXGIFactory4, (void**)&factory) < 0)
-        return false;
-
-    // Here, we shall use a warp device
-    IDXGIAdapter *warpAdapter;
-    if (factory->lpVtbl->EnumWarpAdapter(factory, &IID_IDXGIAdapter, (void**)&warpAdapter) < 0)
-        return false;
-
-    // Create the D3D12 device
-    if (D3D12CreateDevice((IUnknown*)warpAdapter, D3D_FEATURE_LEVEL_12_0, &IID_ID3D12Device, (void**)&s_device) < 0)
-        return false;
-
-    // Check 4X MSAA quality support for our back buffer format.
-    // All Direct3D 11 capable devices support 4X MSAA for all render 
-    // target formats, so we only need to check quality support.
-    // This step is optional.
-    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msQualityLevels;
-    msQualityLevels.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    msQualityLevels.SampleCount = 4;
-    msQualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
-    msQualityLevels.NumQualityLevels = 0;
-    HRESULT hr = s_device->lpVtbl->CheckFeatureSupport(s_device,
-        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS,
-        &msQualityLevels,
-        sizeof(msQualityLevels));
-    if (hr < 0)
-        return false;
-
-    unsigned msaaQuality = msQualityLevels.NumQualityLevels;
-    printf("msaaQuality: %u\n", msaaQuality);
-
-    // ---- Create descriptor heaps. ----
-    D3D12_DESCRIPTOR_HEAP_DESC srvUavHeapDesc = { 0 };
-    // There are two descriptors for the heap. One for SRV buffer, the other for UAV buffer
-    srvUavHeapDesc.NumDescriptors = 2;
-    srvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-    srvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    hr = s_device->lpVtbl->CreateDescriptorHeap(s_device, &srvUavHeapDesc, &IID_ID3D12DescriptorHeap, (void**)&s_heap);
-    if (FAILED(hr))
-    {
-        puts("Failed to create s_srvHeap!");
-        return false;
-    }
-
-    s_heap->lpVtbl->SetName(s_heap, L"s_heap");
-    // Get the size of each descriptor handle
-    s_srvUavDescriptorSize = s_device->lpVtbl->GetDescriptorHandleIncrementSize(s_device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-    // ---- Load Assets ----
-
-    // Create the root signatures.
-    {
-        D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = { 0 };
-
-        // This is the highest version the sample supports. If CheckFeatureSupport succeeds, the HighestVersion returned will not be greater than this.
-        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-        if(s_device->lpVtbl->CheckFeatureSupport(s_device, D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData)) < 0)
-            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-
-        // Compute root signature.
-        {
-            D3D12_DESCRIPTOR_RANGE1 ranges[2] = {
-                {D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND},
-                {D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE, D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND}
-            };
-
-            D3D12_ROOT_PARAMETER1 rootParameters[2] = {
-                {D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[0] }, D3D12_SHADER_VISIBILITY_ALL },
-                {D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[1] }, D3D12_SHADER_VISIBILITY_ALL }
-            };
-
-            D3D12_VERSIONED_ROOT_SIGNATURE_DESC computeRootSignatureDesc = {
-                D3D_ROOT_SIGNATURE_VERSION_1_1, 
-                .Desc_1_1 = { _countof(rootParameters), rootParameters, 0, NULL, D3D12_ROOT_SIGNATURE_FLAG_NONE }
-            };
-
-            ID3DBlob *signature;
-            ID3DBlob *error;
-            if (D3DX12SerializeVersionedRootSignature(&computeRootSignatureDesc, featureData.HighestVersion, &signature, &error) < 0)
-            {
-                puts("Failed to serialize versioned root signature");
-                return false;
-            }
-
-            if (s_device->lpVtbl->CreateRootSignature(s_device, 0, signature->lpVtbl->GetBufferPointer(signature),
-                signature->lpVtbl->GetBufferSize(signature), &IID_ID3D12RootSignature, &s_computeRootSignature) < 0)
-            {
-                puts("Failed to create root signature!");
-                return false;
-            }
-
-            s_computeRootSignature->lpVtbl->SetName(s_computeRootSignature, L"s_computeRootSignature");
-        }
-    }
-
-    // Create the pipeline states, which includes compiling and loading shaders.
-
-    ID3DBlob* computeShader;
-
-    // Enable better shader debugging with the graphics debugging tools.
-    uint32_t compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-
-    // Load and compile the compute shader.
-    // The comppute shader file 'compute.hlsl' is just located in the current working directory.
-    if (D3DCompileFromFile(L"compute.hlsl", NULL, NULL, "CSMain", "cs_5_0", compileFlags, 0, &computeShader, NULL) < 0)
-        return false;
-
-    // Describe and create the compute pipeline state object (PSO).
-    D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = { 0 };
-    computePsoDesc.pRootSignature = s_computeRootSignature;
-    computePsoDesc.CS = (D3D12_SHADER_BYTECODE){ computeShader->lpVtbl->GetBufferPointer(computeShader),
-        computeShader->lpVtbl->GetBufferSize(computeShader) };
-    computePsoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-    hr = s_device->lpVtbl->CreateComputePipelineState(s_device, &computePsoDesc, &IID_ID3D12PipelineState,
-        (void**)&s_computeState);
-    if (FAILED(hr))
-        return false;
-
-    return true;
-}
-
-// Initialize the command list and the command queue
-static bool InitComputeCommands(void)
-{
-    D3D12_COMMAND_QUEUE_DESC queueDesc = { D3D12_COMMAND_LIST_TYPE_DIRECT, 0, D3D12_COMMAND_QUEUE_FLAG_NONE };
-    if (s_device->lpVtbl->CreateCommandQueue(s_device, &queueDesc, &IID_ID3D12CommandQueue, (void**)&s_computeCommandQueue) < 0)
-        return false;
-
-    if (s_device->lpVtbl->CreateCommandAllocator(s_device, D3D12_COMMAND_LIST_TYPE_DIRECT,
-        &IID_ID3D12CommandAllocator, (void**)&s_computeAllocator) < 0)
-        return false;
-
-    if (s_device->lpVtbl->CreateCommandList(s_device, 0, D3D12_COMMAND_LIST_TYPE_DIRECT, s_computeAllocator,
-        NULL, &IID_ID3D12CommandList, (void**)&s_computeCommandList) < 0)
-        return false;
-
-    return true;
-}
-
-static int s_DataBuffer0[TEST_DATA_COUNT];
-
-// Create the source buffer object and the destination buffer object.
-// Initialize the SRV buffer object with the input buffer
-static bool CreateBuffers(void)
-{
-    // 对数据资源做初始化
-    for (int i = 0; i < TEST_DATA_COUNT; i++)
-        s_DataBuffer0[i] = i + 1;
-
-    // Create the compute shader's constant buffer.
-    const uint32_t bufferSize = (uint32_t)sizeof(s_DataBuffer0);
-    s_srcDataBuffer = CreateSRVBuffer(s_DataBuffer0, bufferSize);
-    s_dstDataBuffer = CreateUAV_RWBuffer(NULL, bufferSize);
-
-    return true;
-}
-
-// Do the compute operation and fetch the result
-static void DoCompute(void)
-{
-    ID3D12Resource *readBackBuffer = NULL;
-    D3D12_HEAP_PROPERTIES heapProperties = { D3D12_HEAP_TYPE_READBACK, D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-        D3D12_MEMORY_POOL_UNKNOWN, 1, 1 };
-    D3D12_RESOURCE_DESC resourceDesc = { D3D12_RESOURCE_DIMENSION_BUFFER, 0, sizeof(s_DataBuffer0), 1, 1, 1,
-        DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, D3D12_RESOURCE_FLAG_NONE };
-
-    // Create the read-back buffer object that will fetch the result from the UAV buffer object.
-    // And make it as the copy destination.
-    HRESULT hr = s_device->lpVtbl->CreateCommittedResource(s_device, &heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
-        D3D12_RESOURCE_STATE_COPY_DEST, NULL, &IID_ID3D12Resource, (void**)&readBackBuffer);
-
-    if (FAILED(hr))
-        return;
-
-    // Reuse the memory associated with command recording.
-    // We can only reset when the associated command lists have finished execution on the GPU.
-    if(s_computeAllocator->lpVtbl->Reset(s_computeAllocator) < 0)
-        return;
-
-    // A command list can be reset after it has been added to the command queue via ExecuteCommandList.
-    // Reusing the command list reuses memory.
-    if(s_computeCommandList->lpVtbl->Reset(s_computeCommandList, s_computeAllocator, s_computeState) < 0)
-        return;
-
-    s_computeCommandList->lpVtbl->SetComputeRootSignature(s_computeCommandList, s_computeRootSignature);
-
-    ID3D12DescriptorHeap* ppHeaps[] = { s_heap };
-    s_computeCommandList->lpVtbl->SetDescriptorHeaps(s_computeCommandList, _countof(ppHeaps), ppHeaps);
-
-    D3D12_GPU_DESCRIPTOR_HANDLE srvHandle;
-    // Get the SRV GPU descriptor handle from the descriptor heap
-    GetGPUDescriptorHandleForHeapStart(s_heap, &srvHandle);
-
-    D3D12_GPU_DESCRIPTOR_HANDLE uavHandle;
-    // Get the UAV GPU descriptor handle from the descriptor heap
-    GetGPUDescriptorHandleForHeapStart(s_heap, &uavHandle);
-    uavHandle.ptr += 1 * s_srvUavDescriptorSize;
-
-    s_computeCommandList->lpVtbl->SetComputeRootDescriptorTable(s_computeCommandList, 0, srvHandle);
-    s_computeCommandList->lpVtbl->SetComputeRootDescriptorTable(s_computeCommandList, 1, uavHandle);
-
-    // Dispatch the GPU threads
-    s_computeCommandList->lpVtbl->Dispatch(s_computeCommandList, 4, 1, 1);
-
-    // Insert a barrier command to sync the dispatch operation, 
-    // and make the UAV buffer object as the copy source.
-    const D3D12_RESOURCE_BARRIER barrier = { D3D12_RESOURCE_BARRIER_TYPE_TRANSITION, D3D12_RESOURCE_BARRIER_FLAG_NONE,
-        .Transition = { s_dstDataBuffer, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
-        D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE } };
-    s_computeCommandList->lpVtbl->ResourceBarrier(s_computeCommandList, 1, &barrier);
-
-    // Copy data from the UAV buffer object to the read-back buffer object.
-    s_computeCommandList->lpVtbl->CopyResource(s_computeCommandList, readBackBuffer, s_dstDataBuffer);
-
-    s_computeCommandList->lpVtbl->Close(s_computeCommandList);
-
-    s_computeCommandQueue->lpVtbl->ExecuteCommandLists(s_computeCommandQueue, 1, 
-        (ID3D12CommandList* const[]) { (ID3D12CommandList*)s_computeCommandList });
-
-    SyncCommandQueue(s_computeCommandQueue, s_device, 2);
-
-    void* pData;
-    const D3D12_RANGE range = { 0, TEST_DATA_COUNT };
-    // Map the memory buffer so that we may access the data from the host side.
-    hr = readBackBuffer->lpVtbl->Map(readBackBuffer, 0, &range, &pData);
-    if (FAILED(hr))
-        return;
-
-    int* resultBuffer = malloc(TEST_DATA_COUNT * sizeof(*resultBuffer));
-    memcpy(resultBuffer, pData, TEST_DATA_COUNT * sizeof(*resultBuffer));
-
-    // After copying the data, just release the read-back buffer object.
-    readBackBuffer->lpVtbl->Unmap(readBackBuffer, 0, NULL);
-    readBackBuffer->lpVtbl->Release(readBackBuffer);
-
-    // Verify the result
-    bool equal = true;
-    for (int i = 0; i < TEST_DATA_COUNT; i++)
-    {
-        if (resultBuffer[i] - 10 != s_DataBuffer0[i])
-        {
-            printf("%d index elements are not equal!\n", i);
-            equal = false;
-            break;
-        }
-    }
-    if (equal)
-        puts("Verification OK!");
-
-    free(resultBuffer);
-}
-
-// Release all the resources
-void ReleaseResources(void)
-{
-    if (s_heap != NULL)
-        s_heap->lpVtbl->Release(s_heap);
-
-    if (s_srcDataBuffer != NULL)
-        s_srcDataBuffer->lpVtbl->Release(s_srcDataBuffer);
-
-    if (s_dstDataBuffer != NULL)
-        s_dstDataBuffer->lpVtbl->Release(s_dstDataBuffer);
-
-    if (s_uploadBuffer != NULL)
-        s_uploadBuffer->lpVtbl->Release(s_uploadBuffer);
-
-    if (s_computeAllocator != NULL)
-        s_computeAllocator->lpVtbl->Release(s_computeAllocator);
-
-    if (s_computeCommandList != NULL)
-        s_computeCommandList->lpVtbl->Release(s_computeCommandList);
-
-    if (s_computeCommandQueue != NULL)
-        s_computeCommandQueue->lpVtbl->Release(s_computeCommandQueue);
-
-    if (s_computeState != NULL)
-        s_computeState->lpVtbl->Release(s_computeState);
-
-    if (s_computeRootSignature != NULL)
-        s_computeRootSignature->lpVtbl->Release(s_computeRootSignature);
-
-    if (s_device != NULL)
-        s_device->lpVtbl->Release(s_device);
-}
-
-int main(void)
-{
-    do
-    {
-        if (!InitAssets())
-        {
-            puts("InitAssets failed!");
-            break;
-        }
-        if (!InitComputeCommands())
-        {
-            puts("InitComputeCommands failed!");
-            break;
-        }
-        if (!CreateBuffers())
-        {
-            puts("CreateBuuffers failed!");
-            break;
-        }
-
-        if (s_computeCommandList->lpVtbl->Close(s_computeCommandList) < 0)
-        {
-            puts("Execute init commands failed!");
-            break;
-        }
-
-        s_computeCommandQueue->lpVtbl->ExecuteCommandLists(s_computeCommandQueue, 1, (ID3D12CommandList* const []) { (ID3D12CommandList*)s_computeCommandList });
-
-        SyncCommandQueue(s_computeCommandQueue, s_device, 1);
-
-        // After finishing the whole buffer copy operation,
-        // the intermediate buffer s_uploadBuffer can be released now.
-        if (s_uploadBuffer != NULL)
-        {
-            s_uploadBuffer->lpVtbl->Release(s_uploadBuffer);
-            s_uploadBuffer = NULL;
-        }
-
-        DoCompute();
-
-    } while (false);
-
-    ReleaseResources();
-}
-
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compute_backend.h"
+#include "compute_utils.h"
+#include "compute_timeline.h"
+#include "upload_ring.h"
+#include "descriptor_allocator.h"
+#include "resource_allocator.h"
+#include "readback_pool.h"
+#include "stream_pipeline.h"
+#include "shader_cache.h"
+#include "kernel_variants.h"
+#include "command_pool.h"
+#include "job_graph.h"
+#include "compute_primitives.h"
+#include "compute_completion.h"
+#include "compute_shard.h"
+#include "compute_service.h"
+#include "compute_verify.h"
+#include "host_primitives.h"
+#include "typed_buffer.h"
+#include "root_layout.h"
+#include "kernel_fusion.h"
+#include "thread_pool.h"
+#include "host_copy.h"
+#include "compute_trace.h"
+
+
+// Default test data element count, "--count <n>" selects another one
+#define TEST_DATA_COUNT     4096
+
+// The minimum size of the upload ring shared by all the source buffer uploads
+#define UPLOAD_RING_SIZE    (1024 * 1024)
+
+// Element count of each chunk in the streaming mode, a multiple of the thread group size
+#define STREAM_CHUNK_COUNT  (4 * 1024 * 1024)
+
+// The number of chunks in flight in the streaming mode (triple buffering)
+#define STREAM_SLOT_COUNT   3
+
+// The sizes of the descriptor heaps: the persistent part and the transient tables of the shader visible heap,
+// and the CPU-only staging heap where the views are created
+#define DESCRIPTOR_PERSISTENT_COUNT     256
+#define DESCRIPTOR_TRANSIENT_COUNT      1024
+#define DESCRIPTOR_STAGING_COUNT        256
+
+// The size of the pooled heaps the buffers are placed in. Larger buffers get a heap of their own.
+#define RESOURCE_HEAP_SIZE  (16 * 1024 * 1024)
+
+// The compatible compute device object (D3D12 or CPU backend)
+static ComputeDevice *s_device;
+
+// The on-disk cache of the shader bytecode and the pipeline state blobs
+static ComputeShaderCache s_shaderCache;
+
+// The root signature for compute pipeline state object, generated from the bindings of the compute shader:
+// the dispatch constants as root constants, and the source and destination buffers as root descriptors
+static ComputeRootLayout s_computeLayout;
+
+// The compiled variants of the compute shader
+static ComputeKernelRegistry s_kernelRegistry;
+
+// The specialization of the compute shader used by the sample: add 10 to each int,
+// 1024 threads per group and one element per thread
+static const ComputeKernelVariantKey s_computeVariantKey = { 10, 1024, COMPUTE_ELEMENT_TYPE_INT, 1 };
+
+// The compute pipeline state object of that variant, owned by the registry
+static const ComputeKernelVariant *s_computeVariant;
+
+// The compile flags of the kernels
+static uint32_t s_compileFlags;
+
+// The descriptor heaps shared by all the kernels
+static ComputeDescriptorAllocator s_descriptors;
+
+// The pooled heaps of the buffers
+static ComputeResourceAllocator s_resourceAllocator;
+
+// The destination buffer object with unordered access view type, and its memory
+static ComputeResource *s_dstDataBuffer;
+static ComputeResourceAllocation s_dstDataAllocation;
+
+// The source buffer object with shader source view type, and its memory
+static ComputeResource *s_srcDataBuffer;
+static ComputeResourceAllocation s_srcDataAllocation;
+
+// The comparison of the result on the device, of which only the mismatch count and a few indices are read back
+static ComputeVerifier s_verifier;
+static ComputeResource *s_verifyResultBuffer;
+static ComputeResourceAllocation s_verifyResultAllocation;
+// Whether "--host-verify" reads the whole result back and checks it on the host threads instead
+static bool s_hostVerify;
+
+// The persistently mapped upload memory used to copy the source data to the SRV buffers
+static ComputeUploadRing s_uploadRing;
+
+// The persistently mapped read-back buffers reused by every DoCompute
+static ComputeReadbackPool s_readbackPool;
+
+// The number of submissions that may be in flight at the same time
+#define COMPUTE_FRAME_COUNT     2
+
+// The command queue object
+static ComputeCommandQueue *s_computeCommandQueue;
+
+// The persistent fence of the command queue
+static ComputeTimeline s_computeTimeline;
+
+// The copy queue and its fence, moving the streamed chunks while the compute queue runs the kernels
+static ComputeCommandQueue *s_copyCommandQueue;
+static ComputeTimeline s_copyTimeline;
+
+// The command allocators and command lists, one pair per in-flight submission
+static ComputeFrameRing s_computeFrames;
+
+// The host threads that record the jobs and fill the upload memory
+static ThreadPool *s_hostThreads;
+
+// The recording contexts of the jobs, when the dispatch is split into "--jobs <n>" jobs recorded in parallel
+static ComputeCommandPool s_commandPool;
+static uint32_t s_numJobs = 1;
+
+// The number of chained kernels run through a job graph with "--stages <n>", 0 to skip it
+static uint32_t s_numStages;
+
+// Whether "--primitives" checks the parallel primitives against the host ones
+static bool s_runPrimitives;
+
+// Whether "--records" updates records of mixed field types in the SoA layout
+static bool s_runRecords;
+
+// Whether "--fused" runs a chain of elementwise operations as one generated kernel
+static bool s_runFused;
+static ComputeFusedKernelCache s_fusedKernels;
+
+// The number of devices the operation is sharded across with "--shards <n>", 0 to skip it
+static uint32_t s_numShardDevices;
+
+// The number of runs submitted with "--async <n>" and checked by the completion thread, 0 to skip them
+static uint32_t s_numAsyncJobs;
+
+// The command list currently being recorded
+static ComputeCommandList *s_computeCommandList;
+
+// The states the buffers are left in by the submitted command lists.
+// The barriers within a command list are derived by the state tracker of its frame.
+static ComputeResourceStateTable s_resourceStates;
+
+// The number of test data elements, which needs not be a multiple of the thread group size
+static uint32_t s_testDataCount = TEST_DATA_COUNT;
+
+// The test data
+static int *s_DataBuffer0;
+
+// A record with fields of mixed types, the way the host stores it: 14 bytes of fields in 16 bytes
+typedef struct TestRecord
+{
+    float value;
+    // IEEE half
+    uint16_t scale;
+    int64_t id;
+} TestRecord;
+
+static const ComputeStructLayout s_testRecordLayout = {
+    sizeof(TestRecord), 3, {
+        { COMPUTE_ELEMENT_TYPE_FLOAT, 1, offsetof(TestRecord, value) },
+        { COMPUTE_ELEMENT_TYPE_HALF, 1, offsetof(TestRecord, scale) },
+        { COMPUTE_ELEMENT_TYPE_INT64, 1, offsetof(TestRecord, id) }
+    }
+};
+
+// The increment of the ids, negative to borrow from the high words of the small ids
+#define TEST_RECORD_ID_INCREMENT    (-7)
+
+// Create the Shader Resource View buffer object
+static ComputeResource* CreateSRVBuffer(const void* inputData, size_t dataSize, ComputeResourceAllocation *pAllocation)
+{
+    ComputeResource *resultBuffer = NULL;
+
+    do
+    {
+        const ComputeResourceDesc resourceDesc = { dataSize, COMPUTE_RESOURCE_FLAG_NONE };
+
+        // Place the SRV buffer in a pooled heap and make it as the copy destination.
+        if (!ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &resourceDesc,
+            COMPUTE_RESOURCE_STATE_COPY_DEST, pAllocation))
+            break;
+        resultBuffer = pAllocation->resource;
+        if (!ComputeResourceStateTableRegister(&s_resourceStates, resultBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST))
+            break;
+
+        ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+        ComputeStateTrackerRequire(tracker, resultBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        // Describe the data we want to copy into the SRV buffer.
+        ComputeSubresourceData subResourceData = { 0 };
+        subResourceData.pData = inputData;
+        subResourceData.RowPitch = dataSize;
+        subResourceData.SlicePitch = subResourceData.RowPitch;
+        // The data is staged in a sub-allocation of the upload ring,
+        // which is reclaimed once the GPU has passed the fence value of this submission.
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Upload");
+        const size_t uploadedSize = UpdateSubresourcesFromRing(s_computeCommandList, resultBuffer, &s_uploadRing, 0, 1, &subResourceData);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+        if (uploadedSize == 0)
+            break;
+
+        // Start to transit the SRV buffer to non pixel shader resource state once the copy is done.
+        // The split barrier ends when the buffer is first read, the GPU may run other commands meanwhile.
+        ComputeStateTrackerBeginTransition(tracker, resultBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        // Attention! None of the operations above has been executed.
+        // They have just been put into the command list.
+        // So the upload ring keeps the staged data until the submission's fence value is reached.
+
+        // The buffer needs no view, the kernel reads it through a root descriptor.
+        return resultBuffer;
+
+    } while (false);
+
+    puts("CreateSRVBuffer failed!");
+    if (resultBuffer != NULL)
+    {
+        ComputeResourceStateTableUnregister(&s_resourceStates, resultBuffer);
+        ComputeResourceAllocatorFree(&s_resourceAllocator, pAllocation);
+        memset(pAllocation, 0, sizeof(*pAllocation));
+    }
+    return NULL;
+}
+
+// Create the Unordered Access View buffer object
+static ComputeResource* CreateUAV_RWBuffer(const void* inputData, size_t dataSize, ComputeResourceAllocation *pAllocation)
+{
+    (void)inputData;
+
+    const ComputeResourceDesc resourceDesc = { dataSize, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+
+    // Place the UAV buffer in a pooled heap and make it in the unordered access state.
+    // Its initial content is undefined, the kernel writes every element.
+    if (!ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &resourceDesc,
+        COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, pAllocation))
+    {
+        puts("Failed to create resultBuffer!");
+        return NULL;
+    }
+    ComputeResource *resultBuffer = pAllocation->resource;
+    if (!ComputeResourceStateTableRegister(&s_resourceStates, resultBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS))
+    {
+        ComputeResourceAllocatorFree(&s_resourceAllocator, pAllocation);
+        memset(pAllocation, 0, sizeof(*pAllocation));
+        return NULL;
+    }
+
+    // Like the SRV buffer, it is written through a root descriptor without any view.
+    return resultBuffer;
+}
+
+// Initialize all the necessary assets
+static bool InitAssets(ComputeBackendType backendType)
+{
+    // ---- Load Pipeline ----
+
+#ifdef _WIN32
+    if (backendType == COMPUTE_BACKEND_D3D12)
+        s_device = CreateD3D12ComputeDevice();
+    else
+#else
+    // The other platforms only have the CPU backend.
+    (void)backendType;
+#endif
+        s_device = CreateCPUComputeDevice(NULL);
+
+    if (s_device == NULL)
+        return false;
+
+    // ---- Load Assets ----
+
+    // Create the pipeline states, which includes compiling and loading shaders.
+
+#ifdef _DEBUG
+    // Enable better shader debugging with the graphics debugging tools.
+    s_compileFlags = COMPUTE_COMPILE_DEBUG | COMPUTE_COMPILE_SKIP_OPTIMIZATION;
+#else
+    s_compileFlags = COMPUTE_COMPILE_OPTIMIZATION_LEVEL3;
+#endif
+
+    // The compiled shaders and pipeline states are kept in the 'shader_cache' directory,
+    // so a warm start skips the compilation entirely.
+    if (!ComputeShaderCacheInit(&s_shaderCache, s_device, "shader_cache", NULL, NULL))
+        return false;
+
+    // The comppute shader file 'compute.hlsl' is just located in the current working directory.
+    // Its root signature follows the registers it binds: the per-dispatch parameters of the b0 cbuffer become root constants,
+    // and the structured buffers root descriptors, so binding them takes no view and no copy to the shader visible heap.
+    if (!ComputeRootLayoutCreateFromShader(&s_computeLayout, &s_shaderCache, "compute.hlsl", NULL, "CSMain", "cs_5_0",
+        s_compileFlags, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS))
+    {
+        puts("Failed to create root signature!");
+        return false;
+    }
+
+    if (!ComputeKernelRegistryInit(&s_kernelRegistry, &s_shaderCache, s_computeLayout.rootSignature, "compute.hlsl", "CSMain",
+        "cs_5_0", s_compileFlags))
+        return false;
+
+    // Load and compile the variant of the compute shader, and create its pipeline state object (PSO).
+    // Other variants are compiled the first time they are requested from the registry.
+    s_computeVariant = ComputeKernelRegistryGet(&s_kernelRegistry, &s_computeVariantKey);
+    if (s_computeVariant == NULL)
+        return false;
+
+    // The kernels of 'verify.hlsl' check the result on the GPU.
+    if (!ComputeVerifierInit(&s_verifier, &s_shaderCache, "verify.hlsl", s_compileFlags))
+        return false;
+
+    return true;
+}
+
+// Initialize the command list and the command queue
+static bool InitComputeCommands(void)
+{
+    // The large uploads are split over the host threads.
+    s_hostThreads = CreateThreadPool(0);
+    if (s_hostThreads == NULL)
+        return false;
+    ComputeHostCopySetThreadPool(s_hostThreads);
+
+    s_computeCommandQueue = s_device->lpVtbl->CreateCommandQueue(s_device, COMPUTE_COMMAND_LIST_TYPE_COMPUTE);
+    if (s_computeCommandQueue == NULL)
+        return false;
+
+    if (!ComputeTimelineInit(&s_computeTimeline, s_device, s_computeCommandQueue))
+        return false;
+
+    s_copyCommandQueue = s_device->lpVtbl->CreateCommandQueue(s_device, COMPUTE_COMMAND_LIST_TYPE_COPY);
+    if (s_copyCommandQueue == NULL)
+        return false;
+
+    if (!ComputeTimelineInit(&s_copyTimeline, s_device, s_copyCommandQueue))
+        return false;
+
+#ifdef COMPUTE_TRACE_ENABLED
+    // A queue without timestamps is left out of the trace, the rest still runs.
+    ComputeTraceAddQueue(s_device, &s_computeTimeline, COMPUTE_COMMAND_LIST_TYPE_COMPUTE, "Compute queue");
+    ComputeTraceAddQueue(s_device, &s_copyTimeline, COMPUTE_COMMAND_LIST_TYPE_COPY, "Copy queue");
+#endif
+
+    // ---- Create descriptor heaps. ----
+    // The transient tables are recycled as the timeline advances, so the heaps are created along with it.
+    const ComputeDescriptorAllocatorDesc descriptorDesc = {
+        DESCRIPTOR_PERSISTENT_COUNT, DESCRIPTOR_TRANSIENT_COUNT, DESCRIPTOR_STAGING_COUNT
+    };
+    if (!ComputeDescriptorAllocatorInit(&s_descriptors, s_device, &s_computeTimeline, &descriptorDesc))
+        return false;
+
+    // The buffer memory is recycled along the timeline as well.
+    if (!ComputeResourceAllocatorInit(&s_resourceAllocator, s_device, &s_computeTimeline, RESOURCE_HEAP_SIZE))
+        return false;
+
+    // The whole test data is staged at once, and so are the records.
+    uint64_t uploadSize = (uint64_t)s_testDataCount * sizeof(int);
+    if (s_runRecords)
+    {
+        uint64_t fieldOffsets[COMPUTE_STRUCT_MAX_FIELDS];
+        const uint64_t recordsSize = ComputeStructLayoutGetSoAOffsets(&s_testRecordLayout, s_testDataCount, fieldOffsets);
+        uploadSize = recordsSize > uploadSize ? recordsSize : uploadSize;
+    }
+    if (!ComputeUploadRingInit(&s_uploadRing, s_device, &s_computeTimeline, uploadSize > UPLOAD_RING_SIZE ? uploadSize : UPLOAD_RING_SIZE))
+        return false;
+
+    if (!ComputeReadbackPoolInit(&s_readbackPool, s_device, &s_computeTimeline))
+        return false;
+
+    if (!ComputeFrameRingInit(&s_computeFrames, s_device, &s_computeTimeline, COMPUTE_FRAME_COUNT, COMPUTE_COMMAND_LIST_TYPE_COMPUTE))
+        return false;
+
+    if (!ComputeResourceStateTableInit(&s_resourceStates) ||
+        !ComputeFrameRingEnableStateTracking(&s_computeFrames, s_device, &s_resourceStates))
+        return false;
+
+    // The job command lists share the state table with the frames, since they go to the same queue.
+    if (s_numJobs > 1 &&
+        !ComputeCommandPoolInit(&s_commandPool, s_device, &s_computeTimeline, COMPUTE_COMMAND_LIST_TYPE_COMPUTE, &s_resourceStates))
+        return false;
+
+    // Begin recording the initialization commands.
+    s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, NULL, COMPUTE_WAIT_INFINITE);
+    return s_computeCommandList != NULL;
+}
+
+// Create the source buffer object and the destination buffer object.
+// Initialize the SRV buffer object with the input buffer
+static bool CreateBuffers(void)
+{
+    const size_t bufferSize = (size_t)s_testDataCount * sizeof(int);
+    s_DataBuffer0 = malloc(bufferSize);
+    if (s_DataBuffer0 == NULL)
+        return false;
+
+    // 对数据资源做初始化
+    for (uint32_t i = 0; i < s_testDataCount; i++)
+        s_DataBuffer0[i] = (int)(i + 1);
+
+    // Create the compute shader's constant buffer.
+    s_srcDataBuffer = CreateSRVBuffer(s_DataBuffer0, bufferSize, &s_srcDataAllocation);
+    s_dstDataBuffer = CreateUAV_RWBuffer(NULL, bufferSize, &s_dstDataAllocation);
+    s_verifyResultBuffer = CreateUAV_RWBuffer(NULL, COMPUTE_VERIFY_RESULT_SIZE, &s_verifyResultAllocation);
+
+    return s_srcDataBuffer != NULL && s_dstDataBuffer != NULL && s_verifyResultBuffer != NULL;
+}
+
+// Set the root signature and bind the buffers of the compute operation to its root descriptors
+static void RecordComputeBindings(ComputeCommandList *commandList)
+{
+    commandList->lpVtbl->SetComputeRootSignature(commandList, s_computeLayout.rootSignature);
+    ComputeRootLayoutSetSRV(&s_computeLayout, commandList, 0, s_srcDataBuffer, 0);
+    ComputeRootLayoutSetUAV(&s_computeLayout, commandList, 0, s_dstDataBuffer, 0);
+}
+
+// The dispatch of the compute operation split into jobs of consecutive thread groups
+typedef struct ComputeJobs
+{
+    uint32_t numGroups;
+    uint32_t groupsPerJob;
+    volatile int64_t numFailures;
+} ComputeJobs;
+
+// Record the jobs [begin, end) into a command list of the calling thread
+static void RecordComputeJobRange(void *context, size_t begin, size_t end)
+{
+    ComputeJobs *jobs = context;
+
+    // The lists are executed in the order of their first job.
+    ComputeRecordingContext *recording = ComputeCommandPoolAcquire(&s_commandPool, begin, s_computeVariant->pipelineState);
+    if (recording == NULL)
+    {
+        ComputeAtomicAdd64(&jobs->numFailures, 1);
+        return;
+    }
+
+    COMPUTE_TRACE_CPU_BEGIN(traceScope, "Record jobs");
+    ComputeCommandList *commandList = recording->commandList;
+    RecordComputeBindings(commandList);
+
+    // The jobs write disjoint elements, so they need no UAV barrier between them.
+    ComputeStateTrackerRequire(&recording->tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerRequire(&recording->tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerFlush(&recording->tracker, commandList);
+
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, commandList, "Dispatch jobs");
+    for (size_t job = begin; job < end; job++)
+    {
+        const uint32_t firstGroup = (uint32_t)job * jobs->groupsPerJob;
+        const uint32_t numGroups = jobs->numGroups - firstGroup < jobs->groupsPerJob ?
+            jobs->numGroups - firstGroup : jobs->groupsPerJob;
+        ComputeDispatchGroupRange(commandList, s_computeLayout.constantsParameters[0], s_testDataCount, firstGroup, numGroups);
+    }
+    COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, commandList);
+    COMPUTE_TRACE_CPU_END(traceScope);
+
+    if (!ComputeCommandPoolFinish(&s_commandPool, recording))
+        ComputeAtomicAdd64(&jobs->numFailures, 1);
+}
+
+// Record the dispatch as s_numJobs jobs on the recording threads, and submit all their command lists at once
+static bool RecordComputeJobs(void)
+{
+    const uint32_t elementsPerGroup = s_computeVariant->elementsPerGroup;
+    const uint32_t numGroups = (uint32_t)(((uint64_t)s_testDataCount + elementsPerGroup - 1) / elementsPerGroup);
+
+    ComputeJobs jobs = { numGroups, 0, 0 };
+    jobs.groupsPerJob = (numGroups + s_numJobs - 1) / s_numJobs;
+    const uint32_t numJobs = (numGroups + jobs.groupsPerJob - 1) / jobs.groupsPerJob;
+
+    ThreadPoolParallelFor(s_hostThreads, numJobs, 0, RecordComputeJobRange, &jobs);
+
+    // The lists recorded before a failure are submitted anyway, so their contexts are recycled.
+    const uint64_t fenceValue = ComputeCommandPoolSubmit(&s_commandPool);
+    if (jobs.numFailures != 0 || fenceValue == 0)
+    {
+        puts("Recording the compute jobs failed!");
+        return false;
+    }
+
+    return true;
+}
+
+// Do the compute operation and fetch the result
+static void DoCompute(void)
+{
+    const size_t resultSize = (size_t)s_testDataCount * sizeof(int);
+    // Only the result of the verification on the device is read back, unless the host checks the whole buffer.
+    const size_t readBackSize = s_hostVerify ? resultSize : COMPUTE_VERIFY_RESULT_SIZE;
+
+    // Take a read-back buffer that will fetch the result from the UAV buffer object from the pool.
+    // It is always in the copy destination state and stays mapped.
+    ComputeReadbackBuffer *readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, readBackSize);
+
+    if (readBackBuffer == NULL)
+        return;
+
+    // With several jobs, the dispatches are recorded in parallel and submitted on their own first.
+    if (s_numJobs > 1 && !RecordComputeJobs())
+    {
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+        return;
+    }
+
+    // Record into the next frame's allocator and command list.
+    // The initialization commands are still allowed to run on the GPU meanwhile,
+    // since the frame ring only waits when the slot being reused is in flight.
+    s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, s_computeVariant->pipelineState, COMPUTE_WAIT_INFINITE);
+    if (s_computeCommandList == NULL)
+    {
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+        return;
+    }
+
+    ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+
+    if (s_numJobs <= 1)
+    {
+        RecordComputeBindings(s_computeCommandList);
+
+        // Declare how the dispatch accesses the buffers. The barriers from the states the previous command lists
+        // left them in are executed right before this command list at submit.
+        ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        // Dispatch the GPU threads, one group per elementsPerGroup elements.
+        // The group count is rounded up, and the threads past the last element are masked off by the kernel.
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Dispatch");
+        ComputeDispatchElements(s_computeCommandList, s_computeLayout.constantsParameters[0], s_testDataCount,
+            s_computeVariant->elementsPerGroup);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+    }
+
+    // The source elements are i + 1, so the results are generated on the fly instead of being uploaded.
+    const ComputeVerifyDesc verifyDesc = {
+        COMPUTE_ELEMENT_TYPE_INT, COMPUTE_VERIFY_EXPECTED_LINEAR, { .Int = 1 + s_computeVariantKey.Operand }, { .Int = 1 }, 0.0f
+    };
+    bool recorded = true;
+
+    if (s_hostVerify)
+    {
+        // Sync the dispatch operation, and make the UAV buffer object as the copy source.
+        // The next command list that dispatches into it gets the transition back to the unordered access state.
+        ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        // Copy data from the UAV buffer object to the read-back buffer object.
+        // The pooled buffer may be larger than the result, so only copy the region of the result.
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Readback");
+        s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, 0,
+            s_dstDataBuffer, 0, resultSize);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+    }
+    else
+    {
+        // Compare the result on the GPU, and only read back the mismatch count and the first mismatch indices.
+        ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerRequire(tracker, s_verifyResultBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Verify");
+        recorded = ComputeVerifierRecord(&s_verifier, s_computeCommandList, &verifyDesc, s_dstDataBuffer, NULL,
+            s_verifyResultBuffer, s_testDataCount);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+
+        ComputeStateTrackerRequire(tracker, s_verifyResultBuffer, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, 0,
+            s_verifyResultBuffer, 0, COMPUTE_VERIFY_RESULT_SIZE);
+    }
+
+    const uint64_t computeFenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+    s_computeCommandList = NULL;
+
+    // Wait until the GPU has completed the compute commands,
+    // then access the result straight in the mapped read-back memory.
+    ComputeReadbackView resultView;
+    if (!recorded || computeFenceValue == 0 || !ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, computeFenceValue,
+        readBackSize, COMPUTE_WAIT_INFINITE, &resultView))
+    {
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+        return;
+    }
+
+    // Verify the result
+    ComputeVerifyResult verifyResult;
+    if (s_hostVerify)
+        ComputeVerifyHost(s_hostThreads, &verifyDesc, resultView.pData, NULL, s_testDataCount, &verifyResult);
+    else
+        ComputeVerifyReadResult(resultView.pData, &verifyResult);
+
+    if (verifyResult.NumMismatches == 0)
+        puts("Verification OK!");
+    else
+    {
+        printf("%llu elements are not equal, the first one at index %llu!\n",
+            (unsigned long long)verifyResult.NumMismatches, (unsigned long long)verifyResult.FirstMismatch);
+        for (uint32_t i = 0; i < verifyResult.NumIndices; i++)
+            printf("  %llu\n", (unsigned long long)verifyResult.Indices[i]);
+    }
+
+    // After verifying the data, just give the read-back buffer back to the pool.
+    ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+}
+
+// One submission of DoAsyncCompute, checked by its completion callback
+typedef struct AsyncComputeJob
+{
+    ComputeReadbackBuffer *readBackBuffer;
+    ComputeFuture *future;
+    uint64_t numMismatches;
+} AsyncComputeJob;
+
+// Runs on the completion thread once the copy of the verification result has completed
+static void OnAsyncComputeComplete(void *context, uint64_t fenceValue)
+{
+    AsyncComputeJob *job = context;
+    (void)fenceValue;
+
+    ComputeVerifyResult verifyResult;
+    ComputeVerifyReadResult(job->readBackBuffer->pMappedData, &verifyResult);
+    job->numMismatches = verifyResult.NumMismatches;
+}
+
+// Submit s_numAsyncJobs runs of the compute operation, each verified on the GPU, without waiting between them.
+// The completion thread checks the result of each run as soon as its fence value is reached,
+// and this thread only waits on the futures once everything has been submitted.
+static void DoAsyncCompute(void)
+{
+    AsyncComputeJob *jobs = calloc(s_numAsyncJobs, sizeof(*jobs));
+    if (jobs == NULL)
+        return;
+
+    ComputeCompletionWatcher watcher;
+    if (!ComputeCompletionWatcherInit(&watcher))
+    {
+        free(jobs);
+        return;
+    }
+
+    // The source elements are i + 1, like in DoCompute.
+    const ComputeVerifyDesc verifyDesc = {
+        COMPUTE_ELEMENT_TYPE_INT, COMPUTE_VERIFY_EXPECTED_LINEAR, { .Int = 1 + s_computeVariantKey.Operand }, { .Int = 1 }, 0.0f
+    };
+
+    uint32_t numSubmitted = 0;
+    for (; numSubmitted < s_numAsyncJobs; numSubmitted++)
+    {
+        AsyncComputeJob *job = &jobs[numSubmitted];
+        job->readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, COMPUTE_VERIFY_RESULT_SIZE);
+        if (job->readBackBuffer == NULL)
+            break;
+
+        // The frame ring only blocks when all its frames are in flight.
+        s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, s_computeVariant->pipelineState, COMPUTE_WAIT_INFINITE);
+        if (s_computeCommandList == NULL)
+            break;
+
+        ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+        RecordComputeBindings(s_computeCommandList);
+        ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        ComputeDispatchElements(s_computeCommandList, s_computeLayout.constantsParameters[0], s_testDataCount,
+            s_computeVariant->elementsPerGroup);
+
+        // The runs share the result buffer of the verifier. The queue runs them in order,
+        // so each copy reads the result of its own run.
+        ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerRequire(tracker, s_verifyResultBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        const bool recorded = ComputeVerifierRecord(&s_verifier, s_computeCommandList, &verifyDesc, s_dstDataBuffer, NULL,
+            s_verifyResultBuffer, s_testDataCount);
+        ComputeStateTrackerRequire(tracker, s_verifyResultBuffer, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, job->readBackBuffer->resource, 0,
+            s_verifyResultBuffer, 0, COMPUTE_VERIFY_RESULT_SIZE);
+
+        job->future = ComputeCompletionSubmitFrame(&watcher, &s_computeFrames, OnAsyncComputeComplete, job);
+        s_computeCommandList = NULL;
+        if (!recorded || job->future == NULL)
+            break;
+    }
+
+    uint32_t numFailed = numSubmitted < s_numAsyncJobs ? 1 : 0;
+    for (uint32_t i = 0; i < s_numAsyncJobs; i++)
+    {
+        if (jobs[i].future != NULL)
+        {
+            if (!ComputeFutureWait(jobs[i].future, COMPUTE_WAIT_INFINITE) || jobs[i].numMismatches != 0)
+                numFailed++;
+            ComputeFutureRelease(jobs[i].future);
+        }
+    }
+
+    // All the futures are ready, so no callback reads the buffers anymore.
+    ComputeCompletionWatcherDestroy(&watcher);
+    for (uint32_t i = 0; i < s_numAsyncJobs; i++)
+    {
+        if (jobs[i].readBackBuffer != NULL)
+            ComputeReadbackPoolRelease(&s_readbackPool, jobs[i].readBackBuffer);
+    }
+    free(jobs);
+
+    if (numFailed == 0)
+        printf("Async verification OK! (%u submissions)\n", s_numAsyncJobs);
+    else
+        printf("Async verification failed! (%u of %u submissions)\n", numFailed, s_numAsyncJobs);
+}
+
+// Create the devices of the sharded run. On D3D12 there is one device per adapter, up to s_numShardDevices.
+// The CPU backend creates s_numShardDevices devices of decreasing simulated speeds instead, which share the cores.
+static uint32_t CreateShardDevices(ComputeDevice **devices)
+{
+    uint32_t numDevices = 0;
+
+#ifdef _WIN32
+    if (s_device->lpVtbl->GetBackendType(s_device) == COMPUTE_BACKEND_D3D12)
+    {
+        ComputeAdapterDesc adapters[COMPUTE_SHARD_MAX_DEVICES];
+        uint32_t numAdapters = EnumD3D12ComputeAdapters(adapters, COMPUTE_SHARD_MAX_DEVICES);
+        if (numAdapters > s_numShardDevices)
+            numAdapters = s_numShardDevices;
+
+        for (uint32_t i = 0; i < numAdapters; i++)
+        {
+            devices[numDevices] = CreateD3D12ComputeDeviceOnAdapter(i);
+            if (devices[numDevices] != NULL)
+            {
+                printf("Shard device %u: %s%s\n", numDevices, adapters[i].Description, adapters[i].Software ? " (software)" : "");
+                numDevices++;
+            }
+        }
+        return numDevices;
+    }
+#endif
+
+    const uint32_t numProcessors = ComputeGetProcessorCount();
+    for (uint32_t i = 0; i < s_numShardDevices; i++)
+    {
+        const ComputeCPUDeviceDesc desc = {
+            numProcessors > s_numShardDevices ? numProcessors / s_numShardDevices : 1, 100 / (i + 1)
+        };
+        devices[numDevices] = CreateCPUComputeDevice(&desc);
+        if (devices[numDevices] != NULL)
+        {
+            printf("Shard device %u: CPU at %u%% speed\n", numDevices, desc.SpeedPercent);
+            numDevices++;
+        }
+    }
+    return numDevices;
+}
+
+// Shard the compute operation over several devices for a few runs, and check the gathered result of each.
+// The first run splits the elements evenly, the next ones follow the throughput measured on each device.
+static void DoShardCompute(void)
+{
+    const size_t dataSize = (size_t)s_testDataCount * sizeof(int);
+    int *output = malloc(dataSize);
+    if (output == NULL)
+        return;
+
+    ComputeDevice *devices[COMPUTE_SHARD_MAX_DEVICES];
+    const uint32_t numDevices = CreateShardDevices(devices);
+
+    const ComputeShardKernelDesc kernelDesc = {
+        "shader_cache", "compute.hlsl", "CSMain", "cs_5_0", s_compileFlags, s_computeVariantKey
+    };
+    ComputeShardScheduler scheduler;
+    if (numDevices == 0 || !ComputeShardSchedulerInit(&scheduler, devices, numDevices, &kernelDesc))
+    {
+        puts("Failed to create the shard devices!");
+        free(output);
+        return;
+    }
+
+    // The source elements are i + 1, like in DoCompute.
+    const ComputeVerifyDesc verifyDesc = {
+        COMPUTE_ELEMENT_TYPE_INT, COMPUTE_VERIFY_EXPECTED_LINEAR, { .Int = 1 + s_computeVariantKey.Operand }, { .Int = 1 }, 0.0f
+    };
+
+    bool equal = true;
+    for (uint32_t run = 0; run < 4 && equal; run++)
+    {
+        memset(output, 0, dataSize);
+        if (!ComputeShardSchedulerRun(&scheduler, s_DataBuffer0, output, s_testDataCount))
+        {
+            puts("The sharded run failed!");
+            equal = false;
+            break;
+        }
+
+        printf("Shard run %u:", run);
+        for (uint32_t i = 0; i < numDevices; i++)
+        {
+            printf(" %llu (%.1f M/s)", (unsigned long long)scheduler.devices[i].numElements,
+                scheduler.devices[i].throughput / 1e6);
+        }
+        puts("");
+
+        ComputeVerifyResult verifyResult;
+        ComputeVerifyHost(s_hostThreads, &verifyDesc, output, NULL, s_testDataCount, &verifyResult);
+        if (verifyResult.NumMismatches != 0)
+        {
+            printf("%llu elements are not equal after sharding, the first one at index %llu!\n",
+                (unsigned long long)verifyResult.NumMismatches, (unsigned long long)verifyResult.FirstMismatch);
+            equal = false;
+        }
+    }
+    if (equal)
+        printf("Sharded verification OK! (%u devices)\n", numDevices);
+
+    ComputeShardSchedulerDestroy(&scheduler);
+    free(output);
+}
+
+// The buffers of the primitives check: the keys, the outputs and the scratch buffer
+typedef enum PrimitiveBuffer
+{
+    PRIMITIVE_BUFFER_KEYS,
+    PRIMITIVE_BUFFER_SCAN,
+    PRIMITIVE_BUFFER_COMPACT,
+    PRIMITIVE_BUFFER_SORTED_KEYS,
+    PRIMITIVE_BUFFER_SORTED_VALUES,
+    PRIMITIVE_BUFFER_COUNT_RESULT,
+    PRIMITIVE_BUFFER_SUM,
+    PRIMITIVE_BUFFER_SCRATCH,
+    PRIMITIVE_BUFFER_COUNT
+} PrimitiveBuffer;
+
+// Run the parallel primitives on random keys and check them against the host primitives:
+// the scan and the reduction of the keys, the compaction of the non-zero keys, and the sort of the keys with the test data as values.
+static void DoPrimitives(void)
+{
+    const size_t dataSize = (size_t)s_testDataCount * sizeof(uint32_t);
+    // The outputs are read back one after another, followed by the count of the compaction and the sum of the reduction.
+    const uint64_t readBackSize = 4 * (uint64_t)dataSize + 2 * sizeof(uint32_t);
+
+    ComputePrimitives primitives = { 0 };
+    ComputeResourceAllocation allocations[PRIMITIVE_BUFFER_COUNT] = { 0 };
+    ComputeReadbackBuffer *readBackBuffer = NULL;
+    uint32_t *hostData = NULL;
+
+    do
+    {
+        if (!ComputePrimitivesInit(&primitives, &s_shaderCache, &s_descriptors, "primitives.hlsl", 256, 4, s_compileFlags))
+            break;
+
+        // The keys, the host results and the host copy of the values
+        hostData = malloc(5 * dataSize);
+        readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, readBackSize);
+        if (hostData == NULL || readBackBuffer == NULL)
+            break;
+
+        // Random keys, a quarter of them zero for the compaction
+        uint32_t *keys = hostData;
+        uint32_t seed = 12345;
+        for (uint32_t i = 0; i < s_testDataCount; i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            keys[i] = (seed & 3) == 0 ? 0 : seed;
+        }
+
+        uint64_t scratchSize = 0;
+        for (ComputePrimitiveType type = COMPUTE_PRIMITIVE_REDUCE; type <= COMPUTE_PRIMITIVE_SORT; type++)
+        {
+            const uint64_t size = ComputePrimitivesGetScratchSize(&primitives, type, s_testDataCount, true);
+            scratchSize = size > scratchSize ? size : scratchSize;
+        }
+
+        bool created = true;
+        for (uint32_t i = 0; i < PRIMITIVE_BUFFER_COUNT && created; i++)
+        {
+            const ComputeResourceDesc desc = {
+                i == PRIMITIVE_BUFFER_SCRATCH ? scratchSize : i >= PRIMITIVE_BUFFER_COUNT_RESULT ? sizeof(uint32_t) : dataSize,
+                i == PRIMITIVE_BUFFER_KEYS ? COMPUTE_RESOURCE_FLAG_NONE : COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS
+            };
+            const ComputeResourceStates state = i == PRIMITIVE_BUFFER_KEYS ?
+                COMPUTE_RESOURCE_STATE_COPY_DEST : COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS;
+            created = ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &desc, state, &allocations[i]);
+            if (created && !ComputeResourceStateTableRegister(&s_resourceStates, allocations[i].resource, state))
+            {
+                ComputeResourceAllocatorFree(&s_resourceAllocator, &allocations[i]);
+                memset(&allocations[i], 0, sizeof(allocations[i]));
+                created = false;
+            }
+        }
+        if (!created)
+            break;
+
+        ComputeResource *keysBuffer = allocations[PRIMITIVE_BUFFER_KEYS].resource;
+        ComputeResource *scratch = allocations[PRIMITIVE_BUFFER_SCRATCH].resource;
+
+        s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, NULL, COMPUTE_WAIT_INFINITE);
+        if (s_computeCommandList == NULL)
+            break;
+
+        ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+        ComputeStateTrackerRequire(tracker, keysBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        const ComputeSubresourceData subResourceData = { keys, dataSize, dataSize };
+        bool recorded = UpdateSubresourcesFromRing(s_computeCommandList, keysBuffer, &s_uploadRing, 0, 1, &subResourceData) != 0;
+
+        ComputeStateTrackerRequire(tracker, keysBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        for (uint32_t i = PRIMITIVE_BUFFER_SCAN; i < PRIMITIVE_BUFFER_COUNT; i++)
+            ComputeStateTrackerRequire(tracker, allocations[i].resource, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        // The primitives share the scratch buffer, each one is done with it when the next one starts.
+        // The keys are their own compaction flags.
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Primitives");
+        recorded = recorded &&
+            ComputePrimitivesScan(&primitives, s_computeCommandList, keysBuffer, allocations[PRIMITIVE_BUFFER_SCAN].resource,
+                scratch, s_testDataCount) &&
+            ComputePrimitivesCompact(&primitives, s_computeCommandList, keysBuffer, keysBuffer,
+                allocations[PRIMITIVE_BUFFER_COMPACT].resource, allocations[PRIMITIVE_BUFFER_COUNT_RESULT].resource, scratch,
+                s_testDataCount) &&
+            ComputePrimitivesSort(&primitives, s_computeCommandList, keysBuffer, s_srcDataBuffer,
+                allocations[PRIMITIVE_BUFFER_SORTED_KEYS].resource, allocations[PRIMITIVE_BUFFER_SORTED_VALUES].resource,
+                scratch, s_testDataCount, 32) &&
+            ComputePrimitivesReduce(&primitives, s_computeCommandList, keysBuffer, allocations[PRIMITIVE_BUFFER_SUM].resource,
+                scratch, s_testDataCount);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+
+        for (uint32_t i = PRIMITIVE_BUFFER_SCAN; i < PRIMITIVE_BUFFER_SCRATCH; i++)
+            ComputeStateTrackerRequire(tracker, allocations[i].resource, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        uint64_t readBackOffset = 0;
+        for (uint32_t i = PRIMITIVE_BUFFER_SCAN; i < PRIMITIVE_BUFFER_SCRATCH; i++)
+        {
+            const uint64_t size = i >= PRIMITIVE_BUFFER_COUNT_RESULT ? sizeof(uint32_t) : dataSize;
+            s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, readBackOffset,
+                allocations[i].resource, 0, size);
+            readBackOffset += size;
+        }
+
+        // The command list is submitted even if recording failed, so the frame is recycled.
+        const uint64_t fenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+        s_computeCommandList = NULL;
+
+        ComputeReadbackView resultView;
+        if (!recorded || fenceValue == 0 || !ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, fenceValue,
+            readBackSize, COMPUTE_WAIT_INFINITE, &resultView))
+        {
+            puts("Running the primitives failed!");
+            break;
+        }
+
+        // The same primitives on the host threads, while the keys are still in their original order
+        uint32_t *hostScan = hostData + s_testDataCount;
+        uint32_t *hostCompact = hostScan + s_testDataCount;
+        uint32_t *hostValues = hostCompact + s_testDataCount;
+        uint32_t *hostKeys = hostValues + s_testDataCount;
+        ComputeHostScan(s_hostThreads, keys, hostScan, s_testDataCount);
+        const size_t hostCount = ComputeHostCompact(s_hostThreads, keys, keys, hostCompact, s_testDataCount);
+        const uint32_t hostSum = ComputeHostReduce(s_hostThreads, keys, s_testDataCount);
+        memcpy(hostKeys, keys, dataSize);
+        memcpy(hostValues, s_DataBuffer0, dataSize);
+        if (!ComputeHostSort(s_hostThreads, hostKeys, hostValues, s_testDataCount, 32))
+            break;
+
+        const uint32_t *results = resultView.pData;
+        const uint32_t *resultTotals = results + 4 * (size_t)s_testDataCount;
+        if (memcmp(results, hostScan, dataSize) != 0)
+            puts("The scan is not equal!");
+        else if (resultTotals[0] != hostCount || memcmp(results + s_testDataCount, hostCompact, hostCount * sizeof(uint32_t)) != 0)
+            puts("The compaction is not equal!");
+        else if (memcmp(results + 2 * (size_t)s_testDataCount, hostKeys, dataSize) != 0 ||
+            memcmp(results + 3 * (size_t)s_testDataCount, hostValues, dataSize) != 0)
+            puts("The sort is not equal!");
+        else if (resultTotals[1] != hostSum)
+            puts("The reduction is not equal!");
+        else
+            printf("Primitives verification OK! (%zu elements kept by the compaction)\n", hostCount);
+
+    } while (false);
+
+    // The primitives are waited for, or were never submitted.
+    ComputePrimitivesDestroy(&primitives);
+    if (readBackBuffer != NULL)
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+    for (uint32_t i = 0; i < PRIMITIVE_BUFFER_COUNT; i++)
+    {
+        if (allocations[i].resource != NULL)
+        {
+            ComputeResourceStateTableUnregister(&s_resourceStates, allocations[i].resource);
+            ComputeResourceAllocatorFree(&s_resourceAllocator, &allocations[i]);
+        }
+    }
+    free(hostData);
+}
+
+// Update records of mixed field types in the SoA layout, and check them once transposed back
+static void DoRecords(void)
+{
+    const size_t recordsSize = (size_t)s_testDataCount * sizeof(TestRecord);
+
+    uint64_t fieldOffsets[COMPUTE_STRUCT_MAX_FIELDS];
+    const uint64_t soaSize = ComputeStructLayoutGetSoAOffsets(&s_testRecordLayout, s_testDataCount, fieldOffsets);
+
+    ComputeRootLayout layout = { 0 };
+    ComputePipelineState *pipelineState = NULL;
+    ComputeTypedBuffer buffer = { 0 };
+    ComputeReadbackBuffer *readBackBuffer = NULL;
+    TestRecord *records = malloc(2 * recordsSize);
+
+    do
+    {
+        if (records == NULL || soaSize == 0 || soaSize > UINT32_MAX)
+            break;
+
+        const ComputeShaderMacro defines[] = { { "GROUP_SIZE", "256" }, { NULL, NULL } };
+        ComputeBlob *shader;
+        if (!ComputeShaderCacheCompile(&s_shaderCache, "records.hlsl", defines, "UpdateRecords", "cs_5_0", s_compileFlags, &shader))
+            break;
+
+        // The root signature is generated from the reflected bindings: the records as a whole are a raw buffer
+        // bound as a root UAV, the kernel reading the fields at the offsets passed as root constants.
+        ComputePipelineStateDesc psoDesc = { 0 };
+        psoDesc.CS = (ComputeShaderBytecode){ shader->lpVtbl->GetBufferPointer(shader), shader->lpVtbl->GetBufferSize(shader) };
+        ComputeShaderReflection reflection;
+        const bool reflected = s_device->lpVtbl->ReflectShader(s_device, &psoDesc.CS, &reflection) &&
+            ComputeRootLayoutCreate(&layout, s_device, &reflection, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS);
+        psoDesc.pRootSignature = layout.rootSignature;
+        pipelineState = reflected ? ComputeShaderCacheCreatePipelineState(&s_shaderCache, &psoDesc) : NULL;
+        shader->lpVtbl->Release(shader);
+        if (pipelineState == NULL)
+            break;
+
+        const ComputeTypedBufferDesc bufferDesc = {
+            COMPUTE_ELEMENT_TYPE_UINT, 0, (uint32_t)((soaSize + 3) / 4), COMPUTE_BUFFER_VIEW_RAW,
+            COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS
+        };
+        if (!ComputeTypedBufferCreate(&buffer, &s_resourceAllocator, &bufferDesc, COMPUTE_RESOURCE_STATE_COPY_DEST))
+            break;
+        if (!ComputeResourceStateTableRegister(&s_resourceStates, buffer.allocation.resource, COMPUTE_RESOURCE_STATE_COPY_DEST))
+        {
+            ComputeTypedBufferDestroy(&buffer, &s_resourceAllocator);
+            break;
+        }
+
+        readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, soaSize);
+        if (readBackBuffer == NULL)
+            break;
+
+        for (uint32_t i = 0; i < s_testDataCount; i++)
+        {
+            records[i].value = (float)i * 0.5f;
+            records[i].scale = ComputeFloatToHalf(0.25f * (float)(i % 8 + 1));
+            records[i].id = (int64_t)i * 0x100000001LL;
+        }
+
+        s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, pipelineState, COMPUTE_WAIT_INFINITE);
+        if (s_computeCommandList == NULL)
+            break;
+
+        // The records are transposed as they are staged
+        ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+        ComputeStateTrackerRequire(tracker, buffer.allocation.resource, COMPUTE_RESOURCE_STATE_COPY_DEST);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        const bool uploaded = ComputeUploadRecordsSoA(s_computeCommandList, buffer.allocation.resource, 0, &s_uploadRing,
+            &s_testRecordLayout, records, s_testDataCount) != 0;
+
+        ComputeStateTrackerRequire(tracker, buffer.allocation.resource, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        s_computeCommandList->lpVtbl->SetComputeRootSignature(s_computeCommandList, layout.rootSignature);
+        ComputeRootLayoutSetUAV(&layout, s_computeCommandList, 0, buffer.allocation.resource, 0);
+
+        // The offsets of the value, scale and id arrays, and the increment of the ids
+        const uint32_t constants[4] = {
+            (uint32_t)fieldOffsets[0], (uint32_t)fieldOffsets[1], (uint32_t)fieldOffsets[2], (uint32_t)TEST_RECORD_ID_INCREMENT
+        };
+        s_computeCommandList->lpVtbl->SetComputeRoot32BitConstants(s_computeCommandList, layout.constantsParameters[0], 4, constants,
+            COMPUTE_DISPATCH_CONSTANTS_COUNT);
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Update records");
+        ComputeDispatchElements(s_computeCommandList, layout.constantsParameters[0], s_testDataCount, reflection.ThreadGroupSize[0]);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+
+        ComputeStateTrackerRequire(tracker, buffer.allocation.resource, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+        s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, 0,
+            buffer.allocation.resource, 0, soaSize);
+
+        const uint64_t fenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+        s_computeCommandList = NULL;
+
+        ComputeReadbackView resultView;
+        if (!uploaded || fenceValue == 0 || !ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, fenceValue,
+            soaSize, COMPUTE_WAIT_INFINITE, &resultView))
+        {
+            puts("Updating the records failed!");
+            break;
+        }
+
+        // Back to records, after the source ones
+        TestRecord *results = records + s_testDataCount;
+        const void *fieldArrays[COMPUTE_STRUCT_MAX_FIELDS];
+        for (uint32_t field = 0; field < s_testRecordLayout.NumFields; field++)
+            fieldArrays[field] = (const uint8_t*)resultView.pData + fieldOffsets[field];
+        ComputeHostSoAToAoS(results, fieldArrays, &s_testRecordLayout, s_testDataCount);
+
+        bool equal = true;
+        for (uint32_t i = 0; i < s_testDataCount && equal; i++)
+        {
+            const float value = records[i].value * ComputeHalfToFloat(records[i].scale);
+            if (results[i].value != value || results[i].scale != records[i].scale ||
+                results[i].id != records[i].id + TEST_RECORD_ID_INCREMENT)
+            {
+                printf("%u index records are not equal!\n", i);
+                equal = false;
+            }
+        }
+        if (equal)
+            printf("Records verification OK! (%u bytes per record, %llu bytes in SoA layout)\n",
+                (uint32_t)sizeof(TestRecord), (unsigned long long)soaSize);
+
+    } while (false);
+
+    // The records are waited for, or were never submitted.
+    if (readBackBuffer != NULL)
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+    if (buffer.allocation.resource != NULL)
+    {
+        ComputeResourceStateTableUnregister(&s_resourceStates, buffer.allocation.resource);
+        ComputeTypedBufferDestroy(&buffer, &s_resourceAllocator);
+    }
+    if (pipelineState != NULL)
+        pipelineState->lpVtbl->Release(pipelineState);
+    ComputeRootLayoutDestroy(&layout);
+    free(records);
+}
+
+// A chain of elementwise operations on the source data, run as one generated kernel:
+//  out0 = (int)clamp((float)src * 0.5f + 3.0f, 0.0f, 1000.0f)
+//  out1 = (uint)(src * 3 - 7)
+// Step by step, each operation would be a Dispatch of its own with a buffer round trip for each intermediate value.
+static void DoFused(void)
+{
+    const size_t dataSize = (size_t)s_testDataCount * sizeof(int);
+
+    ComputeTypedBuffer outputs[2] = { 0 };
+    ComputeReadbackBuffer *readBackBuffer = NULL;
+    int32_t *expected = malloc(2 * dataSize);
+
+    do
+    {
+        if (expected == NULL || !ComputeFusedKernelCacheInit(&s_fusedKernels, &s_shaderCache, "cs_5_0", s_compileFlags))
+            break;
+
+        ComputeFusedExpression expr;
+        ComputeFusedExpressionInit(&expr);
+        // The arguments of a call are evaluated in any order, so the nodes are added one statement at a time
+        // for the expression, and so its kernel, to be the same with any compiler.
+        const ComputeFusedValue src = ComputeFusedInput(&expr, COMPUTE_ELEMENT_TYPE_INT);
+        ComputeFusedValue value = ComputeFusedCast(&expr, src, COMPUTE_ELEMENT_TYPE_FLOAT);
+        value = ComputeFusedMul(&expr, value, ComputeFusedConstantFloat(&expr, 0.5f));
+        value = ComputeFusedAdd(&expr, value, ComputeFusedConstantFloat(&expr, 3.0f));
+        const ComputeFusedValue low = ComputeFusedConstantFloat(&expr, 0.0f);
+        value = ComputeFusedClamp(&expr, value, low, ComputeFusedConstantFloat(&expr, 1000.0f));
+        ComputeFusedOutput(&expr, ComputeFusedCast(&expr, value, COMPUTE_ELEMENT_TYPE_INT));
+
+        value = ComputeFusedMul(&expr, src, ComputeFusedConstantInt(&expr, 3));
+        value = ComputeFusedSub(&expr, value, ComputeFusedConstantInt(&expr, 7));
+        ComputeFusedOutput(&expr, ComputeFusedCast(&expr, value, COMPUTE_ELEMENT_TYPE_UINT));
+
+        const ComputeFusedKernel *kernel = ComputeFusedKernelCacheGet(&s_fusedKernels, &expr);
+        if (kernel == NULL)
+            break;
+
+        bool created = true;
+        for (uint32_t i = 0; i < 2 && created; i++)
+        {
+            const ComputeTypedBufferDesc bufferDesc = {
+                i == 0 ? COMPUTE_ELEMENT_TYPE_INT : COMPUTE_ELEMENT_TYPE_UINT, 0, s_testDataCount, COMPUTE_BUFFER_VIEW_STRUCTURED,
+                COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS
+            };
+            created = ComputeTypedBufferCreate(&outputs[i], &s_resourceAllocator, &bufferDesc, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+            if (created && !ComputeResourceStateTableRegister(&s_resourceStates, outputs[i].allocation.resource,
+                COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS))
+            {
+                ComputeTypedBufferDestroy(&outputs[i], &s_resourceAllocator);
+                created = false;
+            }
+        }
+        if (!created)
+            break;
+
+        readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, 2 * dataSize);
+        if (readBackBuffer == NULL)
+            break;
+
+        s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, kernel->pipelineState, COMPUTE_WAIT_INFINITE);
+        if (s_computeCommandList == NULL)
+            break;
+
+        ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+        ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        ComputeResource *const inputBuffers[1] = { s_srcDataBuffer };
+        ComputeResource *const outputBuffers[2] = { outputs[0].allocation.resource, outputs[1].allocation.resource };
+        COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Fused kernel");
+        ComputeFusedKernelDispatch(kernel, s_computeCommandList, inputBuffers, outputBuffers, s_testDataCount);
+        COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            ComputeStateTrackerRequire(tracker, outputBuffers[i], COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+            ComputeStateTrackerFlush(tracker, s_computeCommandList);
+            s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, i * dataSize,
+                outputBuffers[i], 0, dataSize);
+        }
+
+        const uint64_t fenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+        s_computeCommandList = NULL;
+
+        ComputeReadbackView resultView;
+        if (fenceValue == 0 || !ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, fenceValue,
+            2 * dataSize, COMPUTE_WAIT_INFINITE, &resultView))
+        {
+            puts("The fused kernel failed!");
+            break;
+        }
+
+        // The host evaluates the same expression, the float values being precise in the kernel
+        const void *hostInputs[1] = { s_DataBuffer0 };
+        void *hostOutputs[2] = { expected, expected + s_testDataCount };
+        ComputeFusedEvaluate(&expr, hostInputs, hostOutputs, 0, s_testDataCount);
+
+        // Both outputs are compared as a whole, bit for bit
+        const ComputeVerifyDesc verifyDesc = { .ElementType = COMPUTE_ELEMENT_TYPE_UINT, .Expected = COMPUTE_VERIFY_EXPECTED_BUFFER };
+        ComputeVerifyResult verifyResult;
+        ComputeVerifyHost(s_hostThreads, &verifyDesc, resultView.pData, expected, 2 * (size_t)s_testDataCount, &verifyResult);
+        if (verifyResult.NumMismatches != 0)
+            printf("%llu index of the output %llu of the fused kernel is not equal!\n",
+                (unsigned long long)(verifyResult.FirstMismatch % s_testDataCount),
+                (unsigned long long)(verifyResult.FirstMismatch / s_testDataCount));
+        else
+            printf("Fused kernel verification OK! (%u nodes in one Dispatch, kernel fused_%016llx)\n",
+                expr.numNodes, (unsigned long long)kernel->hash);
+
+    } while (false);
+
+    // The kernel is waited for, or was never submitted.
+    if (readBackBuffer != NULL)
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (outputs[i].allocation.resource != NULL)
+        {
+            ComputeResourceStateTableUnregister(&s_resourceStates, outputs[i].allocation.resource);
+            ComputeTypedBufferDestroy(&outputs[i], &s_resourceAllocator);
+        }
+    }
+    ComputeFusedKernelCacheDestroy(&s_fusedKernels);
+    free(expected);
+}
+
+// Write new input data to the SRV buffer, and leave the buffers in the states the job graph rests in
+static uint64_t SubmitGraphInputs(const void *inputData)
+{
+    s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, NULL, COMPUTE_WAIT_INFINITE);
+    if (s_computeCommandList == NULL)
+        return 0;
+
+    ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+    bool uploaded = true;
+    if (inputData != NULL)
+    {
+        ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST);
+        ComputeStateTrackerFlush(tracker, s_computeCommandList);
+
+        const size_t dataSize = (size_t)s_testDataCount * sizeof(int);
+        const ComputeSubresourceData subResourceData = { inputData, dataSize, dataSize };
+        uploaded = UpdateSubresourcesFromRing(s_computeCommandList, s_srcDataBuffer, &s_uploadRing, 0, 1, &subResourceData) != 0;
+    }
+    ComputeStateTrackerRequire(tracker, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerRequire(tracker, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    // The command list is submitted even if the upload failed, so the frame is recycled.
+    const uint64_t fenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+    s_computeCommandList = NULL;
+    if (!uploaded)
+    {
+        puts("Failed to upload the input data of the job graph!");
+        return 0;
+    }
+    return fenceValue;
+}
+
+// Chain s_numStages runs of the compute operation through a job graph, then read back the result.
+// The graph is recorded once and executed twice, the second time with new input data.
+static void DoGraphCompute(void)
+{
+    const size_t dataSize = (size_t)s_testDataCount * sizeof(int);
+
+    ComputeJobGraph graph;
+    ComputeJobGraphInit(&graph);
+    ComputeResourceAllocation tmpAllocation = { 0 };
+    ComputeReadbackBuffer *readBackBuffer = NULL;
+    int *inputData = NULL;
+
+    do
+    {
+        // The stages alternate between the UAV buffer and a temporary buffer, the last one writing the UAV buffer.
+        const ComputeResourceDesc tmpDesc = { dataSize, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+        if (!ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &tmpDesc,
+            COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, &tmpAllocation))
+            break;
+
+        readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, dataSize);
+        inputData = malloc(dataSize);
+        if (readBackBuffer == NULL || inputData == NULL)
+            break;
+
+        // The buffers are bound to the root descriptors by address, so the stages need no view.
+        ComputeResource *const buffers[3] = { s_srcDataBuffer, s_dstDataBuffer, tmpAllocation.resource };
+
+        if (!ComputeJobGraphAddBuffer(&graph, s_srcDataBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) ||
+            !ComputeJobGraphAddBuffer(&graph, s_dstDataBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS) ||
+            !ComputeJobGraphAddBuffer(&graph, tmpAllocation.resource, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS) ||
+            !ComputeJobGraphAddBuffer(&graph, readBackBuffer->resource, COMPUTE_RESOURCE_STATE_COPY_DEST))
+            break;
+
+        bool added = true;
+        uint32_t input = 0;
+        for (uint32_t stage = 0; stage < s_numStages && added; stage++)
+        {
+            const uint32_t output = (s_numStages - 1 - stage) % 2 == 0 ? 1 : 2;
+
+            const ComputeJobRootDescriptor rootDescriptors[2] = {
+                { s_computeLayout.srvParameters[0], COMPUTE_ROOT_PARAMETER_TYPE_SRV,
+                    buffers[input]->lpVtbl->GetGPUVirtualAddress(buffers[input]) },
+                { s_computeLayout.uavParameters[0], COMPUTE_ROOT_PARAMETER_TYPE_UAV,
+                    buffers[output]->lpVtbl->GetGPUVirtualAddress(buffers[output]) }
+            };
+            const ComputeJobAccess accesses[2] = {
+                { buffers[input], COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE },
+                { buffers[output], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS }
+            };
+            const ComputeJobKernelDesc kernelDesc = {
+                s_computeVariant->pipelineState, s_computeLayout.rootSignature, NULL, 0, NULL, 2, rootDescriptors,
+                s_computeLayout.constantsParameters[0], s_testDataCount, s_computeVariant->elementsPerGroup, 2, accesses
+            };
+            added = ComputeJobGraphAddKernel(&graph, &kernelDesc);
+            input = output;
+        }
+
+        const ComputeJobCopyDesc copyDesc = { readBackBuffer->resource, 0, s_dstDataBuffer, 0, dataSize };
+        if (!added || !ComputeJobGraphAddCopy(&graph, &copyDesc) ||
+            !ComputeJobGraphCompile(&graph, s_device, COMPUTE_COMMAND_LIST_TYPE_COMPUTE))
+            break;
+
+        // The first execution reads the current input, the second one a new input.
+        bool equal = true;
+        for (int run = 0; run < 2 && equal; run++)
+        {
+            const int *expected = s_DataBuffer0;
+            if (run > 0)
+            {
+                for (uint32_t i = 0; i < s_testDataCount; i++)
+                    inputData[i] = (int)(s_testDataCount - i);
+                expected = inputData;
+            }
+
+            ComputeReadbackView resultView;
+            const uint64_t fenceValue = SubmitGraphInputs(run > 0 ? inputData : NULL) == 0 ? 0 :
+                ComputeJobGraphExecute(&graph, &s_computeTimeline);
+            if (fenceValue == 0 || !ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, fenceValue,
+                dataSize, COMPUTE_WAIT_INFINITE, &resultView))
+            {
+                equal = false;
+                break;
+            }
+
+            const int *resultBuffer = resultView.pData;
+            for (uint32_t i = 0; i < s_testDataCount; i++)
+            {
+                if (resultBuffer[i] - (int)s_numStages * s_computeVariantKey.Operand != expected[i])
+                {
+                    printf("%u index elements are not equal after %u stages!\n", i, s_numStages);
+                    equal = false;
+                    break;
+                }
+            }
+        }
+        if (equal)
+            printf("Job graph verification OK! (%u stages, %u levels)\n", s_numStages, graph.numLevels);
+
+    } while (false);
+
+    // The graph waits for its last execution, so the buffers it uses are released after it.
+    ComputeJobGraphDestroy(&graph);
+    if (readBackBuffer != NULL)
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+    if (tmpAllocation.resource != NULL)
+        ComputeResourceAllocatorFree(&s_resourceAllocator, &tmpAllocation);
+    free(inputData);
+}
+
+// Record the compute operation of one streamed chunk
+static bool RecordStreamChunk(void *context, ComputeCommandList *commandList, const ComputeStreamChunk *chunk)
+{
+    (void)context;
+
+    commandList->lpVtbl->SetPipelineState(commandList, s_computeVariant->pipelineState);
+    commandList->lpVtbl->SetComputeRootSignature(commandList, s_computeLayout.rootSignature);
+    ComputeRootLayoutSetSRV(&s_computeLayout, commandList, 0, chunk->inputBuffer, 0);
+    ComputeRootLayoutSetUAV(&s_computeLayout, commandList, 0, chunk->outputBuffer, 0);
+
+    // The last chunk may be shorter, the kernel skips the elements past its end.
+    ComputeDispatchElements(commandList, s_computeLayout.constantsParameters[0], (uint32_t)chunk->numElements,
+        s_computeVariant->elementsPerGroup);
+
+    return true;
+}
+
+// Add 10 to every int of the input file, writing the output file.
+// The files may be far larger than the memory, they are processed chunk by chunk.
+static void DoStreamCompute(const char *inputPath, const char *outputPath)
+{
+    const ComputeStreamDesc streamDesc = { sizeof(int), STREAM_CHUNK_COUNT, STREAM_SLOT_COUNT, RecordStreamChunk, NULL };
+
+    const uint64_t startTime = ComputeGetTimeNanoseconds();
+    if (!ComputeStreamFile(s_device, &s_copyTimeline, &s_computeTimeline, &s_descriptors, &streamDesc, inputPath, outputPath))
+    {
+        puts("Streaming compute failed!");
+        return;
+    }
+
+    printf("Streaming compute finished in %.3f ms.\n", (double)(ComputeGetTimeNanoseconds() - startTime) / 1000000.0);
+}
+
+// A command list that only records the barriers it is given, so the state tracker is checked without any device
+typedef struct BarrierRecorder
+{
+    ComputeCommandList list;
+    uint32_t numCalls;
+    uint32_t numBarriers;
+    ComputeResourceBarrier barriers[8];
+} BarrierRecorder;
+
+static void BarrierRecorder_ResourceBarrier(ComputeCommandList *This, uint32_t NumBarriers, const ComputeResourceBarrier *pBarriers)
+{
+    BarrierRecorder *recorder = (BarrierRecorder*)This;
+    recorder->numCalls++;
+    for (uint32_t i = 0; i < NumBarriers && recorder->numBarriers < 8; i++)
+        recorder->barriers[recorder->numBarriers++] = pBarriers[i];
+}
+
+static const ComputeCommandListVtbl s_barrierRecorderVtbl = { .ResourceBarrier = BarrierRecorder_ResourceBarrier };
+
+// Compare the barriers recorded since the last check with the expected ones, all in at most one ResourceBarrier call
+static bool CheckRecordedBarriers(BarrierRecorder *recorder, const ComputeResourceBarrier *expected, uint32_t numExpected,
+    const char *name)
+{
+    bool matched = recorder->numCalls == (numExpected > 0 ? 1U : 0U) && recorder->numBarriers == numExpected;
+    for (uint32_t i = 0; i < numExpected && matched; i++)
+    {
+        const ComputeResourceBarrier *actual = &recorder->barriers[i];
+        matched = actual->Type == expected[i].Type && actual->Flags == expected[i].Flags && actual->pResource == expected[i].pResource &&
+            (actual->Type == COMPUTE_RESOURCE_BARRIER_TYPE_UAV ||
+                (actual->StateBefore == expected[i].StateBefore && actual->StateAfter == expected[i].StateAfter));
+    }
+    if (!matched)
+        printf("State tracker: wrong barriers for %s (%u calls, %u barriers)!\n", name, recorder->numCalls, recorder->numBarriers);
+
+    recorder->numCalls = 0;
+    recorder->numBarriers = 0;
+    return matched;
+}
+
+// Check the barriers the state tracker derives for a few command sequences, on placeholder resources
+// that are never dereferenced: the merge and the removal of pending transitions, the combination of read states,
+// the UAV barriers between dependent commands only, the split barriers and the resolution against the state table.
+static void DoStateTrackerTest(void)
+{
+    enum { MERGED, DROPPED, READ, UAV, OTHER_UAV, SPLIT, NUM_RESOURCES };
+    ComputeResource resources[NUM_RESOURCES] = { 0 };
+    BarrierRecorder recorder;
+    memset(&recorder, 0, sizeof(recorder));
+    recorder.list.lpVtbl = &s_barrierRecorderVtbl;
+    ComputeCommandList *commandList = &recorder.list;
+
+    ComputeStateTracker tracker;
+    ComputeResourceStateTable table;
+    if (!ComputeStateTrackerInit(&tracker))
+        return;
+    if (!ComputeResourceStateTableInit(&table))
+    {
+        ComputeStateTrackerDestroy(&tracker);
+        return;
+    }
+
+    const ComputeResourceBarrierType transition = COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION;
+    const ComputeResourceBarrierFlags none = COMPUTE_RESOURCE_BARRIER_FLAG_NONE;
+    bool passed = true;
+
+    // The first accesses need no barrier within the command list, Resolve handles them.
+    ComputeStateTrackerRequire(&tracker, &resources[MERGED], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerRequire(&tracker, &resources[DROPPED], COMPUTE_RESOURCE_STATE_COPY_DEST);
+    ComputeStateTrackerRequire(&tracker, &resources[READ], COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerRequire(&tracker, &resources[UAV], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerRequire(&tracker, &resources[SPLIT], COMPUTE_RESOURCE_STATE_COPY_DEST);
+    ComputeStateTrackerFlush(&tracker, commandList);
+    passed &= CheckRecordedBarriers(&recorder, NULL, 0, "the first accesses");
+
+    // Two transitions of a resource before a command merge into one, and a transition undone before the command is dropped.
+    // A read state the resource has not left yet is added to the state it enters the command list in.
+    // The split barrier begins as early as possible.
+    ComputeStateTrackerRequire(&tracker, &resources[MERGED], COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+    ComputeStateTrackerRequire(&tracker, &resources[MERGED], COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerRequire(&tracker, &resources[DROPPED], COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+    ComputeStateTrackerRequire(&tracker, &resources[DROPPED], COMPUTE_RESOURCE_STATE_COPY_DEST);
+    ComputeStateTrackerRequire(&tracker, &resources[READ], COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+    ComputeStateTrackerBeginTransition(&tracker, &resources[SPLIT], COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerFlush(&tracker, commandList);
+    const ComputeResourceBarrier mergedBarriers[2] = {
+        { transition, none, &resources[MERGED], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            NULL },
+        { transition, COMPUTE_RESOURCE_BARRIER_FLAG_BEGIN_ONLY, &resources[SPLIT], COMPUTE_RESOURCE_STATE_COPY_DEST,
+            COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, NULL }
+    };
+    passed &= CheckRecordedBarriers(&recorder, mergedBarriers, 2, "the merged transitions");
+
+    // A command writing another UAV does not depend on the first one.
+    ComputeStateTrackerRequire(&tracker, &resources[OTHER_UAV], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerFlush(&tracker, commandList);
+    passed &= CheckRecordedBarriers(&recorder, NULL, 0, "an independent UAV");
+
+    // A command accessing the same UAV again waits for the previous one, and the split barrier ends at its first use.
+    ComputeStateTrackerRequire(&tracker, &resources[UAV], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerRequire(&tracker, &resources[SPLIT], COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerFlush(&tracker, commandList);
+    const ComputeResourceBarrier dependentBarriers[2] = {
+        { COMPUTE_RESOURCE_BARRIER_TYPE_UAV, none, &resources[UAV], COMPUTE_RESOURCE_STATE_COMMON, COMPUTE_RESOURCE_STATE_COMMON, NULL },
+        { transition, COMPUTE_RESOURCE_BARRIER_FLAG_END_ONLY, &resources[SPLIT], COMPUTE_RESOURCE_STATE_COPY_DEST,
+            COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, NULL }
+    };
+    passed &= CheckRecordedBarriers(&recorder, dependentBarriers, 2, "the dependent UAV and the split barrier");
+
+    ComputeStateTrackerFinish(&tracker, commandList);
+    passed &= CheckRecordedBarriers(&recorder, NULL, 0, "the finish");
+
+    // At submit, only the resources whose table state differs from their first state get a barrier,
+    // and the table takes the final states.
+    ComputeResourceStateTableRegister(&table, &resources[MERGED], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeResourceStateTableRegister(&table, &resources[DROPPED], COMPUTE_RESOURCE_STATE_COPY_DEST);
+    ComputeResourceStateTableRegister(&table, &resources[READ], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeResourceStateTableRegister(&table, &resources[SPLIT], COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+    const ComputeResourceBarrier *resolvedBarriers;
+    const uint32_t numResolved = ComputeStateTrackerResolve(&tracker, &table, &resolvedBarriers);
+    recorder.numCalls = numResolved > 0 ? 1 : 0;
+    for (uint32_t i = 0; i < numResolved && recorder.numBarriers < 8; i++)
+    {
+        // The order of the resolved barriers follows the hash table, so put them in the order of the resources.
+        const uint32_t index = resolvedBarriers[i].pResource == &resources[READ] ? 0 : 1;
+        recorder.barriers[index] = resolvedBarriers[i];
+        recorder.numBarriers++;
+    }
+    const ComputeResourceBarrier resolvedExpected[2] = {
+        { transition, none, &resources[READ], COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS,
+            COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | COMPUTE_RESOURCE_STATE_COPY_SOURCE, NULL },
+        { transition, none, &resources[SPLIT], COMPUTE_RESOURCE_STATE_COPY_SOURCE, COMPUTE_RESOURCE_STATE_COPY_DEST, NULL }
+    };
+    passed &= CheckRecordedBarriers(&recorder, resolvedExpected, 2, "the resolution");
+
+    ComputeResourceStates state;
+    passed &= ComputeResourceStateTableGet(&table, &resources[MERGED], &state) && state == COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    passed &= ComputeResourceStateTableGet(&table, &resources[SPLIT], &state) && state == COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    // The resources missing from the table are left out.
+    passed &= !ComputeResourceStateTableGet(&table, &resources[UAV], &state);
+
+    ComputeResourceStateTableDestroy(&table);
+    ComputeStateTrackerDestroy(&tracker);
+
+    if (passed)
+        puts("State tracker verification OK!");
+    else
+        puts("State tracker verification failed!");
+}
+
+// The buffers of the jobs of the compute service, kept from one job to the next and grown to the largest one.
+// The upload buffer stays mapped, the input and output buffers rest in the copy destination and unordered access states.
+static uint64_t s_serviceCapacity;
+static ComputeResource *s_serviceUploadBuffer;
+static void *s_pServiceUploadData;
+static ComputeResourceAllocation s_serviceInputAllocation;
+static ComputeResourceAllocation s_serviceOutputAllocation;
+
+// The pipeline of the service: CSMainDynamic takes the operand of each job as a root constant,
+// so one variant serves every operand, however many distinct ones the clients send.
+static ComputeRootLayout s_serviceLayout;
+static ComputeKernelRegistry s_serviceRegistry;
+static const ComputeKernelVariant *s_serviceVariant;
+
+// The number of jobs run by "--submit <path>", each with a distinct operand,
+// more than the variants a registry holds
+#define SERVICE_CLIENT_JOB_COUNT    (COMPUTE_KERNEL_MAX_VARIANTS + 8)
+// The number of jobs of which the times are printed
+#define SERVICE_CLIENT_PRINTED_JOBS 4
+
+static void ReleaseServiceBuffers(void)
+{
+    ComputeResourceAllocation *const allocations[2] = { &s_serviceInputAllocation, &s_serviceOutputAllocation };
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (allocations[i]->resource != NULL)
+        {
+            ComputeResourceStateTableUnregister(&s_resourceStates, allocations[i]->resource);
+            ComputeResourceAllocatorFree(&s_resourceAllocator, allocations[i]);
+            memset(allocations[i], 0, sizeof(*allocations[i]));
+        }
+    }
+    if (s_serviceUploadBuffer != NULL)
+        s_serviceUploadBuffer->lpVtbl->Release(s_serviceUploadBuffer);
+    s_serviceUploadBuffer = NULL;
+    s_pServiceUploadData = NULL;
+    s_serviceCapacity = 0;
+}
+
+// Grow the service buffers to hold size bytes. No job may be in flight.
+static bool ReserveServiceBuffers(uint64_t size)
+{
+    if (size <= s_serviceCapacity)
+        return true;
+    ReleaseServiceBuffers();
+
+    const ComputeResourceDesc desc = { size, COMPUTE_RESOURCE_FLAG_NONE };
+    const ComputeResourceDesc uavDesc = { size, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+    const ComputeRange noRead = { 0, 0 };
+
+    s_serviceUploadBuffer = s_device->lpVtbl->CreateCommittedResource(s_device, COMPUTE_HEAP_TYPE_UPLOAD, &desc,
+        COMPUTE_RESOURCE_STATE_GENERIC_READ);
+    if (s_serviceUploadBuffer == NULL || !s_serviceUploadBuffer->lpVtbl->Map(s_serviceUploadBuffer, &noRead, &s_pServiceUploadData) ||
+        !ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &desc,
+            COMPUTE_RESOURCE_STATE_COPY_DEST, &s_serviceInputAllocation) ||
+        !ComputeResourceStateTableRegister(&s_resourceStates, s_serviceInputAllocation.resource, COMPUTE_RESOURCE_STATE_COPY_DEST) ||
+        !ComputeResourceAllocatorCreateBuffer(&s_resourceAllocator, COMPUTE_HEAP_TYPE_DEFAULT, &uavDesc,
+            COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS, &s_serviceOutputAllocation) ||
+        !ComputeResourceStateTableRegister(&s_resourceStates, s_serviceOutputAllocation.resource, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS))
+    {
+        puts("Failed to create the service buffers!");
+        ReleaseServiceBuffers();
+        return false;
+    }
+    s_serviceCapacity = size;
+
+    return true;
+}
+
+// Create the pipeline of the service. The OPERAND macro is ignored by CSMainDynamic, so the key is the same for all the jobs.
+static bool InitServicePipeline(void)
+{
+    const ComputeKernelVariantKey key = { 0, s_computeVariantKey.GroupSize, COMPUTE_ELEMENT_TYPE_INT, 1 };
+
+    if (!ComputeRootLayoutCreateFromShader(&s_serviceLayout, &s_shaderCache, "compute.hlsl", NULL, "CSMainDynamic", "cs_5_0",
+        s_compileFlags, COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS) ||
+        s_serviceLayout.constantsParameters[1] == COMPUTE_ROOT_LAYOUT_UNUSED)
+    {
+        puts("Failed to create the root signature of the service!");
+        return false;
+    }
+
+    if (!ComputeKernelRegistryInit(&s_serviceRegistry, &s_shaderCache, s_serviceLayout.rootSignature, "compute.hlsl",
+        "CSMainDynamic", "cs_5_0", s_compileFlags))
+        return false;
+
+    s_serviceVariant = ComputeKernelRegistryGet(&s_serviceRegistry, &key);
+    return s_serviceVariant != NULL;
+}
+
+static void ReleaseServicePipeline(void)
+{
+    ComputeKernelRegistryDestroy(&s_serviceRegistry);
+    ComputeRootLayoutDestroy(&s_serviceLayout);
+    s_serviceVariant = NULL;
+}
+
+// Run one job of a client on the warm device: the operand is a root constant of the service pipeline,
+// and the buffers, the frames and the read-back buffers are the ones of the previous jobs.
+// The input is copied once, from the shared memory to the upload buffer, and the output once, from the read-back buffer.
+static bool ServeComputeJob(const ComputeServiceJob *job, void *context)
+{
+    (void)context;
+
+    const uint64_t size = (uint64_t)job->NumElements * sizeof(int);
+    if (!ReserveServiceBuffers(size))
+        return false;
+
+    ComputeReadbackBuffer *readBackBuffer = ComputeReadbackPoolAcquire(&s_readbackPool, size);
+    if (readBackBuffer == NULL)
+        return false;
+
+    ComputeHostCopy(s_pServiceUploadData, job->pInput, (size_t)size);
+
+    s_computeCommandList = ComputeFrameRingBegin(&s_computeFrames, s_serviceVariant->pipelineState, COMPUTE_WAIT_INFINITE);
+    if (s_computeCommandList == NULL)
+    {
+        ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+        return false;
+    }
+
+    ComputeResource *inputBuffer = s_serviceInputAllocation.resource;
+    ComputeResource *outputBuffer = s_serviceOutputAllocation.resource;
+    ComputeStateTracker *tracker = ComputeFrameRingGetStateTracker(&s_computeFrames);
+
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, &s_computeTimeline, s_computeCommandList, "Service job");
+    ComputeStateTrackerRequire(tracker, inputBuffer, COMPUTE_RESOURCE_STATE_COPY_DEST);
+    ComputeStateTrackerFlush(tracker, s_computeCommandList);
+    s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, inputBuffer, 0, s_serviceUploadBuffer, 0, size);
+
+    ComputeStateTrackerRequire(tracker, inputBuffer, COMPUTE_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ComputeStateTrackerRequire(tracker, outputBuffer, COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS);
+    ComputeStateTrackerFlush(tracker, s_computeCommandList);
+    s_computeCommandList->lpVtbl->SetComputeRootSignature(s_computeCommandList, s_serviceLayout.rootSignature);
+    ComputeRootLayoutSetSRV(&s_serviceLayout, s_computeCommandList, 0, inputBuffer, 0);
+    ComputeRootLayoutSetUAV(&s_serviceLayout, s_computeCommandList, 0, outputBuffer, 0);
+    s_computeCommandList->lpVtbl->SetComputeRoot32BitConstants(s_computeCommandList, s_serviceLayout.constantsParameters[1],
+        1, &job->Operand, 0);
+    ComputeDispatchElements(s_computeCommandList, s_serviceLayout.constantsParameters[0], job->NumElements,
+        s_serviceVariant->elementsPerGroup);
+
+    ComputeStateTrackerRequire(tracker, outputBuffer, COMPUTE_RESOURCE_STATE_COPY_SOURCE);
+    ComputeStateTrackerFlush(tracker, s_computeCommandList);
+    s_computeCommandList->lpVtbl->CopyBufferRegion(s_computeCommandList, readBackBuffer->resource, 0, outputBuffer, 0, size);
+    COMPUTE_TRACE_GPU_END(traceSpan, &s_computeTimeline, s_computeCommandList);
+
+    const uint64_t fenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+    s_computeCommandList = NULL;
+
+    ComputeReadbackView resultView;
+    const bool completed = fenceValue != 0 && ComputeReadbackPoolGetView(&s_readbackPool, readBackBuffer, fenceValue,
+        size, COMPUTE_WAIT_INFINITE, &resultView);
+    if (completed)
+        ComputeHostCopy(job->pOutput, resultView.pData, (size_t)size);
+
+    ComputeReadbackPoolRelease(&s_readbackPool, readBackBuffer);
+    return completed;
+}
+
+// Keep the device and the pipelines warm, and run the jobs of the clients on the socket path until one stops the service
+static void DoServe(const char *socketPath)
+{
+    if (!InitServicePipeline() || !ComputeServiceRun(socketPath, ServeComputeJob, NULL))
+        puts("The compute service failed!");
+
+    // Every job has been waited for.
+    ReleaseServiceBuffers();
+    ReleaseServicePipeline();
+}
+
+// Run jobs of s_testDataCount elements with distinct operands on the compute service of the socket path, and check their results.
+// The client needs no device: the input and the output go through a shared memory region it creates.
+static void DoSubmit(const char *socketPath)
+{
+    const uint64_t dataSize = (uint64_t)s_testDataCount * sizeof(int);
+
+    char sharedMemoryName[COMPUTE_SHARED_MEMORY_MAX_NAME];
+    snprintf(sharedMemoryName, sizeof(sharedMemoryName), "/compute_client_%u", ComputeGetCurrentThreadId());
+
+    ComputeServiceClient client;
+    if (!ComputeServiceClientConnect(&client, socketPath, sharedMemoryName, 2 * dataSize))
+        return;
+
+    // The input is written straight into the shared memory, the service reads it from there.
+    int *input = (int*)client.memory.pData;
+    const int *output = (const int*)(client.memory.pData + dataSize);
+    for (uint32_t i = 0; i < s_testDataCount; i++)
+        input[i] = (int)i + 1;
+
+    uint32_t numFailed = 0;
+    for (uint32_t i = 0; i < SERVICE_CLIENT_JOB_COUNT; i++)
+    {
+        // Around s_computeVariantKey.Operand: +0, -1, +1, -2, +2...
+        const int32_t operand = s_computeVariantKey.Operand + (i % 2 == 0 ? (int32_t)(i / 2) : -(int32_t)(i / 2) - 1);
+
+        uint64_t serviceTime = 0;
+        const uint64_t startTime = ComputeGetTimeNanoseconds();
+        if (!ComputeServiceClientRun(&client, 0, dataSize, s_testDataCount, operand, &serviceTime))
+        {
+            numFailed++;
+            break;
+        }
+        const uint64_t latency = ComputeGetTimeNanoseconds() - startTime;
+
+        const ComputeVerifyDesc verifyDesc = {
+            COMPUTE_ELEMENT_TYPE_INT, COMPUTE_VERIFY_EXPECTED_LINEAR, { .Int = 1 + operand }, { .Int = 1 }, 0.0f
+        };
+        ComputeVerifyResult verifyResult;
+        ComputeVerifyHost(NULL, &verifyDesc, output, NULL, s_testDataCount, &verifyResult);
+        if (verifyResult.NumMismatches != 0)
+            numFailed++;
+
+        if (i < SERVICE_CLIENT_PRINTED_JOBS || verifyResult.NumMismatches != 0)
+            printf("Service job %u (operand %d): %.3f ms, %.3f ms in the service%s\n", i, operand,
+                (double)latency / 1000000.0, (double)serviceTime / 1000000.0, verifyResult.NumMismatches != 0 ? ", wrong result!" : "");
+    }
+
+    ComputeServiceClientClose(&client);
+
+    if (numFailed == 0)
+        printf("Service verification OK! (%u jobs of %u elements with distinct operands)\n", SERVICE_CLIENT_JOB_COUNT, s_testDataCount);
+    else
+        puts("Service verification failed!");
+}
+
+// Ask the compute service of the socket path to stop
+static void DoStop(const char *socketPath)
+{
+    ComputeServiceClient client;
+    if (!ComputeServiceClientConnect(&client, socketPath, NULL, 0))
+        return;
+
+    if (ComputeServiceClientShutdown(&client))
+        puts("The compute service is stopping.");
+    ComputeServiceClientClose(&client);
+}
+
+// Release all the resources
+void ReleaseResources(void)
+{
+    // The frame ring and the timeline wait for all the submitted work,
+    // so none of the resources below is released while the GPU may still access it.
+    ComputeFrameRingDestroy(&s_computeFrames);
+    ComputeCommandPoolDestroy(&s_commandPool);
+    ComputeUploadRingDestroy(&s_uploadRing);
+    ComputeReadbackPoolDestroy(&s_readbackPool);
+    ComputeDescriptorAllocatorDestroy(&s_descriptors);
+
+    ComputeResourceStateTableUnregister(&s_resourceStates, s_srcDataBuffer);
+    ComputeResourceStateTableUnregister(&s_resourceStates, s_dstDataBuffer);
+    ComputeResourceStateTableUnregister(&s_resourceStates, s_verifyResultBuffer);
+    ComputeResourceStateTableDestroy(&s_resourceStates);
+
+    ComputeResourceAllocatorFree(&s_resourceAllocator, &s_srcDataAllocation);
+    ComputeResourceAllocatorFree(&s_resourceAllocator, &s_dstDataAllocation);
+    ComputeResourceAllocatorFree(&s_resourceAllocator, &s_verifyResultAllocation);
+    ComputeResourceAllocatorDestroy(&s_resourceAllocator);
+
+#ifdef COMPUTE_TRACE_ENABLED
+    // The query heaps of the trace are released before the queues they are resolved on.
+    ComputeTraceStop();
+#endif
+
+    ComputeTimelineDestroy(&s_copyTimeline);
+    ComputeTimelineDestroy(&s_computeTimeline);
+
+    if (s_copyCommandQueue != NULL)
+        s_copyCommandQueue->lpVtbl->Release(s_copyCommandQueue);
+    if (s_computeCommandQueue != NULL)
+        s_computeCommandQueue->lpVtbl->Release(s_computeCommandQueue);
+
+    ComputeKernelRegistryDestroy(&s_kernelRegistry);
+    ComputeVerifierDestroy(&s_verifier);
+
+    ComputeHostCopySetThreadPool(NULL);
+    if (s_hostThreads != NULL)
+        ReleaseThreadPool(s_hostThreads);
+
+    ComputeRootLayoutDestroy(&s_computeLayout);
+
+    if (s_device != NULL)
+        s_device->lpVtbl->Release(s_device);
+
+    free(s_DataBuffer0);
+}
+
+int main(int argc, char* argv[])
+{
+    // The D3D12 device (WARP) is used by default on Windows, "--cpu" selects the CPU backend.
+    // Other platforms only have the CPU backend.
+#ifdef _WIN32
+    ComputeBackendType backendType = COMPUTE_BACKEND_D3D12;
+#else
+    ComputeBackendType backendType = COMPUTE_BACKEND_CPU;
+#endif
+    // "--stream <input> <output>" processes the int array of the input file instead of the built-in test data.
+    // "--count <n>" sets the number of elements of the built-in test data.
+    // "--host-verify" checks its result on the host threads instead of on the GPU.
+    // "--jobs <n>" splits its dispatch into n jobs recorded on all the cores.
+    // "--primitives" then runs the scan, compaction, reduction and sort primitives on as many elements.
+    // "--records" then updates as many records of mixed field types, transposed to one array per field.
+    // "--shards <n>" then shards it across n devices, one per adapter, or n CPU devices of different speeds.
+    // "--async <n>" then submits n more runs without waiting, each checked by a completion callback.
+    // "--fused" then runs a chain of elementwise operations on the source data as one generated kernel.
+    // "--stages <n>" then chains n runs of the operation in a job graph.
+    // "--trace <path>" writes a Chrome trace of the run, when built with COMPUTE_TRACE_ENABLED.
+    // "--self-test" checks the barriers derived by the state tracker instead, without a device.
+    // "--serve <socket>" keeps the device warm and runs the jobs of other processes instead, until "--stop <socket>".
+    // "--submit <socket>" runs a few jobs of the built-in test data on that service, without a device of its own.
+    const char *streamInputPath = NULL;
+    const char *servePath = NULL;
+    const char *submitPath = NULL;
+    const char *stopPath = NULL;
+    bool selfTest = false;
+    const char *tracePath = NULL;
+    const char *streamOutputPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--cpu") == 0)
+            backendType = COMPUTE_BACKEND_CPU;
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            const unsigned long count = strtoul(argv[++i], NULL, 10);
+            if (count == 0 || count > UINT32_MAX / sizeof(int))
+            {
+                puts("Invalid element count!");
+                return 1;
+            }
+            s_testDataCount = (uint32_t)count;
+        }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+        {
+            const unsigned long numJobs = strtoul(argv[++i], NULL, 10);
+            if (numJobs == 0 || numJobs > UINT32_MAX)
+            {
+                puts("Invalid job count!");
+                return 1;
+            }
+            s_numJobs = (uint32_t)numJobs;
+        }
+        else if (strcmp(argv[i], "--stages") == 0 && i + 1 < argc)
+        {
+            const unsigned long numStages = strtoul(argv[++i], NULL, 10);
+            if (numStages == 0 || numStages > 1024)
+            {
+                puts("Invalid stage count!");
+                return 1;
+            }
+            s_numStages = (uint32_t)numStages;
+        }
+        else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc)
+        {
+            const unsigned long numShardDevices = strtoul(argv[++i], NULL, 10);
+            if (numShardDevices == 0 || numShardDevices > COMPUTE_SHARD_MAX_DEVICES)
+            {
+                puts("Invalid shard device count!");
+                return 1;
+            }
+            s_numShardDevices = (uint32_t)numShardDevices;
+        }
+        else if (strcmp(argv[i], "--async") == 0 && i + 1 < argc)
+        {
+            const unsigned long numAsyncJobs = strtoul(argv[++i], NULL, 10);
+            if (numAsyncJobs == 0 || numAsyncJobs > 256)
+            {
+                puts("Invalid submission count!");
+                return 1;
+            }
+            s_numAsyncJobs = (uint32_t)numAsyncJobs;
+        }
+        else if (strcmp(argv[i], "--primitives") == 0)
+            s_runPrimitives = true;
+        else if (strcmp(argv[i], "--records") == 0)
+            s_runRecords = true;
+        else if (strcmp(argv[i], "--fused") == 0)
+            s_runFused = true;
+        else if (strcmp(argv[i], "--host-verify") == 0)
+            s_hostVerify = true;
+        else if (strcmp(argv[i], "--stream") == 0 && i + 2 < argc)
+        {
+            streamInputPath = argv[++i];
+            streamOutputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--self-test") == 0)
+            selfTest = true;
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+            servePath = argv[++i];
+        else if (strcmp(argv[i], "--submit") == 0 && i + 1 < argc)
+            submitPath = argv[++i];
+        else if (strcmp(argv[i], "--stop") == 0 && i + 1 < argc)
+            stopPath = argv[++i];
+    }
+
+    if (selfTest)
+    {
+        DoStateTrackerTest();
+        return 0;
+    }
+
+    // The clients of the service create no device.
+    if (submitPath != NULL || stopPath != NULL)
+    {
+        if (submitPath != NULL)
+            DoSubmit(submitPath);
+        if (stopPath != NULL)
+            DoStop(stopPath);
+        return 0;
+    }
+
+#ifdef COMPUTE_TRACE_ENABLED
+    if (tracePath != NULL && !ComputeTraceStart())
+    {
+        puts("Failed to start the trace!");
+        return 1;
+    }
+#else
+    if (tracePath != NULL)
+        puts("The trace is not built in, define COMPUTE_TRACE_ENABLED to write it.");
+#endif
+
+    do
+    {
+        COMPUTE_TRACE_CPU_BEGIN(initScope, "Init");
+        if (!InitAssets(backendType))
+        {
+            puts("InitAssets failed!");
+            break;
+        }
+        if (!InitComputeCommands())
+        {
+            puts("InitComputeCommands failed!");
+            break;
+        }
+        COMPUTE_TRACE_CPU_END(initScope);
+
+        if (streamInputPath != NULL)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(streamScope, "DoStreamCompute");
+            DoStreamCompute(streamInputPath, streamOutputPath);
+            COMPUTE_TRACE_CPU_END(streamScope);
+            break;
+        }
+
+        if (servePath != NULL)
+        {
+            // The service runs its jobs on the frames, so the empty initialization command list goes first.
+            const uint64_t initFenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+            s_computeCommandList = NULL;
+            if (initFenceValue == 0)
+            {
+                puts("Execute init commands failed!");
+                break;
+            }
+            COMPUTE_TRACE_CPU_BEGIN(serveScope, "DoServe");
+            DoServe(servePath);
+            COMPUTE_TRACE_CPU_END(serveScope);
+            break;
+        }
+
+        COMPUTE_TRACE_CPU_BEGIN(buffersScope, "CreateBuffers");
+        if (!CreateBuffers())
+        {
+            puts("CreateBuuffers failed!");
+            break;
+        }
+
+        // Submit the initialization commands without waiting for them.
+        const uint64_t initFenceValue = ComputeFrameRingSubmit(&s_computeFrames);
+        s_computeCommandList = NULL;
+        if (initFenceValue == 0)
+        {
+            puts("Execute init commands failed!");
+            break;
+        }
+        COMPUTE_TRACE_CPU_END(buffersScope);
+
+        COMPUTE_TRACE_CPU_BEGIN(computeScope, "DoCompute");
+        DoCompute();
+        COMPUTE_TRACE_CPU_END(computeScope);
+
+        if (s_numShardDevices > 0)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(shardScope, "DoShardCompute");
+            DoShardCompute();
+            COMPUTE_TRACE_CPU_END(shardScope);
+        }
+
+        if (s_numAsyncJobs > 0)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(asyncScope, "DoAsyncCompute");
+            DoAsyncCompute();
+            COMPUTE_TRACE_CPU_END(asyncScope);
+        }
+
+        // The fused kernel reads the source data, so it runs before the primitives sort it.
+        if (s_runFused)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(fusedScope, "DoFused");
+            DoFused();
+            COMPUTE_TRACE_CPU_END(fusedScope);
+        }
+
+        // The primitives sort the source data along with their keys, so they run before the job graph changes it.
+        if (s_runPrimitives)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(primitivesScope, "DoPrimitives");
+            DoPrimitives();
+            COMPUTE_TRACE_CPU_END(primitivesScope);
+        }
+
+        if (s_runRecords)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(recordsScope, "DoRecords");
+            DoRecords();
+            COMPUTE_TRACE_CPU_END(recordsScope);
+        }
+
+        if (s_numStages > 0)
+        {
+            COMPUTE_TRACE_CPU_BEGIN(graphScope, "DoGraphCompute");
+            DoGraphCompute();
+            COMPUTE_TRACE_CPU_END(graphScope);
+        }
+
+    } while (false);
+
+#ifdef COMPUTE_TRACE_ENABLED
+    if (tracePath != NULL)
+        ComputeTraceWrite(tracePath);
+#endif
+
+    ReleaseResources();
+}
+
@@ -0,0 +1,216 @@
+#ifndef _WIN32
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+
+static uint64_t GetPageSize(void)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwPageSize;
+}
+
+static bool MapFile(ComputeMappedFile *file, uint64_t size)
+{
+    // An empty file cannot be mapped, and there is nothing to access anyway.
+    if (size == 0)
+        return true;
+
+    const DWORD protect = file->writable ? PAGE_READWRITE : PAGE_READONLY;
+    file->mapping = CreateFileMappingA(file->file, NULL, protect, (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (file->mapping == NULL)
+        return false;
+
+    file->pData = MapViewOfFile(file->mapping, file->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    return file->pData != NULL;
+}
+
+bool ComputeMappedFileOpenRead(ComputeMappedFile *file, const char *path)
+{
+    memset(file, 0, sizeof(*file));
+
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+    {
+        file->file = NULL;
+        printf("Failed to open %s!\n", path);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file->file, &fileSize) || !MapFile(file, (uint64_t)fileSize.QuadPart))
+    {
+        printf("Failed to map %s!\n", path);
+        ComputeMappedFileClose(file);
+        return false;
+    }
+    file->size = (uint64_t)fileSize.QuadPart;
+
+    return true;
+}
+
+bool ComputeMappedFileCreate(ComputeMappedFile *file, const char *path, uint64_t size)
+{
+    memset(file, 0, sizeof(*file));
+    file->writable = true;
+
+    file->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+    {
+        file->file = NULL;
+        printf("Failed to create %s!\n", path);
+        return false;
+    }
+
+    // Creating the mapping with the size extends the file.
+    if (!MapFile(file, size))
+    {
+        printf("Failed to map %s!\n", path);
+        ComputeMappedFileClose(file);
+        return false;
+    }
+    file->size = size;
+
+    return true;
+}
+
+void ComputeMappedFileEvict(ComputeMappedFile *file, uint64_t offset, uint64_t size)
+{
+    const uint64_t pageSize = GetPageSize();
+    const uint64_t begin = offset / pageSize * pageSize;
+    if (file->pData == NULL || size == 0 || begin >= file->size)
+        return;
+
+    uint64_t end = offset + size;
+    if (end > file->size)
+        end = file->size;
+
+    if (file->writable)
+        FlushViewOfFile(file->pData + begin, (SIZE_T)(end - begin));
+
+    // Unlocking pages that are not locked removes them from the working set.
+    VirtualUnlock(file->pData + begin, (SIZE_T)(end - begin));
+}
+
+void ComputeMappedFileClose(ComputeMappedFile *file)
+{
+    if (file->pData != NULL)
+        UnmapViewOfFile(file->pData);
+    if (file->mapping != NULL)
+        CloseHandle(file->mapping);
+    if (file->file != NULL)
+        CloseHandle(file->file);
+
+    memset(file, 0, sizeof(*file));
+}
+
+#else
+
+static bool MapFile(ComputeMappedFile *file, uint64_t size)
+{
+    // An empty file cannot be mapped, and there is nothing to access anyway.
+    if (size == 0)
+        return true;
+
+    const int protect = file->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *pData = mmap(NULL, (size_t)size, protect, MAP_SHARED, file->fd, 0);
+    if (pData == MAP_FAILED)
+        return false;
+
+    // The chunks are processed front to back.
+    madvise(pData, (size_t)size, MADV_SEQUENTIAL);
+
+    file->pData = pData;
+    return true;
+}
+
+bool ComputeMappedFileOpenRead(ComputeMappedFile *file, const char *path)
+{
+    memset(file, 0, sizeof(*file));
+
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0)
+    {
+        file->fd = 0;
+        printf("Failed to open %s!\n", path);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(file->fd, &fileStat) != 0 || !MapFile(file, (uint64_t)fileStat.st_size))
+    {
+        printf("Failed to map %s!\n", path);
+        ComputeMappedFileClose(file);
+        return false;
+    }
+    file->size = (uint64_t)fileStat.st_size;
+
+    return true;
+}
+
+bool ComputeMappedFileCreate(ComputeMappedFile *file, const char *path, uint64_t size)
+{
+    memset(file, 0, sizeof(*file));
+    file->writable = true;
+
+    file->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0)
+    {
+        file->fd = 0;
+        printf("Failed to create %s!\n", path);
+        return false;
+    }
+
+    if (ftruncate(file->fd, (off_t)size) != 0 || !MapFile(file, size))
+    {
+        printf("Failed to map %s!\n", path);
+        ComputeMappedFileClose(file);
+        return false;
+    }
+    file->size = size;
+
+    return true;
+}
+
+void ComputeMappedFileEvict(ComputeMappedFile *file, uint64_t offset, uint64_t size)
+{
+    const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    const uint64_t begin = offset / pageSize * pageSize;
+    if (file->pData == NULL || size == 0 || begin >= file->size)
+        return;
+
+    uint64_t end = offset + size;
+    if (end > file->size)
+        end = file->size;
+
+    // Start writing back the dirty pages.
+    if (file->writable)
+        msync(file->pData + begin, (size_t)(end - begin), MS_ASYNC);
+
+    // The mapping is shared, so the written data stays in the file while the pages leave the resident set.
+    madvise(file->pData + begin, (size_t)(end - begin), MADV_DONTNEED);
+}
+
+void ComputeMappedFileClose(ComputeMappedFile *file)
+{
+    if (file->pData != NULL)
+        munmap(file->pData, (size_t)file->size);
+    // A zeroed descriptor means the file has not been opened.
+    if (file->fd > 0)
+        close(file->fd);
+
+    memset(file, 0, sizeof(*file));
+}
+
+#endif
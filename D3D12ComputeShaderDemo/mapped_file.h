@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// A whole file mapped into the address space.
+// Only the pages being touched are resident, and Evict drops the ones that are no longer needed,
+// so files larger than the physical memory can be processed.
+typedef struct ComputeMappedFile
+{
+    uint8_t *pData;
+    uint64_t size;
+    bool writable;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} ComputeMappedFile;
+
+// Map an existing file for reading
+extern bool ComputeMappedFileOpenRead(ComputeMappedFile *file, const char *path);
+
+// Create (or truncate) a file of the given size and map it for writing
+extern bool ComputeMappedFileCreate(ComputeMappedFile *file, const char *path, uint64_t size);
+
+// Drop the pages of the range from the resident set. Written pages are flushed to the file first.
+extern void ComputeMappedFileEvict(ComputeMappedFile *file, uint64_t offset, uint64_t size);
+
+extern void ComputeMappedFileClose(ComputeMappedFile *file);
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,460 @@
+// Parallel primitives on 32-bit unsigned integers: reduction, exclusive prefix scan, stream compaction and radix sort.
+// Signed integers give the same bits for the sum and the scan.
+// Each group processes a block of GROUP_SIZE * ITEMS_PER_THREAD elements. compute_primitives.c chains the kernels
+// over several passes for inputs of any size, with the per-block results in the scratch buffer.
+
+// Specialization macros, set through D3D_SHADER_MACRO when the kernels are compiled.
+// GROUP_SIZE must be a power of two in [16, 1024], and the block must stay below 65536 elements.
+// The groupshared arrays below, checked by ComputePrimitivesInit, must fit in 32 KB.
+#ifndef GROUP_SIZE
+#define GROUP_SIZE          256
+#endif
+#ifndef ITEMS_PER_THREAD
+#define ITEMS_PER_THREAD    4
+#endif
+// Defined when the shader is compiled for Shader Model 6.0 or later (dxc): the group scans and reductions
+// then combine the wave intrinsics of each wave instead of stepping through groupshared memory.
+// #define USE_WAVE_INTRINSICS
+
+#define BLOCK_SIZE          (GROUP_SIZE * ITEMS_PER_THREAD)
+
+// The radix sort handles RADIX_BITS bits of the keys per pass
+#define RADIX_BITS          4
+#define RADIX_SIZE          (1 << RADIX_BITS)
+#define RADIX_MASK          (RADIX_SIZE - 1)
+
+// The Flags of the pass, COMPUTE_PRIMITIVE_FLAG_* in compute_primitives.h
+#define FLAG_READ_SCRATCH   1   // The input is read from scratchBuffer at InputOffset instead of srcBuffer
+#define FLAG_WRITE_SCRATCH  2   // The output is written to scratchBuffer at OutputOffset instead of dstBuffer
+#define FLAG_READ_OUTPUT    4   // The input is read from dstBuffer, by the radix sort passes after the first
+#define FLAG_PREDICATE      8   // The input of the scan is srcValues[i] != 0
+#define FLAG_VALUES         16  // The radix sort moves the values along with the keys
+
+StructuredBuffer<uint> srcBuffer: register(t0);         // SRV: the input, the keys of the sort
+StructuredBuffer<uint> srcValues: register(t1);         // SRV: the values of the sort, the flags of the compaction
+RWStructuredBuffer<uint> dstBuffer: register(u0);       // UAV: the output, the sorted keys
+RWStructuredBuffer<uint> scratchBuffer: register(u1);   // UAV: the per-block results
+RWStructuredBuffer<uint> dstValues: register(u2);       // UAV: the sorted values, the element count of the compaction
+
+// Root constants, set by ComputeDispatchElements and compute_primitives.c for each Dispatch
+cbuffer PrimitiveConstants : register(b0)
+{
+    // The DispatchConstants of compute.hlsl
+    uint NumElements;
+    uint BaseGroup;
+    uint GroupsPerRow;
+    // The offsets in scratchBuffer of the input, the output and the per-block results
+    uint InputOffset;
+    uint OutputOffset;
+    uint SumsOffset;
+    uint Flags;
+    // The first bit of the digit of a radix sort pass
+    uint Shift;
+    // The offset in scratchBuffer of the values, read or written along with the keys
+    uint ValuesOffset;
+};
+
+groupshared uint gs_items[BLOCK_SIZE];
+groupshared uint gs_digitOffsets[RADIX_SIZE];
+#ifdef USE_WAVE_INTRINSICS
+// One entry per wave, there are at least 4 lanes per wave, plus the total
+groupshared uint4 gs_waveSums[GROUP_SIZE / 4 + 1];
+#else
+groupshared uint4 gs_scan[GROUP_SIZE];
+#endif
+
+uint GetGroupIndex(uint3 groupID)
+{
+    return BaseGroup + groupID.y * GroupsPerRow + groupID.x;
+}
+
+uint LoadInput(uint index)
+{
+    // The elements past the end are the identity of the sum
+    if (index >= NumElements)
+        return 0;
+    if (Flags & FLAG_PREDICATE)
+        return srcValues[index] != 0 ? 1 : 0;
+    if (Flags & FLAG_READ_SCRATCH)
+        return scratchBuffer[InputOffset + index];
+    if (Flags & FLAG_READ_OUTPUT)
+        return dstBuffer[index];
+    return srcBuffer[index];
+}
+
+void StoreOutput(uint index, uint value)
+{
+    if (index >= NumElements)
+        return;
+    if (Flags & FLAG_WRITE_SCRATCH)
+        scratchBuffer[OutputOffset + index] = value;
+    else
+        dstBuffer[index] = value;
+}
+
+uint LoadValue(uint index)
+{
+    if (index >= NumElements)
+        return 0;
+    if (Flags & FLAG_READ_SCRATCH)
+        return scratchBuffer[ValuesOffset + index];
+    if (Flags & FLAG_READ_OUTPUT)
+        return dstValues[index];
+    return srcValues[index];
+}
+
+void StoreValue(uint index, uint value)
+{
+    if (index >= NumElements)
+        return;
+    if (Flags & FLAG_WRITE_SCRATCH)
+        scratchBuffer[ValuesOffset + index] = value;
+    else
+        dstValues[index] = value;
+}
+
+// Component-wise exclusive scan of one uint4 per thread over the group, in the order of the threads.
+// All the threads of the group must call it.
+uint4 GroupExclusiveScan4(uint4 value, uint localIndex, out uint4 total)
+{
+#ifdef USE_WAVE_INTRINSICS
+    const uint laneCount = WaveGetLaneCount();
+    const uint numWaves = (GROUP_SIZE + laneCount - 1) / laneCount;
+
+    const uint4 prefix = WavePrefixSum(value);
+    const uint4 waveTotal = WaveActiveSum(value);
+    if (WaveIsFirstLane())
+        gs_waveSums[localIndex / laneCount] = waveTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    // There are a few waves per group, their totals are scanned by the first thread.
+    if (localIndex == 0)
+    {
+        uint4 sum = 0;
+        for (uint wave = 0; wave < numWaves; wave++)
+        {
+            const uint4 waveSum = gs_waveSums[wave];
+            gs_waveSums[wave] = sum;
+            sum += waveSum;
+        }
+        gs_waveSums[numWaves] = sum;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    total = gs_waveSums[numWaves];
+    const uint4 result = gs_waveSums[localIndex / laneCount] + prefix;
+    GroupMemoryBarrierWithGroupSync();
+    return result;
+#else
+    gs_scan[localIndex] = value;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1)
+    {
+        const uint4 addend = localIndex >= offset ? gs_scan[localIndex - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_scan[localIndex] += addend;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    total = gs_scan[GROUP_SIZE - 1];
+    const uint4 result = gs_scan[localIndex] - value;
+    GroupMemoryBarrierWithGroupSync();
+    return result;
+#endif
+}
+
+uint GroupExclusiveScan(uint value, uint localIndex, out uint total)
+{
+    uint4 total4;
+    const uint4 result = GroupExclusiveScan4(uint4(value, 0, 0, 0), localIndex, total4);
+    total = total4.x;
+    return result.x;
+}
+
+// The sum of one value per thread over the group, returned to all the threads
+uint GroupReduce(uint value, uint localIndex)
+{
+#ifdef USE_WAVE_INTRINSICS
+    const uint laneCount = WaveGetLaneCount();
+    const uint numWaves = (GROUP_SIZE + laneCount - 1) / laneCount;
+
+    const uint waveTotal = WaveActiveSum(value);
+    if (WaveIsFirstLane())
+        gs_waveSums[localIndex / laneCount].x = waveTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint sum = 0;
+    for (uint wave = 0; wave < numWaves; wave++)
+        sum += gs_waveSums[wave].x;
+    GroupMemoryBarrierWithGroupSync();
+    return sum;
+#else
+    gs_scan[localIndex].x = value;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = GROUP_SIZE / 2; stride > 0; stride >>= 1)
+    {
+        if (localIndex < stride)
+            gs_scan[localIndex].x += gs_scan[localIndex + stride].x;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    const uint sum = gs_scan[0].x;
+    GroupMemoryBarrierWithGroupSync();
+    return sum;
+#endif
+}
+
+// Sum each block into one element: scratchBuffer[OutputOffset + group], or dstBuffer[0] for the last pass
+[numthreads(GROUP_SIZE, 1, 1)]
+void Reduce(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint first = group * BLOCK_SIZE + localIndex;
+
+    // The threads of the group read consecutive elements in each iteration.
+    uint sum = 0;
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+        sum += LoadInput(first + i * GROUP_SIZE);
+
+    sum = GroupReduce(sum, localIndex);
+
+    if (localIndex == 0)
+    {
+        if (Flags & FLAG_WRITE_SCRATCH)
+            scratchBuffer[OutputOffset + group] = sum;
+        else
+            dstBuffer[group] = sum;
+    }
+}
+
+// Exclusive scan of each block, with the total of the block written to scratchBuffer[SumsOffset + group].
+// The input and the output may be the same range of the scratch buffer.
+[numthreads(GROUP_SIZE, 1, 1)]
+void ScanBlocks(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint blockStart = group * BLOCK_SIZE;
+
+    // Coalesced loads through groupshared memory, then each thread scans ITEMS_PER_THREAD consecutive elements.
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+        gs_items[i * GROUP_SIZE + localIndex] = LoadInput(blockStart + i * GROUP_SIZE + localIndex);
+    GroupMemoryBarrierWithGroupSync();
+
+    uint prefixes[ITEMS_PER_THREAD];
+    uint sum = 0;
+    [unroll]
+    for (uint j = 0; j < ITEMS_PER_THREAD; j++)
+    {
+        prefixes[j] = sum;
+        sum += gs_items[localIndex * ITEMS_PER_THREAD + j];
+    }
+
+    uint total;
+    const uint threadPrefix = GroupExclusiveScan(sum, localIndex, total);
+
+    [unroll]
+    for (uint k = 0; k < ITEMS_PER_THREAD; k++)
+        gs_items[localIndex * ITEMS_PER_THREAD + k] = threadPrefix + prefixes[k];
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint m = 0; m < ITEMS_PER_THREAD; m++)
+        StoreOutput(blockStart + m * GROUP_SIZE + localIndex, gs_items[m * GROUP_SIZE + localIndex]);
+
+    if (localIndex == 0)
+        scratchBuffer[SumsOffset + group] = total;
+}
+
+// Add the scanned block sums scratchBuffer[SumsOffset + group] to the blocks of the output
+[numthreads(GROUP_SIZE, 1, 1)]
+void AddBlockOffsets(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint blockStart = group * BLOCK_SIZE;
+    const uint offset = scratchBuffer[SumsOffset + group];
+
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+    {
+        const uint index = blockStart + i * GROUP_SIZE + localIndex;
+        if (index >= NumElements)
+            break;
+
+        if (Flags & FLAG_WRITE_SCRATCH)
+            scratchBuffer[OutputOffset + index] += offset;
+        else
+            dstBuffer[index] += offset;
+    }
+}
+
+// Write the elements srcBuffer[i] whose flag srcValues[i] is set to dstBuffer, at the positions scanned from the flags
+// at InputOffset of the scratch buffer. The element count, at SumsOffset, goes to dstValues[0].
+[numthreads(GROUP_SIZE, 1, 1)]
+void CompactScatter(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint blockStart = group * BLOCK_SIZE;
+
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+    {
+        const uint index = blockStart + i * GROUP_SIZE + localIndex;
+        if (index < NumElements && srcValues[index] != 0)
+            dstBuffer[scratchBuffer[InputOffset + index]] = srcBuffer[index];
+    }
+
+    if (group == 0 && localIndex == 0)
+        dstValues[0] = scratchBuffer[SumsOffset];
+}
+
+// Count the digits of the keys of each block. The counts are stored digit-major at SumsOffset,
+// so that their exclusive scan gives the first output position of each digit of each block.
+[numthreads(GROUP_SIZE, 1, 1)]
+void RadixHistogram(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint blockStart = group * BLOCK_SIZE;
+    const uint numBlocks = (NumElements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    if (localIndex < RADIX_SIZE)
+        gs_digitOffsets[localIndex] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+    {
+        const uint index = blockStart + i * GROUP_SIZE + localIndex;
+        if (index < NumElements)
+            InterlockedAdd(gs_digitOffsets[(LoadInput(index) >> Shift) & RADIX_MASK], 1);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (localIndex < RADIX_SIZE)
+        scratchBuffer[SumsOffset + localIndex * numBlocks + group] = gs_digitOffsets[localIndex];
+}
+
+// The 16-bit count of a digit in the 8 packed counters
+uint GetDigitCount(uint4 counts0, uint4 counts1, uint digit)
+{
+    const uint4 counts = digit < 8 ? counts0 : counts1;
+    return (counts[(digit >> 1) & 3] >> ((digit & 1) * 16)) & 0xffff;
+}
+
+// Move the keys of each block to the positions scanned from the histograms at SumsOffset, stable within each digit.
+// The block is first sorted by digit in groupshared memory, so that the threads write runs of consecutive elements.
+[numthreads(GROUP_SIZE, 1, 1)]
+void RadixScatter(uint3 groupID : SV_GroupID, uint localIndex : SV_GroupIndex)
+{
+    const uint group = GetGroupIndex(groupID);
+    const uint blockStart = group * BLOCK_SIZE;
+    const uint numBlocks = (NumElements + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint blockCount = min(NumElements - blockStart, BLOCK_SIZE);
+
+    [unroll]
+    for (uint i = 0; i < ITEMS_PER_THREAD; i++)
+        gs_items[i * GROUP_SIZE + localIndex] = LoadInput(blockStart + i * GROUP_SIZE + localIndex);
+    GroupMemoryBarrierWithGroupSync();
+
+    // Each thread takes ITEMS_PER_THREAD consecutive keys, so that the order of the threads is the order of the keys.
+    // The digit counts of the thread are packed two per uint, 16 bits each.
+    uint keys[ITEMS_PER_THREAD];
+    uint ranks[ITEMS_PER_THREAD];
+    uint packed[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    [unroll]
+    for (uint j = 0; j < ITEMS_PER_THREAD; j++)
+    {
+        const uint localPosition = localIndex * ITEMS_PER_THREAD + j;
+        keys[j] = gs_items[localPosition];
+        const uint digit = (keys[j] >> Shift) & RADIX_MASK;
+        ranks[j] = (packed[digit >> 1] >> ((digit & 1) * 16)) & 0xffff;
+        if (localPosition < blockCount)
+            packed[digit >> 1] += 1 << ((digit & 1) * 16);
+    }
+
+    uint4 totals0, totals1;
+    const uint4 prefixes0 = GroupExclusiveScan4(uint4(packed[0], packed[1], packed[2], packed[3]), localIndex, totals0);
+    const uint4 prefixes1 = GroupExclusiveScan4(uint4(packed[4], packed[5], packed[6], packed[7]), localIndex, totals1);
+
+    // The first position of each digit in the sorted block, and in the output
+    if (localIndex == 0)
+    {
+        uint blockOffset = 0;
+        for (uint digit = 0; digit < RADIX_SIZE; digit++)
+        {
+            gs_digitOffsets[digit] = scratchBuffer[SumsOffset + digit * numBlocks + group] - blockOffset;
+            blockOffset += GetDigitCount(totals0, totals1, digit);
+        }
+    }
+
+    // Sort the block by digit. The keys past the end of the input stay at the end.
+    uint positions[ITEMS_PER_THREAD];
+    uint blockOffsets[RADIX_SIZE];
+    uint offset = 0;
+    [unroll]
+    for (uint d = 0; d < RADIX_SIZE; d++)
+    {
+        blockOffsets[d] = offset;
+        offset += GetDigitCount(totals0, totals1, d);
+    }
+    [unroll]
+    for (uint k = 0; k < ITEMS_PER_THREAD; k++)
+    {
+        const uint localPosition = localIndex * ITEMS_PER_THREAD + k;
+        const uint digit = (keys[k] >> Shift) & RADIX_MASK;
+        positions[k] = localPosition < blockCount ?
+            blockOffsets[digit] + GetDigitCount(prefixes0, prefixes1, digit) + ranks[k] : localPosition;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+    [unroll]
+    for (uint m = 0; m < ITEMS_PER_THREAD; m++)
+        gs_items[positions[m]] = keys[m];
+    GroupMemoryBarrierWithGroupSync();
+
+    // The keys of a digit go to consecutive output positions.
+    uint outputPositions[ITEMS_PER_THREAD];
+    [unroll]
+    for (uint n = 0; n < ITEMS_PER_THREAD; n++)
+    {
+        const uint localPosition = n * GROUP_SIZE + localIndex;
+        const uint key = gs_items[localPosition];
+        outputPositions[n] = gs_digitOffsets[(key >> Shift) & RADIX_MASK] + localPosition;
+        if (localPosition < blockCount)
+            StoreOutput(outputPositions[n], key);
+    }
+
+    if ((Flags & FLAG_VALUES) == 0)
+        return;
+
+    // The values take the same way through groupshared memory.
+    GroupMemoryBarrierWithGroupSync();
+    [unroll]
+    for (uint p = 0; p < ITEMS_PER_THREAD; p++)
+        gs_items[p * GROUP_SIZE + localIndex] = LoadValue(blockStart + p * GROUP_SIZE + localIndex);
+    GroupMemoryBarrierWithGroupSync();
+
+    uint values[ITEMS_PER_THREAD];
+    [unroll]
+    for (uint q = 0; q < ITEMS_PER_THREAD; q++)
+        values[q] = gs_items[localIndex * ITEMS_PER_THREAD + q];
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint r = 0; r < ITEMS_PER_THREAD; r++)
+        gs_items[positions[r]] = values[r];
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint s = 0; s < ITEMS_PER_THREAD; s++)
+    {
+        const uint localPosition = s * GROUP_SIZE + localIndex;
+        if (localPosition < blockCount)
+            StoreValue(outputPositions[s], gs_items[localPosition]);
+    }
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "readback_pool.h"
+
+bool ComputeReadbackPoolInit(ComputeReadbackPool *pool, ComputeDevice *device, ComputeTimeline *timeline)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->device = device;
+    pool->timeline = timeline;
+    ComputeMutexInit(&pool->mutex);
+    return true;
+}
+
+void ComputeReadbackPoolDestroy(ComputeReadbackPool *pool)
+{
+    if (pool->device == NULL)
+        return;
+
+    while (pool->buffers != NULL)
+    {
+        ComputeReadbackBuffer *buffer = pool->buffers;
+        pool->buffers = buffer->next;
+
+        if (buffer->inUse)
+            puts("A readback buffer is destroyed while still in use!");
+
+        buffer->resource->lpVtbl->Unmap(buffer->resource, NULL);
+        buffer->resource->lpVtbl->Release(buffer->resource);
+        free(buffer);
+    }
+
+    ComputeMutexDestroy(&pool->mutex);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static ComputeReadbackBuffer* CreateReadbackBuffer(ComputeDevice *device, uint64_t size)
+{
+    ComputeReadbackBuffer *buffer = calloc(1, sizeof(*buffer));
+    if (buffer == NULL)
+        return NULL;
+
+    buffer->size = (size + COMPUTE_READBACK_PAGE_SIZE - 1) / COMPUTE_READBACK_PAGE_SIZE * COMPUTE_READBACK_PAGE_SIZE;
+
+    // Readback buffers have to stay in the copy destination state.
+    const ComputeResourceDesc resourceDesc = { buffer->size, COMPUTE_RESOURCE_FLAG_NONE };
+    buffer->resource = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_READBACK, &resourceDesc,
+        COMPUTE_RESOURCE_STATE_COPY_DEST);
+    if (buffer->resource == NULL)
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    // Readback heaps may stay mapped while the GPU writes them,
+    // the data is only read after the fence of the copy has been reached.
+    const ComputeRange readRange = { 0, (size_t)buffer->size };
+    if (!buffer->resource->lpVtbl->Map(buffer->resource, &readRange, &buffer->pMappedData))
+    {
+        buffer->resource->lpVtbl->Release(buffer->resource);
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+ComputeReadbackBuffer* ComputeReadbackPoolAcquire(ComputeReadbackPool *pool, uint64_t size)
+{
+    ComputeMutexLock(&pool->mutex);
+
+    // Best fit among the free buffers
+    ComputeReadbackBuffer *bestBuffer = NULL;
+    for (ComputeReadbackBuffer *buffer = pool->buffers; buffer != NULL; buffer = buffer->next)
+    {
+        if (!buffer->inUse && buffer->size >= size && (bestBuffer == NULL || buffer->size < bestBuffer->size))
+            bestBuffer = buffer;
+    }
+
+    if (bestBuffer != NULL)
+    {
+        bestBuffer->inUse = true;
+        ComputeMutexUnlock(&pool->mutex);
+        return bestBuffer;
+    }
+
+    ComputeMutexUnlock(&pool->mutex);
+
+    // Create the new buffer outside the lock, so that other threads can still take the free ones.
+    ComputeReadbackBuffer *buffer = CreateReadbackBuffer(pool->device, size);
+    if (buffer == NULL)
+    {
+        puts("Failed to create a readback buffer!");
+        return NULL;
+    }
+    buffer->inUse = true;
+
+    ComputeMutexLock(&pool->mutex);
+    buffer->next = pool->buffers;
+    pool->buffers = buffer;
+    ComputeMutexUnlock(&pool->mutex);
+
+    return buffer;
+}
+
+bool ComputeReadbackPoolGetView(ComputeReadbackPool *pool, const ComputeReadbackBuffer *buffer,
+    uint64_t fenceValue, size_t size, uint32_t timeoutMs, ComputeReadbackView *pView)
+{
+    if (size > buffer->size)
+        return false;
+
+    if (!ComputeTimelineWait(pool->timeline, fenceValue, timeoutMs))
+        return false;
+
+    pView->pData = buffer->pMappedData;
+    pView->size = size;
+    return true;
+}
+
+void ComputeReadbackPoolRelease(ComputeReadbackPool *pool, ComputeReadbackBuffer *buffer)
+{
+    ComputeMutexLock(&pool->mutex);
+    buffer->inUse = false;
+    ComputeMutexUnlock(&pool->mutex);
+}
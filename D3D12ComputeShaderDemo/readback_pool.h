@@ -0,0 +1,62 @@
+#ifndef READBACK_POOL_H
+#define READBACK_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_thread.h"
+#include "compute_timeline.h"
+
+// The size of the pooled readback buffers is rounded up to this size
+#define COMPUTE_READBACK_PAGE_SIZE  65536
+
+// A persistently mapped buffer in readback memory
+typedef struct ComputeReadbackBuffer
+{
+    // The copy destination of the results
+    ComputeResource *resource;
+    void *pMappedData;
+    uint64_t size;
+    bool inUse;
+    struct ComputeReadbackBuffer *next;
+} ComputeReadbackBuffer;
+
+// A read-only view straight into the mapped readback memory.
+// It stays valid until the buffer is released back to the pool.
+typedef struct ComputeReadbackView
+{
+    const void *pData;
+    size_t size;
+} ComputeReadbackView;
+
+// The readback buffers are created on demand and reused across dispatches.
+// Acquire and Release may be called from any thread. GetView waits on the timeline,
+// so it belongs to the thread that waits on the timeline otherwise.
+typedef struct ComputeReadbackPool
+{
+    ComputeDevice *device;
+    ComputeTimeline *timeline;
+    ComputeMutex mutex;
+    // All the buffers created by the pool
+    ComputeReadbackBuffer *buffers;
+} ComputeReadbackPool;
+
+extern bool ComputeReadbackPoolInit(ComputeReadbackPool *pool, ComputeDevice *device, ComputeTimeline *timeline);
+// All the buffers must have been released, and the copies into them completed
+extern void ComputeReadbackPoolDestroy(ComputeReadbackPool *pool);
+
+// Get the smallest free buffer of at least size bytes, creating one if there is none.
+// Returns NULL on failure.
+extern ComputeReadbackBuffer* ComputeReadbackPoolAcquire(ComputeReadbackPool *pool, uint64_t size);
+
+// Wait until the copies into the buffer, which complete at fenceValue, have finished,
+// then return a view of the first size bytes. Returns false on timeout.
+extern bool ComputeReadbackPoolGetView(ComputeReadbackPool *pool, const ComputeReadbackBuffer *buffer,
+    uint64_t fenceValue, size_t size, uint32_t timeoutMs, ComputeReadbackView *pView);
+
+// Give the buffer back to the pool. Any view of it becomes invalid.
+extern void ComputeReadbackPoolRelease(ComputeReadbackPool *pool, ComputeReadbackBuffer *buffer);
+
+#endif // READBACK_POOL_H
@@ -0,0 +1,54 @@
+// Update of records with fields of mixed types, stored in the SoA layout of ComputeStructLayoutGetSoAOffsets:
+//
+//  struct Record
+//  {
+//      float value;
+//      half scale;
+//      int64_t id;
+//  };
+//
+// Each field has an array of its own in the buffer, so the consecutive threads load consecutive words of a field
+// instead of strided records. The buffer is raw, which Shader Model 5 reads whatever the field types:
+// the half is unpacked with f16tof32, and the 64-bit integer is a pair of 32-bit words, low word first.
+
+#ifndef GROUP_SIZE
+#define GROUP_SIZE  256
+#endif
+
+RWByteAddressBuffer records: register(u0);    // UAV
+
+// Root constants set for each Dispatch
+cbuffer RecordConstants : register(b0)
+{
+    // The DispatchConstants of the elementwise kernels
+    uint NumElements;
+    uint BaseGroup;
+    uint GroupsPerRow;
+    // The byte offsets of the field arrays
+    uint ValueOffset;
+    uint ScaleOffset;
+    uint IdOffset;
+    // Added to the ids, sign extended to 64 bits
+    int IdIncrement;
+};
+
+// value *= scale, id += IdIncrement. The scales are only read, two records share each of their words.
+[numthreads(GROUP_SIZE, 1, 1)]
+void UpdateRecords(uint3 groupID : SV_GroupID, uint3 localTID : SV_GroupThreadID)
+{
+    const uint group = BaseGroup + groupID.y * GroupsPerRow + groupID.x;
+    const uint index = group * GROUP_SIZE + localTID.x;
+    if (index >= NumElements)
+        return;
+
+    const uint scaleWord = records.Load(ScaleOffset + (index & ~1u) * 2);
+    const float scale = f16tof32((index & 1) != 0 ? scaleWord >> 16 : scaleWord);
+    const float value = asfloat(records.Load(ValueOffset + index * 4));
+    records.Store(ValueOffset + index * 4, asuint(value * scale));
+
+    // 64-bit addition with the carry of the low words
+    const uint2 id = records.Load2(IdOffset + index * 8);
+    const uint low = id.x + (uint)IdIncrement;
+    const uint high = id.y + (IdIncrement < 0 ? 0xffffffffu : 0u) + (low < id.x ? 1u : 0u);
+    records.Store2(IdOffset + index * 8, uint2(low, high));
+}
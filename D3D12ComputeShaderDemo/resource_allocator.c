@@ -0,0 +1,465 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "resource_allocator.h"
+
+// The largest pooled heap, COMPUTE_RESOURCE_MIN_BLOCK_SIZE << COMPUTE_RESOURCE_MAX_ORDER bytes (64 GB)
+#define COMPUTE_RESOURCE_MAX_ORDER  20
+
+// ---- Buddy allocator ----
+
+// The smallest order whose blocks hold size bytes
+static uint32_t GetBlockOrder(uint64_t size)
+{
+    const uint64_t numBlocks = (size + COMPUTE_RESOURCE_MIN_BLOCK_SIZE - 1) / COMPUTE_RESOURCE_MIN_BLOCK_SIZE;
+    uint32_t order = 0;
+    while (((uint64_t)1 << order) < numBlocks)
+        order++;
+    return order;
+}
+
+static void BuddyInit(uint8_t *tree, uint32_t maxOrder)
+{
+    // Every node starts as a free block of the order of its level.
+    uint32_t firstNode = 0;
+    for (uint32_t depth = 0; depth <= maxOrder; depth++)
+    {
+        memset(tree + firstNode, (int)(maxOrder - depth + 1), (size_t)1 << depth);
+        firstNode += 1U << depth;
+    }
+}
+
+// Propagate the change of a node of the given order to the root.
+// A parent whose two halves are both entirely free is a free block itself.
+static void BuddyUpdateParents(uint8_t *tree, uint32_t node, uint32_t order)
+{
+    while (node > 0)
+    {
+        node = (node - 1) / 2;
+        order++;
+        const uint8_t left = tree[2 * node + 1];
+        const uint8_t right = tree[2 * node + 2];
+        tree[node] = left == order && right == order ? (uint8_t)(order + 1) : (left > right ? left : right);
+    }
+}
+
+static bool BuddyAllocate(uint8_t *tree, uint32_t maxOrder, uint32_t order, uint64_t *pBlock)
+{
+    if (tree[0] < order + 1)
+        return false;
+
+    // Descend to a free block of the order, preferring the left halves to keep the heap compact.
+    uint32_t node = 0;
+    for (uint32_t nodeOrder = maxOrder; nodeOrder > order; nodeOrder--)
+    {
+        node = 2 * node + 1;
+        if (tree[node] < order + 1)
+            node++;
+    }
+
+    tree[node] = 0;
+    BuddyUpdateParents(tree, node, order);
+
+    *pBlock = (uint64_t)(node + 1 - (1U << (maxOrder - order))) << order;
+    return true;
+}
+
+static void BuddyFree(uint8_t *tree, uint32_t maxOrder, uint32_t order, uint64_t block)
+{
+    const uint32_t node = (1U << (maxOrder - order)) - 1 + (uint32_t)(block >> order);
+    tree[node] = (uint8_t)(order + 1);
+    BuddyUpdateParents(tree, node, order);
+}
+
+// ---- Allocator ----
+
+bool ComputeResourceAllocatorInit(ComputeResourceAllocator *allocator, ComputeDevice *device, ComputeTimeline *timeline,
+    uint64_t heapSize)
+{
+    memset(allocator, 0, sizeof(*allocator));
+    allocator->device = device;
+    allocator->timeline = timeline;
+    allocator->maxOrder = GetBlockOrder(heapSize);
+    if (allocator->maxOrder > COMPUTE_RESOURCE_MAX_ORDER)
+    {
+        puts("The resource heap size is too large!");
+        return false;
+    }
+    allocator->heapSize = (uint64_t)COMPUTE_RESOURCE_MIN_BLOCK_SIZE << allocator->maxOrder;
+
+    return true;
+}
+
+// Release the resource of the allocation and give its memory back
+static void FreeAllocation(ComputeResourceAllocator *allocator, const ComputeResourceAllocation *allocation)
+{
+    if (allocation->resource != NULL)
+        allocation->resource->lpVtbl->Release(allocation->resource);
+
+    // A lone resource of a transient set, whose memory is freed separately
+    if (allocation->size == 0)
+        return;
+
+    if (allocation->heapIndex == COMPUTE_RESOURCE_DEDICATED_HEAP)
+    {
+        allocation->heap->lpVtbl->Release(allocation->heap);
+        allocator->heapBytes -= allocation->size;
+        return;
+    }
+
+    ComputeResourcePoolHeap *poolHeap = &allocator->heaps[allocation->heapIndex];
+    BuddyFree(poolHeap->tree, allocator->maxOrder, allocation->order, allocation->offset / COMPUTE_RESOURCE_MIN_BLOCK_SIZE);
+    poolHeap->numAllocations--;
+}
+
+// Free the allocations whose fence value has been reached
+static void ReclaimAllocations(ComputeResourceAllocator *allocator)
+{
+    if (allocator->numDeferredFrees == 0)
+        return;
+
+    const uint64_t completedValue = ComputeTimelineGetCompletedValue(allocator->timeline);
+
+    uint32_t numPending = 0;
+    for (uint32_t i = 0; i < allocator->numDeferredFrees; i++)
+    {
+        const ComputeResourceDeferredFree *deferredFree = &allocator->deferredFrees[i];
+        if (deferredFree->fenceValue <= completedValue)
+            FreeAllocation(allocator, &deferredFree->allocation);
+        else
+            allocator->deferredFrees[numPending++] = *deferredFree;
+    }
+    allocator->numDeferredFrees = numPending;
+}
+
+void ComputeResourceAllocatorDestroy(ComputeResourceAllocator *allocator)
+{
+    uint64_t lastFenceValue = 0;
+    for (uint32_t i = 0; i < allocator->numDeferredFrees; i++)
+    {
+        if (allocator->deferredFrees[i].fenceValue > lastFenceValue)
+            lastFenceValue = allocator->deferredFrees[i].fenceValue;
+    }
+    if (lastFenceValue != 0 && lastFenceValue <= allocator->timeline->lastSignaledValue)
+        ComputeTimelineWait(allocator->timeline, lastFenceValue, COMPUTE_WAIT_INFINITE);
+
+    for (uint32_t i = 0; i < allocator->numDeferredFrees; i++)
+        FreeAllocation(allocator, &allocator->deferredFrees[i].allocation);
+
+    for (uint32_t i = 0; i < allocator->numHeaps; i++)
+    {
+        ComputeResourcePoolHeap *poolHeap = &allocator->heaps[i];
+        if (poolHeap->numAllocations > 0)
+            printf("%u buffers are still allocated in the resource heap %u!\n", poolHeap->numAllocations, i);
+        poolHeap->heap->lpVtbl->Release(poolHeap->heap);
+        free(poolHeap->tree);
+    }
+
+    free(allocator->heaps);
+    free(allocator->deferredFrees);
+    memset(allocator, 0, sizeof(*allocator));
+}
+
+static ComputeHeap* CreateHeap(ComputeResourceAllocator *allocator, ComputeHeapType heapType, uint64_t size)
+{
+    ComputeDevice *device = allocator->device;
+    const ComputeHeapDesc heapDesc = { size, heapType };
+    ComputeHeap *heap = device->lpVtbl->CreateHeap(device, &heapDesc);
+    if (heap == NULL)
+    {
+        printf("Failed to create a resource heap of %llu bytes!\n", (unsigned long long)size);
+        return NULL;
+    }
+
+    allocator->heapBytes += size;
+    if (allocator->heapBytes > allocator->peakHeapBytes)
+        allocator->peakHeapBytes = allocator->heapBytes;
+
+    return heap;
+}
+
+// Add a pooled heap of the type, returning its index or COMPUTE_RESOURCE_DEDICATED_HEAP on failure
+static uint32_t AddPoolHeap(ComputeResourceAllocator *allocator, ComputeHeapType heapType)
+{
+    if (allocator->numHeaps == allocator->heapCapacity)
+    {
+        const uint32_t newCapacity = allocator->heapCapacity == 0 ? 4 : allocator->heapCapacity * 2;
+        ComputeResourcePoolHeap *heaps = realloc(allocator->heaps, newCapacity * sizeof(*heaps));
+        if (heaps == NULL)
+            return COMPUTE_RESOURCE_DEDICATED_HEAP;
+        allocator->heaps = heaps;
+        allocator->heapCapacity = newCapacity;
+    }
+
+    ComputeResourcePoolHeap *poolHeap = &allocator->heaps[allocator->numHeaps];
+    memset(poolHeap, 0, sizeof(*poolHeap));
+    poolHeap->type = heapType;
+    poolHeap->tree = malloc(((size_t)2 << allocator->maxOrder) - 1);
+    if (poolHeap->tree == NULL)
+        return COMPUTE_RESOURCE_DEDICATED_HEAP;
+    BuddyInit(poolHeap->tree, allocator->maxOrder);
+
+    poolHeap->heap = CreateHeap(allocator, heapType, allocator->heapSize);
+    if (poolHeap->heap == NULL)
+    {
+        free(poolHeap->tree);
+        return COMPUTE_RESOURCE_DEDICATED_HEAP;
+    }
+
+    return allocator->numHeaps++;
+}
+
+bool ComputeResourceAllocatorAllocateMemory(ComputeResourceAllocator *allocator, ComputeHeapType heapType, uint64_t size,
+    ComputeResourceAllocation *pAllocation)
+{
+    ReclaimAllocations(allocator);
+
+    memset(pAllocation, 0, sizeof(*pAllocation));
+    if (size == 0)
+        return false;
+
+    const uint32_t order = GetBlockOrder(size);
+
+    // Too large for the pooled heaps
+    if (order > allocator->maxOrder)
+    {
+        const uint64_t heapSize = (size + COMPUTE_RESOURCE_MIN_BLOCK_SIZE - 1) / COMPUTE_RESOURCE_MIN_BLOCK_SIZE *
+            COMPUTE_RESOURCE_MIN_BLOCK_SIZE;
+        pAllocation->heap = CreateHeap(allocator, heapType, heapSize);
+        if (pAllocation->heap == NULL)
+            return false;
+
+        pAllocation->heapIndex = COMPUTE_RESOURCE_DEDICATED_HEAP;
+        pAllocation->size = heapSize;
+        return true;
+    }
+
+    uint64_t block = 0;
+    uint32_t heapIndex = 0;
+    for (; heapIndex < allocator->numHeaps; heapIndex++)
+    {
+        ComputeResourcePoolHeap *poolHeap = &allocator->heaps[heapIndex];
+        if (poolHeap->type == heapType && BuddyAllocate(poolHeap->tree, allocator->maxOrder, order, &block))
+            break;
+    }
+
+    if (heapIndex == allocator->numHeaps)
+    {
+        heapIndex = AddPoolHeap(allocator, heapType);
+        if (heapIndex == COMPUTE_RESOURCE_DEDICATED_HEAP)
+            return false;
+        BuddyAllocate(allocator->heaps[heapIndex].tree, allocator->maxOrder, order, &block);
+    }
+
+    ComputeResourcePoolHeap *poolHeap = &allocator->heaps[heapIndex];
+    poolHeap->numAllocations++;
+
+    pAllocation->heap = poolHeap->heap;
+    pAllocation->heapIndex = heapIndex;
+    pAllocation->order = order;
+    pAllocation->offset = block * COMPUTE_RESOURCE_MIN_BLOCK_SIZE;
+    pAllocation->size = (uint64_t)COMPUTE_RESOURCE_MIN_BLOCK_SIZE << order;
+    return true;
+}
+
+bool ComputeResourceAllocatorCreateBuffer(ComputeResourceAllocator *allocator, ComputeHeapType heapType,
+    const ComputeResourceDesc *pDesc, ComputeResourceStates initialState, ComputeResourceAllocation *pAllocation)
+{
+    if (!ComputeResourceAllocatorAllocateMemory(allocator, heapType, pDesc->Width, pAllocation))
+        return false;
+
+    ComputeDevice *device = allocator->device;
+    pAllocation->resource = device->lpVtbl->CreatePlacedResource(device, pAllocation->heap, pAllocation->offset, pDesc, initialState);
+    if (pAllocation->resource == NULL)
+    {
+        puts("Failed to create a placed buffer!");
+        FreeAllocation(allocator, pAllocation);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeResourceAllocatorFree(ComputeResourceAllocator *allocator, const ComputeResourceAllocation *allocation)
+{
+    if (allocation->resource == NULL && allocation->size == 0)
+        return;
+
+    if (allocator->numDeferredFrees == allocator->deferredFreeCapacity)
+    {
+        const uint32_t newCapacity = allocator->deferredFreeCapacity == 0 ? 16 : allocator->deferredFreeCapacity * 2;
+        ComputeResourceDeferredFree *deferredFrees = realloc(allocator->deferredFrees, newCapacity * sizeof(*deferredFrees));
+        if (deferredFrees == NULL)
+        {
+            puts("Failed to free the buffer memory!");
+            return;
+        }
+        allocator->deferredFrees = deferredFrees;
+        allocator->deferredFreeCapacity = newCapacity;
+    }
+
+    // The command list being recorded may still access the memory.
+    ComputeResourceDeferredFree *deferredFree = &allocator->deferredFrees[allocator->numDeferredFrees++];
+    deferredFree->fenceValue = allocator->timeline->lastSignaledValue + 1;
+    deferredFree->allocation = *allocation;
+}
+
+// ---- Transient buffers ----
+
+static inline uint64_t GetPlacedSize(const ComputeTransientBufferDesc *desc)
+{
+    return (desc->Desc.Width + COMPUTE_RESOURCE_MIN_BLOCK_SIZE - 1) / COMPUTE_RESOURCE_MIN_BLOCK_SIZE * COMPUTE_RESOURCE_MIN_BLOCK_SIZE;
+}
+
+static inline bool PassesOverlap(const ComputeTransientBufferDesc *a, const ComputeTransientBufferDesc *b)
+{
+    return a->FirstPass <= b->LastPass && b->FirstPass <= a->LastPass;
+}
+
+static inline bool MemoryOverlaps(uint64_t offsetA, uint64_t sizeA, uint64_t offsetB, uint64_t sizeB)
+{
+    return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+}
+
+// Place the buffers, largest first, at the lowest offset that does not overlap any placed buffer alive at the same time.
+// Returns the memory size of the set.
+static uint64_t PackTransientBuffers(uint32_t numBuffers, const ComputeTransientBufferDesc *pDescs, uint32_t *sortedIndices,
+    ComputeTransientBuffer *buffers)
+{
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        uint32_t j = i;
+        for (; j > 0 && GetPlacedSize(&pDescs[sortedIndices[j - 1]]) < GetPlacedSize(&pDescs[i]); j--)
+            sortedIndices[j] = sortedIndices[j - 1];
+        sortedIndices[j] = i;
+    }
+
+    uint64_t totalSize = 0;
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        const uint32_t index = sortedIndices[i];
+        const uint64_t size = GetPlacedSize(&pDescs[index]);
+
+        // The candidates are the start of the memory and the ends of the live buffers.
+        uint64_t bestOffset = UINT64_MAX;
+        for (uint32_t c = 0; c <= i; c++)
+        {
+            uint64_t candidate = 0;
+            if (c < i)
+            {
+                const uint32_t other = sortedIndices[c];
+                if (!PassesOverlap(&pDescs[index], &pDescs[other]))
+                    continue;
+                candidate = buffers[other].offset + GetPlacedSize(&pDescs[other]);
+            }
+            if (candidate >= bestOffset)
+                continue;
+
+            bool fits = true;
+            for (uint32_t p = 0; p < i && fits; p++)
+            {
+                const uint32_t other = sortedIndices[p];
+                fits = !PassesOverlap(&pDescs[index], &pDescs[other]) ||
+                    !MemoryOverlaps(candidate, size, buffers[other].offset, GetPlacedSize(&pDescs[other]));
+            }
+            if (fits)
+                bestOffset = candidate;
+        }
+
+        buffers[index].offset = bestOffset;
+        if (bestOffset + size > totalSize)
+            totalSize = bestOffset + size;
+    }
+
+    return totalSize;
+}
+
+bool ComputeResourceAllocatorCreateTransientSet(ComputeResourceAllocator *allocator, uint32_t numBuffers,
+    const ComputeTransientBufferDesc *pDescs, ComputeTransientSet *set)
+{
+    memset(set, 0, sizeof(*set));
+
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        if (pDescs[i].Desc.Width == 0 || pDescs[i].FirstPass > pDescs[i].LastPass)
+        {
+            puts("Invalid transient buffer description!");
+            return false;
+        }
+        set->unaliasedSize += GetPlacedSize(&pDescs[i]);
+    }
+
+    uint32_t *sortedIndices = malloc(numBuffers * sizeof(*sortedIndices));
+    set->buffers = calloc(numBuffers, sizeof(*set->buffers));
+    if (numBuffers == 0 || sortedIndices == NULL || set->buffers == NULL)
+    {
+        free(sortedIndices);
+        free(set->buffers);
+        set->buffers = NULL;
+        return false;
+    }
+
+    const uint64_t totalSize = PackTransientBuffers(numBuffers, pDescs, sortedIndices, set->buffers);
+    free(sortedIndices);
+
+    if (!ComputeResourceAllocatorAllocateMemory(allocator, COMPUTE_HEAP_TYPE_DEFAULT, totalSize, &set->memory))
+    {
+        free(set->buffers);
+        set->buffers = NULL;
+        return false;
+    }
+
+    ComputeDevice *device = allocator->device;
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        ComputeTransientBuffer *buffer = &set->buffers[i];
+        buffer->resource = device->lpVtbl->CreatePlacedResource(device, set->memory.heap, set->memory.offset + buffer->offset,
+            &pDescs[i].Desc, pDescs[i].InitialState);
+        if (buffer->resource == NULL)
+        {
+            puts("Failed to create a transient buffer!");
+            ComputeResourceAllocatorFreeTransientSet(allocator, set);
+            return false;
+        }
+        set->numBuffers++;
+    }
+
+    // The memory of a buffer was last used by the buffers that overlap it and whose passes end before its own.
+    for (uint32_t i = 0; i < numBuffers; i++)
+    {
+        ComputeTransientBuffer *buffer = &set->buffers[i];
+        uint32_t numPredecessors = 0;
+        for (uint32_t j = 0; j < numBuffers; j++)
+        {
+            if (pDescs[j].LastPass < pDescs[i].FirstPass &&
+                MemoryOverlaps(buffer->offset, GetPlacedSize(&pDescs[i]), set->buffers[j].offset, GetPlacedSize(&pDescs[j])))
+            {
+                buffer->aliasedResource = set->buffers[j].resource;
+                numPredecessors++;
+            }
+        }
+
+        buffer->aliased = numPredecessors > 0;
+        if (numPredecessors > 1)
+            buffer->aliasedResource = NULL;
+    }
+
+    return true;
+}
+
+void ComputeResourceAllocatorFreeTransientSet(ComputeResourceAllocator *allocator, ComputeTransientSet *set)
+{
+    for (uint32_t i = 0; i < set->numBuffers; i++)
+    {
+        // The buffers share the memory of the set, which is freed once after them.
+        ComputeResourceAllocation allocation;
+        memset(&allocation, 0, sizeof(allocation));
+        allocation.resource = set->buffers[i].resource;
+        ComputeResourceAllocatorFree(allocator, &allocation);
+    }
+    ComputeResourceAllocatorFree(allocator, &set->memory);
+
+    free(set->buffers);
+    memset(set, 0, sizeof(*set));
+}
@@ -0,0 +1,136 @@
+#ifndef RESOURCE_ALLOCATOR_H
+#define RESOURCE_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+
+// The smallest block of the buddy allocator, which is the placement alignment
+#define COMPUTE_RESOURCE_MIN_BLOCK_SIZE     COMPUTE_PLACEMENT_ALIGNMENT
+
+// The heap index of the memory that has a heap of its own
+#define COMPUTE_RESOURCE_DEDICATED_HEAP     0xffffffffU
+
+// A range of heap memory handed out by the allocator, with the buffer placed in it if any
+typedef struct ComputeResourceAllocation
+{
+    ComputeResource *resource;
+    ComputeHeap *heap;
+    // Index of the pooled heap, or COMPUTE_RESOURCE_DEDICATED_HEAP when the memory is too large for the pooled heaps
+    uint32_t heapIndex;
+    // Size class of the pooled memory: COMPUTE_RESOURCE_MIN_BLOCK_SIZE << order bytes
+    uint32_t order;
+    uint64_t offset;
+    uint64_t size;
+} ComputeResourceAllocation;
+
+// One pooled heap, split into power of two blocks by a buddy allocator
+typedef struct ComputeResourcePoolHeap
+{
+    ComputeHeap *heap;
+    ComputeHeapType type;
+    // Complete binary tree over the blocks of the heap, the root covering the whole heap.
+    // Each node holds 1 + the order of the largest free block in its subtree, or 0 if there is none.
+    uint8_t *tree;
+    uint32_t numAllocations;
+} ComputeResourcePoolHeap;
+
+// Memory released while the GPU may still access it, reusable once the timeline reaches fenceValue
+typedef struct ComputeResourceDeferredFree
+{
+    uint64_t fenceValue;
+    ComputeResourceAllocation allocation;
+} ComputeResourceDeferredFree;
+
+// Sub-allocates buffers from a few large heaps instead of giving each buffer an implicit heap of its own,
+// so creating a buffer costs a tree walk and a placed resource, and the memory is recycled across buffers.
+// Requests larger than a pooled heap get a heap of their own.
+// Like the descriptor allocator, it is meant to be used by the single thread that records the command lists.
+typedef struct ComputeResourceAllocator
+{
+    ComputeDevice *device;
+    ComputeTimeline *timeline;
+    // The size of the pooled heaps, COMPUTE_RESOURCE_MIN_BLOCK_SIZE << maxOrder
+    uint64_t heapSize;
+    uint32_t maxOrder;
+    ComputeResourcePoolHeap *heaps;
+    uint32_t numHeaps;
+    uint32_t heapCapacity;
+    ComputeResourceDeferredFree *deferredFrees;
+    uint32_t numDeferredFrees;
+    uint32_t deferredFreeCapacity;
+    // The memory of all the heaps created, and its high-water mark
+    uint64_t heapBytes;
+    uint64_t peakHeapBytes;
+} ComputeResourceAllocator;
+
+// The size of the pooled heaps is rounded up to a power of two multiple of COMPUTE_RESOURCE_MIN_BLOCK_SIZE.
+extern bool ComputeResourceAllocatorInit(ComputeResourceAllocator *allocator, ComputeDevice *device, ComputeTimeline *timeline,
+    uint64_t heapSize);
+// Waits for the memory released last, then releases the heaps.
+// The buffers still allocated must have been released, or at least no longer be used.
+extern void ComputeResourceAllocatorDestroy(ComputeResourceAllocator *allocator);
+
+// Allocate size bytes of heap memory without a resource
+extern bool ComputeResourceAllocatorAllocateMemory(ComputeResourceAllocator *allocator, ComputeHeapType heapType, uint64_t size,
+    ComputeResourceAllocation *pAllocation);
+
+// Create a buffer placed in pooled memory. Its initial content is undefined.
+extern bool ComputeResourceAllocatorCreateBuffer(ComputeResourceAllocator *allocator, ComputeHeapType heapType,
+    const ComputeResourceDesc *pDesc, ComputeResourceStates initialState, ComputeResourceAllocation *pAllocation);
+
+// Release the buffer, if any, and the memory once the commands recorded so far have completed
+extern void ComputeResourceAllocatorFree(ComputeResourceAllocator *allocator, const ComputeResourceAllocation *allocation);
+
+// ---- Transient buffers ----
+
+// An intermediate buffer of a job graph, only accessed by the passes FirstPass to LastPass included
+typedef struct ComputeTransientBufferDesc
+{
+    ComputeResourceDesc Desc;
+    ComputeResourceStates InitialState;
+    uint32_t FirstPass;
+    uint32_t LastPass;
+} ComputeTransientBufferDesc;
+
+typedef struct ComputeTransientBuffer
+{
+    ComputeResource *resource;
+    // The offset of the buffer in the memory of its set
+    uint64_t offset;
+    // Whether some memory of the buffer was last used by another buffer of the set,
+    // in which case an aliasing barrier has to precede its first pass
+    bool aliased;
+    // The buffer that last used the memory, or NULL if there are several of them
+    ComputeResource *aliasedResource;
+} ComputeTransientBuffer;
+
+// The buffers of a job graph packed into one allocation.
+// Buffers whose pass ranges do not overlap may share memory, so the set takes the memory of the largest
+// group of buffers alive at the same pass rather than the sum of all of them.
+typedef struct ComputeTransientSet
+{
+    ComputeResourceAllocation memory;
+    ComputeTransientBuffer *buffers;
+    uint32_t numBuffers;
+    // The memory the buffers would take without aliasing
+    uint64_t unaliasedSize;
+} ComputeTransientSet;
+
+extern bool ComputeResourceAllocatorCreateTransientSet(ComputeResourceAllocator *allocator, uint32_t numBuffers,
+    const ComputeTransientBufferDesc *pDescs, ComputeTransientSet *set);
+// Release the buffers of the set and its memory once the commands recorded so far have completed
+extern void ComputeResourceAllocatorFreeTransientSet(ComputeResourceAllocator *allocator, ComputeTransientSet *set);
+
+// The barrier to record before the first pass of a buffer whose memory is aliased
+static inline ComputeResourceBarrier ComputeTransientAliasingBarrier(const ComputeTransientBuffer *buffer)
+{
+    const ComputeResourceBarrier barrier = { COMPUTE_RESOURCE_BARRIER_TYPE_ALIASING, COMPUTE_RESOURCE_BARRIER_FLAG_NONE,
+        buffer->resource, COMPUTE_RESOURCE_STATE_COMMON, COMPUTE_RESOURCE_STATE_COMMON, buffer->aliasedResource };
+    return barrier;
+}
+
+#endif // RESOURCE_ALLOCATOR_H
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "resource_states.h"
+
+#define RESOURCE_STATES_INITIAL_CAPACITY    16
+
+static inline uint32_t HashResource(const ComputeResource *resource, uint32_t capacity)
+{
+    uint64_t key = (uint64_t)(uintptr_t)resource;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key & (capacity - 1);
+}
+
+// Read-only states may be combined, and a resource in a combination needs no barrier for any of its parts.
+static inline bool IsReadState(ComputeResourceStates state)
+{
+    return state != COMPUTE_RESOURCE_STATE_COMMON && (state & ~COMPUTE_RESOURCE_STATE_GENERIC_READ) == 0;
+}
+
+static inline bool IsStateIncluded(ComputeResourceStates current, ComputeResourceStates required)
+{
+    return current == required || (IsReadState(current) && IsReadState(required) && (current & required) == required);
+}
+
+// ---- State table ----
+
+static uint32_t FindTableSlot(const ComputeResourceStateTable *table, const ComputeResource *resource)
+{
+    uint32_t slot = HashResource(resource, table->capacity);
+    while (table->entries[slot].resource != NULL && table->entries[slot].resource != resource)
+        slot = (slot + 1) & (table->capacity - 1);
+    return slot;
+}
+
+static bool GrowTable(ComputeResourceStateTable *table)
+{
+    ComputeResourceStateTable grown = { NULL, table->capacity * 2, table->numEntries };
+    grown.entries = calloc(grown.capacity, sizeof(*grown.entries));
+    if (grown.entries == NULL)
+        return false;
+
+    for (uint32_t i = 0; i < table->capacity; i++)
+    {
+        if (table->entries[i].resource != NULL)
+            grown.entries[FindTableSlot(&grown, table->entries[i].resource)] = table->entries[i];
+    }
+
+    free(table->entries);
+    *table = grown;
+    return true;
+}
+
+bool ComputeResourceStateTableInit(ComputeResourceStateTable *table)
+{
+    table->capacity = RESOURCE_STATES_INITIAL_CAPACITY;
+    table->numEntries = 0;
+    table->entries = calloc(table->capacity, sizeof(*table->entries));
+    return table->entries != NULL;
+}
+
+void ComputeResourceStateTableDestroy(ComputeResourceStateTable *table)
+{
+    free(table->entries);
+    memset(table, 0, sizeof(*table));
+}
+
+bool ComputeResourceStateTableRegister(ComputeResourceStateTable *table, ComputeResource *resource, ComputeResourceStates state)
+{
+    // Keep the load factor under 3/4.
+    if ((table->numEntries + 1) * 4 > table->capacity * 3 && !GrowTable(table))
+    {
+        puts("Failed to register the resource state!");
+        return false;
+    }
+
+    ComputeResourceStateEntry *entry = &table->entries[FindTableSlot(table, resource)];
+    if (entry->resource == NULL)
+        table->numEntries++;
+    entry->resource = resource;
+    entry->state = state;
+    return true;
+}
+
+void ComputeResourceStateTableUnregister(ComputeResourceStateTable *table, ComputeResource *resource)
+{
+    if (table->entries == NULL || resource == NULL)
+        return;
+
+    uint32_t slot = FindTableSlot(table, resource);
+    if (table->entries[slot].resource == NULL)
+        return;
+
+    // Shift the following entries of the probe sequence back into the hole.
+    const uint32_t mask = table->capacity - 1;
+    for (uint32_t next = (slot + 1) & mask; table->entries[next].resource != NULL; next = (next + 1) & mask)
+    {
+        const uint32_t home = HashResource(table->entries[next].resource, table->capacity);
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            table->entries[slot] = table->entries[next];
+            slot = next;
+        }
+    }
+
+    table->entries[slot].resource = NULL;
+    table->numEntries--;
+}
+
+bool ComputeResourceStateTableGet(const ComputeResourceStateTable *table, ComputeResource *resource, ComputeResourceStates *pState)
+{
+    const ComputeResourceStateEntry *entry = &table->entries[FindTableSlot(table, resource)];
+    if (entry->resource == NULL)
+        return false;
+
+    *pState = entry->state;
+    return true;
+}
+
+// ---- Tracker ----
+
+static uint32_t FindTrackerSlot(const ComputeStateTracker *tracker, const ComputeResource *resource)
+{
+    uint32_t slot = HashResource(resource, tracker->capacity);
+    while (tracker->resources[slot].resource != NULL && tracker->resources[slot].resource != resource)
+        slot = (slot + 1) & (tracker->capacity - 1);
+    return slot;
+}
+
+// Get the state of the resource in the command list, or NULL on first access
+static ComputeTrackedResource* GetTrackedResource(ComputeStateTracker *tracker, ComputeResource *resource, bool *pFirstAccess)
+{
+    if ((tracker->numResources + 1) * 4 > tracker->capacity * 3)
+    {
+        const uint32_t oldCapacity = tracker->capacity;
+        ComputeTrackedResource *oldResources = tracker->resources;
+
+        tracker->resources = calloc(oldCapacity * 2, sizeof(*tracker->resources));
+        if (tracker->resources == NULL)
+        {
+            tracker->resources = oldResources;
+            puts("Failed to track the resource state!");
+            return NULL;
+        }
+        tracker->capacity = oldCapacity * 2;
+
+        for (uint32_t i = 0; i < oldCapacity; i++)
+        {
+            if (oldResources[i].resource != NULL)
+                tracker->resources[FindTrackerSlot(tracker, oldResources[i].resource)] = oldResources[i];
+        }
+        free(oldResources);
+    }
+
+    ComputeTrackedResource *tracked = &tracker->resources[FindTrackerSlot(tracker, resource)];
+    *pFirstAccess = tracked->resource == NULL;
+    if (*pFirstAccess)
+    {
+        memset(tracked, 0, sizeof(*tracked));
+        tracked->resource = resource;
+        tracker->numResources++;
+    }
+    return tracked;
+}
+
+static bool ReserveBarriers(ComputeResourceBarrier **pBarriers, uint32_t *pCapacity, uint32_t count)
+{
+    if (count <= *pCapacity)
+        return true;
+
+    uint32_t newCapacity = *pCapacity == 0 ? RESOURCE_STATES_INITIAL_CAPACITY : *pCapacity;
+    while (newCapacity < count)
+        newCapacity *= 2;
+
+    ComputeResourceBarrier *barriers = realloc(*pBarriers, newCapacity * sizeof(*barriers));
+    if (barriers == NULL)
+        return false;
+
+    *pBarriers = barriers;
+    *pCapacity = newCapacity;
+    return true;
+}
+
+static void AddPendingBarrier(ComputeStateTracker *tracker, ComputeResourceBarrierType type, ComputeResourceBarrierFlags flags,
+    ComputeResource *resource, ComputeResourceStates stateBefore, ComputeResourceStates stateAfter)
+{
+    if (!ReserveBarriers(&tracker->pendingBarriers, &tracker->pendingCapacity, tracker->numPendingBarriers + 1))
+    {
+        puts("Failed to record a resource barrier!");
+        return;
+    }
+
+    const ComputeResourceBarrier barrier = { type, flags, resource, stateBefore, stateAfter, NULL };
+    tracker->pendingBarriers[tracker->numPendingBarriers++] = barrier;
+}
+
+// Find the pending barrier of the resource of the type and flags, or return NULL
+static ComputeResourceBarrier* FindPendingBarrier(ComputeStateTracker *tracker, ComputeResourceBarrierType type,
+    ComputeResourceBarrierFlags flags, const ComputeResource *resource)
+{
+    for (uint32_t i = 0; i < tracker->numPendingBarriers; i++)
+    {
+        ComputeResourceBarrier *barrier = &tracker->pendingBarriers[i];
+        if (barrier->Type == type && barrier->Flags == flags && barrier->pResource == resource)
+            return barrier;
+    }
+    return NULL;
+}
+
+static void RemovePendingBarrier(ComputeStateTracker *tracker, ComputeResourceBarrier *barrier)
+{
+    const uint32_t index = (uint32_t)(barrier - tracker->pendingBarriers);
+    memmove(barrier, barrier + 1, (tracker->numPendingBarriers - index - 1) * sizeof(*barrier));
+    tracker->numPendingBarriers--;
+}
+
+// Move the resource to the state with a full transition, merged with the one already pending if any
+static void TransitionResource(ComputeStateTracker *tracker, ComputeTrackedResource *tracked, ComputeResourceStates state)
+{
+    // A transition also orders the UAV accesses around it.
+    ComputeResourceBarrier *uavBarrier = FindPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_UAV,
+        COMPUTE_RESOURCE_BARRIER_FLAG_NONE, tracked->resource);
+    if (uavBarrier != NULL)
+        RemovePendingBarrier(tracker, uavBarrier);
+
+    ComputeResourceBarrier *pending = FindPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION,
+        COMPUTE_RESOURCE_BARRIER_FLAG_NONE, tracked->resource);
+    if (pending != NULL)
+    {
+        pending->StateAfter = state;
+        if (pending->StateBefore == state)
+            RemovePendingBarrier(tracker, pending);
+    }
+    else
+        AddPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE,
+            tracked->resource, tracked->state, state);
+
+    tracked->state = state;
+    tracked->transitioned = true;
+    tracked->uavCommand = 0;
+}
+
+// End the split barrier of the resource
+static void EndSplitTransition(ComputeStateTracker *tracker, ComputeTrackedResource *tracked)
+{
+    AddPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_END_ONLY,
+        tracked->resource, tracked->state, tracked->splitState);
+    tracked->state = tracked->splitState;
+    tracked->splitting = false;
+    tracked->uavCommand = 0;
+}
+
+bool ComputeStateTrackerInit(ComputeStateTracker *tracker)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->capacity = RESOURCE_STATES_INITIAL_CAPACITY;
+    tracker->resources = calloc(tracker->capacity, sizeof(*tracker->resources));
+    return tracker->resources != NULL;
+}
+
+void ComputeStateTrackerDestroy(ComputeStateTracker *tracker)
+{
+    free(tracker->resources);
+    free(tracker->pendingBarriers);
+    free(tracker->resolvedBarriers);
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+void ComputeStateTrackerReset(ComputeStateTracker *tracker)
+{
+    memset(tracker->resources, 0, tracker->capacity * sizeof(*tracker->resources));
+    tracker->numResources = 0;
+    tracker->numPendingBarriers = 0;
+    tracker->commandIndex = 0;
+}
+
+void ComputeStateTrackerRequire(ComputeStateTracker *tracker, ComputeResource *resource, ComputeResourceStates state)
+{
+    bool firstAccess;
+    ComputeTrackedResource *tracked = GetTrackedResource(tracker, resource, &firstAccess);
+    if (tracked == NULL)
+        return;
+
+    if (firstAccess)
+    {
+        tracked->firstState = state;
+        tracked->state = state;
+    }
+    else if (tracked->splitting)
+    {
+        EndSplitTransition(tracker, tracked);
+        if (!IsStateIncluded(tracked->state, state))
+            TransitionResource(tracker, tracked, state);
+    }
+    else if (IsStateIncluded(tracked->state, state))
+    {
+        // Two commands accessing the resource as a UAV may depend on each other.
+        if (state == COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS && tracked->uavCommand != 0 && tracked->uavCommand <= tracker->commandIndex &&
+            FindPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_UAV, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, resource) == NULL)
+            AddPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_UAV, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, resource,
+                COMPUTE_RESOURCE_STATE_COMMON, COMPUTE_RESOURCE_STATE_COMMON);
+    }
+    else if (!tracked->transitioned && IsReadState(tracked->state) && IsReadState(state))
+    {
+        // Until its first barrier, the resource can enter the command list in all the read states it needs.
+        tracked->state = (ComputeResourceStates)(tracked->state | state);
+        tracked->firstState = tracked->state;
+    }
+    else
+        TransitionResource(tracker, tracked, state);
+
+    if (state == COMPUTE_RESOURCE_STATE_UNORDERED_ACCESS)
+        tracked->uavCommand = tracker->commandIndex + 1;
+}
+
+void ComputeStateTrackerBeginTransition(ComputeStateTracker *tracker, ComputeResource *resource, ComputeResourceStates state)
+{
+    bool firstAccess;
+    ComputeTrackedResource *tracked = GetTrackedResource(tracker, resource, &firstAccess);
+    if (tracked == NULL)
+        return;
+
+    // The transition from the state left by the previous command list runs before this one anyway.
+    if (firstAccess)
+    {
+        tracked->firstState = state;
+        tracked->state = state;
+        return;
+    }
+
+    if (tracked->splitting)
+    {
+        if (tracked->splitState == state)
+            return;
+        EndSplitTransition(tracker, tracked);
+    }
+
+    if (IsStateIncluded(tracked->state, state))
+        return;
+
+    // A pending transition of the resource would not leave any slack, merge into it instead.
+    if (FindPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE, resource) != NULL)
+    {
+        TransitionResource(tracker, tracked, state);
+        return;
+    }
+
+    ComputeResourceBarrier *uavBarrier = FindPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_UAV,
+        COMPUTE_RESOURCE_BARRIER_FLAG_NONE, resource);
+    if (uavBarrier != NULL)
+        RemovePendingBarrier(tracker, uavBarrier);
+
+    AddPendingBarrier(tracker, COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_BEGIN_ONLY,
+        resource, tracked->state, state);
+    tracked->splitState = state;
+    tracked->splitting = true;
+    tracked->transitioned = true;
+}
+
+void ComputeStateTrackerFlush(ComputeStateTracker *tracker, ComputeCommandList *commandList)
+{
+    if (tracker->numPendingBarriers > 0)
+    {
+        commandList->lpVtbl->ResourceBarrier(commandList, tracker->numPendingBarriers, tracker->pendingBarriers);
+        tracker->numPendingBarriers = 0;
+    }
+    tracker->commandIndex++;
+}
+
+void ComputeStateTrackerFinish(ComputeStateTracker *tracker, ComputeCommandList *commandList)
+{
+    for (uint32_t i = 0; i < tracker->capacity; i++)
+    {
+        ComputeTrackedResource *tracked = &tracker->resources[i];
+        if (tracked->resource != NULL && tracked->splitting)
+            EndSplitTransition(tracker, tracked);
+    }
+
+    if (tracker->numPendingBarriers > 0)
+    {
+        commandList->lpVtbl->ResourceBarrier(commandList, tracker->numPendingBarriers, tracker->pendingBarriers);
+        tracker->numPendingBarriers = 0;
+    }
+}
+
+uint32_t ComputeStateTrackerResolve(ComputeStateTracker *tracker, ComputeResourceStateTable *table,
+    const ComputeResourceBarrier **ppBarriers)
+{
+    uint32_t numBarriers = 0;
+
+    for (uint32_t i = 0; i < tracker->capacity; i++)
+    {
+        const ComputeTrackedResource *tracked = &tracker->resources[i];
+        ComputeResourceStates state;
+        if (tracked->resource == NULL || !ComputeResourceStateTableGet(table, tracked->resource, &state))
+            continue;
+
+        if (!IsStateIncluded(state, tracked->firstState))
+        {
+            if (!ReserveBarriers(&tracker->resolvedBarriers, &tracker->resolvedCapacity, numBarriers + 1))
+            {
+                puts("Failed to resolve the resource states!");
+                break;
+            }
+
+            const ComputeResourceBarrier barrier = { COMPUTE_RESOURCE_BARRIER_TYPE_TRANSITION, COMPUTE_RESOURCE_BARRIER_FLAG_NONE,
+                tracked->resource, state, tracked->firstState, NULL };
+            tracker->resolvedBarriers[numBarriers++] = barrier;
+        }
+
+        // A resource left in a read state it was already in keeps the wider state.
+        ComputeResourceStateTableRegister(table, tracked->resource,
+            !tracked->transitioned && IsStateIncluded(state, tracked->firstState) ? state : tracked->state);
+    }
+
+    *ppBarriers = tracker->resolvedBarriers;
+    return numBarriers;
+}
@@ -0,0 +1,102 @@
+#ifndef RESOURCE_STATES_H
+#define RESOURCE_STATES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+
+// The state of a resource between the submissions of a queue
+typedef struct ComputeResourceStateEntry
+{
+    ComputeResource *resource;
+    ComputeResourceStates state;
+} ComputeResourceStateEntry;
+
+// The states the registered resources are left in by the command lists submitted so far.
+// Open addressing hash table keyed on the resource.
+typedef struct ComputeResourceStateTable
+{
+    ComputeResourceStateEntry *entries;
+    uint32_t capacity;
+    uint32_t numEntries;
+} ComputeResourceStateTable;
+
+extern bool ComputeResourceStateTableInit(ComputeResourceStateTable *table);
+extern void ComputeResourceStateTableDestroy(ComputeResourceStateTable *table);
+
+// Start tracking a resource, in the state it was created in
+extern bool ComputeResourceStateTableRegister(ComputeResourceStateTable *table, ComputeResource *resource, ComputeResourceStates state);
+// Stop tracking a resource before it is released
+extern void ComputeResourceStateTableUnregister(ComputeResourceStateTable *table, ComputeResource *resource);
+extern bool ComputeResourceStateTableGet(const ComputeResourceStateTable *table, ComputeResource *resource, ComputeResourceStates *pState);
+
+// The state of a resource within one command list
+typedef struct ComputeTrackedResource
+{
+    ComputeResource *resource;
+    // The state required by the first access, resolved against the state table at submit
+    ComputeResourceStates firstState;
+    // The state after the commands and the barriers recorded so far
+    ComputeResourceStates state;
+    // The target of a split barrier that has begun but not ended
+    ComputeResourceStates splitState;
+    bool splitting;
+    // Whether a barrier has been recorded for the resource, otherwise the first state may still be widened
+    bool transitioned;
+    // 1 + the index of the last command that accessed the resource as a UAV, 0 if none since its last barrier
+    uint32_t uavCommand;
+} ComputeTrackedResource;
+
+// Records the states the commands of one command list need, and derives the barriers:
+// - The accesses of a command are declared with Require, then Flush records all the barriers they need
+//   in a single ResourceBarrier call, right before the command.
+// - A transition that is undone before the flush is dropped, and two pending transitions of a resource are merged.
+// - Read states are combined instead of being transitioned between.
+// - A UAV barrier is only recorded between two commands that access the same resource as a UAV.
+// - BeginTransition starts a split barrier that the next Require of the resource ends,
+//   so the transition overlaps with the commands in between.
+// The state of a resource before its first access is unknown while recording. Resolve produces the barriers
+// from the states in the table to the first states, to be executed right before the command list.
+typedef struct ComputeStateTracker
+{
+    ComputeTrackedResource *resources;
+    uint32_t capacity;
+    uint32_t numResources;
+    // The barriers recorded by the next flush
+    ComputeResourceBarrier *pendingBarriers;
+    uint32_t numPendingBarriers;
+    uint32_t pendingCapacity;
+    // The barriers returned by Resolve
+    ComputeResourceBarrier *resolvedBarriers;
+    uint32_t resolvedCapacity;
+    // The number of commands flushed so far
+    uint32_t commandIndex;
+} ComputeStateTracker;
+
+extern bool ComputeStateTrackerInit(ComputeStateTracker *tracker);
+extern void ComputeStateTrackerDestroy(ComputeStateTracker *tracker);
+
+// Forget the states, when a command list begins recording
+extern void ComputeStateTrackerReset(ComputeStateTracker *tracker);
+
+// Declare that the next command accesses the resource in the state
+extern void ComputeStateTrackerRequire(ComputeStateTracker *tracker, ComputeResource *resource, ComputeResourceStates state);
+
+// Declare that a later command accesses the resource in the state, and no command before it accesses the resource
+extern void ComputeStateTrackerBeginTransition(ComputeStateTracker *tracker, ComputeResource *resource, ComputeResourceStates state);
+
+// Record the pending barriers. Called once right before each command whose accesses have been declared.
+extern void ComputeStateTrackerFlush(ComputeStateTracker *tracker, ComputeCommandList *commandList);
+
+// End the split barriers still open and record the pending barriers, before the command list is closed
+extern void ComputeStateTrackerFinish(ComputeStateTracker *tracker, ComputeCommandList *commandList);
+
+// Get the barriers from the states of the table to the first states of the command list,
+// and store the final states of the command list in the table. The resources missing from the table are ignored.
+// Called at submit, in the order of the submissions. Returns the number of barriers.
+extern uint32_t ComputeStateTrackerResolve(ComputeStateTracker *tracker, ComputeResourceStateTable *table,
+    const ComputeResourceBarrier **ppBarriers);
+
+#endif // RESOURCE_STATES_H
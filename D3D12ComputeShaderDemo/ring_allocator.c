@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_allocator.h"
+
+void ComputeRingAllocatorInit(ComputeRingAllocator *ring, ComputeTimeline *timeline, uint64_t capacity, const char *name)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->timeline = timeline;
+    ring->name = name;
+    ring->capacity = capacity;
+}
+
+void ComputeRingAllocatorDestroy(ComputeRingAllocator *ring)
+{
+    if (ring->numRetirements > 0)
+    {
+        const uint32_t last = (ring->firstRetirement + ring->numRetirements - 1) % ring->retirementCapacity;
+        const uint64_t fenceValue = ring->retirements[last].fenceValue;
+        if (fenceValue <= ring->timeline->lastSignaledValue)
+            ComputeTimelineWait(ring->timeline, fenceValue, COMPUTE_WAIT_INFINITE);
+    }
+
+    free(ring->retirements);
+    memset(ring, 0, sizeof(*ring));
+}
+
+void ComputeRingAllocatorReclaim(ComputeRingAllocator *ring)
+{
+    if (ring->numRetirements == 0)
+        return;
+
+    const uint64_t completedValue = ComputeTimelineGetCompletedValue(ring->timeline);
+
+    while (ring->numRetirements > 0)
+    {
+        const ComputeRingRetirement *retirement = &ring->retirements[ring->firstRetirement];
+        if (retirement->fenceValue > completedValue)
+            break;
+
+        ring->tail = retirement->end;
+        ring->firstRetirement = (ring->firstRetirement + 1) % ring->retirementCapacity;
+        ring->numRetirements--;
+    }
+}
+
+// Record that the range up to end is owned by the next timeline value
+static bool RetireRingRange(ComputeRingAllocator *ring, uint64_t end)
+{
+    const uint64_t fenceValue = ring->timeline->lastSignaledValue + 1;
+
+    if (ring->numRetirements > 0)
+    {
+        const uint32_t last = (ring->firstRetirement + ring->numRetirements - 1) % ring->retirementCapacity;
+        if (ring->retirements[last].fenceValue == fenceValue)
+        {
+            ring->retirements[last].end = end;
+            return true;
+        }
+    }
+
+    if (ring->numRetirements == ring->retirementCapacity)
+    {
+        // Grow the FIFO and make it contiguous again.
+        const uint32_t newCapacity = ring->retirementCapacity == 0 ? 16 : ring->retirementCapacity * 2;
+        ComputeRingRetirement *retirements = malloc(newCapacity * sizeof(*retirements));
+        if (retirements == NULL)
+            return false;
+
+        for (uint32_t i = 0; i < ring->numRetirements; i++)
+            retirements[i] = ring->retirements[(ring->firstRetirement + i) % ring->retirementCapacity];
+
+        free(ring->retirements);
+        ring->retirements = retirements;
+        ring->retirementCapacity = newCapacity;
+        ring->firstRetirement = 0;
+    }
+
+    const uint32_t index = (ring->firstRetirement + ring->numRetirements) % ring->retirementCapacity;
+    ring->retirements[index].fenceValue = fenceValue;
+    ring->retirements[index].end = end;
+    ring->numRetirements++;
+
+    return true;
+}
+
+bool ComputeRingAllocatorAllocate(ComputeRingAllocator *ring, uint64_t size, uint64_t alignment,
+    uint32_t timeoutMs, uint64_t *pOffset)
+{
+    if (alignment == 0)
+        alignment = 1;
+
+    if (size == 0 || size + alignment - 1 > ring->capacity)
+    {
+        printf("Allocation of %llu does not fit in the %s!\n", (unsigned long long)size, ring->name);
+        return false;
+    }
+
+    ComputeRingAllocatorReclaim(ring);
+
+    for (;;)
+    {
+        // When nothing is in flight, restart from the beginning of the ring.
+        if (ring->numRetirements == 0)
+        {
+            ring->head = (ring->head + ring->capacity - 1) / ring->capacity * ring->capacity;
+            ring->tail = ring->head;
+        }
+
+        // Align the physical position, and skip the end of the ring if the allocation would straddle it.
+        uint64_t position = ring->head % ring->capacity;
+        uint64_t start = ring->head + (alignment - position % alignment) % alignment;
+        position = start % ring->capacity;
+        if (position != 0 && position + size > ring->capacity)
+            start += ring->capacity - position;
+
+        const uint64_t end = start + size;
+        if (end - ring->tail <= ring->capacity)
+        {
+            if (!RetireRingRange(ring, end))
+                return false;
+
+            ring->head = end;
+            *pOffset = start % ring->capacity;
+            return true;
+        }
+
+        // The ring is full. Wait for the oldest allocations to be consumed by the GPU.
+        // Allocations owned by a value that has not been signaled yet belong to the commands being recorded,
+        // waiting for them would never finish.
+        const uint64_t oldestValue = ring->retirements[ring->firstRetirement].fenceValue;
+        if (oldestValue > ring->timeline->lastSignaledValue)
+        {
+            printf("The %s is full of unsubmitted allocations!\n", ring->name);
+            return false;
+        }
+
+        if (!ComputeTimelineWait(ring->timeline, oldestValue, timeoutMs))
+            return false;
+
+        ComputeRingAllocatorReclaim(ring);
+    }
+}
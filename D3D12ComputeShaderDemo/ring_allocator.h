@@ -0,0 +1,52 @@
+#ifndef RING_ALLOCATOR_H
+#define RING_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_timeline.h"
+
+// An in-flight part of the ring, reclaimed once the queue has reached its fence value
+typedef struct ComputeRingRetirement
+{
+    uint64_t fenceValue;
+    uint64_t end;
+} ComputeRingRetirement;
+
+// Linear ring allocator of offsets into some GPU memory, such as a buffer or a descriptor heap.
+// Offsets grow monotonically; the physical position is the offset modulo the capacity.
+// Every allocation is owned by the next value signaled on the timeline,
+// so the command list that consumes it must be submitted before the timeline is signaled again.
+// The ring is meant to be used by a single recording thread.
+typedef struct ComputeRingAllocator
+{
+    ComputeTimeline *timeline;
+    // Used in the error messages
+    const char *name;
+    uint64_t capacity;
+    // The next offset to allocate from
+    uint64_t head;
+    // The oldest offset still in use by the GPU
+    uint64_t tail;
+    // FIFO of the retirements, in the order of the fence values
+    ComputeRingRetirement *retirements;
+    uint32_t retirementCapacity;
+    uint32_t firstRetirement;
+    uint32_t numRetirements;
+} ComputeRingAllocator;
+
+extern void ComputeRingAllocatorInit(ComputeRingAllocator *ring, ComputeTimeline *timeline, uint64_t capacity, const char *name);
+// Waits for all the allocations in flight
+extern void ComputeRingAllocatorDestroy(ComputeRingAllocator *ring);
+
+// Reclaim the space of all the allocations whose fence value has been reached. Never blocks.
+extern void ComputeRingAllocatorReclaim(ComputeRingAllocator *ring);
+
+// Allocate size units, never straddling the end of the ring. The alignment must divide the capacity.
+// When the ring is full, waits for the oldest allocations for at most timeoutMs.
+// Returns false on timeout, or when the request can never fit in the ring.
+extern bool ComputeRingAllocatorAllocate(ComputeRingAllocator *ring, uint64_t size, uint64_t alignment,
+    uint32_t timeoutMs, uint64_t *pOffset);
+
+#endif // RING_ALLOCATOR_H
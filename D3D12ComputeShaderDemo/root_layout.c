@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "root_layout.h"
+
+// The cost of the parameters in the root signature, in 32-bit values
+#define ROOT_TABLE_SIZE         1
+#define ROOT_DESCRIPTOR_SIZE    2
+
+typedef enum RegisterUse
+{
+    REGISTER_UNUSED,
+    REGISTER_ROOT_DESCRIPTOR,
+    REGISTER_TABLE
+} RegisterUse;
+
+// The registers of each kind used by the shader
+typedef struct RegisterUses
+{
+    uint32_t constantsSize[COMPUTE_MAX_SHADER_REGISTERS];
+    RegisterUse srv[COMPUTE_MAX_SHADER_REGISTERS];
+    RegisterUse uav[COMPUTE_MAX_SHADER_REGISTERS];
+} RegisterUses;
+
+static bool GetRegisterUses(const ComputeShaderReflection *reflection, ComputeRootLayoutFlags flags, RegisterUses *uses)
+{
+    memset(uses, 0, sizeof(*uses));
+
+    const bool rootDescriptors = (flags & COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS) != 0;
+    for (uint32_t i = 0; i < reflection->NumBoundResources; i++)
+    {
+        const ComputeShaderInputBinding *binding = &reflection->BoundResources[i];
+        if (binding->Space != 0 || binding->BindPoint >= COMPUTE_MAX_SHADER_REGISTERS)
+        {
+            printf("The register %u of space %u is out of the range of the root layouts!\n", binding->BindPoint, binding->Space);
+            return false;
+        }
+
+        const uint32_t reg = binding->BindPoint;
+        switch (binding->Type)
+        {
+        case COMPUTE_SHADER_INPUT_CBUFFER:
+            // A cbuffer without any variable still takes a root parameter.
+            uses->constantsSize[reg] = binding->Size > 0 ? (binding->Size + 3) / 4 : 1;
+            break;
+        case COMPUTE_SHADER_INPUT_TYPED_SRV:
+            uses->srv[reg] = REGISTER_TABLE;
+            break;
+        case COMPUTE_SHADER_INPUT_STRUCTURED_SRV:
+        case COMPUTE_SHADER_INPUT_RAW_SRV:
+            uses->srv[reg] = rootDescriptors ? REGISTER_ROOT_DESCRIPTOR : REGISTER_TABLE;
+            break;
+        case COMPUTE_SHADER_INPUT_TYPED_UAV:
+            uses->uav[reg] = REGISTER_TABLE;
+            break;
+        case COMPUTE_SHADER_INPUT_STRUCTURED_UAV:
+        case COMPUTE_SHADER_INPUT_RAW_UAV:
+            uses->uav[reg] = rootDescriptors ? REGISTER_ROOT_DESCRIPTOR : REGISTER_TABLE;
+            break;
+        default:
+            printf("The resource of the register %u cannot be bound by the root layouts!\n", reg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Add the root parameters of the registers of one kind bound as root descriptors.
+// Returns the number of table descriptors: up to the highest register bound through the table.
+static uint32_t AddRootDescriptors(const RegisterUse uses[COMPUTE_MAX_SHADER_REGISTERS], ComputeRootParameterType type,
+    ComputeRootParameter *parameters, uint32_t *numParameters, uint32_t rootParameters[COMPUTE_MAX_SHADER_REGISTERS])
+{
+    uint32_t numTableDescriptors = 0;
+    for (uint32_t reg = 0; reg < COMPUTE_MAX_SHADER_REGISTERS; reg++)
+    {
+        rootParameters[reg] = COMPUTE_ROOT_LAYOUT_UNUSED;
+        if (uses[reg] == REGISTER_TABLE)
+            numTableDescriptors = reg + 1;
+        if (uses[reg] != REGISTER_ROOT_DESCRIPTOR)
+            continue;
+
+        rootParameters[reg] = *numParameters;
+        parameters[(*numParameters)++] = (ComputeRootParameter){ type, .Descriptor = { reg } };
+    }
+    return numTableDescriptors;
+}
+
+bool ComputeRootLayoutCreate(ComputeRootLayout *layout, ComputeDevice *device, const ComputeShaderReflection *reflection,
+    ComputeRootLayoutFlags flags)
+{
+    memset(layout, 0, sizeof(*layout));
+
+    RegisterUses uses;
+    if (!GetRegisterUses(reflection, flags, &uses))
+        return false;
+
+    // At most one parameter per register, and the two tables
+    ComputeRootParameter parameters[3 * COMPUTE_MAX_SHADER_REGISTERS + 2];
+    uint32_t numParameters = 0;
+    uint32_t size = 0, numConstants = 0;
+
+    for (uint32_t reg = 0; reg < COMPUTE_MAX_SHADER_REGISTERS; reg++)
+    {
+        layout->constantsParameters[reg] = COMPUTE_ROOT_LAYOUT_UNUSED;
+        if (uses.constantsSize[reg] == 0)
+            continue;
+
+        layout->constantsParameters[reg] = numParameters;
+        layout->numConstants[reg] = uses.constantsSize[reg];
+        parameters[numParameters++] = (ComputeRootParameter){
+            COMPUTE_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, .Constants = { reg, uses.constantsSize[reg] }
+        };
+        numConstants += uses.constantsSize[reg];
+    }
+    size += numConstants;
+
+    const uint32_t firstRootDescriptor = numParameters;
+    layout->numSrvTableDescriptors = AddRootDescriptors(uses.srv, COMPUTE_ROOT_PARAMETER_TYPE_SRV, parameters, &numParameters,
+        layout->srvParameters);
+    layout->numUavTableDescriptors = AddRootDescriptors(uses.uav, COMPUTE_ROOT_PARAMETER_TYPE_UAV, parameters, &numParameters,
+        layout->uavParameters);
+    size += (numParameters - firstRootDescriptor) * ROOT_DESCRIPTOR_SIZE;
+
+    // The tables start at register 0, the registers the shader does not use leaving unused descriptors.
+    const ComputeDescriptorRange ranges[2] = {
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_SRV, layout->numSrvTableDescriptors, 0 },
+        { COMPUTE_DESCRIPTOR_RANGE_TYPE_UAV, layout->numUavTableDescriptors, 0 }
+    };
+    layout->srvTableParameter = COMPUTE_ROOT_LAYOUT_UNUSED;
+    layout->uavTableParameter = COMPUTE_ROOT_LAYOUT_UNUSED;
+    if (layout->numSrvTableDescriptors > 0)
+    {
+        layout->srvTableParameter = numParameters;
+        parameters[numParameters++] = (ComputeRootParameter){
+            COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[0] }
+        };
+        size += ROOT_TABLE_SIZE;
+    }
+    if (layout->numUavTableDescriptors > 0)
+    {
+        layout->uavTableParameter = numParameters;
+        parameters[numParameters++] = (ComputeRootParameter){
+            COMPUTE_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, .DescriptorTable = { 1, &ranges[1] }
+        };
+        size += ROOT_TABLE_SIZE;
+    }
+
+    if (numParameters > COMPUTE_MAX_ROOT_PARAMETERS || size > COMPUTE_MAX_ROOT_SIGNATURE_SIZE ||
+        numConstants > COMPUTE_MAX_ROOT_CONSTANTS)
+    {
+        printf("The bindings of the shader take %u root parameters and %u 32-bit values, more than a root signature holds!\n",
+            numParameters, size);
+        return false;
+    }
+
+    const ComputeRootSignatureDesc rootSignatureDesc = { numParameters, parameters };
+    layout->rootSignature = device->lpVtbl->CreateRootSignature(device, &rootSignatureDesc);
+    if (layout->rootSignature == NULL)
+    {
+        puts("Failed to create the root signature of the root layout!");
+        return false;
+    }
+
+    layout->numParameters = numParameters;
+    return true;
+}
+
+bool ComputeRootLayoutCreateFromShader(ComputeRootLayout *layout, ComputeShaderCache *shaderCache, const char *fileName,
+    const ComputeShaderMacro *defines, const char *entryPoint, const char *target, uint32_t compileFlags, ComputeRootLayoutFlags flags)
+{
+    memset(layout, 0, sizeof(*layout));
+
+    ComputeBlob *shader;
+    if (!ComputeShaderCacheCompile(shaderCache, fileName, defines, entryPoint, target, compileFlags, &shader))
+        return false;
+
+    ComputeDevice *device = shaderCache->device;
+    const ComputeShaderBytecode bytecode = { shader->lpVtbl->GetBufferPointer(shader), shader->lpVtbl->GetBufferSize(shader) };
+    ComputeShaderReflection reflection;
+    const bool reflected = device->lpVtbl->ReflectShader(device, &bytecode, &reflection);
+    shader->lpVtbl->Release(shader);
+
+    return reflected && ComputeRootLayoutCreate(layout, device, &reflection, flags);
+}
+
+void ComputeRootLayoutDestroy(ComputeRootLayout *layout)
+{
+    if (layout->rootSignature != NULL)
+        layout->rootSignature->lpVtbl->Release(layout->rootSignature);
+    memset(layout, 0, sizeof(*layout));
+}
+
+bool ComputeRootLayoutSetSRV(const ComputeRootLayout *layout, ComputeCommandList *commandList, uint32_t shaderRegister,
+    ComputeResource *buffer, uint64_t offset)
+{
+    if (shaderRegister >= COMPUTE_MAX_SHADER_REGISTERS || layout->srvParameters[shaderRegister] == COMPUTE_ROOT_LAYOUT_UNUSED ||
+        offset % 4 != 0)
+    {
+        printf("The register t%u is not bound as a root descriptor, or the offset is not a multiple of 4!\n", shaderRegister);
+        return false;
+    }
+
+    commandList->lpVtbl->SetComputeRootShaderResourceView(commandList, layout->srvParameters[shaderRegister],
+        buffer->lpVtbl->GetGPUVirtualAddress(buffer) + offset);
+    return true;
+}
+
+bool ComputeRootLayoutSetUAV(const ComputeRootLayout *layout, ComputeCommandList *commandList, uint32_t shaderRegister,
+    ComputeResource *buffer, uint64_t offset)
+{
+    if (shaderRegister >= COMPUTE_MAX_SHADER_REGISTERS || layout->uavParameters[shaderRegister] == COMPUTE_ROOT_LAYOUT_UNUSED ||
+        offset % 4 != 0)
+    {
+        printf("The register u%u is not bound as a root descriptor, or the offset is not a multiple of 4!\n", shaderRegister);
+        return false;
+    }
+
+    commandList->lpVtbl->SetComputeRootUnorderedAccessView(commandList, layout->uavParameters[shaderRegister],
+        buffer->lpVtbl->GetGPUVirtualAddress(buffer) + offset);
+    return true;
+}
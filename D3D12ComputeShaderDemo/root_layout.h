@@ -0,0 +1,63 @@
+#ifndef ROOT_LAYOUT_H
+#define ROOT_LAYOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "shader_cache.h"
+
+// The root parameter of a register the shader does not use
+#define COMPUTE_ROOT_LAYOUT_UNUSED  0xffffffffU
+
+typedef enum ComputeRootLayoutFlags
+{
+    COMPUTE_ROOT_LAYOUT_FLAG_NONE = 0,
+    // Bind the structured and raw buffers as root SRVs and UAVs instead of through the descriptor tables
+    COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS = 0x1
+} ComputeRootLayoutFlags;
+
+// A root signature generated from the registers the shader uses, instead of being written by hand for it:
+// - each cbuffer becomes 32-bit root constants, set for each Dispatch without any buffer to update,
+// - with COMPUTE_ROOT_LAYOUT_FLAG_ROOT_DESCRIPTORS, each structured and raw buffer becomes a root descriptor,
+//   bound by its address without a view, so the hot buffers skip the descriptor heap entirely,
+// - the other buffers go to one table of SRVs and one of UAVs, where the view of t#n or u#n is the n-th descriptor.
+// The parameters are ordered from the most often changed: the constants, the root descriptors, and then the tables.
+typedef struct ComputeRootLayout
+{
+    ComputeRootSignature *rootSignature;
+    uint32_t numParameters;
+    // The root parameter and the number of 32-bit values of the constants of each b# register
+    uint32_t constantsParameters[COMPUTE_MAX_SHADER_REGISTERS];
+    uint32_t numConstants[COMPUTE_MAX_SHADER_REGISTERS];
+    // The root parameter of each t# and u# register bound as a root descriptor
+    uint32_t srvParameters[COMPUTE_MAX_SHADER_REGISTERS];
+    uint32_t uavParameters[COMPUTE_MAX_SHADER_REGISTERS];
+    // The root parameter and the number of descriptors of the tables
+    uint32_t srvTableParameter;
+    uint32_t numSrvTableDescriptors;
+    uint32_t uavTableParameter;
+    uint32_t numUavTableDescriptors;
+} ComputeRootLayout;
+
+// Generate the layout of the bindings of the reflection. Fails if a binding cannot be part of a root signature,
+// such as a texture, a register space other than 0 or cbuffers past the size of the root signature.
+extern bool ComputeRootLayoutCreate(ComputeRootLayout *layout, ComputeDevice *device, const ComputeShaderReflection *reflection,
+    ComputeRootLayoutFlags flags);
+
+// Compile the shader through the cache to reflect its bindings. The variants of a kernel bind the same registers,
+// so the layout of one of them serves all of them.
+extern bool ComputeRootLayoutCreateFromShader(ComputeRootLayout *layout, ComputeShaderCache *shaderCache, const char *fileName,
+    const ComputeShaderMacro *defines, const char *entryPoint, const char *target, uint32_t compileFlags, ComputeRootLayoutFlags flags);
+
+extern void ComputeRootLayoutDestroy(ComputeRootLayout *layout);
+
+// Bind the buffer from offset, a multiple of 4 bytes, to the root descriptor of a t# or u# register.
+// Returns false if the register is not bound as a root descriptor.
+extern bool ComputeRootLayoutSetSRV(const ComputeRootLayout *layout, ComputeCommandList *commandList, uint32_t shaderRegister,
+    ComputeResource *buffer, uint64_t offset);
+extern bool ComputeRootLayoutSetUAV(const ComputeRootLayout *layout, ComputeCommandList *commandList, uint32_t shaderRegister,
+    ComputeResource *buffer, uint64_t offset);
+
+#endif // ROOT_LAYOUT_H
@@ -0,0 +1,301 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shader_cache.h"
+
+#define SHADER_CACHE_FILE_MAGIC     0x43485343U     // 'CSHC'
+#define SHADER_CACHE_FILE_VERSION   1
+
+// The header of every cache file
+typedef struct ShaderCacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t size;
+} ShaderCacheFileHeader;
+
+// ---- Blob holding the data loaded from the cache ----
+
+typedef struct ShaderCacheBlob
+{
+    const ComputeBlobVtbl *lpVtbl;
+    size_t size;
+    uint8_t data[];
+} ShaderCacheBlob;
+
+static void ShaderCacheBlob_Release(ComputeBlob *This)
+{
+    free(This);
+}
+
+static void* ShaderCacheBlob_GetBufferPointer(ComputeBlob *This)
+{
+    return ((ShaderCacheBlob*)This)->data;
+}
+
+static size_t ShaderCacheBlob_GetBufferSize(ComputeBlob *This)
+{
+    return ((ShaderCacheBlob*)This)->size;
+}
+
+static const ComputeBlobVtbl s_shaderCacheBlobVtbl = {
+    ShaderCacheBlob_Release, ShaderCacheBlob_GetBufferPointer, ShaderCacheBlob_GetBufferSize
+};
+
+// ---- Hashing ----
+
+#define FNV_OFFSET_BASIS    0xcbf29ce484222325ULL
+#define FNV_PRIME           0x100000001b3ULL
+
+static uint64_t HashBytes(uint64_t hash, const void *pData, size_t size)
+{
+    const uint8_t *bytes = pData;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Strings are hashed with their terminator so that adjacent strings cannot run into each other.
+static uint64_t HashString(uint64_t hash, const char *str)
+{
+    return str != NULL ? HashBytes(hash, str, strlen(str) + 1) : HashBytes(hash, "", 1);
+}
+
+// ---- Files ----
+
+static bool ReadWholeFile(const char *path, void **ppData, size_t *pSize)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return false;
+
+    bool result = false;
+    uint8_t *data = NULL;
+
+    do
+    {
+        if (fseek(fp, 0, SEEK_END) != 0)
+            break;
+        const long size = ftell(fp);
+        if (size < 0 || fseek(fp, 0, SEEK_SET) != 0)
+            break;
+
+        data = malloc(size > 0 ? (size_t)size : 1);
+        if (data == NULL || fread(data, 1, (size_t)size, fp) != (size_t)size)
+            break;
+
+        *ppData = data;
+        *pSize = (size_t)size;
+        result = true;
+
+    } while (false);
+
+    fclose(fp);
+    if (!result)
+        free(data);
+
+    return result;
+}
+
+static void MakeCachePath(const ComputeShaderCache *cache, uint64_t key, const char *extension, char *path, size_t pathSize)
+{
+    snprintf(path, pathSize, "%s/%016llx.%s", cache->directory, (unsigned long long)key, extension);
+}
+
+static ComputeBlob* LoadCacheEntry(const ComputeShaderCache *cache, uint64_t key, const char *extension)
+{
+    char path[COMPUTE_SHADER_CACHE_MAX_PATH + 32];
+    MakeCachePath(cache, key, extension, path, sizeof(path));
+
+    void *pData;
+    size_t size;
+    if (!ReadWholeFile(path, &pData, &size))
+        return NULL;
+
+    ShaderCacheBlob *blob = NULL;
+    const ShaderCacheFileHeader *header = pData;
+
+    // A truncated or foreign file is a miss.
+    if (size >= sizeof(*header) && header->magic == SHADER_CACHE_FILE_MAGIC && header->version == SHADER_CACHE_FILE_VERSION &&
+        header->key == key && header->size == size - sizeof(*header))
+    {
+        blob = malloc(sizeof(*blob) + (size_t)header->size);
+        if (blob != NULL)
+        {
+            blob->lpVtbl = &s_shaderCacheBlobVtbl;
+            blob->size = (size_t)header->size;
+            memcpy(blob->data, header + 1, blob->size);
+        }
+    }
+
+    free(pData);
+    return (ComputeBlob*)blob;
+}
+
+// Write to a temporary file first and rename it, so that concurrent processes never see a partial entry.
+static void StoreCacheEntry(const ComputeShaderCache *cache, uint64_t key, const char *extension, const void *pData, size_t size)
+{
+    char path[COMPUTE_SHADER_CACHE_MAX_PATH + 32];
+    MakeCachePath(cache, key, extension, path, sizeof(path));
+
+    char tempPath[COMPUTE_SHADER_CACHE_MAX_PATH + 64];
+#ifdef _WIN32
+    snprintf(tempPath, sizeof(tempPath), "%s.%lu.tmp", path, (unsigned long)GetCurrentProcessId());
+#else
+    snprintf(tempPath, sizeof(tempPath), "%s.%ld.tmp", path, (long)getpid());
+#endif
+
+    FILE *fp = fopen(tempPath, "wb");
+    if (fp == NULL)
+        return;
+
+    const ShaderCacheFileHeader header = { SHADER_CACHE_FILE_MAGIC, SHADER_CACHE_FILE_VERSION, key, size };
+    const bool written = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(pData, 1, size, fp) == size;
+    if (fclose(fp) != 0 || !written)
+    {
+        remove(tempPath);
+        return;
+    }
+
+#ifdef _WIN32
+    if (!MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING))
+        remove(tempPath);
+#else
+    if (rename(tempPath, path) != 0)
+        remove(tempPath);
+#endif
+}
+
+// ---- Cache ----
+
+static bool CompileWithDevice(void *context, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode)
+{
+    ComputeDevice *device = context;
+    return device->lpVtbl->CompileShaderFromFile(device, pFileName, pDefines, pEntryPoint, pTarget, Flags, ppCode);
+}
+
+bool ComputeShaderCacheInit(ComputeShaderCache *cache, ComputeDevice *device, const char *directory,
+    ComputeShaderCompileFunc compileFunc, void *compileContext)
+{
+    memset(cache, 0, sizeof(*cache));
+
+    if (strlen(directory) >= sizeof(cache->directory))
+    {
+        puts("The shader cache path is too long!");
+        return false;
+    }
+    strcpy(cache->directory, directory);
+
+    cache->device = device;
+    cache->compileFunc = compileFunc != NULL ? compileFunc : CompileWithDevice;
+    cache->compileContext = compileFunc != NULL ? compileContext : device;
+
+    // The directory may exist already. If it cannot be created, every lookup is simply a miss.
+#ifdef _WIN32
+    CreateDirectoryA(directory, NULL);
+#else
+    mkdir(directory, 0755);
+#endif
+
+    return true;
+}
+
+bool ComputeShaderCacheCompile(ComputeShaderCache *cache, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode)
+{
+    void *pSource;
+    size_t sourceSize;
+    if (!ReadWholeFile(pFileName, &pSource, &sourceSize))
+    {
+        // Without the source there is nothing to key on, the compiler reports the error.
+        return cache->compileFunc(cache->compileContext, pFileName, pDefines, pEntryPoint, pTarget, Flags, ppCode);
+    }
+
+    const uint32_t backendType = cache->device->lpVtbl->GetBackendType(cache->device);
+    uint64_t key = HashBytes(FNV_OFFSET_BASIS, &backendType, sizeof(backendType));
+    key = HashBytes(key, pSource, sourceSize);
+    key = HashString(key, pEntryPoint);
+    key = HashString(key, pTarget);
+    key = HashBytes(key, &Flags, sizeof(Flags));
+    for (const ComputeShaderMacro *macro = pDefines; macro != NULL && macro->Name != NULL; macro++)
+    {
+        key = HashString(key, macro->Name);
+        key = HashString(key, macro->Definition);
+    }
+    free(pSource);
+
+    *ppCode = LoadCacheEntry(cache, key, "cso");
+    if (*ppCode != NULL)
+    {
+        cache->numHits++;
+        return true;
+    }
+
+    cache->numMisses++;
+    if (!cache->compileFunc(cache->compileContext, pFileName, pDefines, pEntryPoint, pTarget, Flags, ppCode))
+        return false;
+
+    StoreCacheEntry(cache, key, "cso", (*ppCode)->lpVtbl->GetBufferPointer(*ppCode), (*ppCode)->lpVtbl->GetBufferSize(*ppCode));
+    return true;
+}
+
+ComputePipelineState* ComputeShaderCacheCreatePipelineState(ComputeShaderCache *cache, const ComputePipelineStateDesc *pDesc)
+{
+    ComputeDevice *device = cache->device;
+
+    const uint32_t backendType = device->lpVtbl->GetBackendType(device);
+    uint64_t key = HashBytes(FNV_OFFSET_BASIS, &backendType, sizeof(backendType));
+    key = HashBytes(key, pDesc->CS.pShaderBytecode, pDesc->CS.BytecodeLength);
+    // The same bytecode may be bound through different root signatures, and each gets a pipeline of its own.
+    const uint64_t rootSignatureHash = pDesc->pRootSignature->lpVtbl->GetHash(pDesc->pRootSignature);
+    key = HashBytes(key, &rootSignatureHash, sizeof(rootSignatureHash));
+
+    ComputePipelineStateDesc psoDesc = *pDesc;
+    psoDesc.CachedPSO = (ComputeCachedPipelineState){ NULL, 0 };
+
+    ComputeBlob *cachedBlob = LoadCacheEntry(cache, key, "pso");
+    if (cachedBlob != NULL)
+    {
+        psoDesc.CachedPSO.pCachedBlob = cachedBlob->lpVtbl->GetBufferPointer(cachedBlob);
+        psoDesc.CachedPSO.CachedBlobSizeInBytes = cachedBlob->lpVtbl->GetBufferSize(cachedBlob);
+
+        ComputePipelineState *pipelineState = device->lpVtbl->CreateComputePipelineState(device, &psoDesc);
+        cachedBlob->lpVtbl->Release(cachedBlob);
+        if (pipelineState != NULL)
+        {
+            cache->numHits++;
+            return pipelineState;
+        }
+
+        // The blob is stale, e.g. after a driver update. Fall back to a full creation and replace it.
+        psoDesc.CachedPSO = (ComputeCachedPipelineState){ NULL, 0 };
+    }
+
+    cache->numMisses++;
+    ComputePipelineState *pipelineState = device->lpVtbl->CreateComputePipelineState(device, &psoDesc);
+    if (pipelineState == NULL)
+        return NULL;
+
+    ComputeBlob *blob;
+    if (pipelineState->lpVtbl->GetCachedBlob(pipelineState, &blob))
+    {
+        StoreCacheEntry(cache, key, "pso", blob->lpVtbl->GetBufferPointer(blob), blob->lpVtbl->GetBufferSize(blob));
+        blob->lpVtbl->Release(blob);
+    }
+
+    return pipelineState;
+}
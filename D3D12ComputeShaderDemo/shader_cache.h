@@ -0,0 +1,43 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+
+// The maximum length of the cache directory path
+#define COMPUTE_SHADER_CACHE_MAX_PATH   260
+
+// Compiles an HLSL file into bytecode, with the same parameters as ComputeDevice::CompileShaderFromFile
+typedef bool (*ComputeShaderCompileFunc)(void *context, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode);
+
+// Content-addressed on-disk cache of shader bytecode and pipeline state blobs.
+// The bytecode is keyed on the backend, the source file content, the entry point, the target,
+// the macros and the flags. Files included by the source are not part of the key.
+// The pipeline state blobs are keyed on the backend, the bytecode and the root signature; a blob the driver rejects is replaced.
+typedef struct ComputeShaderCache
+{
+    char directory[COMPUTE_SHADER_CACHE_MAX_PATH];
+    ComputeDevice *device;
+    ComputeShaderCompileFunc compileFunc;
+    void *compileContext;
+    uint32_t numHits;
+    uint32_t numMisses;
+} ComputeShaderCache;
+
+// compileFunc may be NULL to compile with the device.
+extern bool ComputeShaderCacheInit(ComputeShaderCache *cache, ComputeDevice *device, const char *directory,
+    ComputeShaderCompileFunc compileFunc, void *compileContext);
+
+// Load the bytecode from the cache, or compile and store it on a miss
+extern bool ComputeShaderCacheCompile(ComputeShaderCache *cache, const char *pFileName, const ComputeShaderMacro *pDefines,
+    const char *pEntryPoint, const char *pTarget, uint32_t Flags, ComputeBlob **ppCode);
+
+// Create the pipeline state from its cached blob if there is a valid one,
+// otherwise create it from scratch and store its blob. pDesc->CachedPSO is ignored.
+extern ComputePipelineState* ComputeShaderCacheCreatePipelineState(ComputeShaderCache *cache, const ComputePipelineStateDesc *pDesc);
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "stream_pipeline.h"
+#include "mapped_file.h"
+#include "upload_ring.h"
+#include "readback_pool.h"
+#include "host_copy.h"
+#include "compute_trace.h"
+
+// The device buffers and the readback buffer of one chunk in flight
+typedef struct StreamSlot
+{
+    ComputeResource *inputBuffer;
+    ComputeResource *outputBuffer;
+    ComputeReadbackBuffer *readbackBuffer;
+    // The chunk whose results are pending in the readback buffer
+    bool pending;
+    uint64_t chunkIndex;
+    uint64_t numElements;
+    // The copy timeline value of the upload, the compute timeline value of the dispatch,
+    // and the copy timeline value of the readback, 0 until the readback is submitted
+    uint64_t uploadValue;
+    uint64_t computeValue;
+    uint64_t readbackValue;
+} StreamSlot;
+
+typedef struct StreamContext
+{
+    ComputeDevice *device;
+    ComputeTimeline *copyTimeline;
+    ComputeTimeline *computeTimeline;
+    const ComputeStreamDesc *desc;
+    uint64_t chunkSize;
+    ComputeMappedFile input;
+    ComputeMappedFile output;
+    ComputeUploadRing uploadRing;
+    ComputeReadbackPool readbackPool;
+    // The upload and readback submissions on the copy queue, the dispatches on the compute queue
+    ComputeFrameRing copyFrames;
+    ComputeFrameRing computeFrames;
+    ComputeDescriptorAllocator *descriptors;
+    ComputeDescriptorAllocation views;
+    StreamSlot slots[COMPUTE_STREAM_MAX_SLOTS];
+} StreamContext;
+
+static bool CreateStreamSlots(StreamContext *stream)
+{
+    ComputeDevice *device = stream->device;
+    const ComputeStreamDesc *desc = stream->desc;
+
+    // Two descriptors per slot, the SRV of the input followed by the UAV of the output
+    if (!ComputeDescriptorAllocatorAllocatePersistent(stream->descriptors, 2 * desc->NumSlots, &stream->views))
+        return false;
+
+    const ComputeResourceDesc inputDesc = { stream->chunkSize, COMPUTE_RESOURCE_FLAG_NONE };
+    const ComputeResourceDesc outputDesc = { stream->chunkSize, COMPUTE_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS };
+    const ComputeBufferViewDesc viewDesc = {
+        0, (uint32_t)desc->ChunkElements, desc->ElementSize, COMPUTE_FORMAT_UNKNOWN, COMPUTE_BUFFER_VIEW_FLAG_NONE
+    };
+
+    for (uint32_t i = 0; i < desc->NumSlots; i++)
+    {
+        StreamSlot *slot = &stream->slots[i];
+
+        // The buffers pass between the queues in the common state, which needs no barrier:
+        // buffers are promoted implicitly to the state of their first access in a command list,
+        // and decay back to the common state when the command list completes.
+        slot->inputBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &inputDesc,
+            COMPUTE_RESOURCE_STATE_COMMON);
+        slot->outputBuffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_DEFAULT, &outputDesc,
+            COMPUTE_RESOURCE_STATE_COMMON);
+        slot->readbackBuffer = ComputeReadbackPoolAcquire(&stream->readbackPool, stream->chunkSize);
+        if (slot->inputBuffer == NULL || slot->outputBuffer == NULL || slot->readbackBuffer == NULL)
+            return false;
+
+        device->lpVtbl->CreateShaderResourceView(device, slot->inputBuffer, &viewDesc,
+            ComputeDescriptorCPUHandle(stream->descriptors, &stream->views, 2 * i));
+        device->lpVtbl->CreateUnorderedAccessView(device, slot->outputBuffer, &viewDesc,
+            ComputeDescriptorCPUHandle(stream->descriptors, &stream->views, 2 * i + 1));
+    }
+
+    return true;
+}
+
+static void ReleaseStreamSlots(StreamContext *stream)
+{
+    for (uint32_t i = 0; i < COMPUTE_STREAM_MAX_SLOTS; i++)
+    {
+        StreamSlot *slot = &stream->slots[i];
+        if (slot->inputBuffer != NULL)
+            slot->inputBuffer->lpVtbl->Release(slot->inputBuffer);
+        if (slot->outputBuffer != NULL)
+            slot->outputBuffer->lpVtbl->Release(slot->outputBuffer);
+        if (slot->readbackBuffer != NULL)
+            ComputeReadbackPoolRelease(&stream->readbackPool, slot->readbackBuffer);
+    }
+
+    if (stream->views.count > 0)
+        ComputeDescriptorAllocatorFreePersistent(stream->descriptors, &stream->views);
+}
+
+static bool SubmitStreamReadback(StreamContext *stream, StreamSlot *slot);
+
+// Wait for the slot's chunk and write its results to the output file
+static bool DrainStreamSlot(StreamContext *stream, StreamSlot *slot)
+{
+    if (!slot->pending)
+        return true;
+    if (slot->readbackValue == 0 && !SubmitStreamReadback(stream, slot))
+        return false;
+    slot->pending = false;
+
+    const size_t resultSize = (size_t)(slot->numElements * stream->desc->ElementSize);
+    ComputeReadbackView view;
+    if (!ComputeReadbackPoolGetView(&stream->readbackPool, slot->readbackBuffer, slot->readbackValue,
+        resultSize, COMPUTE_WAIT_INFINITE, &view))
+        return false;
+
+    COMPUTE_TRACE_CPU_BEGIN(traceScope, "Write chunk");
+    const uint64_t offset = slot->chunkIndex * stream->chunkSize;
+    memcpy(stream->output.pData + offset, view.pData, view.size);
+    COMPUTE_TRACE_CPU_END(traceScope);
+
+    // Neither the input nor the output of the chunk is touched again.
+    ComputeMappedFileEvict(&stream->input, offset, resultSize);
+    ComputeMappedFileEvict(&stream->output, offset, resultSize);
+
+    return true;
+}
+
+// Copy the chunk from the upload ring to the slot's input buffer, on the copy queue
+static bool SubmitStreamUpload(StreamContext *stream, StreamSlot *slot, uint64_t chunkIndex)
+{
+    const ComputeStreamDesc *desc = stream->desc;
+    const uint64_t totalElements = stream->input.size / desc->ElementSize;
+    const uint64_t firstElement = chunkIndex * desc->ChunkElements;
+    const uint64_t numElements = totalElements - firstElement < desc->ChunkElements ?
+        totalElements - firstElement : desc->ChunkElements;
+    const uint64_t dataSize = numElements * desc->ElementSize;
+
+    ComputeCommandList *commandList = ComputeFrameRingBegin(&stream->copyFrames, NULL, COMPUTE_WAIT_INFINITE);
+    if (commandList == NULL)
+        return false;
+
+    // Stage the chunk straight from the mapped input file.
+    // The ring holds NumSlots chunks, so it only ever waits for chunks that have been submitted already.
+    ComputeUploadAllocation allocation;
+    if (!ComputeUploadRingAllocate(&stream->uploadRing, dataSize, COMPUTE_UPLOAD_ALIGNMENT, COMPUTE_WAIT_INFINITE, &allocation))
+    {
+        ComputeFrameRingSubmit(&stream->copyFrames);
+        return false;
+    }
+    COMPUTE_TRACE_CPU_BEGIN(traceScope, "Stage chunk");
+    ComputeHostCopy(allocation.pData, stream->input.pData + firstElement * desc->ElementSize, (size_t)dataSize);
+    COMPUTE_TRACE_CPU_END(traceScope);
+
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, stream->copyTimeline, commandList, "Upload chunk");
+    commandList->lpVtbl->CopyBufferRegion(commandList, slot->inputBuffer, 0, allocation.resource, allocation.offset, dataSize);
+    COMPUTE_TRACE_GPU_END(traceSpan, stream->copyTimeline, commandList);
+
+    const uint64_t fenceValue = ComputeFrameRingSubmit(&stream->copyFrames);
+    if (fenceValue == 0)
+        return false;
+
+    slot->pending = true;
+    slot->chunkIndex = chunkIndex;
+    slot->numElements = numElements;
+    slot->uploadValue = fenceValue;
+    slot->computeValue = 0;
+    slot->readbackValue = 0;
+
+    return true;
+}
+
+// Record the dispatch of the slot's chunk on the compute queue, once its upload has completed
+static bool SubmitStreamCompute(StreamContext *stream, StreamSlot *slot)
+{
+    const ComputeStreamDesc *desc = stream->desc;
+
+    ComputeCommandList *commandList = ComputeFrameRingBegin(&stream->computeFrames, NULL, COMPUTE_WAIT_INFINITE);
+    if (commandList == NULL)
+        return false;
+
+    const uint32_t slotIndex = (uint32_t)(slot - stream->slots);
+    const ComputeStreamChunk chunk = {
+        .index = slot->chunkIndex,
+        .numElements = slot->numElements,
+        .descriptorHeap = stream->descriptors->heap,
+        .srvHandle = ComputeDescriptorGPUHandle(stream->descriptors, &stream->views, 2 * slotIndex),
+        .uavHandle = ComputeDescriptorGPUHandle(stream->descriptors, &stream->views, 2 * slotIndex + 1),
+        .inputBuffer = slot->inputBuffer,
+        .outputBuffer = slot->outputBuffer
+    };
+
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, stream->computeTimeline, commandList, "Compute chunk");
+    const bool recorded = desc->RecordFunc(desc->pContext, commandList, &chunk);
+    COMPUTE_TRACE_GPU_END(traceSpan, stream->computeTimeline, commandList);
+    if (!recorded)
+    {
+        ComputeFrameRingSubmit(&stream->computeFrames);
+        return false;
+    }
+
+    if (!ComputeTimelineWaitOnQueue(stream->computeTimeline, stream->copyTimeline, slot->uploadValue))
+    {
+        ComputeFrameRingSubmit(&stream->computeFrames);
+        return false;
+    }
+
+    slot->computeValue = ComputeFrameRingSubmit(&stream->computeFrames);
+    return slot->computeValue != 0;
+}
+
+// Copy the slot's results to its readback buffer on the copy queue, once its dispatch has completed
+static bool SubmitStreamReadback(StreamContext *stream, StreamSlot *slot)
+{
+    ComputeCommandList *commandList = ComputeFrameRingBegin(&stream->copyFrames, NULL, COMPUTE_WAIT_INFINITE);
+    if (commandList == NULL)
+        return false;
+
+    const uint64_t dataSize = slot->numElements * stream->desc->ElementSize;
+    COMPUTE_TRACE_GPU_BEGIN(traceSpan, stream->copyTimeline, commandList, "Readback chunk");
+    commandList->lpVtbl->CopyBufferRegion(commandList, slot->readbackBuffer->resource, 0, slot->outputBuffer, 0, dataSize);
+    COMPUTE_TRACE_GPU_END(traceSpan, stream->copyTimeline, commandList);
+
+    if (!ComputeTimelineWaitOnQueue(stream->copyTimeline, stream->computeTimeline, slot->computeValue))
+    {
+        ComputeFrameRingSubmit(&stream->copyFrames);
+        return false;
+    }
+
+    slot->readbackValue = ComputeFrameRingSubmit(&stream->copyFrames);
+    return slot->readbackValue != 0;
+}
+
+bool ComputeStreamFile(ComputeDevice *device, ComputeTimeline *copyTimeline, ComputeTimeline *computeTimeline,
+    ComputeDescriptorAllocator *descriptors,
+    const ComputeStreamDesc *desc,
+    const char *inputPath, const char *outputPath)
+{
+    if (desc->ElementSize == 0 || desc->ChunkElements == 0 || desc->ChunkElements > UINT32_MAX ||
+        desc->NumSlots == 0 || desc->NumSlots > COMPUTE_STREAM_MAX_SLOTS || desc->RecordFunc == NULL)
+    {
+        puts("Invalid stream description!");
+        return false;
+    }
+
+    StreamContext stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.device = device;
+    stream.copyTimeline = copyTimeline;
+    stream.computeTimeline = computeTimeline;
+    stream.descriptors = descriptors;
+    stream.desc = desc;
+    stream.chunkSize = desc->ChunkElements * desc->ElementSize;
+
+    bool result = false;
+
+    do
+    {
+        if (!ComputeMappedFileOpenRead(&stream.input, inputPath))
+            break;
+
+        const uint64_t numChunks = (stream.input.size / desc->ElementSize + desc->ChunkElements - 1) / desc->ChunkElements;
+
+        if (!ComputeMappedFileCreate(&stream.output, outputPath, stream.input.size / desc->ElementSize * desc->ElementSize))
+            break;
+        // On a single queue, the copies have to be recorded on lists of the queue's type.
+        const ComputeCommandListType copyType = copyTimeline == computeTimeline ?
+            COMPUTE_COMMAND_LIST_TYPE_COMPUTE : COMPUTE_COMMAND_LIST_TYPE_COPY;
+
+        // Each chunk may need up to an alignment of padding in front of it.
+        if (!ComputeUploadRingInit(&stream.uploadRing, device, copyTimeline,
+            desc->NumSlots * (stream.chunkSize + COMPUTE_UPLOAD_ALIGNMENT)))
+            break;
+        if (!ComputeReadbackPoolInit(&stream.readbackPool, device, copyTimeline))
+            break;
+        if (!ComputeFrameRingInit(&stream.copyFrames, device, copyTimeline, 2 * desc->NumSlots, copyType))
+            break;
+        if (!ComputeFrameRingInit(&stream.computeFrames, device, computeTimeline, desc->NumSlots, COMPUTE_COMMAND_LIST_TYPE_COMPUTE))
+            break;
+        if (!CreateStreamSlots(&stream))
+        {
+            puts("Failed to create the stream buffers!");
+            break;
+        }
+
+        // The readback of a chunk is submitted after the upload of the next one, so the copy queue
+        // uploads chunk i + 1 and reads back chunk i - 1 while the compute queue processes chunk i.
+        uint64_t chunkIndex = 0;
+        for (; chunkIndex < numChunks; chunkIndex++)
+        {
+            // Before the slot is reused, its previous chunk has to be written out.
+            // Meanwhile the other slots keep the GPU busy.
+            StreamSlot *slot = &stream.slots[chunkIndex % desc->NumSlots];
+            if (!DrainStreamSlot(&stream, slot) || !SubmitStreamUpload(&stream, slot, chunkIndex) ||
+                !SubmitStreamCompute(&stream, slot))
+                break;
+
+            StreamSlot *previous = &stream.slots[(chunkIndex + desc->NumSlots - 1) % desc->NumSlots];
+            if (chunkIndex > 0 && previous != slot && !SubmitStreamReadback(&stream, previous))
+                break;
+        }
+
+        result = chunkIndex == numChunks;
+
+        // Write out the chunks still in flight, oldest first.
+        for (uint64_t i = 0; i < desc->NumSlots; i++)
+        {
+            if (!DrainStreamSlot(&stream, &stream.slots[(chunkIndex + i) % desc->NumSlots]))
+                result = false;
+        }
+
+    } while (false);
+
+    ComputeFrameRingDestroy(&stream.computeFrames);
+    ComputeFrameRingDestroy(&stream.copyFrames);
+    ReleaseStreamSlots(&stream);
+    ComputeReadbackPoolDestroy(&stream.readbackPool);
+    ComputeUploadRingDestroy(&stream.uploadRing);
+    ComputeMappedFileClose(&stream.output);
+    ComputeMappedFileClose(&stream.input);
+
+    return result;
+}
@@ -0,0 +1,58 @@
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+#include "descriptor_allocator.h"
+
+// The maximum number of chunks in flight
+#define COMPUTE_STREAM_MAX_SLOTS    3
+
+// One chunk handed to the record callback
+typedef struct ComputeStreamChunk
+{
+    uint64_t index;
+    // Number of valid elements in the chunk. The last chunk may be shorter than the others.
+    uint64_t numElements;
+    ComputeDescriptorHeap *descriptorHeap;
+    // The SRV of the chunk's input buffer and the UAV of its output buffer,
+    // both covering a whole chunk
+    ComputeGPUDescriptorHandle srvHandle;
+    ComputeGPUDescriptorHandle uavHandle;
+    // The same buffers, for the kernels that bind them as root descriptors
+    ComputeResource *inputBuffer;
+    ComputeResource *outputBuffer;
+} ComputeStreamChunk;
+
+// Records the dispatch of one chunk on a compute command list: root signature, descriptor tables or root descriptors, and Dispatch.
+// Both buffers start in the common state, and are promoted implicitly by their first access.
+typedef bool (*ComputeStreamRecordFunc)(void *context, ComputeCommandList *commandList, const ComputeStreamChunk *chunk);
+
+typedef struct ComputeStreamDesc
+{
+    // Size of one input element and one output element
+    uint32_t ElementSize;
+    // Number of elements processed per chunk
+    uint64_t ChunkElements;
+    // 2 for double buffering, 3 for triple buffering
+    uint32_t NumSlots;
+    ComputeStreamRecordFunc RecordFunc;
+    void *pContext;
+} ComputeStreamDesc;
+
+// Stream the input file through the compute pipeline chunk by chunk, writing the output file.
+// The uploads and the readbacks run on the queue of the copy timeline and the dispatches on the queue of the compute
+// timeline, ordered by GPU-side fence waits, so the transfers of the neighbouring chunks overlap with each dispatch.
+// Both timelines may be the same one, which then has to be on a compute queue.
+// The resident memory is bounded by NumSlots chunks no matter how large the files are.
+// The views of the chunks are persistent descriptors of the allocator, freed when the stream ends.
+extern bool ComputeStreamFile(ComputeDevice *device, ComputeTimeline *copyTimeline, ComputeTimeline *computeTimeline,
+    ComputeDescriptorAllocator *descriptors,
+    const ComputeStreamDesc *desc,
+    const char *inputPath, const char *outputPath);
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,197 @@
+#include "thread_pool.h"
+#include "compute_thread.h"
+
+#include <stdlib.h>
+
+// One parallel loop issued by ThreadPoolParallelFor. It lives on the stack of the issuing thread.
+typedef struct ParallelJob
+{
+    ThreadPoolTaskFunc func;
+    void *context;
+    size_t count;
+    size_t grain;
+    // The first item that has not been claimed yet
+    volatile int64_t nextIndex;
+    // The number of items that have not been processed yet
+    volatile int64_t remaining;
+    // The number of pool workers that currently reference this job (protected by the pool mutex)
+    uint32_t activeWorkers;
+    struct ParallelJob *next;
+} ParallelJob;
+
+struct ThreadPool
+{
+    ComputeMutex mutex;
+    ComputeCondition workAvailable;
+    ComputeCondition jobDone;
+    ParallelJob *jobs;
+    bool shutdown;
+    uint32_t numWorkers;
+    ComputeThread *workers;
+};
+
+// Claim and process chunks of the job until all the items are claimed
+static void RunJobChunks(ThreadPool *pool, ParallelJob *job)
+{
+    for (;;)
+    {
+        const int64_t begin = ComputeAtomicAdd64(&job->nextIndex, (int64_t)job->grain);
+        if (begin >= (int64_t)job->count)
+            break;
+
+        int64_t end = begin + (int64_t)job->grain;
+        if (end > (int64_t)job->count)
+            end = (int64_t)job->count;
+
+        job->func(job->context, (size_t)begin, (size_t)end);
+
+        if (ComputeAtomicAdd64(&job->remaining, begin - end) == end - begin)
+        {
+            // This was the last chunk, wake up the issuing thread.
+            ComputeMutexLock(&pool->mutex);
+            ComputeConditionBroadcast(&pool->jobDone);
+            ComputeMutexUnlock(&pool->mutex);
+        }
+    }
+}
+
+// Find a job that still has unclaimed items. Must be called with the pool mutex held.
+static ParallelJob* FindPendingJob(ThreadPool *pool)
+{
+    for (ParallelJob *job = pool->jobs; job != NULL; job = job->next)
+    {
+        if (ComputeAtomicLoad64(&job->nextIndex) < (int64_t)job->count)
+            return job;
+    }
+    return NULL;
+}
+
+static void WorkerThreadProc(void *context)
+{
+    ThreadPool *pool = context;
+
+    ComputeMutexLock(&pool->mutex);
+    for (;;)
+    {
+        ParallelJob *job = FindPendingJob(pool);
+        if (job == NULL)
+        {
+            if (pool->shutdown)
+                break;
+            ComputeConditionWait(&pool->workAvailable, &pool->mutex);
+            continue;
+        }
+
+        job->activeWorkers++;
+        ComputeMutexUnlock(&pool->mutex);
+
+        RunJobChunks(pool, job);
+
+        ComputeMutexLock(&pool->mutex);
+        job->activeWorkers--;
+        ComputeConditionBroadcast(&pool->jobDone);
+    }
+    ComputeMutexUnlock(&pool->mutex);
+}
+
+ThreadPool* CreateThreadPool(uint32_t numThreads)
+{
+    if (numThreads == 0)
+        numThreads = ComputeGetProcessorCount();
+
+    ThreadPool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+        return NULL;
+
+    ComputeMutexInit(&pool->mutex);
+    ComputeConditionInit(&pool->workAvailable);
+    ComputeConditionInit(&pool->jobDone);
+
+    // The calling thread of a parallel loop is one of the workers.
+    if (numThreads > 1)
+    {
+        pool->workers = calloc(numThreads - 1, sizeof(*pool->workers));
+        if (pool->workers == NULL)
+        {
+            ReleaseThreadPool(pool);
+            return NULL;
+        }
+
+        for (uint32_t i = 0; i < numThreads - 1; i++)
+        {
+            if (!ComputeThreadCreate(&pool->workers[i], WorkerThreadProc, pool))
+                break;
+            pool->numWorkers++;
+        }
+    }
+
+    return pool;
+}
+
+void ReleaseThreadPool(ThreadPool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    ComputeMutexLock(&pool->mutex);
+    pool->shutdown = true;
+    ComputeConditionBroadcast(&pool->workAvailable);
+    ComputeMutexUnlock(&pool->mutex);
+
+    for (uint32_t i = 0; i < pool->numWorkers; i++)
+        ComputeThreadJoin(pool->workers[i]);
+
+    free(pool->workers);
+    ComputeConditionDestroy(&pool->jobDone);
+    ComputeConditionDestroy(&pool->workAvailable);
+    ComputeMutexDestroy(&pool->mutex);
+    free(pool);
+}
+
+uint32_t ThreadPoolGetThreadCount(const ThreadPool *pool)
+{
+    return pool->numWorkers + 1;
+}
+
+void ThreadPoolParallelFor(ThreadPool *pool, size_t count, size_t grain, ThreadPoolTaskFunc func, void *context)
+{
+    if (count == 0)
+        return;
+
+    const uint32_t numThreads = pool != NULL ? pool->numWorkers + 1 : 1;
+    if (grain == 0)
+    {
+        // Several chunks per thread so that uneven chunks are balanced out
+        grain = count / ((size_t)numThreads * 4);
+        if (grain == 0)
+            grain = 1;
+    }
+
+    // Not worth waking up the workers
+    if (numThreads == 1 || count <= grain)
+    {
+        func(context, 0, count);
+        return;
+    }
+
+    ParallelJob job = { func, context, count, grain, 0, (int64_t)count, 0, NULL };
+
+    ComputeMutexLock(&pool->mutex);
+    job.next = pool->jobs;
+    pool->jobs = &job;
+    ComputeConditionBroadcast(&pool->workAvailable);
+    ComputeMutexUnlock(&pool->mutex);
+
+    RunJobChunks(pool, &job);
+
+    // Wait for the chunks claimed by the workers, then unlink the job.
+    ComputeMutexLock(&pool->mutex);
+    while (ComputeAtomicLoad64(&job.remaining) > 0 || job.activeWorkers > 0)
+        ComputeConditionWait(&pool->jobDone, &pool->mutex);
+
+    ParallelJob **link = &pool->jobs;
+    while (*link != &job)
+        link = &(*link)->next;
+    *link = job.next;
+    ComputeMutexUnlock(&pool->mutex);
+}
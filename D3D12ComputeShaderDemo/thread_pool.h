@@ -0,0 +1,26 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Processes the items in [begin, end)
+typedef void (*ThreadPoolTaskFunc)(void *context, size_t begin, size_t end);
+
+typedef struct ThreadPool ThreadPool;
+
+// Create a thread pool. numThreads includes the calling thread, 0 means one thread per logical processor.
+extern ThreadPool* CreateThreadPool(uint32_t numThreads);
+extern void ReleaseThreadPool(ThreadPool *pool);
+
+// Number of threads (including the caller) that take part in a parallel loop
+extern uint32_t ThreadPoolGetThreadCount(const ThreadPool *pool);
+
+// Split [0, count) into chunks of `grain` items and run them on the pool.
+// The calling thread also takes part in the work and the function returns after all the items are processed.
+// Several threads may issue parallel loops on the same pool at the same time.
+// Pass grain 0 to let the pool pick a chunk size.
+extern void ThreadPoolParallelFor(ThreadPool *pool, size_t count, size_t grain, ThreadPoolTaskFunc func, void *context);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "typed_buffer.h"
+#include "compute_utils.h"
+#include "host_copy.h"
+
+// The arrays of the SoA layout start at a multiple of this many bytes
+#define SOA_ARRAY_ALIGNMENT     16
+
+typedef struct ElementTypeInfo
+{
+    uint32_t size;
+    ComputeFormat format;
+} ElementTypeInfo;
+
+static const ElementTypeInfo s_elementTypes[COMPUTE_ELEMENT_TYPE_COUNT] = {
+    { 4, COMPUTE_FORMAT_R32_SINT },
+    { 4, COMPUTE_FORMAT_R32_UINT },
+    { 4, COMPUTE_FORMAT_R32_FLOAT },
+    { 2, COMPUTE_FORMAT_R16_FLOAT },
+    { 8, COMPUTE_FORMAT_R32G32_UINT },
+    { 8, COMPUTE_FORMAT_R32G32_UINT },
+    { 0, COMPUTE_FORMAT_UNKNOWN }
+};
+
+uint32_t ComputeElementTypeGetSize(ComputeElementType type)
+{
+    return (uint32_t)type < COMPUTE_ELEMENT_TYPE_COUNT ? s_elementTypes[type].size : 0;
+}
+
+ComputeFormat ComputeElementTypeGetFormat(ComputeElementType type)
+{
+    return (uint32_t)type < COMPUTE_ELEMENT_TYPE_COUNT ? s_elementTypes[type].format : COMPUTE_FORMAT_UNKNOWN;
+}
+
+bool ComputeTypedBufferCreate(ComputeTypedBuffer *buffer, ComputeResourceAllocator *allocator,
+    const ComputeTypedBufferDesc *desc, ComputeResourceStates initialState)
+{
+    memset(buffer, 0, sizeof(*buffer));
+
+    const uint32_t elementSize = desc->ElementType == COMPUTE_ELEMENT_TYPE_STRUCT ?
+        desc->StructSize : ComputeElementTypeGetSize(desc->ElementType);
+    const ComputeFormat format = ComputeElementTypeGetFormat(desc->ElementType);
+
+    bool valid = elementSize > 0;
+    switch (desc->ViewType)
+    {
+    case COMPUTE_BUFFER_VIEW_STRUCTURED:
+        valid = valid && elementSize % 4 == 0;
+        break;
+    case COMPUTE_BUFFER_VIEW_RAW:
+        break;
+    case COMPUTE_BUFFER_VIEW_TYPED:
+        valid = valid && format != COMPUTE_FORMAT_UNKNOWN;
+        break;
+    default:
+        valid = false;
+        break;
+    }
+    if (!valid)
+    {
+        puts("Invalid element type for the view type of the buffer!");
+        return false;
+    }
+
+    buffer->elementType = desc->ElementType;
+    buffer->elementSize = elementSize;
+    buffer->numElements = desc->NumElements;
+    buffer->viewType = desc->ViewType;
+    buffer->format = format;
+    // The raw views cover whole 32-bit words.
+    buffer->size = ((uint64_t)desc->NumElements * elementSize + 3) & ~(uint64_t)3;
+
+    const ComputeResourceDesc resourceDesc = { buffer->size > 0 ? buffer->size : 4, desc->Flags };
+    return ComputeResourceAllocatorCreateBuffer(allocator, COMPUTE_HEAP_TYPE_DEFAULT, &resourceDesc, initialState,
+        &buffer->allocation);
+}
+
+void ComputeTypedBufferDestroy(ComputeTypedBuffer *buffer, ComputeResourceAllocator *allocator)
+{
+    if (buffer->allocation.resource != NULL)
+        ComputeResourceAllocatorFree(allocator, &buffer->allocation);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+bool ComputeTypedBufferGetViewDesc(const ComputeTypedBuffer *buffer, uint32_t firstElement, uint32_t numElements,
+    ComputeBufferViewDesc *pDesc)
+{
+    if ((uint64_t)firstElement + numElements > buffer->numElements)
+        return false;
+
+    memset(pDesc, 0, sizeof(*pDesc));
+    switch (buffer->viewType)
+    {
+    case COMPUTE_BUFFER_VIEW_STRUCTURED:
+        pDesc->FirstElement = firstElement;
+        pDesc->NumElements = numElements;
+        pDesc->StructureByteStride = buffer->elementSize;
+        return true;
+    case COMPUTE_BUFFER_VIEW_TYPED:
+        pDesc->FirstElement = firstElement;
+        pDesc->NumElements = numElements;
+        pDesc->Format = buffer->format;
+        return true;
+    case COMPUTE_BUFFER_VIEW_RAW:
+    {
+        const uint64_t offset = (uint64_t)firstElement * buffer->elementSize;
+        const uint64_t size = (uint64_t)numElements * buffer->elementSize;
+        if (offset % 4 != 0)
+            return false;
+        pDesc->FirstElement = offset / 4;
+        pDesc->NumElements = (uint32_t)((size + 3) / 4);
+        pDesc->Format = COMPUTE_FORMAT_R32_TYPELESS;
+        pDesc->Flags = COMPUTE_BUFFER_VIEW_FLAG_RAW;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void ComputeTypedBufferCreateSRV(ComputeDevice *device, const ComputeTypedBuffer *buffer, ComputeCPUDescriptorHandle handle)
+{
+    ComputeBufferViewDesc viewDesc;
+    ComputeTypedBufferGetViewDesc(buffer, 0, buffer->numElements, &viewDesc);
+    device->lpVtbl->CreateShaderResourceView(device, buffer->allocation.resource, &viewDesc, handle);
+}
+
+void ComputeTypedBufferCreateUAV(ComputeDevice *device, const ComputeTypedBuffer *buffer, ComputeCPUDescriptorHandle handle)
+{
+    ComputeBufferViewDesc viewDesc;
+    ComputeTypedBufferGetViewDesc(buffer, 0, buffer->numElements, &viewDesc);
+    device->lpVtbl->CreateUnorderedAccessView(device, buffer->allocation.resource, &viewDesc, handle);
+}
+
+uint16_t ComputeFloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // NaN stays a quiet NaN, infinity and the overflows become infinity
+    if (exponent == 0xff)
+        return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+    const int32_t halfExponent = (int32_t)exponent - 127 + 15;
+    if (halfExponent >= 31)
+        return (uint16_t)(sign | 0x7c00);
+
+    // Denormals and underflows: shift the mantissa with its implicit bit into place
+    uint32_t shift = 13;
+    if (halfExponent <= 0)
+    {
+        if (halfExponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        shift = (uint32_t)(14 - halfExponent);
+    }
+
+    uint32_t half = (halfExponent > 0 ? (uint32_t)halfExponent << 10 : 0) | (mantissa >> shift);
+
+    // Round to the nearest even. A carry into the exponent gives the next power of two, or infinity.
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+        half++;
+
+    return (uint16_t)(sign | half);
+}
+
+float ComputeHalfToFloat(uint16_t value)
+{
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else
+    {
+        // Normalize the denormal
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+uint32_t ComputeStructLayoutGetFieldSize(const ComputeStructLayout *layout, uint32_t field)
+{
+    return ComputeElementTypeGetSize(layout->Fields[field].Type) * layout->Fields[field].Count;
+}
+
+static uint64_t GetGreatestCommonDivisor(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        const uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+uint64_t ComputeStructLayoutGetSoAOffsets(const ComputeStructLayout *layout, uint64_t numRecords,
+    uint64_t offsets[COMPUTE_STRUCT_MAX_FIELDS])
+{
+    if (layout->NumFields == 0 || layout->NumFields > COMPUTE_STRUCT_MAX_FIELDS)
+        return 0;
+
+    uint64_t size = 0;
+    for (uint32_t field = 0; field < layout->NumFields; field++)
+    {
+        const uint32_t fieldSize = ComputeStructLayoutGetFieldSize(layout, field);
+        if (fieldSize == 0 || (uint64_t)layout->Fields[field].Offset + fieldSize > layout->Size)
+            return 0;
+
+        // The least common multiple of the alignment and the field size
+        const uint64_t alignment = SOA_ARRAY_ALIGNMENT / GetGreatestCommonDivisor(SOA_ARRAY_ALIGNMENT, fieldSize) * fieldSize;
+        offsets[field] = (size + alignment - 1) / alignment * alignment;
+        size = offsets[field] + numRecords * fieldSize;
+    }
+
+    return size;
+}
+
+uint64_t ComputeUploadRecordsSoA(ComputeCommandList *commandList, ComputeResource *pDestinationResource, uint64_t dstOffset,
+    ComputeUploadRing *pUploadRing, const ComputeStructLayout *layout, const void *records, uint64_t numRecords)
+{
+    uint64_t offsets[COMPUTE_STRUCT_MAX_FIELDS];
+    const uint64_t size = ComputeStructLayoutGetSoAOffsets(layout, numRecords, offsets);
+    if (size == 0 || size > (size_t)-1)
+        return 0;
+
+    ComputeUploadAllocation allocation;
+    if (!ComputeUploadRingAllocate(pUploadRing, size, COMPUTE_UPLOAD_ALIGNMENT, COMPUTE_WAIT_INFINITE, &allocation))
+        return 0;
+
+    // The records are transposed as they are written to the upload memory, without an intermediate copy.
+    void *fieldArrays[COMPUTE_STRUCT_MAX_FIELDS];
+    for (uint32_t field = 0; field < layout->NumFields; field++)
+        fieldArrays[field] = (uint8_t*)allocation.pData + offsets[field];
+    ComputeHostAoSToSoA(fieldArrays, records, layout, (size_t)numRecords);
+
+    commandList->lpVtbl->CopyBufferRegion(commandList, pDestinationResource, dstOffset, allocation.resource, allocation.offset, size);
+    return size;
+}
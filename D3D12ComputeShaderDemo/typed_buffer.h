@@ -0,0 +1,125 @@
+#ifndef TYPED_BUFFER_H
+#define TYPED_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "resource_allocator.h"
+#include "upload_ring.h"
+
+// The element types of the buffers. The 32-bit ones are also the ELEM_TYPE of the kernel variants.
+typedef enum ComputeElementType
+{
+    COMPUTE_ELEMENT_TYPE_INT,
+    COMPUTE_ELEMENT_TYPE_UINT,
+    COMPUTE_ELEMENT_TYPE_FLOAT,
+    // IEEE half, stored as a uint16_t on the host
+    COMPUTE_ELEMENT_TYPE_HALF,
+    COMPUTE_ELEMENT_TYPE_INT64,
+    COMPUTE_ELEMENT_TYPE_UINT64,
+    // A user-defined struct, of the size given with the buffer
+    COMPUTE_ELEMENT_TYPE_STRUCT,
+    COMPUTE_ELEMENT_TYPE_COUNT
+} ComputeElementType;
+
+// How the kernels see a buffer
+typedef enum ComputeBufferViewType
+{
+    // StructuredBuffer<T>, with the element size as stride
+    COMPUTE_BUFFER_VIEW_STRUCTURED,
+    // ByteAddressBuffer, loaded and stored as 32-bit words at byte addresses
+    COMPUTE_BUFFER_VIEW_RAW,
+    // Buffer<T>, the elements being converted from and to their format on access
+    COMPUTE_BUFFER_VIEW_TYPED
+} ComputeBufferViewType;
+
+typedef struct ComputeTypedBufferDesc
+{
+    ComputeElementType ElementType;
+    // The size of a COMPUTE_ELEMENT_TYPE_STRUCT element, ignored for the other types
+    uint32_t StructSize;
+    uint32_t NumElements;
+    ComputeBufferViewType ViewType;
+    ComputeResourceFlags Flags;
+} ComputeTypedBufferDesc;
+
+// A buffer placed by the resource allocator, with the views of its element type
+typedef struct ComputeTypedBuffer
+{
+    ComputeResourceAllocation allocation;
+    ComputeElementType elementType;
+    uint32_t elementSize;
+    uint32_t numElements;
+    ComputeBufferViewType viewType;
+    // The format of the typed views
+    ComputeFormat format;
+    // The size of the buffer, rounded up to a 32-bit word
+    uint64_t size;
+} ComputeTypedBuffer;
+
+// The size of an element of the type, 0 for COMPUTE_ELEMENT_TYPE_STRUCT
+extern uint32_t ComputeElementTypeGetSize(ComputeElementType type);
+
+// The format of the typed views of the type. The 64-bit integers are viewed as R32G32_UINT pairs, low word first.
+// Returns COMPUTE_FORMAT_UNKNOWN if the type has no typed view.
+extern ComputeFormat ComputeElementTypeGetFormat(ComputeElementType type);
+
+// Create the buffer in the default heap. Returns false if the view type does not suit the element type:
+// - a structured view needs a multiple of 4 bytes, since a StructuredBuffer<half> has a 4-byte stride without 16-bit types,
+// - a typed view needs a format, so no struct.
+extern bool ComputeTypedBufferCreate(ComputeTypedBuffer *buffer, ComputeResourceAllocator *allocator,
+    const ComputeTypedBufferDesc *desc, ComputeResourceStates initialState);
+extern void ComputeTypedBufferDestroy(ComputeTypedBuffer *buffer, ComputeResourceAllocator *allocator);
+
+// The view of the elements [firstElement, firstElement + numElements).
+// The raw views start at a 32-bit word, so the range of a raw view has to start at a multiple of 4 bytes.
+extern bool ComputeTypedBufferGetViewDesc(const ComputeTypedBuffer *buffer, uint32_t firstElement, uint32_t numElements,
+    ComputeBufferViewDesc *pDesc);
+
+// Create the views of the whole buffer
+extern void ComputeTypedBufferCreateSRV(ComputeDevice *device, const ComputeTypedBuffer *buffer, ComputeCPUDescriptorHandle handle);
+extern void ComputeTypedBufferCreateUAV(ComputeDevice *device, const ComputeTypedBuffer *buffer, ComputeCPUDescriptorHandle handle);
+
+// IEEE half conversions, rounding to the nearest even like f32tof16
+extern uint16_t ComputeFloatToHalf(float value);
+extern float ComputeHalfToFloat(uint16_t value);
+
+// The maximum number of fields of a struct layout
+#define COMPUTE_STRUCT_MAX_FIELDS   16
+
+// A field of a struct: Count elements of the type (e.g. 3 floats for a float3) at the byte Offset of the record
+typedef struct ComputeStructField
+{
+    ComputeElementType Type;
+    uint32_t Count;
+    uint32_t Offset;
+} ComputeStructField;
+
+// The layout of the records of a user-defined struct, Size being the sizeof of the struct with its padding.
+// The records may be transposed from this array of structures (AoS) into one array per field (SoA),
+// so that the consecutive threads of a kernel that reads a field read consecutive addresses.
+typedef struct ComputeStructLayout
+{
+    uint32_t Size;
+    uint32_t NumFields;
+    ComputeStructField Fields[COMPUTE_STRUCT_MAX_FIELDS];
+} ComputeStructLayout;
+
+// The size of a field of the layout
+extern uint32_t ComputeStructLayoutGetFieldSize(const ComputeStructLayout *layout, uint32_t field);
+
+// The SoA layout of numRecords records in one buffer: the byte offset of the array of each field, and the size of the buffer.
+// Each array starts at a multiple of 16 bytes and of its field size, so it can be viewed as raw or structured.
+// Returns 0 if a field does not fit in the record.
+extern uint64_t ComputeStructLayoutGetSoAOffsets(const ComputeStructLayout *layout, uint64_t numRecords,
+    uint64_t offsets[COMPUTE_STRUCT_MAX_FIELDS]);
+
+// Transpose the records straight into a sub-allocation of the upload ring in the SoA layout,
+// and copy them to dstOffset in the destination buffer. The transposition runs on the host copy thread pool.
+// Returns the number of bytes staged in the ring, or 0 on failure.
+extern uint64_t ComputeUploadRecordsSoA(ComputeCommandList *commandList, ComputeResource *pDestinationResource, uint64_t dstOffset,
+    ComputeUploadRing *pUploadRing, const ComputeStructLayout *layout, const void *records, uint64_t numRecords);
+
+#endif // TYPED_BUFFER_H
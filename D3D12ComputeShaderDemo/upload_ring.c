@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "upload_ring.h"
+
+bool ComputeUploadRingInit(ComputeUploadRing *ring, ComputeDevice *device, ComputeTimeline *timeline, uint64_t capacity)
+{
+    memset(ring, 0, sizeof(*ring));
+    // Buffers occupy whole 64KB pages anyway, and a page-multiple capacity keeps
+    // the aligned offsets aligned after wrapping around.
+    capacity = (capacity + COMPUTE_UPLOAD_RING_PAGE_SIZE - 1) / COMPUTE_UPLOAD_RING_PAGE_SIZE * COMPUTE_UPLOAD_RING_PAGE_SIZE;
+    ComputeRingAllocatorInit(&ring->allocator, timeline, capacity, "upload ring");
+
+    // The upload heap stays in the generic read state for its whole lifetime.
+    const ComputeResourceDesc bufferDesc = { capacity, COMPUTE_RESOURCE_FLAG_NONE };
+    ring->buffer = device->lpVtbl->CreateCommittedResource(device, COMPUTE_HEAP_TYPE_UPLOAD, &bufferDesc,
+        COMPUTE_RESOURCE_STATE_GENERIC_READ);
+    if (ring->buffer == NULL)
+    {
+        puts("Failed to create the upload ring buffer!");
+        return false;
+    }
+
+    // Upload heaps may stay mapped while the GPU reads them, so map it once.
+    // The CPU never reads the upload memory, hence the empty read range.
+    const ComputeRange readRange = { 0, 0 };
+    if (!ring->buffer->lpVtbl->Map(ring->buffer, &readRange, (void**)&ring->pMappedData))
+    {
+        puts("Failed to map the upload ring buffer!");
+        ComputeUploadRingDestroy(ring);
+        return false;
+    }
+
+    return true;
+}
+
+void ComputeUploadRingDestroy(ComputeUploadRing *ring)
+{
+    ComputeRingAllocatorDestroy(&ring->allocator);
+
+    if (ring->buffer != NULL)
+    {
+        if (ring->pMappedData != NULL)
+            ring->buffer->lpVtbl->Unmap(ring->buffer, NULL);
+        ring->buffer->lpVtbl->Release(ring->buffer);
+    }
+
+    memset(ring, 0, sizeof(*ring));
+}
+
+void ComputeUploadRingReclaim(ComputeUploadRing *ring)
+{
+    ComputeRingAllocatorReclaim(&ring->allocator);
+}
+
+bool ComputeUploadRingAllocate(ComputeUploadRing *ring, uint64_t size, uint64_t alignment,
+    uint32_t timeoutMs, ComputeUploadAllocation *pAllocation)
+{
+    uint64_t offset;
+    if (!ComputeRingAllocatorAllocate(&ring->allocator, size, alignment, timeoutMs, &offset))
+        return false;
+
+    pAllocation->resource = ring->buffer;
+    pAllocation->offset = offset;
+    pAllocation->pData = ring->pMappedData + offset;
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "compute_backend.h"
+#include "compute_timeline.h"
+#include "ring_allocator.h"
+
+// The alignment used for the staged buffer data
+#define COMPUTE_UPLOAD_ALIGNMENT        16
+
+// The capacity of the ring is rounded up to this size. Allocation alignments must divide it.
+#define COMPUTE_UPLOAD_RING_PAGE_SIZE   65536
+
+// A sub-allocation in the upload ring
+typedef struct ComputeUploadAllocation
+{
+    // The upload buffer that holds the allocation, used as the copy source
+    ComputeResource *resource;
+    // Byte offset of the allocation in the upload buffer
+    uint64_t offset;
+    // CPU address of the allocation in the persistently mapped upload buffer
+    void *pData;
+} ComputeUploadAllocation;
+
+// Linear ring allocator over one persistently mapped buffer in upload memory.
+// Every allocation is owned by the next value signaled on the timeline,
+// so the command list that consumes it must be submitted before the timeline is signaled again.
+// The ring is meant to be used by the single thread that records the uploads.
+typedef struct ComputeUploadRing
+{
+    ComputeRingAllocator allocator;
+    ComputeResource *buffer;
+    uint8_t *pMappedData;
+} ComputeUploadRing;
+
+extern bool ComputeUploadRingInit(ComputeUploadRing *ring, ComputeDevice *device, ComputeTimeline *timeline, uint64_t capacity);
+// Waits for all the allocations in flight before releasing the upload buffer
+extern void ComputeUploadRingDestroy(ComputeUploadRing *ring);
+
+// Reclaim the space of all the allocations whose fence value has been reached. Never blocks.
+extern void ComputeUploadRingReclaim(ComputeUploadRing *ring);
+
+// Sub-allocate size bytes. When the ring is full, waits for the oldest allocations for at most timeoutMs.
+// Returns false on timeout, or when the request can never fit in the ring.
+extern bool ComputeUploadRingAllocate(ComputeUploadRing *ring, uint64_t size, uint64_t alignment,
+    uint32_t timeoutMs, ComputeUploadAllocation *pAllocation);
+
+#endif // UPLOAD_RING_H
@@ -0,0 +1,84 @@
+// Comparison of a buffer of 32-bit elements against the expected ones, on the device.
+// Only the number of mismatches and a few of their indices are written, so the result is read back
+// instead of the whole buffer.
+
+#ifndef GROUP_SIZE
+#define GROUP_SIZE      256
+#endif
+// The number of mismatch indices recorded, COMPUTE_VERIFY_MAX_INDICES
+#ifndef MAX_INDICES
+#define MAX_INDICES     16
+#endif
+
+// The ElementType of the VerifyConstants, ComputeElementType
+#define ELEMENT_TYPE_INT        0
+#define ELEMENT_TYPE_UINT       1
+#define ELEMENT_TYPE_FLOAT      2
+// The Expected of the VerifyConstants, ComputeVerifyExpected
+#define EXPECTED_BUFFER         0
+#define EXPECTED_LINEAR         1
+
+StructuredBuffer<uint> actual: register(t0);        // SRV
+StructuredBuffer<uint> expected: register(t1);      // SRV, only read with EXPECTED_BUFFER
+// [0] the number of mismatches, [1] the lowest mismatch index, [2, 2 + MAX_INDICES) the indices of the first mismatches found
+RWStructuredBuffer<uint> result: register(u0);      // UAV
+
+// Root constants set for each Dispatch
+cbuffer VerifyConstants : register(b0)
+{
+    // The DispatchConstants of the elementwise kernels
+    uint NumElements;
+    uint BaseGroup;
+    uint GroupsPerRow;
+    uint ElementType;
+    uint Expected;
+    // The bits of the generator First + index * Step in the element type
+    uint First;
+    uint Step;
+    // The largest absolute difference of matching floats
+    float Tolerance;
+};
+
+[numthreads(1, 1, 1)]
+void VerifyReset()
+{
+    result[0] = 0;
+    result[1] = 0xffffffffu;
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void VerifyElements(uint3 groupID : SV_GroupID, uint3 localTID : SV_GroupThreadID)
+{
+    const uint group = BaseGroup + groupID.y * GroupsPerRow + groupID.x;
+    const uint index = group * GROUP_SIZE + localTID.x;
+    if (index >= NumElements)
+        return;
+
+    const uint value = actual[index];
+    uint reference;
+    if (Expected == EXPECTED_BUFFER)
+        reference = expected[index];
+    else if (ElementType == ELEMENT_TYPE_FLOAT)
+    {
+        // Without a mad, like the host generator
+        precise const float generated = asfloat(First) + (float)index * asfloat(Step);
+        reference = asuint(generated);
+    }
+    else
+        reference = First + index * Step;
+
+    // The same bits always match, so that equal infinities and NaNs do.
+    bool match = value == reference;
+    if (!match && ElementType == ELEMENT_TYPE_FLOAT)
+        match = abs(asfloat(value) - asfloat(reference)) <= Tolerance;
+
+    // The atomics are only taken by the mismatches, a matching buffer is a plain streaming read.
+    if (!match)
+    {
+        uint slot;
+        InterlockedAdd(result[0], 1, slot);
+        if (slot < MAX_INDICES)
+            result[2 + slot] = index;
+        InterlockedMin(result[1], index);
+    }
+}